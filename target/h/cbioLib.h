@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01k,17oct26,agt  added CBIO_CACHE_META
 01j,21aug01,jkf  SPR#69031, common code for both AE & 5.x.
 01i,14apr00,jkf  fixed S_cbioLib_INVALID_CBIO_DEV_ID definition
 01h,29feb00,jkf  T3 changes
@@ -191,6 +192,7 @@ IMPORT CBIO_DEV_ID cbioWrapBlkDev
 #define	CBIO_CACHE_FLUSH	0xcb100010	/* Flush dirty caches */
 #define	CBIO_CACHE_INVAL	0xcb100030	/* Flush & Invalidate all */
 #define	CBIO_CACHE_NEWBLK	0xcb100050	/* Allocate scratch block */
+#define	CBIO_CACHE_META		0xcb100060	/* Block holds fs metadata */
 
 /*
  * cbioLib errno's 
@@ -5,6 +5,10 @@
 /*
 modification history
 --------------------
+01j,17oct26,agt  restored dcacheDevTune() signature, added
+		 dcacheDevProtectSet()
+01i,17oct26,agt  added dcacheUpdAsync
+01h,17oct26,agt  added protectPct argument to dcacheDevTune()
 01g,04mar02,jkf  SPR#32277, adding dcacheDevEnable and Disable
 01f,21sep01,jkf  SPR#69031, common code for both AE & 5.x.
 01e,29feb00,jkf  T3 changes
@@ -28,6 +32,7 @@ extern "C" {
 IMPORT int dcacheUpdTaskId ;		/* updater task id, one per system */
 IMPORT int dcacheUpdTaskPriority ;	/* updater task priority - tunable */
 IMPORT int dcacheUpdTaskStack ;		/* updater task stack size - tunable */
+IMPORT BOOL dcacheUpdAsync ;		/* updater writes behind - tunable */
 
 /* prototypes */
 
@@ -46,6 +51,11 @@ IMPORT STATUS dcacheDevTune (
     int		syncInterval	/* how many seconds between disk updates */
     ) ;
 
+IMPORT STATUS dcacheDevProtectSet (
+    CBIO_DEV_ID dev,		/* device handle */
+    int		protectPct	/* % of cache for frequently used blocks */
+    ) ;
+
 IMPORT void dcacheShow (
     CBIO_DEV_ID dev,	/* device handle */
     int verbose		/* 1: display state of each cache block */
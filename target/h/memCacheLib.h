@@ -0,0 +1,64 @@
+/* memCacheLib.h - memory partition size-class cache header */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  written
+*/
+
+#ifndef __INCmemCacheLibh
+#define __INCmemCacheLibh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vxWorks.h"
+#include "memLib.h"
+
+/* partition option, for memPartOptionsSet() */
+
+#define MEM_PART_SIZE_CLASS	0x1000	/* front with size-class cache */
+
+/* size classes, in bytes of user data */
+
+#define MEM_CACHE_MIN_SHIFT	4	/* smallest class is 16 bytes */
+#define MEM_CACHE_CLASSES	8	/* ... largest is 2048 bytes */
+
+/* typedefs */
+
+typedef struct			/* MEM_CACHE_STATS */
+    {
+    unsigned long numBytesCached;	/* bytes held in the cache */
+    unsigned long numBlocksCached;	/* blocks held in the cache */
+    unsigned long numHits;		/* allocations served by the cache */
+    unsigned long numMisses;		/* allocations that refilled it */
+    unsigned long numFlushes;		/* batches given back to partition */
+    } MEM_CACHE_STATS;
+
+/* function declarations */
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+extern STATUS	memPartCacheCreate	(PART_ID partId);
+extern STATUS	memPartCacheFlush	(PART_ID partId);
+extern STATUS	memPartCacheInfoGet	(PART_ID partId,
+					 MEM_CACHE_STATS *pStats);
+extern STATUS	memPartCacheShow	(PART_ID partId);
+
+#else   /* __STDC__ */
+
+extern STATUS	memPartCacheCreate	();
+extern STATUS	memPartCacheFlush	();
+extern STATUS	memPartCacheInfoGet	();
+extern STATUS	memPartCacheShow	();
+
+#endif  /* __STDC__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCmemCacheLibh */
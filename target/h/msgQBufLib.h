@@ -0,0 +1,46 @@
+/* msgQBufLib.h - message queue buffer loan library header file */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+/*
+modification history
+--------------------
+01a,17oct26,agt  written.
+*/
+
+#ifndef __INCmsgQBufLibh
+#define __INCmsgQBufLibh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vxWorks.h"
+#include "msgQLib.h"
+
+/* function declarations */
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+extern char *	msgQBufAlloc (MSG_Q_ID msgQId, int timeout);
+extern STATUS	msgQBufFree (MSG_Q_ID msgQId, char *pBuf);
+extern STATUS	msgQBufSend (MSG_Q_ID msgQId, char *bufList[],
+			     UINT lenList[], int nBufs, int priority);
+extern int	msgQBufReceive (MSG_Q_ID msgQId, char *bufList[],
+				UINT lenList[], int maxBufs, int timeout);
+extern int	msgQBufNumLoaned (MSG_Q_ID msgQId);
+
+#else	/* __STDC__ */
+
+extern char *	msgQBufAlloc ();
+extern STATUS	msgQBufFree ();
+extern STATUS	msgQBufSend ();
+extern int	msgQBufReceive ();
+extern int	msgQBufNumLoaned ();
+
+#endif	/* __STDC__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCmsgQBufLibh */
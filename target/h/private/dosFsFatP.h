@@ -5,6 +5,8 @@
 /* 
 modification history 
 -------------------- 
+01h,17oct26,agt  added per file extent maps to MS_FAT_DESC
+01g,17oct26,agt  added free cluster map to MS_FAT_DESC
 01f,20sep01,jkf  SPR#69031, common code for both AE & 5.x.
 01e,29feb00,jkf  T3 changes
 01d,31jul99,jkf  T2 merge, tidiness & spelling.
@@ -41,6 +43,30 @@ extern "C" {
 
 typedef enum fat_rw	{FAT_READ, FAT_WRITE_GROUP, FAT_WRITE_CLUST} FAT_RW;
 
+typedef struct		/* FAT_MAP_NODE - free cluster runs in a span */
+    {
+    uint32_t		pre;		/* free clusters at start of span */
+    uint32_t		suf;		/* free clusters at end of span */
+    uint32_t		max;		/* longest run of free clusters */
+    } FAT_MAP_NODE;
+
+typedef struct		/* FAT_EXTENT - run of contiguous clusters in a file */
+    {
+    uint32_t		logClust;	/* cluster number within file */
+    uint32_t		physClust;	/* cluster number on disk */
+    uint32_t		nClusts;	/* clusters in run */
+    } FAT_EXTENT;
+
+typedef struct		/* FAT_EXT_MAP - known runs of one file chain */
+    {
+    uint32_t		startClust;	/* file start cluster mapped */
+    uint32_t		nClusts;	/* file clusters mapped, from start */
+    uint32_t		nExts;		/* runs in use */
+    uint32_t		maxExts;	/* runs allocated */
+    uint32_t		hint;		/* run last looked up */
+    FAT_EXTENT *	pExt;		/* runs, by ascending logClust */
+    } FAT_EXT_MAP;
+
 typedef struct
     {
     DOS_FAT_DESC	dosFatDesc;	/* generic DOS FAT descriptor */
@@ -64,6 +90,15 @@ typedef struct
     uint32_t		clustAllocStart;/* initialize to DOS_MIN_CLUST */
     BOOL		syncEnabled;	/* FAT copies mirroring enabling */
     SEM_ID		allocSem;	/* semaphore to guard allocations */
+    uint32_t *		pFreeMap;	/* free cluster bitmap, 1 - free */
+    FAT_MAP_NODE *	pMapTree;	/* free runs tree, root at [1] */
+    uint32_t		mapLeaves;	/* tree leaves, a power of 2 */
+    uint32_t		mapBuildTicks;	/* time taken to build the map */
+    BOOL		mapFailed;	/* could not build, dont retry */
+    FAT_EXT_MAP *	pExtMaps;	/* extent map per file handle */
+    int			nExtMaps;	/* number of extent maps */
+    uint32_t		extHits;	/* seeks served from extent maps */
+    uint32_t		extWalks;	/* FAT entries read by seeks */
     } MS_FAT_DESC;
 
 typedef MS_FAT_DESC * MS_FAT_DESC_ID;
@@ -4,6 +4,7 @@
  
 /* modification history
 --------------------
+01r,17oct26,agt  added dosFsMetaBytesRW()
 01q,03mar02,jkf  SPR#29751, added volIsCaseSens to DOS_VOLUME_DESC, orig by chn
 01p,30nov01,jkf  SPR#68203, add updateLastAccessDate boolean to DOS_VOLUME_DESC
 01o,17nov01,jkf  fixing dosFsVolIsFat12 divide error.
@@ -591,6 +592,10 @@ IMPORT STATUS dosFsHdlrInstall( DOS_HDLR_DESC_ID hdlrsList,
 
 IMPORT int dosFsVolIsFat12 (u_char * pBootBuf); /* pick fat12 or fat16 */
 
+IMPORT STATUS dosFsMetaBytesRW( CBIO_DEV_ID pCbio, block_t sec, off_t offset,
+				addr_t buffer, size_t nBytes, CBIO_RW rw,
+				cookie_t * pCookie );
+
 #ifdef __cplusplus
     }
 #endif
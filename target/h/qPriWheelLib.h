@@ -0,0 +1,115 @@
+/* qPriWheelLib.h - timing wheel priority queue header file */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+/*
+modification history
+--------------------
+01a,17oct26,agt  written.
+*/
+
+#ifndef __INCqPriWheelLibh
+#define __INCqPriWheelLibh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vxWorks.h"
+#include "qClass.h"
+
+/* wheel geometry: WHEEL_LEVELS * WHEEL_SHIFT must cover a ULONG */
+
+#define WHEEL_LEVELS	4		/* levels in the wheel */
+#define WHEEL_SHIFT	8		/* log2 of slots per level */
+#define WHEEL_SLOTS	(1 << WHEEL_SHIFT)	/* slots per level */
+#define WHEEL_MASK	(WHEEL_SLOTS - 1)
+
+/* HIDDEN */
+
+typedef struct wheel_link	/* WHEEL_LINK - circular, so no head to remove */
+    {
+    struct wheel_link *	next;
+    struct wheel_link *	prev;
+    } WHEEL_LINK;
+
+typedef struct			/* Q_PRI_WHEEL_NODE */
+    {
+    WHEEL_LINK	link;		/* slot list links */
+    ULONG	key;		/* expiry in vxTicks, for qPriWheelKey() */
+    ULONG	expire;		/* expiry in wheel time, selects the slot */
+    } Q_PRI_WHEEL_NODE;
+
+typedef struct			/* WHEEL_ARRAY */
+    {
+    ULONG	now;		/* wheel time, counts qPriWheelAdvance() */
+    WHEEL_LINK	slot [WHEEL_LEVELS][WHEEL_SLOTS];	/* slot list heads */
+    } WHEEL_ARRAY;
+
+typedef struct q_pri_wheel_head	/* Q_PRI_WHEEL_HEAD */
+    {
+    Q_PRI_WHEEL_NODE *	pFirstNode;	/* NOT USED */
+    WHEEL_ARRAY *	pWheel;		/* slot lists and wheel time */
+    UINT		nNodes;		/* nodes in the queue */
+    Q_CLASS *		pQClass;	/* pointer to queue class */
+    } Q_PRI_WHEEL_HEAD;
+
+extern Q_CLASS_ID qPriWheelClassId;
+
+/* END HIDDEN */
+
+
+/* function declarations */
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+extern WHEEL_ARRAY *	qPriWheelArrayCreate (void);
+extern STATUS		qPriWheelArrayDelete (WHEEL_ARRAY *pWheel);
+extern Q_PRI_WHEEL_HEAD * qPriWheelCreate (WHEEL_ARRAY *pWheel);
+extern STATUS		qPriWheelInit (Q_PRI_WHEEL_HEAD *pQHead,
+				       WHEEL_ARRAY *pWheel);
+extern STATUS		qPriWheelDelete (Q_PRI_WHEEL_HEAD *pQHead);
+extern STATUS		qPriWheelTerminate (Q_PRI_WHEEL_HEAD *pQHead);
+extern void		qPriWheelPut (Q_PRI_WHEEL_HEAD *pQHead,
+				      Q_PRI_WHEEL_NODE *pQNode, ULONG key);
+extern Q_PRI_WHEEL_NODE * qPriWheelGet (Q_PRI_WHEEL_HEAD *pQHead);
+extern STATUS		qPriWheelRemove (Q_PRI_WHEEL_HEAD *pQHead,
+					 Q_PRI_WHEEL_NODE *pQNode);
+extern void		qPriWheelResort (Q_PRI_WHEEL_HEAD *pQHead,
+					 Q_PRI_WHEEL_NODE *pQNode,
+					 ULONG newKey);
+extern void		qPriWheelAdvance (Q_PRI_WHEEL_HEAD *pQHead);
+extern Q_PRI_WHEEL_NODE * qPriWheelGetExpired (Q_PRI_WHEEL_HEAD *pQHead);
+extern ULONG		qPriWheelKey (Q_PRI_WHEEL_NODE *pQNode, int keyType);
+extern void		qPriWheelCalibrate (Q_PRI_WHEEL_HEAD *pQHead,
+					    ULONG keyDelta);
+extern int		qPriWheelInfo (Q_PRI_WHEEL_HEAD *pQHead,
+				       int nodeArray[], int maxNodes);
+extern Q_PRI_WHEEL_NODE * qPriWheelEach (Q_PRI_WHEEL_HEAD *pQHead,
+					 FUNCPTR routine, int routineArg);
+
+#else	/* __STDC__ */
+
+extern WHEEL_ARRAY *	qPriWheelArrayCreate ();
+extern STATUS		qPriWheelArrayDelete ();
+extern Q_PRI_WHEEL_HEAD * qPriWheelCreate ();
+extern STATUS		qPriWheelInit ();
+extern STATUS		qPriWheelDelete ();
+extern STATUS		qPriWheelTerminate ();
+extern void		qPriWheelPut ();
+extern Q_PRI_WHEEL_NODE * qPriWheelGet ();
+extern STATUS		qPriWheelRemove ();
+extern void		qPriWheelResort ();
+extern void		qPriWheelAdvance ();
+extern Q_PRI_WHEEL_NODE * qPriWheelGetExpired ();
+extern ULONG		qPriWheelKey ();
+extern void		qPriWheelCalibrate ();
+extern int		qPriWheelInfo ();
+extern Q_PRI_WHEEL_NODE * qPriWheelEach ();
+
+#endif	/* __STDC__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCqPriWheelLibh */
@@ -0,0 +1,63 @@
+/* selSetLib.h - persistent select() interest set header */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01b,17oct26,agt  selSetWait() returns a list of SEL_SET_EVENTs.
+01a,17oct26,agt  written
+*/
+
+#ifndef __INCselSetLibh
+#define __INCselSetLibh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vxWorks.h"
+#include "selectLib.h"
+
+/* typedefs */
+
+typedef struct selSet *SEL_SET_ID;	/* opaque select set handle */
+
+typedef struct selSetEvent	/* SEL_SET_EVENT - ready descriptor */
+    {
+    int		fd;		/* descriptor */
+    SELECT_TYPE	type;		/* SELREAD or SELWRITE */
+    } SEL_SET_EVENT;
+
+/* function declarations */
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+extern SEL_SET_ID selSetCreate	(void);
+extern STATUS	selSetDelete	(SEL_SET_ID selSetId);
+extern STATUS	selSetAdd	(SEL_SET_ID selSetId, int fd,
+				 SELECT_TYPE type);
+extern STATUS	selSetRemove	(SEL_SET_ID selSetId, int fd,
+				 SELECT_TYPE type);
+extern STATUS	selSetRearm	(SEL_SET_ID selSetId, int fd,
+				 SELECT_TYPE type);
+extern int	selSetWait	(SEL_SET_ID selSetId,
+				 SEL_SET_EVENT *pEvents, int maxEvents,
+				 struct timeval *pTimeOut);
+
+#else   /* __STDC__ */
+
+extern SEL_SET_ID selSetCreate	();
+extern STATUS	selSetDelete	();
+extern STATUS	selSetAdd	();
+extern STATUS	selSetRemove	();
+extern STATUS	selSetRearm	();
+extern int	selSetWait	();
+
+#endif  /* __STDC__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCselSetLibh */
@@ -0,0 +1,60 @@
+/* semFmLib.h - fast mutual-exclusion semaphore library header file */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+/*
+modification history
+--------------------
+01b,17oct26,agt  lock byte is volatile char, allocated as a char.
+01a,17oct26,agt  written.
+*/
+
+#ifndef __INCsemFmLibh
+#define __INCsemFmLibh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vxWorks.h"
+#include "semLib.h"
+
+/* semaphore type, the first one left free by semLibP.h */
+
+#define SEM_TYPE_FMUTEX		0x4
+
+/* HIDDEN */
+
+/*
+ * The test-and-set lock byte of a fast mutex is the char allocated
+ * immediately after the SEMAPHORE by semFmCreate().  It is claimed with
+ * vxTas() and released with a plain store, outside of kernel state.
+ */
+
+#define SEM_FM_LOCK(semId)	((volatile char *) (((SEMAPHORE *) (semId)) + 1))
+
+/* END HIDDEN */
+
+
+/* function declarations */
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+extern STATUS	semFmLibInit (void);
+extern SEM_ID	semFmCreate (int options);
+extern STATUS	semFmGive (SEM_ID semId);
+extern STATUS	semFmTake (SEM_ID semId, int timeout);
+
+#else	/* __STDC__ */
+
+extern STATUS	semFmLibInit ();
+extern SEM_ID	semFmCreate ();
+extern STATUS	semFmGive ();
+extern STATUS	semFmTake ();
+
+#endif	/* __STDC__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCsemFmLibh */
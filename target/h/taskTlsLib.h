@@ -0,0 +1,63 @@
+/* taskTlsLib.h - task local storage slot library header */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01b,17oct26,agt  added status codes of its own
+01a,17oct26,agt  written
+*/
+
+#ifndef __INCtaskTlsLibh
+#define __INCtaskTlsLibh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vxWorks.h"
+
+/* generic status codes, above those of taskLib.h */
+
+#define S_taskLib_TLS_KEYS_EXHAUSTED	(M_taskLib | 120)
+#define S_taskLib_TLS_KEY_INVALID	(M_taskLib | 121)
+
+/* defines */
+
+#define TASK_TLS_MAX	32		/* slots in a task's slot table */
+
+/* slot <key> of the calling task, or NULL if the task has no slot table */
+
+#define TASK_TLS_GET(key)						\
+    ((taskTlsTable == NULL) ? NULL : taskTlsTable [(key)])
+
+/* variable declarations */
+
+extern void **	taskTlsTable;		/* calling task's slot table */
+
+/* function declarations */
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+extern STATUS	taskTlsLibInit	(void);
+extern int	taskTlsKeyCreate (void);
+extern void *	taskTlsGet	(int key);
+extern STATUS	taskTlsSet	(int key, void *value);
+extern void *	taskTlsTaskGet	(int tid, int key);
+
+#else   /* __STDC__ */
+
+extern STATUS	taskTlsLibInit	();
+extern int	taskTlsKeyCreate ();
+extern void *	taskTlsGet	();
+extern STATUS	taskTlsSet	();
+extern void *	taskTlsTaskGet	();
+
+#endif  /* __STDC__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCtaskTlsLibh */
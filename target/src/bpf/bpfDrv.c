@@ -49,6 +49,8 @@
 /*
 modification history
 --------------------
+01g,17oct26,agt  filters run pre-decoded (bpf_decode(), bpf_dfilter());
+                 filter length only changes with the filter
 01f,07may02,wap  Correctly initialize filter length (SPR #74358)
 01e,26mar02,wap  remember to call _bpfDevUnlock() when bpfIfSet() exits with
                  error (SPR #74039)
@@ -158,6 +160,21 @@ SEE ALSO: ioLib
 
 #define BPF_BUFSIZE 4096         /* default BPF buffer size */   
 
+/* pre-decoded form of a unit's filter, stored after its instructions */
+
+#define BPF_DPROG(pBpfDev) \
+     ((pBpfDev)->pBpfInsnFilter == NULL ? NULL : \
+     (struct bpf_dinsn *)((pBpfDev)->pBpfInsnFilter + (pBpfDev)->filterLen))
+
+/* externals */
+
+struct bpf_dinsn;
+
+IMPORT u_int bpf_dsize (int);
+IMPORT void bpf_decode (struct bpf_insn *, int, struct bpf_dinsn *);
+IMPORT u_int bpf_dfilter (struct bpf_dinsn *, u_char *, u_int, u_int, long,
+                          int);
+
 /* globals */
 
 /* locals */
@@ -755,8 +772,8 @@ void _bpfPacketTap
         {
         _bpfUnitLock (pBpfDev);  /* Prevent changing filter or buffer size. */
         pBpfDev->pktRecvCount++;
-        snapLen = bpf_filter (pBpfDev->pBpfInsnFilter, (u_char *) pMBlk,
-                              pMBlk->mBlkPktHdr.len, 0, type, netDataOffset);
+        snapLen = bpf_dfilter (BPF_DPROG (pBpfDev), (u_char *) pMBlk,
+                               pMBlk->mBlkPktHdr.len, 0, type, netDataOffset);
         if (snapLen != 0)
             {
             /* Filter accepted the frame. Copy it to the BPF unit's buffer. */
@@ -1556,7 +1573,9 @@ LOCAL void bpfSelectDelete
 *
 * This routine sets the filter program to be used with a BPF device.  Before
 * the filter progam is set it will be validated using the bpf_validate () 
-* routine.
+* routine.  A valid program is then translated by bpf_decode () into the
+* pre-decoded form which _bpfPacketTap () runs for each packet; that is
+* stored after the instructions, in the same buffer.
 *
 * RETURNS:
 * OK
@@ -1605,10 +1624,9 @@ LOCAL int bpfSetFilter
         bpfDevReset (pBpfDev);
 
         if (pBpfInsnOld != NULL)
-            {
             free (pBpfInsnOld);
-            return (OK);
-            }
+
+        return (OK);
         }
 
     filterLen = pBpfProg->bf_len;
@@ -1618,12 +1636,11 @@ LOCAL int bpfSetFilter
     if (filterLen != pBpfDev->filterLen)
         newFlag = TRUE;
 
-    pBpfDev->filterLen = filterLen;
     filterSize = filterLen * sizeof (*pBpfProg->bf_insns);
 
     if (newFlag)
         {
-        pBpfInsnNew = (BPF_INSN *)malloc (filterSize);
+        pBpfInsnNew = (BPF_INSN *)malloc (filterSize + bpf_dsize (filterLen));
         if (pBpfInsnNew == NULL)
             {
             return (ENOMEM);
@@ -1643,7 +1660,10 @@ LOCAL int bpfSetFilter
 
     if (bpf_validate (pBpfInsnNew, filterLen))
         {
+        bpf_decode (pBpfInsnNew, filterLen,
+                    (struct bpf_dinsn *) (pBpfInsnNew + filterLen));
         pBpfDev->pBpfInsnFilter = pBpfInsnNew;
+        pBpfDev->filterLen = filterLen;
 
         bpfDevReset (pBpfDev);
         if (newFlag && pBpfInsnOld != NULL)
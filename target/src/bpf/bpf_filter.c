@@ -49,6 +49,9 @@ static const char rcsid[] =
 /*
 modification history
 --------------------
+01d,17oct26,agt  added pre-decoded filters (bpf_decode(), bpf_dfilter());
+                 mbuf loads reject out-of-range offsets; bpf_validate()
+                 checks LDX and STX scratch memory addresses
 01c,25apr02,wap  Don't choose EXTRACT_xx() macros based on byte-ordering (SPR
                  #76316)
 01b,26oct00,spm  fixed merge from tor3_x branch and updated mod history
@@ -89,6 +92,8 @@ modification history
 #include <net/mbuf.h>
 #define MINDEX(len, m, k) \
 { \
+	if (k < 0) \
+		return 0; \
 	len = m->m_len; \
 	while (k >= len) { \
 		k -= len; \
@@ -108,6 +113,7 @@ m_xword(m, k, err)
 	register u_char *cp, *np;
 	register struct mbuf *m0;
 
+	*err = 1;
 	MINDEX(len, m, k);
 	cp = mtod(m, u_char *) + k;
 	if (len - k >= 4) {
@@ -144,6 +150,7 @@ m_xhalf(m, k, err)
 	register u_char *cp;
 	register struct mbuf *m0;
 
+	*err = 1;
 	MINDEX(len, m, k);
 	cp = mtod(m, u_char *) + k;
 	if (len - k >= 2) {
@@ -160,6 +167,19 @@ m_xhalf(m, k, err)
 	return 0;
 }
 
+static int
+m_xbyte(m, k, err)
+	register struct mbuf *m;
+	register int k, *err;
+{
+	register int len;
+
+	*err = 1;
+	MINDEX(len, m, k);
+	*err = 0;
+	return mtod(m, u_char *)[k];
+}
+
 /*
  * Execute the filter program starting at pc on the packet p
  * wirelen is the length of the original packet
@@ -226,6 +246,8 @@ bpf_filter(pc, p, wirelen, buflen, type, offset)
 				if (buflen != 0)
 					return 0;
 				A = m_xhalf((struct mbuf *)p, k, &merr);
+				if (merr != 0)
+					return 0;
 				continue;
 			}
 			A = EXTRACT_SHORT(&p[k]);
@@ -270,6 +292,8 @@ bpf_filter(pc, p, wirelen, buflen, type, offset)
 				if (buflen != 0)
 					return 0;
 				A = m_xhalf((struct mbuf *)p, k, &merr);
+				if (merr != 0)
+					return 0;
 				continue;
 			}
 			A = EXTRACT_SHORT(&p[k]);
@@ -370,7 +394,7 @@ bpf_filter(pc, p, wirelen, buflen, type, offset)
 				X = (mtod(m, char *)[k] & 0xf) << 2;
 				continue;
 			}
-			X = (p[pc->k] & 0xf) << 2;
+			X = (p[k] & 0xf) << 2;
 			continue;
 
 		case BPF_LDX|BPF_MSH|BPF_B:
@@ -386,7 +410,7 @@ bpf_filter(pc, p, wirelen, buflen, type, offset)
 				X = (mtod(m, char *)[k] & 0xf) << 2;
 				continue;
 			}
-			X = (p[pc->k] & 0xf) << 2;
+			X = (p[k] & 0xf) << 2;
 			continue;
 
 		case BPF_LD|BPF_IMM:
@@ -568,7 +592,9 @@ bpf_validate(f, len)
 		 * Check that memory operations use valid addresses.
 		 */
 		if ((BPF_CLASS(p->code) == BPF_ST ||
-		     (BPF_CLASS(p->code) == BPF_LD && 
+		     BPF_CLASS(p->code) == BPF_STX ||
+		     ((BPF_CLASS(p->code) == BPF_LD ||
+		       BPF_CLASS(p->code) == BPF_LDX) && 
 		      (p->code & 0xe0) == BPF_MEM)) &&
 		    (p->k >= BPF_MEMWORDS || p->k < 0))
 			return 0;
@@ -580,3 +606,453 @@ bpf_validate(f, len)
 	}
 	return BPF_CLASS(f[len - 1].code) == BPF_RET;
 }
+
+/*
+ * Pre-decoded filters.
+ *
+ * bpf_decode() translates a validated program, once, into an array of
+ * bpf_dinsn: each instruction carries a dense opcode and its jump
+ * targets as pointers, so bpf_dfilter() need not decode the BPF fields
+ * again for every packet.  Compiled with gcc, bpf_dfilter() jumps from
+ * each instruction straight to the code for the next through a table
+ * of label addresses; otherwise it uses a switch, like bpf_filter().
+ * When handed an mbuf chain, it reads loads that fall within the first
+ * mbuf -- in practice, the headers -- directly, and only walks the
+ * chain for data beyond it.
+ */
+
+#define BPF_D_OPS \
+	D_OP(RET_K) D_OP(RET_A) D_OP(RET_K_HLEN) \
+	D_OP(LD_W_ABS) D_OP(LD_H_ABS) D_OP(LD_B_ABS) \
+	D_OP(LD_W_ABS_HLEN) D_OP(LD_H_ABS_HLEN) D_OP(LD_B_ABS_HLEN) \
+	D_OP(LD_W_IND) D_OP(LD_H_IND) D_OP(LD_B_IND) \
+	D_OP(LDX_MSH_B) D_OP(LDX_MSH_B_HLEN) \
+	D_OP(LD_W_LEN) D_OP(LDX_W_LEN) D_OP(LD_TYPE) D_OP(LD_HLEN) \
+	D_OP(LDX_HLEN) D_OP(LD_IMM) D_OP(LDX_IMM) D_OP(LD_MEM) \
+	D_OP(LDX_MEM) D_OP(ST) D_OP(STX) \
+	D_OP(JA) D_OP(JGT_K) D_OP(JGE_K) D_OP(JEQ_K) D_OP(JSET_K) \
+	D_OP(JGT_X) D_OP(JGE_X) D_OP(JEQ_X) D_OP(JSET_X) \
+	D_OP(ADD_X) D_OP(SUB_X) D_OP(MUL_X) D_OP(DIV_X) D_OP(AND_X) \
+	D_OP(OR_X) D_OP(LSH_X) D_OP(RSH_X) \
+	D_OP(ADD_K) D_OP(SUB_K) D_OP(MUL_K) D_OP(DIV_K) D_OP(AND_K) \
+	D_OP(OR_K) D_OP(LSH_K) D_OP(RSH_K) \
+	D_OP(NEG) D_OP(TAX) D_OP(TXA)
+
+enum bpf_dop {
+#define D_OP(op)	BPF_D_##op,
+	BPF_D_OPS
+#undef D_OP
+	BPF_D_NOPS
+};
+
+struct bpf_dinsn {
+	int	d_op;			/* BPF_D_xxx */
+	u_int32	d_k;			/* operand */
+	struct bpf_dinsn *d_jt;		/* next instruction if true */
+	struct bpf_dinsn *d_jf;		/* next instruction if false */
+};
+
+/*
+ * Return the number of bytes bpf_decode() needs for a program of
+ * 'len' instructions.
+ */
+u_int
+bpf_dsize(len)
+	int len;
+{
+	return (len * sizeof(struct bpf_dinsn));
+}
+
+/*
+ * Translate the 'len' instructions at 'f', which bpf_validate() has
+ * accepted, into the pre-decoded program at 'd'.
+ */
+void
+bpf_decode(f, len, d)
+	register struct bpf_insn *f;
+	int len;
+	register struct bpf_dinsn *d;
+{
+	register int i;
+	register int op;
+
+	for (i = 0; i < len; ++i, ++f, ++d) {
+		d->d_k = f->k;
+		d->d_jt = d->d_jf = d + 1;
+
+		switch (f->code) {
+
+		default:
+			/* bpf_filter() rejects the packet here */
+			op = BPF_D_RET_K;
+			d->d_k = 0;
+			break;
+
+		case BPF_RET|BPF_K:		op = BPF_D_RET_K; break;
+		case BPF_RET|BPF_A:		op = BPF_D_RET_A; break;
+		case BPF_RET|BPF_K|BPF_HLEN:	op = BPF_D_RET_K_HLEN; break;
+		case BPF_LD|BPF_W|BPF_ABS:	op = BPF_D_LD_W_ABS; break;
+		case BPF_LD|BPF_H|BPF_ABS:	op = BPF_D_LD_H_ABS; break;
+		case BPF_LD|BPF_B|BPF_ABS:	op = BPF_D_LD_B_ABS; break;
+		case BPF_LD|BPF_W|BPF_ABS|BPF_HLEN:
+						op = BPF_D_LD_W_ABS_HLEN; break;
+		case BPF_LD|BPF_H|BPF_ABS|BPF_HLEN:
+						op = BPF_D_LD_H_ABS_HLEN; break;
+		case BPF_LD|BPF_B|BPF_ABS|BPF_HLEN:
+						op = BPF_D_LD_B_ABS_HLEN; break;
+		case BPF_LD|BPF_W|BPF_IND:	op = BPF_D_LD_W_IND; break;
+		case BPF_LD|BPF_H|BPF_IND:	op = BPF_D_LD_H_IND; break;
+		case BPF_LD|BPF_B|BPF_IND:	op = BPF_D_LD_B_IND; break;
+		case BPF_LDX|BPF_MSH|BPF_B:	op = BPF_D_LDX_MSH_B; break;
+		case BPF_LDX|BPF_MSH|BPF_B|BPF_HLEN:
+						op = BPF_D_LDX_MSH_B_HLEN; break;
+		case BPF_LD|BPF_W|BPF_LEN:	op = BPF_D_LD_W_LEN; break;
+		case BPF_LDX|BPF_W|BPF_LEN:	op = BPF_D_LDX_W_LEN; break;
+		case BPF_LD|BPF_TYPE:		op = BPF_D_LD_TYPE; break;
+		case BPF_LD|BPF_HLEN:		op = BPF_D_LD_HLEN; break;
+		case BPF_LDX|BPF_HLEN:		op = BPF_D_LDX_HLEN; break;
+		case BPF_LD|BPF_IMM:		op = BPF_D_LD_IMM; break;
+		case BPF_LDX|BPF_IMM:		op = BPF_D_LDX_IMM; break;
+		case BPF_LD|BPF_MEM:		op = BPF_D_LD_MEM; break;
+		case BPF_LDX|BPF_MEM:		op = BPF_D_LDX_MEM; break;
+		case BPF_ST:			op = BPF_D_ST; break;
+		case BPF_STX:			op = BPF_D_STX; break;
+		case BPF_JMP|BPF_JGT|BPF_K:	op = BPF_D_JGT_K; break;
+		case BPF_JMP|BPF_JGE|BPF_K:	op = BPF_D_JGE_K; break;
+		case BPF_JMP|BPF_JEQ|BPF_K:	op = BPF_D_JEQ_K; break;
+		case BPF_JMP|BPF_JSET|BPF_K:	op = BPF_D_JSET_K; break;
+		case BPF_JMP|BPF_JGT|BPF_X:	op = BPF_D_JGT_X; break;
+		case BPF_JMP|BPF_JGE|BPF_X:	op = BPF_D_JGE_X; break;
+		case BPF_JMP|BPF_JEQ|BPF_X:	op = BPF_D_JEQ_X; break;
+		case BPF_JMP|BPF_JSET|BPF_X:	op = BPF_D_JSET_X; break;
+		case BPF_ALU|BPF_ADD|BPF_X:	op = BPF_D_ADD_X; break;
+		case BPF_ALU|BPF_SUB|BPF_X:	op = BPF_D_SUB_X; break;
+		case BPF_ALU|BPF_MUL|BPF_X:	op = BPF_D_MUL_X; break;
+		case BPF_ALU|BPF_DIV|BPF_X:	op = BPF_D_DIV_X; break;
+		case BPF_ALU|BPF_AND|BPF_X:	op = BPF_D_AND_X; break;
+		case BPF_ALU|BPF_OR|BPF_X:	op = BPF_D_OR_X; break;
+		case BPF_ALU|BPF_LSH|BPF_X:	op = BPF_D_LSH_X; break;
+		case BPF_ALU|BPF_RSH|BPF_X:	op = BPF_D_RSH_X; break;
+		case BPF_ALU|BPF_ADD|BPF_K:	op = BPF_D_ADD_K; break;
+		case BPF_ALU|BPF_SUB|BPF_K:	op = BPF_D_SUB_K; break;
+		case BPF_ALU|BPF_MUL|BPF_K:	op = BPF_D_MUL_K; break;
+		case BPF_ALU|BPF_DIV|BPF_K:	op = BPF_D_DIV_K; break;
+		case BPF_ALU|BPF_AND|BPF_K:	op = BPF_D_AND_K; break;
+		case BPF_ALU|BPF_OR|BPF_K:	op = BPF_D_OR_K; break;
+		case BPF_ALU|BPF_LSH|BPF_K:	op = BPF_D_LSH_K; break;
+		case BPF_ALU|BPF_RSH|BPF_K:	op = BPF_D_RSH_K; break;
+		case BPF_ALU|BPF_NEG:		op = BPF_D_NEG; break;
+		case BPF_MISC|BPF_TAX:		op = BPF_D_TAX; break;
+		case BPF_MISC|BPF_TXA:		op = BPF_D_TXA; break;
+
+		case BPF_JMP|BPF_JA:
+			op = BPF_D_JA;
+			d->d_jt = d + 1 + f->k;
+			break;
+		}
+
+		if (BPF_CLASS(f->code) == BPF_JMP && op != BPF_D_JA) {
+			d->d_jt = d + 1 + f->jt;
+			d->d_jf = d + 1 + f->jf;
+		}
+		d->d_op = op;
+	}
+}
+
+#ifdef __GNUC__
+#define D_BEGIN		goto *dtbl[pc->d_op];
+#define D_END
+#define D_CASE(op)	L_##op
+#define D_NEXT		goto *dtbl[(++pc)->d_op]
+#define D_GOTO(t)	pc = (t); goto *dtbl[pc->d_op]
+#else
+#define D_BEGIN		for (;;) switch (pc->d_op) {
+#define D_END		}
+#define D_CASE(op)	case BPF_D_##op
+#define D_NEXT		++pc; continue
+#define D_GOTO(t)	pc = (t); continue
+#endif
+
+/*
+ * Packet loads for bpf_dfilter().  A load outside the first 'buflen'
+ * bytes at 'p' is taken from the mbuf chain 'm', if there is one;
+ * a load past the end of the packet rejects it.
+ */
+#define D_LOAD(r, k, size, direct, xfunc) \
+	if ((k) < buflen && buflen - (k) >= (size)) \
+		r = direct; \
+	else { \
+		if (m == 0 || (int32)(k) < 0) \
+			return 0; \
+		r = xfunc(m, (int)(k), &merr); \
+		if (merr != 0) \
+			return 0; \
+	}
+#define D_LDW(r, k)	D_LOAD(r, k, sizeof(int32), EXTRACT_LONG(&p[k]), m_xword)
+#define D_LDH(r, k)	D_LOAD(r, k, sizeof(short), EXTRACT_SHORT(&p[k]), m_xhalf)
+#define D_LDB(r, k)	D_LOAD(r, k, 1, p[k], m_xbyte)
+
+/*
+ * Execute the pre-decoded filter program 'pc'; the remaining arguments
+ * and the result are those of bpf_filter().
+ */
+u_int
+bpf_dfilter(pc, p, wirelen, buflen, type, offset)
+	register struct bpf_dinsn *pc;
+	register u_char *p;
+	u_int wirelen;
+	register u_int buflen;
+        long type;
+        int offset;
+{
+	register u_int32 A, X;
+	register u_int32 k;
+	struct mbuf *m;
+	int merr;
+	int32 mem[BPF_MEMWORDS];
+#ifdef __GNUC__
+	static void * const dtbl[] = {
+#define D_OP(op)	&&L_##op,
+		BPF_D_OPS
+#undef D_OP
+	};
+#endif
+
+	if (pc == 0)
+		/*
+		 * No filter means accept all.
+		 */
+		return (u_int)-1;
+
+	/*
+	 * Given an mbuf chain, read the first mbuf directly.
+	 */
+	if (buflen == 0) {
+		m = (struct mbuf *)p;
+		p = mtod(m, u_char *);
+		buflen = m->m_len;
+	} else
+		m = 0;
+
+	A = 0;
+	X = 0;
+
+	D_BEGIN
+
+	D_CASE(RET_K):
+		return (u_int)pc->d_k;
+
+	D_CASE(RET_A):
+		return (u_int)A;
+
+	D_CASE(RET_K_HLEN):
+		return (u_int)(pc->d_k + offset);
+
+	D_CASE(LD_W_ABS):
+		k = pc->d_k;
+		D_LDW(A, k);
+		D_NEXT;
+
+	D_CASE(LD_H_ABS):
+		k = pc->d_k;
+		D_LDH(A, k);
+		D_NEXT;
+
+	D_CASE(LD_B_ABS):
+		k = pc->d_k;
+		D_LDB(A, k);
+		D_NEXT;
+
+	D_CASE(LD_W_ABS_HLEN):
+		k = pc->d_k + offset;
+		D_LDW(A, k);
+		D_NEXT;
+
+	D_CASE(LD_H_ABS_HLEN):
+		k = pc->d_k + offset;
+		D_LDH(A, k);
+		D_NEXT;
+
+	D_CASE(LD_B_ABS_HLEN):
+		k = pc->d_k + offset;
+		D_LDB(A, k);
+		D_NEXT;
+
+	D_CASE(LD_W_IND):
+		k = X + pc->d_k;
+		D_LDW(A, k);
+		D_NEXT;
+
+	D_CASE(LD_H_IND):
+		k = X + pc->d_k;
+		D_LDH(A, k);
+		D_NEXT;
+
+	D_CASE(LD_B_IND):
+		k = X + pc->d_k;
+		D_LDB(A, k);
+		D_NEXT;
+
+	D_CASE(LDX_MSH_B):
+		k = pc->d_k;
+		D_LDB(X, k);
+		X = (X & 0xf) << 2;
+		D_NEXT;
+
+	D_CASE(LDX_MSH_B_HLEN):
+		k = pc->d_k + offset;
+		D_LDB(X, k);
+		X = (X & 0xf) << 2;
+		D_NEXT;
+
+	D_CASE(LD_W_LEN):
+		A = wirelen;
+		D_NEXT;
+
+	D_CASE(LDX_W_LEN):
+		X = wirelen;
+		D_NEXT;
+
+	D_CASE(LD_TYPE):
+		A = type;
+		D_NEXT;
+
+	D_CASE(LD_HLEN):
+		A = offset;
+		D_NEXT;
+
+	D_CASE(LDX_HLEN):
+		X = offset;
+		D_NEXT;
+
+	D_CASE(LD_IMM):
+		A = pc->d_k;
+		D_NEXT;
+
+	D_CASE(LDX_IMM):
+		X = pc->d_k;
+		D_NEXT;
+
+	D_CASE(LD_MEM):
+		A = mem[pc->d_k];
+		D_NEXT;
+
+	D_CASE(LDX_MEM):
+		X = mem[pc->d_k];
+		D_NEXT;
+
+	D_CASE(ST):
+		mem[pc->d_k] = A;
+		D_NEXT;
+
+	D_CASE(STX):
+		mem[pc->d_k] = X;
+		D_NEXT;
+
+	D_CASE(JA):
+		D_GOTO(pc->d_jt);
+
+	D_CASE(JGT_K):
+		D_GOTO((A > pc->d_k) ? pc->d_jt : pc->d_jf);
+
+	D_CASE(JGE_K):
+		D_GOTO((A >= pc->d_k) ? pc->d_jt : pc->d_jf);
+
+	D_CASE(JEQ_K):
+		D_GOTO((A == pc->d_k) ? pc->d_jt : pc->d_jf);
+
+	D_CASE(JSET_K):
+		D_GOTO((A & pc->d_k) ? pc->d_jt : pc->d_jf);
+
+	D_CASE(JGT_X):
+		D_GOTO((A > X) ? pc->d_jt : pc->d_jf);
+
+	D_CASE(JGE_X):
+		D_GOTO((A >= X) ? pc->d_jt : pc->d_jf);
+
+	D_CASE(JEQ_X):
+		D_GOTO((A == X) ? pc->d_jt : pc->d_jf);
+
+	D_CASE(JSET_X):
+		D_GOTO((A & X) ? pc->d_jt : pc->d_jf);
+
+	D_CASE(ADD_X):
+		A += X;
+		D_NEXT;
+
+	D_CASE(SUB_X):
+		A -= X;
+		D_NEXT;
+
+	D_CASE(MUL_X):
+		A *= X;
+		D_NEXT;
+
+	D_CASE(DIV_X):
+		if (X == 0)
+			return 0;
+		A /= X;
+		D_NEXT;
+
+	D_CASE(AND_X):
+		A &= X;
+		D_NEXT;
+
+	D_CASE(OR_X):
+		A |= X;
+		D_NEXT;
+
+	D_CASE(LSH_X):
+		A <<= X;
+		D_NEXT;
+
+	D_CASE(RSH_X):
+		A >>= X;
+		D_NEXT;
+
+	D_CASE(ADD_K):
+		A += pc->d_k;
+		D_NEXT;
+
+	D_CASE(SUB_K):
+		A -= pc->d_k;
+		D_NEXT;
+
+	D_CASE(MUL_K):
+		A *= pc->d_k;
+		D_NEXT;
+
+	D_CASE(DIV_K):
+		A /= pc->d_k;
+		D_NEXT;
+
+	D_CASE(AND_K):
+		A &= pc->d_k;
+		D_NEXT;
+
+	D_CASE(OR_K):
+		A |= pc->d_k;
+		D_NEXT;
+
+	D_CASE(LSH_K):
+		A <<= pc->d_k;
+		D_NEXT;
+
+	D_CASE(RSH_K):
+		A >>= pc->d_k;
+		D_NEXT;
+
+	D_CASE(NEG):
+		A = -A;
+		D_NEXT;
+
+	D_CASE(TAX):
+		X = A;
+		D_NEXT;
+
+	D_CASE(TXA):
+		A = X;
+		D_NEXT;
+
+	D_END
+}
@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+01z,17oct26,agt  CBIO_CACHE_META is a no-op for wrapped block devices
 01y,03jun02,jkf  fixed SPR#78162, cbioLib has INTERNAL comment visable
 01x,29apr02,jkf  SPR#76013, blkWrapBlkRWbuf() shall semGive what it semTake's,
                  also removed cbioWrapBlkDev check for bytesPerBlk since the 
@@ -611,6 +612,8 @@ CBIO_CACHE_FLUSH - Flush any dirty cached data
 CBIO_CACHE_INVAL - Flush & Invalidate all cached data
 .IP
 CBIO_CACHE_NEWBLK - Allocate scratch block
+.IP
+CBIO_CACHE_META - Block holds file system metadata
 .LP
 
 The CBIO module may also implement other codes.  CBIO modules pass all 
@@ -918,6 +921,8 @@ STATUS cbioBlkCopy
 * CBIO_CACHE_INVAL - Flush & Invalidate all cached data
 * .IP
 * CBIO_CACHE_NEWBLK - Allocate scratch block
+* .IP
+* CBIO_CACHE_META - Block holds file system metadata
 * .LP
 *
 * If the CBIO_DEV_ID passed to this routine is not a valid CBIO handle,
@@ -2214,6 +2219,8 @@ LOCAL STATUS blkWrapBlkCopy
 * CBIO_CACHE_INVAL - Flush & Invalidate all cached data
 * .IP
 * CBIO_CACHE_NEWBLK - Allocate scratch block
+* .IP
+* CBIO_CACHE_META - Block holds file system metadata
 * .LP
 *
 * RETURNS OK or ERROR and may otherwise set errno.
@@ -2436,6 +2443,9 @@ LOCAL STATUS blkWrapIoctl
 		}
 	    break;
 
+	case CBIO_CACHE_META :	/* one block buffer, nothing to retain */
+	    break;
+
 	default:
 	    stat = pBd->bd_ioctl( pBd, command, arg );
 	    break ;
@@ -5,6 +5,18 @@
 /*
 modification history
 --------------------
+02e,17oct26,agt  dcacheDevCreate() frees the new device when it fails
+02d,17oct26,agt  blocks are metadata only when marked by CBIO_CACHE_META,
+                 bytewise file data no longer fills the protected list
+02c,17oct26,agt  restored five argument dcacheDevTune(), protected share is
+                 set by new dcacheDevProtectSet()
+02b,17oct26,agt  asynchronous write-behind: tDcacheUpd writes elevator
+                 ordered, merged runs without holding the device mutex,
+                 writers are throttled by dirty ratio, writer latency
+                 histogram added to dcacheShow
+02a,17oct26,agt  hash table is always present and sized from the block
+                 count; segmented LRU replacement with separate metadata
+                 and data statistics, protected share set by dcacheDevTune
 01z,03mar02,jkf  SPR#32277, adding dcacheDevEnable and Disable(), orig by chn
 01y,21dec01,chn  SPRs 30130, 22463, 21975 (partial). Disabled defaulting
                  tuneable parameters after they are explicitly set by user.
@@ -75,7 +87,7 @@ available through dcacheDevTune().
 
 Briefly, here are the main techniques deployed by the disk cache:
 .IP
-Least Recently Used block re-use policy
+Scan resistant, segmented Least Recently Used block re-use policy
 .IP
 Read-ahead
 .IP
@@ -94,15 +106,40 @@ are described in varrious professional and academic publications.
 
 DISK CACHE ALGORITHM
 The disk cache is composed internally of a number cache blocks, of
-the same size as the disk physical block (sector). These cache blocks
-are maintained in a list in "Most Recently Used" order, that is, blocks
-which are used are moved to the top of this list. When a block needs to
-be relinquished, and made available to contain a new disk block, the
-Least Recently Used block will be used for this purpose.
+the same size as the disk physical block (sector). Each cache block is
+found by its disk block number through a hash table, which is sized
+from the number of cache blocks whenever the cache is created or
+resized, so a lookup never degrades into a walk of all blocks.
+
+The cache blocks are kept in two lists, both in "Most Recently Used"
+order. A disk block which is read into the cache enters the
+.I probationary
+list, and is only moved to the
+.I protected
+list when it is used again while still in the cache. When a block
+needs to be relinquished, and made available to contain a new disk
+block, the Least Recently Used block of the probationary list is used
+for this purpose, and only if there is no suitable block there is one
+taken from the protected list. The protected list is limited to a
+share of the cache, set with dcacheDevProtectSet(); when it grows past that
+share, its Least Recently Used block is moved back to the probationary
+list. Hence a large sequential read, whose blocks are each used once,
+only cycles through the probationary list and does not flush out the
+blocks which are used repeatedly, such as the File Allocation Table
+and directories.
+
+Blocks which the file system marks with the CBIO_CACHE_META ioctl, as
+dosFs does for its File Allocation Table and directory sectors, are
+treated as
+.I metadata
+and enter the protected list directly. Hits, misses and evictions are
+counted separately for metadata and data blocks, and are displayed by
+dcacheShow().
 
 In addition to the regular cache blocks, some of the memory allocated
 for cache is set aside for a "big buffer", which may range from 1/4 of
-the overall cache size up to 64KB.  This buffer is used for:
+the overall cache size up to 64KB.  Half of it is used by the update
+task for writing behind (see below), and the other half is used for:
 
 .IP
 Combining cache blocks with adjacent disk block numbers, in order to
@@ -141,6 +178,26 @@ it can wake up frequently enough to keep the disk synchronized with the
 cache.   There is only one such task for all cache devices configured.  
 The task name is tDcacheUpd
 
+The updating task also writes behind: when more than half of dirtyMax
+blocks are dirty, the task which modified them wakes up the updating task,
+which writes dirty blocks until a quarter of dirtyMax remain.  Blocks are
+written in ascending block order, continuing from where the previous
+write ended and wrapping around at the end of the disk, and each write
+covers as many adjacent dirty blocks as fit into the write-behind buffer.
+The blocks are copied to that buffer and marked clean before the write
+is started, so the disk cache is not locked while the disk is busy, and
+other tasks may read and modify cached blocks, including the ones being
+written.  A block which is modified again during the write is simply
+written again later.
+
+Tasks which write to the cache are throttled by the proportion of dirty
+blocks: when more than dirtyMax blocks are dirty, a writer is delayed,
+in proportion to the excess, to let the updating task catch up, and
+only if it does not are all dirty blocks written by the writer itself.
+The number of writers delayed, and of those which had to write, as well
+as a histogram of the time spent in each write request, in ticks, are
+displayed by dcacheShow().
+
 The updating task also has the responsibility to invalidate disk cache
 blocks for removable devices which have not been used for 2 seconds or more.
 
@@ -155,6 +212,12 @@ is used to set the update task stack size.
 
 .IP <dcacheUpdTaskOptions>
 controls the task options for the update task.
+
+.IP <dcacheUpdAsync>
+enables the write-behind, and is TRUE by default. When it is set to FALSE,
+dirty blocks are written only when the update period expires, or by the
+writer which finds that more than dirtyMax blocks are dirty, with the disk
+cache locked for the duration of the write.
 .LP
 All the above global parameters must be set prior to calling
 dcacheDevCreate() for the first time, with the exception of
@@ -304,6 +367,15 @@ which is used to indicate that a block is being modified in memory
 and its data is not valid. This state is never used after mutex is 
 released.
 
+Write-behind
+------------
+The write-behind marks blocks CLEAN before they are written, and then
+writes them from its own buffer with only the I/O mutex (dcIoMutex) taken.
+All other transfers to the subordinate device also take the I/O mutex,
+after the cbioMutex, so a block which was evicted while being written is
+not read back until the write is complete, and dcacheManyFlushInval()
+waits for the write before it can consider CLEAN blocks to be on disk.
+
 Removable Device Support Details
 
 It is worth noting that we dont trust the block driver's ability
@@ -347,6 +419,9 @@ Issues to revisit or implement:
 #define DCACHE_MAX_DEVS         16
 #endif
 
+/* writer latency histogram, bucket n counts 2^(n-1) .. 2^n-1 ticks */
+#define DCACHE_LAT_BUCKETS      8
+
 /* Cache block states */
 typedef enum {
     CB_STATE_EMPTY,             /* no valid block is assigned */
@@ -364,23 +439,34 @@ typedef struct dcacheDesc {
                 pHashNext;      /* offset of next desc in hash slot */
     CB_STATE    state:4;        /* current state */
     unsigned    busy:1;         /* descriptor busy (unused) */
+    unsigned    prot:1;         /* on protected list, else probationary */
+    unsigned    ref:1;          /* used since it was read into cache */
+    unsigned    meta:1;         /* file system metadata */
 } DCACHE_DESC ;
 
 struct dcacheCtrl {
         CBIO_DEV_ID     cbioDev ;       /* main device handle */
         CBIO_DEV_ID     dcSubDev ;      /* subordinate CBIO device */
-        DL_LIST         dcLru ;         /* LRU list head */
+        DL_LIST         dcLru ;         /* probationary LRU list head */
+        DL_LIST         dcProt ;        /* protected LRU list head */
+        u_long          dcProtCount ;   /* # of blocks on protected list */
+        u_long          dcProtMax ;     /* max # of protected blocks */
         char *          pDcDesc ;       /* description */
         u_long          dcNumCacheBlocks ;
         caddr_t         dcBigBufPtr;
         u_long          dcBigBufSize;
+        caddr_t         dcFlushBufPtr;  /* write-behind buffer */
+        u_long          dcFlushBufSize; /* ... in blocks */
+        SEM_ID          dcIoMutex ;     /* serializes subordinate I/O */
+        block_t         dcFlushCursor ; /* write-behind elevator position */
         block_t         dcLastAccBlock ;
         u_long          dcUpdTick ;
         u_long          dcActTick ;
         u_long          dcDiskSignature;
         /* Hash table params */
         DCACHE_DESC **  ppDcHashBase;
-        u_long          dcHashSize;
+        u_long          dcHashSize;     /* always a power of two */
+        u_long          dcHashMask;     /* dcHashSize - 1 */
         u_long          dcHashHits;
         u_long          dcHashMisses;
         /* Tunable Parameters */
@@ -390,17 +476,28 @@ struct dcacheCtrl {
         u_long          dcReadAhead;
         u_long          dcSyncInterval;
         u_long          dcCylinderSize;
+        u_long          dcProtPct;      /* % of cache for protected list */
         BOOL            dcIsTuned;      /* Set when cache is tuned */
         /* Statistic Counters */
         u_long          dcDirtyCount;
         u_long          dcCookieHits ;
         u_long          dcCookieMisses ;
-        u_long          dcLruHits ;
-        u_long          dcLruMisses ;
+        u_long          dcMetaHits ;
+        u_long          dcMetaMisses ;
+        u_long          dcMetaEvicts ;
+        u_long          dcDataHits ;
+        u_long          dcDataMisses ;
+        u_long          dcDataEvicts ;
+        DCACHE_DESC *   dcLastDesc ;    /* block of the last lookup */
+        BOOL            dcLastMiss ;    /* ... and whether it missed */
+        u_long          dcDemotions ;   /* protected -> probationary */
         u_long          dcWritesForeground ;
         u_long          dcWritesBackground ;
         u_long          dcWritesHidden ;
         u_long          dcWritesForced ;
+        u_long          dcThrottles ;   /* writer delays on dirty ratio */
+        u_long          dcThrottleFlushes ; /* ... which had to flush */
+        u_long          dcWriteLat [DCACHE_LAT_BUCKETS] ;
 } DCACHE_CTRL ;
 
 LOCAL const struct tunablePresets {
@@ -408,20 +505,42 @@ LOCAL const struct tunablePresets {
         u_long          dcBypassCount;
         u_long          dcDirtyMax;
         u_long          dcReadAhead;
-        u_long          dcHashSize;
         u_long          dcSyncInterval;
 } dcacheTunablePresets[] = {
-/* <= nblks     bypass  dirty   read-ahead      hash-sz sync */
-{   16,         4,      7,      1,              0,      0       },
-{   32,         8,      15,     4,              37,     0       },
-{   64,         8,      25,     7,              67,     0       },
-{   128,        16,     50,     10,             131,    1       },
-{   256,        24,     100,    22,             269,    1       },
-{   512,        32,     200,    28,             547,    2       },
-{  1024,        64,     500,    32,             1033,   5       },
-{  NONE,        128,    1000,   64,             2221,   15      },
+/* <= nblks     bypass  dirty   read-ahead      sync */
+{   16,         4,      7,      1,              0       },
+{   32,         8,      15,     4,              0       },
+{   64,         8,      25,     7,              0       },
+{   128,        16,     50,     10,             1       },
+{   256,        24,     100,    22,             1       },
+{   512,        32,     200,    28,             2       },
+{  1024,        64,     500,    32,             5       },
+{  NONE,        128,    1000,   64,             15      },
 };
 
+#define DCACHE_PROT_PCT_DEF     75      /* default protected list share */
+#define DCACHE_PROT_PCT_MIN     10      /* ... and its limits */
+#define DCACHE_PROT_PCT_MAX     90
+
+/* hash slot of a disk block, sequential blocks go to adjacent slots */
+#define DCACHE_HASH(pDc, blk)   ((blk) & (pDc)->dcHashMask)
+
+/* write-behind is woken at half of dirtyMax, and writes down to a quarter */
+#define DCACHE_DIRTY_BGND(pDc)  ((pDc)->dcDirtyMax / 2)
+#define DCACHE_DIRTY_LOW(pDc)   ((pDc)->dcDirtyMax / 4)
+
+/* a writer over dirtyMax is delayed this many times before it flushes */
+#define DCACHE_THROTTLE_ROUNDS  4
+
+/* dirty blocks are written by the updater task, outside of the mutex */
+#define DCACHE_ASYNC(pDc)       (dcacheUpdAsync && (dcacheUpdSem != NULL) && \
+                                 (dcacheUpdTaskId != 0) && \
+                                 ((pDc)->dcFlushBufSize > 0))
+
+/* the list a cache block is on */
+#define DCACHE_LIST(pDc, pDesc) \
+        ((pDesc)->prot ? &(pDc)->dcProt : &(pDc)->dcLru)
+
 #undef DEBUG
 
 #ifdef DEBUG
@@ -442,7 +561,13 @@ LOCAL void dcacheQuickFlush (void);
 
 LOCAL DCACHE_DESC * dcacheBlockLocate( CBIO_DEV_ID dev, block_t block );
 LOCAL DCACHE_DESC * dcacheBlockGet( CBIO_DEV_ID dev, block_t block,
-        cookie_t * pCookie, BOOL readData );
+        cookie_t * pCookie, BOOL readData, BOOL meta );
+LOCAL void dcacheBlockTouch( CBIO_DEV_ID dev, DCACHE_DESC * pDesc,
+        BOOL refer, BOOL meta );
+LOCAL STATUS dcacheSubRW( CBIO_DEV_ID dev, block_t startBlock,
+        block_t numBlocks, addr_t buffer, CBIO_RW rw );
+LOCAL void dcacheIoDrain( CBIO_DEV_ID dev );
+LOCAL STATUS dcacheWriteThrottle( CBIO_DEV_ID dev, u_long startTick );
 
 LOCAL STATUS dcacheBlkRW 
     ( 
@@ -482,6 +607,8 @@ struct dcacheCtrl dcacheCtrl[ DCACHE_MAX_DEVS ] ;
 int dcacheUpdTaskId = 0;           /* updater task, one for all devices */
 int dcacheUpdTaskPriority = 250;   /* tunable by user */
 int dcacheUpdTaskStack = 5000 ;    /* tuneable by user to save space */
+BOOL dcacheUpdAsync = TRUE ;       /* FALSE - writers flush inline */
+LOCAL SEM_ID dcacheUpdSem = NULL ; /* wakes up the updater task */
 
 /* CBIO_FUNCS, one per cbio driver */
 
@@ -622,9 +749,9 @@ CBIO_DEV_ID dcacheDevCreate
 
     if( pDev->pDc == NULL )
         {
-        taskUnlock();           /* FIXME - if too many devs, mem leak */
+        taskUnlock();
         errno = ENODEV;
-        return NULL;
+        goto error;
         }
 
     bzero( (caddr_t) pDev->pDc, sizeof(struct dcacheCtrl));
@@ -637,6 +764,15 @@ CBIO_DEV_ID dcacheDevCreate
     /* connect the underlying block driver */
     pDev->pDc->dcSubDev = pSubDev ;
 
+    /* write-behind runs without cbioMutex, subordinate I/O is ordered here */
+    pDev->pDc->dcIoMutex = semMCreate( SEM_Q_PRIORITY | SEM_INVERSION_SAFE );
+
+    if( pDev->pDc->dcIoMutex == NULL )
+        {
+        pDev->pDc->cbioDev = NULL ;     /* release the control structure */
+        goto error;
+        }
+
     if( pDesc != NULL )
         {
         pDev->pDc->pDcDesc      = strdup(pDesc) ;
@@ -651,6 +787,9 @@ CBIO_DEV_ID dcacheDevCreate
     /* Create the Updater task if not already created */
     if( 0 == dcacheUpdTaskId )
         {
+        if( NULL == dcacheUpdSem )
+            dcacheUpdSem = semBCreate( SEM_Q_PRIORITY, SEM_EMPTY );
+
         dcacheUpdTaskId = taskSpawn(
                 "tDcacheUpd",
                 dcacheUpdTaskPriority,
@@ -662,6 +801,18 @@ CBIO_DEV_ID dcacheDevCreate
 
     /* return device handle */
     return( pDev );
+
+error:
+    /* undo cbioDevCreate(), the same way its own error path does */
+    semDelete( pDev->cbioMutex );
+
+    if( (pRamAddr == NULL) && (pDev->cbioMemBase != NULL) )
+        KHEAP_FREE( pDev->cbioMemBase );
+
+    /* a stale handle must fail cbioDevVerify(), e.g. in cbioShow(NULL) */
+    bzero( (caddr_t) pDev, sizeof(CBIO_DEV) );
+    KHEAP_FREE( (char *) pDev );
+    return NULL;
     }
 
 /*******************************************************************************
@@ -819,12 +970,11 @@ LOCAL void dcacheHashRemove ( CBIO_DEV_ID dev, DCACHE_DESC *pDesc )
     FAST DCACHE_DESC ** ppHashSlot ;
     FAST struct dcacheCtrl * pDc = dev->pDc ;
 
-    if( pDesc->state != CB_STATE_EMPTY && pDc->dcHashSize != 0 )
+    if( pDesc->state != CB_STATE_EMPTY )
         {
-        /* empty blocks are not expected to be in hash, or no hash table */
+        /* empty blocks are not expected to be in hash */
 
-        ppHashSlot = &(pDc->ppDcHashBase [
-                        pDesc->block % pDc->dcHashSize ]);
+        ppHashSlot = &(pDc->ppDcHashBase [ DCACHE_HASH(pDc, pDesc->block) ]);
 
         pTmp = *ppHashSlot ;
 
@@ -845,15 +995,39 @@ LOCAL void dcacheHashRemove ( CBIO_DEV_ID dev, DCACHE_DESC *pDesc )
                 }
             }
         }
-    /* assert that we did not fail to find in hash unless has is void */
-    assert( (pTmp != NULL) == (pDc->dcHashSize > 0) );
+    /* assert that we did not fail to find in hash unless block was empty */
+    assert( (pTmp != NULL) || (pDesc->state == CB_STATE_EMPTY) );
 
     pDesc->busy = 0;
+    pDesc->ref = 0;
+    pDesc->meta = 0;
     pDesc->block = NONE ;
     pDesc->state = CB_STATE_EMPTY ;
     pDesc->pHashNext = NULL ;
     }
 
+/*******************************************************************************
+* 
+* dcacheBlockInval - invalidate a cache block which is on its LRU list
+*
+* The block is removed from the hash table, and if it was protected,
+* it is moved to the end of the probationary list to be reused first.
+*/
+LOCAL void dcacheBlockInval ( CBIO_DEV_ID dev, DCACHE_DESC *pDesc )
+    {
+    FAST struct dcacheCtrl * pDc = dev->pDc ;
+
+    dcacheHashRemove( dev, pDesc );
+
+    if( pDesc->prot )
+        {
+        dllRemove( & pDc->dcProt, &pDesc->lruList );
+        pDesc->prot = 0;
+        pDc->dcProtCount -- ;
+        dllAdd( & pDc->dcLru, &pDesc->lruList );
+        }
+    }
+
 /*******************************************************************************
 * 
 * dcacheChangeDetect - detect a possible disk change
@@ -873,7 +1047,8 @@ LOCAL STATUS dcacheChangeDetect ( CBIO_DEV_ID dev, BOOL invalidate )
 
     dev->pDc->dcActTick = tickGet() ;
     
-    pDesc = dcacheBlockGet(dev, bootBlockNum, NULL, /*readData=*/ TRUE);
+    pDesc = dcacheBlockGet(dev, bootBlockNum, NULL, /*readData=*/ TRUE,
+                /*meta=*/ TRUE);
 
     if( pDesc == NULL )
         return ERROR ;
@@ -884,7 +1059,7 @@ LOCAL STATUS dcacheChangeDetect ( CBIO_DEV_ID dev, BOOL invalidate )
     else if ((pDesc->state == CB_STATE_CLEAN) && invalidate )
         {
         /* invalidate the boot block to read it from disk */
-        dcacheHashRemove(dev, pDesc);
+        dcacheBlockInval(dev, pDesc);
         }
 
     cksum = dcacheBlockCksum( dev, pDesc );
@@ -902,6 +1077,56 @@ LOCAL STATUS dcacheChangeDetect ( CBIO_DEV_ID dev, BOOL invalidate )
     return (OK);
     }
 
+/*******************************************************************************
+* 
+* dcacheSubRW - read or write blocks on the subordinate device
+*
+* All transfers to and from the subordinate device go through here, so
+* that they are ordered with the write-behind, which writes its data with
+* only the I/O mutex taken.  A reader which missed a block that is being
+* written waits here until the write is complete, and then reads back
+* the new data.
+*
+* NOTE: The cbioMutex is taken before the I/O mutex, never the other way.
+*/
+LOCAL STATUS dcacheSubRW
+    (
+    CBIO_DEV_ID         dev,
+    block_t             startBlock,
+    block_t             numBlocks,
+    addr_t              buffer,
+    CBIO_RW             rw
+    )
+    {
+    FAST struct dcacheCtrl * pDc = dev->pDc ;
+    STATUS stat ;
+
+    if( semTake( pDc->dcIoMutex, WAIT_FOREVER) == ERROR )
+        return ERROR;
+
+    stat = pDc->dcSubDev->pFuncs->cbioDevBlkRW(
+                pDc->dcSubDev,
+                startBlock, numBlocks,
+                buffer, rw, NULL );
+
+    semGive( pDc->dcIoMutex );
+    return (stat);
+    }
+
+/*******************************************************************************
+* 
+* dcacheIoDrain - wait for a write-behind in progress to complete
+*
+* Blocks written by the write-behind are marked CLEAN before their data
+* reaches the disk, hence anyone who needs the disk to be up to date,
+* e.g. an explicit flush, must wait for the write to finish.
+*/
+LOCAL void dcacheIoDrain( CBIO_DEV_ID dev )
+    {
+    if( semTake( dev->pDc->dcIoMutex, WAIT_FOREVER) == OK )
+        semGive( dev->pDc->dcIoMutex );
+    }
+
 /*******************************************************************************
 * 
 * dcacheListAddSort - add descriptor to a sorted list
@@ -983,10 +1208,8 @@ LOCAL STATUS dcacheFlushBatch
         if( burstCount == 1 )
             {
             /* non-contiguous block, write directly from cache block */
-            ret = pDc->dcSubDev->pFuncs->cbioDevBlkRW(
-                    pDc->dcSubDev,
-                    pTmp->block, 1,
-                    pTmp->data, CBIO_WRITE, NULL );
+            ret = dcacheSubRW( dev, pTmp->block, 1,
+                    pTmp->data, CBIO_WRITE );
             pDc->dcLastAccBlock = pTmp->block + 1 ;
             }
         else
@@ -1006,10 +1229,8 @@ LOCAL STATUS dcacheFlushBatch
                 pContig =  (DCACHE_DESC *) DLL_NEXT( pContig );
                 }
 
-            ret = pDc->dcSubDev->pFuncs->cbioDevBlkRW(
-                    pDc->dcSubDev,
-                    pTmp->block, burstCount,
-                    pDc->dcBigBufPtr, CBIO_WRITE, NULL );
+            ret = dcacheSubRW( dev, pTmp->block, burstCount,
+                    pDc->dcBigBufPtr, CBIO_WRITE );
 
             pDc->dcLastAccBlock = pTmp->block + burstCount ;
             } /* else - burst write */
@@ -1035,6 +1256,13 @@ LOCAL STATUS dcacheFlushBatch
             if( doInvalidate )
                 {
                 dcacheHashRemove(dev, pTmp);
+
+                /* invalid blocks go back to be reused first */
+                if( pTmp->prot )
+                    {
+                    pTmp->prot = 0;
+                    pDc->dcProtCount -- ;
+                    }
                 }
             else
                 {
@@ -1042,9 +1270,9 @@ LOCAL STATUS dcacheFlushBatch
                 }
 
             pContig =  (DCACHE_DESC *) DLL_NEXT( pTmp );
-            /* Makes this block LRU now */
+            /* Makes this block LRU of its list now */
             dllRemove( pList, &pTmp->lruList );
-            dllAdd( & pDc->dcLru,  &pTmp->lruList );
+            dllAdd( DCACHE_LIST(pDc, pTmp),  &pTmp->lruList );
             pTmp = pContig ;
             }
         } /* for */
@@ -1057,7 +1285,7 @@ LOCAL STATUS dcacheFlushBatch
 * 
 * dcacheManyFlushInval - Flush and/or Invalidate many blocks at once
 *
-* Walk through the entire block list, and perform the requested action
+* Walk through both block lists, and perform the requested action
 * for each of the blocks that fall within the specified range.
 * All of these operations are done without releasing the mutex, so as to avoid
 * anyone filling or modifying any of the blocks or otherwise rearranging of the
@@ -1077,14 +1305,26 @@ LOCAL STATUS dcacheManyFlushInval
     DCACHE_DESC * pDesc, * pNext ;
     STATUS stat = OK ;
     DL_LIST     flushList ;
+    DL_LIST *   pLruList ;
     u_long      writeCounter = 0 ;
 
 
+    /* blocks the write-behind has in flight are already CLEAN */
+    dcacheIoDrain( dev );
+
     /* init the list in which we store all blocks to be flushed */
     dllInit( & flushList );
 
+    /*
+     * Do the probationary list, then the protected list.  Invalidated
+     * protected blocks move to the tail of the probationary list, which
+     * has then been walked already.
+     */
+    pLruList = & dev->pDc->dcLru ;
+
+again:
     /* start with Least Recently Used block, from tail of list */
-    pDesc = (DCACHE_DESC *) DLL_LAST( & dev->pDc->dcLru );
+    pDesc = (DCACHE_DESC *) DLL_LAST( pLruList );
 
     /* walk through the list towards the top */
     while ( (pDesc != NULL) && (stat == OK ) )
@@ -1105,7 +1345,7 @@ LOCAL STATUS dcacheManyFlushInval
                 if( doFlush )
                     {
                     /* remove from LRU list, add to flush batch */
-                    dllRemove( & dev->pDc->dcLru,  &pDesc->lruList );
+                    dllRemove( pLruList,  &pDesc->lruList );
                     dcacheListAddSort( &flushList, pDesc );
                     writeCounter ++ ;
                     goto next ;
@@ -1115,7 +1355,7 @@ LOCAL STATUS dcacheManyFlushInval
             case CB_STATE_CLEAN:/* contains a valid block, unmodified */
                 if( doInvalidate )
                     {
-                    dcacheHashRemove(dev, pDesc);
+                    dcacheBlockInval(dev, pDesc);
                     }
                 break ;
 
@@ -1127,6 +1367,12 @@ next:
         pDesc = pNext ;
         }
 
+    if( pLruList == & dev->pDc->dcLru )
+        {
+        pLruList = & dev->pDc->dcProt ;
+        goto again ;
+        }
+
     if( ! DLL_EMPTY( &flushList ) )
         {
         stat = dcacheFlushBatch( dev, &flushList, doInvalidate ) ;
@@ -1137,12 +1383,277 @@ next:
     return (stat);
     }
 
+/*******************************************************************************
+* 
+* dcacheDirtyFind - find a dirty block by its disk block number
+*
+* Same as dcacheBlockLocate(), but returns only DIRTY blocks and does not
+* count hash hits, because it is not a user access.
+*/
+LOCAL DCACHE_DESC * dcacheDirtyFind( CBIO_DEV_ID dev, block_t block )
+    {
+    FAST DCACHE_DESC *pDesc ;
+    FAST struct dcacheCtrl * pDc = dev->pDc ;
+
+    for( pDesc = pDc->ppDcHashBase [ DCACHE_HASH(pDc, block) ] ;
+         pDesc != NULL ; pDesc = pDesc->pHashNext )
+        {
+        if( pDesc->block == block )
+            return( (pDesc->state == CB_STATE_DIRTY) ? pDesc : NULL );
+        }
+
+    return NULL;
+    }
+
+/*******************************************************************************
+* 
+* dcacheDirtyNext - find the next dirty block in elevator order
+*
+* Returns the dirty block with the lowest block number which is not below
+* <cursor>, or if there is none, the lowest numbered dirty block, so that
+* the disk is swept in one direction only.
+*/
+LOCAL DCACHE_DESC * dcacheDirtyNext( CBIO_DEV_ID dev, block_t cursor )
+    {
+    FAST DCACHE_DESC * pTmp ;
+    DCACHE_DESC * pAhead = NULL ;       /* lowest at or above cursor */
+    DCACHE_DESC * pLow = NULL ;         /* lowest of all */
+    DL_LIST * pList ;
+
+    for( pList = & dev->pDc->dcProt ; pList != NULL ;
+         pList = (pList == & dev->pDc->dcProt) ? & dev->pDc->dcLru : NULL )
+      for( pTmp = (DCACHE_DESC *) DLL_FIRST( pList ) ;
+         pTmp != NULL ;
+         pTmp = (DCACHE_DESC *) DLL_NEXT( pTmp ) )
+        {
+        if( pTmp->state != CB_STATE_DIRTY )
+            continue ;
+
+        if( (pLow == NULL) || (pTmp->block < pLow->block) )
+            pLow = pTmp ;
+
+        if( (pTmp->block >= cursor) &&
+            ((pAhead == NULL) || (pTmp->block < pAhead->block)) )
+            pAhead = pTmp ;
+        }
+
+    return( (pAhead != NULL) ? pAhead : pLow );
+    }
+
+/*******************************************************************************
+* 
+* dcacheWriteBehind - write dirty blocks to disk in the background
+*
+* Called by the updater task, without the mutex.  Dirty blocks are written
+* in elevator order, one run at a time.  Each run is the longest sequence
+* of adjacent dirty blocks around the next block in order which fits into
+* the write-behind buffer.  The run is copied to the buffer and marked
+* CLEAN with the mutex taken, and then written with only the I/O mutex
+* taken, so other tasks may use all cached blocks, including the ones
+* being written, while the disk is busy.
+*
+* Runs are written until no more than <target> blocks are dirty, or until
+* as many blocks as were dirty on entry have been written, so a writer
+* which keeps up with the disk can not hold the updater here forever.
+*
+* RETURNS: OK, or ERROR if a write failed.
+*/
+LOCAL STATUS dcacheWriteBehind( CBIO_DEV_ID dev, u_long target )
+    {
+    FAST struct dcacheCtrl * pDc = dev->pDc ;
+    FAST DCACHE_DESC * pDesc ;
+    STATUS stat = OK ;
+    long budget ;
+    block_t start, n, ix ;
+    caddr_t data ;
+
+    if( semTake( dev->cbioMutex, WAIT_FOREVER) == ERROR )
+        return ERROR;
+
+    if( ! DCACHE_ASYNC(pDc) )
+        {
+        /* no write-behind buffer, write it all with the mutex taken */
+        if( pDc->dcDirtyCount > target )
+            stat = dcacheManyFlushInval( dev, 0, NONE, TRUE, FALSE,
+                        & pDc->dcWritesBackground );
+        semGive( dev->cbioMutex );
+        return (stat);
+        }
+
+    budget = pDc->dcDirtyCount ;
+
+    while( (pDc->dcDirtyCount > target) && (budget > 0) &&
+           (FALSE == cbioRdyChgdGet (dev)) )
+        {
+        /* same as dcacheFlushBatch, dont write over a replaced disk */
+        if ( dev->cbioParams.cbioRemovable &&
+             (pDc->dcActTick < tickGet() - sysClkRateGet() * DCACHE_IDLE_SECS))
+            {
+            if( dcacheChangeDetect( dev, FALSE ) == ERROR )
+                {
+                stat = ERROR ;
+                break ;
+                }
+            }
+
+        pDesc = dcacheDirtyNext( dev, pDc->dcFlushCursor );
+
+        if( pDesc == NULL )
+            break ;
+
+        /* extend the run backward, then forward as far as it goes */
+        start = pDesc->block ;
+        n = 1 ;
+
+        while( (n < pDc->dcFlushBufSize) && (start > 0) &&
+               (dcacheDirtyFind( dev, start - 1 ) != NULL) )
+            {
+            start -- ; n ++ ;
+            }
+
+        while( (n < pDc->dcFlushBufSize) &&
+               (dcacheDirtyFind( dev, start + n ) != NULL) )
+            {
+            n ++ ;
+            }
+
+        /* copy the run out, from now on the cached blocks are CLEAN */
+        data = pDc->dcFlushBufPtr ;
+
+        for( ix = 0 ; ix < n ; ix ++ )
+            {
+            pDesc = dcacheDirtyFind( dev, start + ix );
+            bcopy( pDesc->data, data, dev->cbioParams.bytesPerBlk );
+            pDesc->state = CB_STATE_CLEAN ;
+            pDc->dcDirtyCount -- ;
+            data += dev->cbioParams.bytesPerBlk ;
+            }
+
+        pDc->dcWritesBackground += n ;
+        pDc->dcFlushCursor = start + n ;
+        budget -= n ;
+
+        /* hand over from the cache to the disk, in this order */
+        if( semTake( pDc->dcIoMutex, WAIT_FOREVER) == ERROR )
+            {
+            stat = ERROR ;
+            break ;
+            }
+
+        semGive( dev->cbioMutex );
+
+        stat = pDc->dcSubDev->pFuncs->cbioDevBlkRW(
+                pDc->dcSubDev,
+                start, n,
+                pDc->dcFlushBufPtr, CBIO_WRITE, NULL );
+
+        semGive( pDc->dcIoMutex );
+
+        if( semTake( dev->cbioMutex, WAIT_FOREVER) == ERROR )
+            return ERROR;
+
+        pDc->dcLastAccBlock = start + n ;
+        pDc->dcActTick = tickGet() ;
+
+        if( stat == ERROR )
+            {
+            (void) dcacheErrorHandler( dev, NULL, CBIO_WRITE );
+            dev->cbioParams.lastErrBlk = start ;
+
+            /* 
+             * as in dcacheFlushBatch, cache coherency is questionable
+             * after a write error, so drop whatever was not modified since
+             */
+            for( ix = 0 ; ix < n ; ix ++ )
+                {
+                pDesc = dcacheBlockLocate( dev, start + ix );
+                if( (pDesc != NULL) && (pDesc->state == CB_STATE_CLEAN) )
+                    dcacheBlockInval( dev, pDesc );
+                }
+            break ;
+            }
+        }
+
+    semGive( dev->cbioMutex );
+    return (stat);
+    }
+
+/*******************************************************************************
+* 
+* dcacheWriteThrottle - pace a writer by the dirty block ratio
+*
+* Called by writers after they have released the mutex.  If more than
+* half of dirtyMax blocks are dirty, the updater task is woken up to write
+* some of them.  If more than dirtyMax are dirty, the writer is delayed in
+* proportion to the excess, giving the updater a chance to catch up, and
+* only if it still has not after a few rounds, or if there is no
+* write-behind, are all dirty blocks flushed inline, as a last resort.
+* The time spent by the writer, from <startTick>, is recorded in the
+* latency histogram.
+*
+* RETURNS: OK, or ERROR if an inline flush failed.
+*/
+LOCAL STATUS dcacheWriteThrottle( CBIO_DEV_ID dev, u_long startTick )
+    {
+    FAST struct dcacheCtrl * pDc = dev->pDc ;
+    STATUS stat = OK ;
+    u_long excess, delay, bucket ;
+    int round ;
+
+    for( round = 0 ; DCACHE_ASYNC(pDc) ; round ++ )
+        {
+        if( pDc->dcDirtyCount > DCACHE_DIRTY_BGND(pDc) )
+            semGive( dcacheUpdSem );
+
+        if( (pDc->dcDirtyCount <= pDc->dcDirtyMax) ||
+            (round >= DCACHE_THROTTLE_ROUNDS) )
+            break ;
+
+        if( round == 0 )
+            pDc->dcThrottles ++ ;
+
+        /* a full dirtyMax over the limit is a quarter second */
+        excess = pDc->dcDirtyCount - pDc->dcDirtyMax ;
+        delay = 1 + (excess * sysClkRateGet()) / (4 * pDc->dcDirtyMax + 1) ;
+        taskDelay( (int) min( delay, (u_long) sysClkRateGet() >> 2 ));
+        }
+
+    if( pDc->dcDirtyCount > pDc->dcDirtyMax )
+        {
+        if( semTake( dev->cbioMutex, WAIT_FOREVER) == ERROR )
+            return ERROR;
+
+        if( pDc->dcDirtyCount > pDc->dcDirtyMax )
+            {
+            if( DCACHE_ASYNC(pDc) )
+                pDc->dcThrottleFlushes ++ ;
+
+            stat = dcacheManyFlushInval( dev, 0, NONE, TRUE, FALSE,
+                            & pDc->dcWritesForeground );
+            }
+
+        semGive( dev->cbioMutex );
+        }
+
+    /* log2 of the ticks it took */
+    for( delay = tickGet() - startTick, bucket = 0 ;
+         (delay > 0) && (bucket < DCACHE_LAT_BUCKETS - 1) ; bucket ++ )
+        delay >>= 1 ;
+
+    pDc->dcWriteLat [bucket] ++ ;
+
+    return (stat);
+    }
+
 /*******************************************************************************
 *
 * dcacheBlockAllocate - allocate a cache block with disk data
 *
 * Allocate a cache block to be associated with a certain disk block.
-* At this point we assume the block IS NOT already on the list
+* At this point we assume the block IS NOT already on the list.
+* The victim is the Least Recently Used clean or empty block of the
+* probationary list, or of the protected list if the probationary list
+* has none. The block returned is always on the probationary list.
 *
 * NOTE: The cbioMutex must already be taken when entering this function.
 */
@@ -1164,13 +1675,23 @@ again:
         }
 
     /* never reuse blocks which are Dirty or Unstable */
-    while ( (pDesc->state == CB_STATE_DIRTY) ||
-            (pDesc->state == CB_STATE_UNSTABLE))
+    while ( (pDesc != NULL) &&
+            ((pDesc->state == CB_STATE_DIRTY) ||
+             (pDesc->state == CB_STATE_UNSTABLE)))
         {
         pDesc = (DCACHE_DESC *) DLL_PREVIOUS(pDesc);
-        if( pDesc == NULL)
+        }
+
+    /* nothing on the probationary list, try the protected list */
+    if( pDesc == NULL )
+        {
+        pDesc = (DCACHE_DESC *) DLL_LAST( & pDc->dcProt );
+
+        while ( (pDesc != NULL) &&
+                ((pDesc->state == CB_STATE_DIRTY) ||
+                 (pDesc->state == CB_STATE_UNSTABLE)))
             {
-            break;
+            pDesc = (DCACHE_DESC *) DLL_PREVIOUS(pDesc);
             }
         }
 
@@ -1192,27 +1713,42 @@ again:
 
     /* in case this block contained some valid block remove it from hash */
     if( pDesc->state != CB_STATE_EMPTY )
+        {
+        if( pDesc->meta )
+            pDc->dcMetaEvicts ++ ;
+        else
+            pDc->dcDataEvicts ++ ;
+
         dcacheHashRemove(dev, pDesc);
+        }
+
+    /* a new block starts on probation */
+    if( pDesc->prot )
+        {
+        dllRemove( & pDc->dcProt, &pDesc->lruList );
+        pDesc->prot = 0;
+        pDc->dcProtCount -- ;
+        dllAdd( & pDc->dcLru, &pDesc->lruList );
+        }
 
     /* mark block fields */
     pDesc->state = CB_STATE_UNSTABLE ;
     pDesc->block = block ;
+    pDesc->ref = 0;
+    pDesc->meta = 0;
 
     assert( dev == pDc->cbioDev );
 
-    if( pDc->dcHashSize > 0)
-        {
-        /* insert the block into hash table too */
-        ppHashSlot = &(pDc->ppDcHashBase [ block % pDc->dcHashSize ]);
+    /* insert the block into hash table too */
+    ppHashSlot = &(pDc->ppDcHashBase [ DCACHE_HASH(pDc, block) ]);
 
-        if( *ppHashSlot != NULL )
-            assert( (block % pDc->dcHashSize) ==
-                    ((*ppHashSlot)->block % pDc->dcHashSize));
+    if( *ppHashSlot != NULL )
+        assert( DCACHE_HASH(pDc, block) ==
+                DCACHE_HASH(pDc, (*ppHashSlot)->block));
 
-        pDesc->pHashNext = *ppHashSlot ;
-        *ppHashSlot =  pDesc ;
-        pDesc->busy = 1;
-        }
+    pDesc->pHashNext = *ppHashSlot ;
+    *ppHashSlot =  pDesc ;
+    pDesc->busy = 1;
 
     return (pDesc );
     }
@@ -1277,18 +1813,20 @@ LOCAL STATUS dcacheBlockFill( CBIO_DEV_ID dev, DCACHE_DESC * pDesc )
             return( stat );
         /* END   - Hidden write handling */
 
-        stat = pDc->dcSubDev->pFuncs->cbioDevBlkRW(
-                    pDc->dcSubDev,
-                    startBlock, numBlks,
-                    pDc->dcBigBufPtr,
-                    CBIO_READ, NULL );
+        stat = dcacheSubRW( dev, startBlock, numBlks,
+                    pDc->dcBigBufPtr, CBIO_READ );
 
         if( stat == ERROR )
             goto read_single ;
 
         pDc->dcLastAccBlock = startBlock + numBlks;
 
-        /* dump each prefetched block into its own block buffer */
+        /*
+         * dump each prefetched block into its own block buffer.
+         * The blocks stay UNSTABLE until all are done, so that the
+         * read-ahead can not reuse the blocks it has just filled,
+         * which are all at the head of the probationary list.
+         */
         do 
             {
             /* calculate how far into the BBlk we need to go */
@@ -1298,10 +1836,8 @@ LOCAL STATUS dcacheBlockFill( CBIO_DEV_ID dev, DCACHE_DESC * pDesc )
             pDesc->state = CB_STATE_UNSTABLE ;
             bcopy( pDc->dcBigBufPtr + off, 
                    pDesc->data , dev->cbioParams.bytesPerBlk );
-            /* make this block MRU */
-            dllRemove( & pDc->dcLru, &pDesc->lruList );
-            dllInsert( & pDc->dcLru, NULL, &pDesc->lruList );
-            pDesc->state = CB_STATE_CLEAN ;
+            /* make this block MRU, it has not been used yet */
+            dcacheBlockTouch( dev, pDesc, FALSE, FALSE );
             
             /* another one is done */
             numBlks -- ; block ++ ; pDesc = NULL ;
@@ -1309,7 +1845,7 @@ LOCAL STATUS dcacheBlockFill( CBIO_DEV_ID dev, DCACHE_DESC * pDesc )
             /* get us more them blocks for read-ahead data */
             if( numBlks > 0)
                 {
-                /* locate block in LRU list, although it shouldn't be there */
+                /* locate block in cache, although it shouldn't be there */
                 if( dcacheBlockLocate(dev, block) != NULL )
                     {
                     break;      /* if found, terminate read-ahead */
@@ -1328,6 +1864,14 @@ LOCAL STATUS dcacheBlockFill( CBIO_DEV_ID dev, DCACHE_DESC * pDesc )
 
             } while (numBlks > 0);
 
+        /* now they may all be used */
+        for( pDesc = (DCACHE_DESC *) DLL_FIRST( & pDc->dcLru ) ;
+             block > startBlock ; block -- )
+            {
+            pDesc->state = CB_STATE_CLEAN ;
+            pDesc = (DCACHE_DESC *) DLL_NEXT( pDesc );
+            }
+
         /* return here if read ahead was successful */
         pDc->dcActTick = tickGet() ;
         return (OK);
@@ -1338,11 +1882,7 @@ LOCAL STATUS dcacheBlockFill( CBIO_DEV_ID dev, DCACHE_DESC * pDesc )
 read_single:
 
     /* get the actual data from disk */
-    stat = pDc->dcSubDev->pFuncs->cbioDevBlkRW(
-            pDc->dcSubDev,
-            pDesc->block, 1,
-            pDesc->data,
-            CBIO_READ, NULL );
+    stat = dcacheSubRW( dev, pDesc->block, 1, pDesc->data, CBIO_READ );
 
     if(stat == ERROR)
         {
@@ -1383,10 +1923,7 @@ LOCAL STATUS dcacheBlkBypassRW
 
     /* NOTE: no need to do change detect here, its been done by ManyInval */
 
-    stat = pDc->dcSubDev->pFuncs->cbioDevBlkRW(
-            pDc->dcSubDev,
-            startBlock, numBlocks, buffer, 
-            rw, NULL );
+    stat = dcacheSubRW( dev, startBlock, numBlocks, buffer, rw );
 
     if(stat == ERROR)
         stat = dcacheErrorHandler( dev, NULL, rw );
@@ -1399,54 +1936,32 @@ LOCAL STATUS dcacheBlkBypassRW
 
 /*******************************************************************************
 *
-* dcacheBlockLocate - locate a block in the cache list
+* dcacheBlockLocate - locate a block in the cache
 *
-* First, search the block in the has table, if that is not
-* possible, find the block in the LRU list.
+* Search the block in the hash table, which always covers all blocks.
 */
 LOCAL DCACHE_DESC * dcacheBlockLocate( CBIO_DEV_ID dev, block_t block )
     {
     FAST DCACHE_DESC *pDesc = NULL;
     FAST struct dcacheCtrl * pDc = dev->pDc ;
 
-    if( pDc->dcHashSize > 0)
-        {
-        /* First, search in hash table */
-        pDesc = pDc->ppDcHashBase [ block % pDc->dcHashSize ] ;
-
-        pDc->dcHashHits ++ ;            /* think positively */
-
-        while( pDesc != NULL )
-            {
-            /* verify all blocks are in correct hash slot */
-            assert( (block % pDc->dcHashSize) == 
-                    (pDesc->block % pDc->dcHashSize) );
-            if( pDesc->block == block )
-                return (pDesc);
-            else
-                pDesc = pDesc->pHashNext ;
-            }
+    pDesc = pDc->ppDcHashBase [ DCACHE_HASH(pDc, block) ] ;
 
-        /* hash miss, block not in cache */
-        pDc->dcHashHits -- ; pDc->dcHashMisses ++ ;
-        return NULL;
-        }
+    pDc->dcHashHits ++ ;            /* think positively */
 
-    /* Now search the LRU list - linear search */
-    pDesc = (DCACHE_DESC *) DLL_FIRST( & pDc->dcLru );
     while( pDesc != NULL )
         {
+        /* verify all blocks are in correct hash slot */
+        assert( DCACHE_HASH(pDc, block) == DCACHE_HASH(pDc, pDesc->block) );
         if( pDesc->block == block )
-            {
-            goto found ;
-            }
-        pDesc = (DCACHE_DESC *) DLL_NEXT(& pDesc->lruList );
+            return (pDesc);
+        else
+            pDesc = pDesc->pHashNext ;
         }
 
+    /* hash miss, block not in cache */
+    pDc->dcHashHits -- ; pDc->dcHashMisses ++ ;
     return NULL;
-
-found:
-    return (pDesc );
     }
 
 /*******************************************************************************
@@ -1571,16 +2086,73 @@ STATUS dcacheDevEnable
     return (OK);
     }
 
+/*******************************************************************************
+*
+* dcacheBlockTouch - make a cache block Most Recently Used
+*
+* The block is moved to the head of its list.  A probationary block is
+* promoted to the protected list if it is metadata, or if <refer> is
+* set and the block has been used before since it was read into the
+* cache.  Read-ahead blocks are touched with <refer> FALSE, so their
+* first real use does not count as a second one.  If the protected list
+* grows beyond its share of the cache, its Least Recently Used blocks are
+* moved back to the head of the probationary list.
+*
+* NOTE: The cbioMutex must already be taken when entering this function.
+*/
+LOCAL void dcacheBlockTouch
+    (
+    CBIO_DEV_ID         dev,
+    DCACHE_DESC *       pDesc,
+    BOOL                refer,          /* block is used by this access */
+    BOOL                meta            /* block is metadata */
+    )
+    {
+    FAST struct dcacheCtrl * pDc = dev->pDc ;
+    FAST DCACHE_DESC * pTmp ;
+
+    dllRemove( DCACHE_LIST(pDc, pDesc), &pDesc->lruList );
+
+    if( meta )
+        pDesc->meta = 1;
+
+    if( !pDesc->prot && (pDesc->meta || (refer && pDesc->ref)) )
+        {
+        pDesc->prot = 1;
+        pDc->dcProtCount ++ ;
+        }
+
+    if( refer )
+        pDesc->ref = 1;
+
+    dllInsert( DCACHE_LIST(pDc, pDesc), NULL, &pDesc->lruList );
+
+    /* keep the protected list within its share */
+    while( pDc->dcProtCount > pDc->dcProtMax )
+        {
+        pTmp = (DCACHE_DESC *) DLL_LAST( & pDc->dcProt );
+
+        dllRemove( & pDc->dcProt, &pTmp->lruList );
+        pTmp->prot = 0;
+        pTmp->ref = 0;
+        pDc->dcProtCount -- ;
+        pDc->dcDemotions ++ ;
+        dllInsert( & pDc->dcLru, NULL, &pTmp->lruList );
+        }
+    }
+
 /*******************************************************************************
 *
 * dcacheBlockGet - get a disc block in a cache block
 *
 * This function is code which is common for reading and writing bytewise
-* as well as reading blockwise.
+* as well as reading blockwise.  <meta> is TRUE for blocks known to be
+* metadata, which are accounted and retained as such; a block already
+* marked as metadata is accounted as metadata in any case.
 * NOTE: The cbioMutex must already be taken when entering this function.
 */
 LOCAL DCACHE_DESC * dcacheBlockGet( CBIO_DEV_ID dev, block_t block,
-        cookie_t * pCookie, BOOL readData )
+        cookie_t * pCookie, BOOL readData, BOOL meta )
     {
     DCACHE_DESC * pDesc = NULL ;
     BOOL allocated = FALSE ;
@@ -1618,14 +2190,17 @@ LOCAL DCACHE_DESC * dcacheBlockGet( CBIO_DEV_ID dev, block_t block,
                 }
             }
 
-    /* locate block in LRU list */
+    /* locate block in cache */
     if( pDesc == NULL)
         pDesc = dcacheBlockLocate(dev, block);
 
     /* block not found, allocate one */
     if( pDesc == NULL)
         {
-        dev->pDc->dcLruMisses ++ ;
+        if( meta )
+            dev->pDc->dcMetaMisses ++ ;
+        else
+            dev->pDc->dcDataMisses ++ ;
         allocated = TRUE ;
         pDesc = dcacheBlockAllocate(dev, block);
 
@@ -1635,11 +2210,19 @@ LOCAL DCACHE_DESC * dcacheBlockGet( CBIO_DEV_ID dev, block_t block,
             return NULL ;
             }
         }
+    else if( meta || pDesc->meta )
+        {
+        dev->pDc->dcMetaHits ++ ;
+        }
     else
         {
-        dev->pDc->dcLruHits ++ ;
+        dev->pDc->dcDataHits ++ ;
         }
 
+    /* remembered in case CBIO_CACHE_META follows for this block */
+    dev->pDc->dcLastDesc = pDesc ;
+    dev->pDc->dcLastMiss = allocated ;
+
     /* if this is a write-only operation,  -> DIRTY shortcut */
     if( ! readData )
         {
@@ -1660,7 +2243,7 @@ LOCAL DCACHE_DESC * dcacheBlockGet( CBIO_DEV_ID dev, block_t block,
 
         if( stat == ERROR)
             {
-            dcacheHashRemove(dev, pDesc);
+            dcacheBlockInval(dev, pDesc);
             /* the disk may have been removed */
             return NULL ;
             }
@@ -1668,9 +2251,8 @@ LOCAL DCACHE_DESC * dcacheBlockGet( CBIO_DEV_ID dev, block_t block,
         assert(pDesc->state == CB_STATE_CLEAN);
         }
 
-    /* make this block MRU */
-    dllRemove( & dev->pDc->dcLru, &pDesc->lruList );
-    dllInsert( & dev->pDc->dcLru, NULL, &pDesc->lruList );
+    /* make this block MRU, possibly promoting it */
+    dcacheBlockTouch( dev, pDesc, TRUE, meta );
 
     if( (pDesc->block == block) )
         {
@@ -1710,6 +2292,7 @@ LOCAL STATUS dcacheBlkRW
     CBIO_DEV *  pDev = (void *) dev ;
     DCACHE_DESC *pDesc;
     STATUS stat = OK ;
+    u_long startTick = tickGet() ;      /* for writer latency */
 
     if( TRUE == cbioRdyChgdGet (dev))
         {
@@ -1771,7 +2354,7 @@ LOCAL STATUS dcacheBlkRW
         CB_STATE saveState ;
 
         /* get that block */
-        pDesc = dcacheBlockGet(pDev, startBlock, pCookie, readData);
+        pDesc = dcacheBlockGet(pDev, startBlock, pCookie, readData, FALSE);
 
         if( pDesc == NULL )
             goto read_error ;
@@ -1803,11 +2386,12 @@ LOCAL STATUS dcacheBlkRW
         buffer += pDev->cbioParams.bytesPerBlk ;
         }       /* end of: For each block req'ed */
 
-    if( dev->pDc->dcDirtyCount > dev->pDc->dcDirtyMax )
-        stat = dcacheManyFlushInval( pDev, 0, NONE, TRUE, FALSE,
-                        & pDev->pDc->dcWritesForeground );
-
     semGive(pDev->cbioMutex);
+
+    /* flushing is left to the updater, unless it is falling behind */
+    if( (rw == CBIO_WRITE) && (stat == OK) )
+        stat = dcacheWriteThrottle( pDev, startTick );
+
     return stat;
 read_error:
     semGive(pDev->cbioMutex);
@@ -1840,6 +2424,7 @@ LOCAL STATUS dcacheBytesRW
     BOOL readData = TRUE;       /* read data from disk, always */
     STATUS stat = OK ;
     CB_STATE saveState ;
+    u_long startTick = tickGet() ;      /* for writer latency */
 
     if( TRUE == cbioRdyChgdGet (pDev))
         {
@@ -1870,7 +2455,7 @@ LOCAL STATUS dcacheBytesRW
         return ERROR;
 
     /* get that block */
-    pDesc = dcacheBlockGet(pDev, startBlock, pCookie, readData);
+    pDesc = dcacheBlockGet(pDev, startBlock, pCookie, readData, FALSE);
 
     if( pDesc == NULL )
         goto _error ;
@@ -1895,11 +2480,12 @@ LOCAL STATUS dcacheBytesRW
             break;
         } /* switch */
 
-    if( pDc->dcDirtyCount > pDc->dcDirtyMax )
-        stat = dcacheManyFlushInval( pDev, 0, NONE, TRUE, FALSE,
-                & pDev->pDc->dcWritesForeground );
-
     semGive(pDev->cbioMutex);
+
+    /* flushing is left to the updater, unless it is falling behind */
+    if( rw == CBIO_WRITE )
+        stat = dcacheWriteThrottle( pDev, startTick );
+
     return stat;
 _error:
     semGive(pDev->cbioMutex);
@@ -1931,6 +2517,7 @@ LOCAL STATUS dcacheBlkCopy
     CBIO_DEV    *pDev = (void *) dev ;
     DCACHE_DESC *pDescSrc, *pDescDst ;
     CB_STATE saveState ;
+    u_long startTick = tickGet() ;      /* for writer latency */
 
     if( TRUE == cbioRdyChgdGet (dev))
         {
@@ -1963,13 +2550,15 @@ LOCAL STATUS dcacheBlkCopy
 
     for( ; numBlocks > 0; numBlocks-- ) /* For each block req'ed */
         {
-        if( dev->pDc->dcDirtyCount > dev->pDc->dcDirtyMax )
+        /* with write-behind, this is left to dcacheWriteThrottle() */
+        if( (dev->pDc->dcDirtyCount > dev->pDc->dcDirtyMax) &&
+            ! DCACHE_ASYNC(dev->pDc) )
             if( dcacheManyFlushInval( pDev, 0, NONE, TRUE, FALSE,
                                     & pDev->pDc->dcWritesForeground) == ERROR )
                 goto _error ;
 
         /* get a source  block , with data in it */
-        pDescSrc = dcacheBlockGet(pDev, srcBlock, NULL, TRUE);
+        pDescSrc = dcacheBlockGet(pDev, srcBlock, NULL, TRUE, FALSE);
 
         if( pDescSrc == NULL )
             goto _error ;
@@ -1979,7 +2568,7 @@ LOCAL STATUS dcacheBlkCopy
                  (pDescSrc->state == CB_STATE_DIRTY) );
 
         /* get a destination  block , with or without data */
-        pDescDst = dcacheBlockGet(pDev, dstBlock, NULL, FALSE);
+        pDescDst = dcacheBlockGet(pDev, dstBlock, NULL, FALSE, FALSE);
 
         if( pDescDst == NULL )
             goto _error ;
@@ -2001,7 +2590,7 @@ LOCAL STATUS dcacheBlkCopy
         }       /* end of: For each block req'ed */
 
     semGive(pDev->cbioMutex);
-    return OK;
+    return( dcacheWriteThrottle( pDev, startTick ) );
 _error:
     semGive(pDev->cbioMutex);
     return ERROR;
@@ -2022,6 +2611,7 @@ _error:
 * CBIO_CACHE_FLUSH - Flush any dirty cached data
 * CBIO_CACHE_INVAL - Flush & Invalidate all cached data
 * CBIO_CACHE_NEWBLK - Allocate scratch block
+* CBIO_CACHE_META - Block holds file system metadata
 *
 * RETURNS OK or ERROR and may otherwise set errno.
 */
@@ -2071,6 +2661,9 @@ LOCAL STATUS dcacheIoctl
     switch ( command )
         {
         case CBIO_RESET :
+            /* let a write-behind in progress complete first */
+            dcacheIoDrain( dev );
+
             /* reset subordinate device, pass along 3rd argument */
 
             pDc->dcSubDev->pFuncs->cbioDevIoctl(pDc->dcSubDev, command, arg);
@@ -2154,11 +2747,37 @@ LOCAL STATUS dcacheIoctl
         case CBIO_CACHE_NEWBLK :        /* Allocate scratch block */
             arg += dev->cbioParams.blockOffset ;
             /* get that block */
-            pDesc = dcacheBlockGet(dev, (block_t) arg, NULL, FALSE);
+            pDesc = dcacheBlockGet(dev, (block_t) arg, NULL, FALSE, FALSE);
             /* zero-fill the block so that unwritten data reads 0s */
             bzero( pDesc->data, dev->cbioParams.bytesPerBlk );
             break ;
 
+        case CBIO_CACHE_META :          /* block holds metadata */
+            arg += dev->cbioParams.blockOffset ;
+            pDesc = dcacheBlockLocate( dev, (block_t) arg );
+
+            if( (pDesc == NULL) || pDesc->meta )
+                break;
+
+            /* the access just before the hint was to metadata too */
+            if( pDesc == pDc->dcLastDesc )
+                {
+                if( pDc->dcLastMiss )
+                    {
+                    pDc->dcDataMisses -- ;
+                    pDc->dcMetaMisses ++ ;
+                    }
+                else
+                    {
+                    pDc->dcDataHits -- ;
+                    pDc->dcMetaHits ++ ;
+                    }
+                pDc->dcLastDesc = NULL ;
+                }
+
+            dcacheBlockTouch( dev, pDesc, FALSE, TRUE );
+            break ;
+
         case CBIO_DEVICE_LOCK :         /* these belong to low-level */
         case CBIO_DEVICE_UNLOCK :
         case CBIO_DEVICE_EJECT :
@@ -2227,6 +2846,11 @@ LOCAL void dcacheTunableVerify( CBIO_DEV_ID dev )
     /* bypass count could be anything, but no less then two */
     pDc->dcBypassCount = max( 2, pDc->dcBypassCount );
 
+    /* protected share - leave some room for probation either way */
+    pDc->dcProtPct = max( DCACHE_PROT_PCT_MIN, pDc->dcProtPct );
+    pDc->dcProtPct = min( DCACHE_PROT_PCT_MAX, pDc->dcProtPct );
+    pDc->dcProtMax = (pDc->dcNumCacheBlocks * pDc->dcProtPct) / 100 ;
+
     /* Only modify if not hand tuned */
     if (pDc->dcIsTuned == FALSE )
         {
@@ -2258,9 +2882,13 @@ LOCAL STATUS dcacheMemInit( CBIO_DEV_ID dev )
     block_t     nBlk ;
     u_long      n ;
     int         sizeBBlk = 0;
+    int         sizeFBlk = 0;
 
-    /* Init LRU list to be empty */
+    /* Init LRU lists to be empty */
     dllInit( & pDc->dcLru );
+    dllInit( & pDc->dcProt );
+    pDc->dcProtCount = 0 ;
+    pDc->dcLastDesc = NULL ;
 
     /* calculate how many blocks we can afford to keep in our cache */
     size = dev->cbioMemSize ;
@@ -2275,7 +2903,15 @@ LOCAL STATUS dcacheMemInit( CBIO_DEV_ID dev )
 
     size -= sizeBBlk * dev->cbioParams.bytesPerBlk ;
 
-    nBlk = size / ( dev->cbioParams.bytesPerBlk + sizeof(DCACHE_DESC) );
+    /* half of it is for the write-behind, which uses it without mutex */
+    if( sizeBBlk >= 4 )
+        sizeFBlk = sizeBBlk / 2 ;
+
+    sizeBBlk -= sizeFBlk ;
+
+    /* leave room for one hash slot per block */
+    nBlk = size / ( dev->cbioParams.bytesPerBlk + sizeof(DCACHE_DESC) +
+                    sizeof(caddr_t) );
 
     pDc->dcNumCacheBlocks               = nBlk ;
 
@@ -2296,7 +2932,18 @@ LOCAL STATUS dcacheMemInit( CBIO_DEV_ID dev )
       pDc->dcReadAhead    = dcacheTunablePresets[n].dcReadAhead;
       pDc->dcSyncInterval = dcacheTunablePresets[n].dcSyncInterval;
       }
-    pDc->dcHashSize     = dcacheTunablePresets[n].dcHashSize;
+
+    if( pDc->dcProtPct == 0 )
+        pDc->dcProtPct  = DCACHE_PROT_PCT_DEF ;
+
+    /*
+     * The hash table is the largest power of two not above the number of
+     * blocks, so chains average at most two blocks at any cache size.
+     */
+    for( pDc->dcHashSize = 1 ; (pDc->dcHashSize << 1) <= nBlk ; )
+        pDc->dcHashSize <<= 1 ;
+
+    pDc->dcHashMask     = pDc->dcHashSize - 1 ;
 
     /* re-calculate the nBlk now accounting for hash table size too */
     size -= pDc->dcHashSize * sizeof(caddr_t) ;
@@ -2326,6 +2973,9 @@ LOCAL STATUS dcacheMemInit( CBIO_DEV_ID dev )
         pDesc->state = CB_STATE_EMPTY ;
         pDesc->data  = data ;
         pDesc->busy = 0;
+        pDesc->prot = 0;
+        pDesc->ref = 0;
+        pDesc->meta = 0;
         pDesc->pHashNext = NULL;
 
         /* add node to list */
@@ -2345,6 +2995,17 @@ LOCAL STATUS dcacheMemInit( CBIO_DEV_ID dev )
 
     data += sizeBBlk * dev->cbioParams.bytesPerBlk ;            /* forw mark */
 
+    /* the write-behind buffer follows */
+    pDc->dcFlushBufSize = sizeFBlk ;
+    if( sizeFBlk > 0)
+        pDc->dcFlushBufPtr = data ;
+    else
+        pDc->dcFlushBufPtr = NULL ;
+
+    pDc->dcFlushCursor = 0 ;
+
+    data += sizeFBlk * dev->cbioParams.bytesPerBlk ;
+
     /* reset of memory is used for hash table */
     pDc->ppDcHashBase = (DCACHE_DESC **) data ;
     data += pDc->dcHashSize * sizeof(caddr_t) ;
@@ -2414,11 +3075,12 @@ LOCAL STATUS dcacheMemInit( CBIO_DEV_ID dev )
 * is too large may decrease the Hit Ratio, thus degrading performance.
 * Passing the value of 0 in this argument preserves the pervious value of
 * the associated parameter.
+*
 * 
 * RETURNS: OK or  ERROR if device handle is invalid.
 * Parameter value which is out of range will be silently corrected.
 *
-* SEE ALSO: dcacheShow()
+* SEE ALSO: dcacheShow(), dcacheDevProtectSet()
 */
 
 STATUS dcacheDevTune
@@ -2461,6 +3123,53 @@ STATUS dcacheDevTune
     dcacheTunableVerify( dev ); /* check and correct for sanity */
 
 
+    semGive(dev->cbioMutex);
+    return OK ;
+    }
+
+/*******************************************************************************
+*
+* dcacheDevProtectSet - set the share of a disk cache kept for reused blocks
+*
+* Blocks which are used more than once while in the cache, and file system
+* metadata blocks, are kept on a protected list which is not used for new
+* blocks until blocks on probation have been exhausted. This function sets
+* the largest share of the cache, in percent, that the protected list may
+* occupy, between 10 and 90. A larger value keeps more of the frequently
+* used blocks across long sequential transfers, a smaller one adapts
+* faster when the working set changes. The default is 75.
+*
+* The value is checked for sanity before being used, hence it is
+* recommended to verify the actual value set with dcacheShow().
+*
+* RETURNS: OK or ERROR if device handle is invalid.
+* Parameter value which is out of range will be silently corrected.
+*
+* SEE ALSO: dcacheShow(), dcacheDevTune()
+*/
+
+STATUS dcacheDevProtectSet
+    (
+    CBIO_DEV_ID dev,            /* device handle */
+    int         protectPct      /* % of cache for frequently used blocks */
+    )
+    {
+    FAST struct dcacheCtrl * pDc = dev->pDc ;
+
+    if( OK != cbioDevVerify(dev))
+        {
+        DEBUG_MSG("dcacheDevProtectSet: invalid handle\n",0,0,0,0,0,0);
+        return ERROR;
+        }
+
+    if( semTake( dev->cbioMutex, WAIT_FOREVER) == ERROR )
+        return ERROR;
+
+    if( protectPct > 0 )
+        pDc->dcProtPct  = protectPct;
+
+    dcacheTunableVerify( dev ); /* check and correct for sanity */
+
     semGive(dev->cbioMutex);
     return OK ;
     }
@@ -2546,7 +3255,7 @@ LOCAL STATUS dacacheDevInit ( CBIO_DEV_ID dev )
         return( ERROR );
         }
 
-    dev->cbioDesc       = "CBIO Disk Data Cache - LRU";
+    dev->cbioDesc       = "CBIO Disk Data Cache - Segmented LRU";
     dev->cbioParams.bytesPerBlk = bytesPerBlk ;
     dev->cbioParams.blockOffset = 0;
     dev->cbioParams.lastErrBlk  = NONE ;
@@ -2565,6 +3274,9 @@ LOCAL STATUS dacacheDevInit ( CBIO_DEV_ID dev )
     dev->cbioParams.blocksPerTrack      = 
                 dev->pDc->dcSubDev->cbioParams.blocksPerTrack ;
 
+    /* the write-behind buffer is about to be carved again */
+    dcacheIoDrain( dev );
+
     dcacheMemInit(dev) ;
 
     return (OK);
@@ -2624,6 +3336,11 @@ LOCAL void dcacheQuickFlush (void)
 *
 * dcacheUpd - disk-cache updater task (lazy writer)
 *
+* Wakes up every quarter second, or when a writer finds that too many
+* blocks are dirty.  Each device is written completely when its sync
+* interval has expired, and down to a quarter of dirtyMax when more than
+* half of dirtyMax blocks are dirty.
+*
 * NOMANUAL
 */
 
@@ -2639,7 +3356,11 @@ void dcacheUpd (void)
         taskPrioritySet(0, dcacheUpdTaskPriority);
 
         /* all update intervals are in seconds, pause a second every time */
-        taskDelay(sysClkRateGet() >> DCACHE_UPD_TASK_GRANULARITY  );
+        if( dcacheUpdSem == NULL )
+            taskDelay(sysClkRateGet() >> DCACHE_UPD_TASK_GRANULARITY  );
+        else
+            (void) semTake( dcacheUpdSem,
+                        sysClkRateGet() >> DCACHE_UPD_TASK_GRANULARITY );
 
         tick = tickGet();
 
@@ -2652,16 +3373,19 @@ void dcacheUpd (void)
                 continue ;
                 }
 
-            /* our time has not come yet or readyChanged is set */
-            if( (dcacheCtrl[i].dcUpdTick > tick ) || 
-                (TRUE == cbioRdyChgdGet (dev)))
+            if( TRUE == cbioRdyChgdGet (dev))
                 {
                 continue ;
                 }
 
-            /* skip the device if its busy now */
-            if( semTake( dev->cbioMutex, NO_WAIT) == ERROR )
+            /* our time has not come yet, but there is much to write */
+            if( dcacheCtrl[i].dcUpdTick > tick )
                 {
+                if( DCACHE_ASYNC( & dcacheCtrl[i] ) &&
+                    (dcacheCtrl[i].dcDirtyCount >
+                        DCACHE_DIRTY_BGND( & dcacheCtrl[i] )) )
+                    (void) dcacheWriteBehind( dev,
+                                DCACHE_DIRTY_LOW( & dcacheCtrl[i] ) );
                 continue ;
                 }
 
@@ -2671,10 +3395,17 @@ void dcacheUpd (void)
 
             if( dcacheCtrl[i].dcDirtyCount > 0 )
                 {
-                (void) dcacheManyFlushInval( dev, 0, NONE, TRUE, FALSE,
-                        & dev->pDc->dcWritesBackground );
+                (void) dcacheWriteBehind( dev, 0 );
+                continue ;
+                }
+
+            /* skip the device if its busy now */
+            if( semTake( dev->cbioMutex, NO_WAIT) == ERROR )
+                {
+                continue ;
                 }
-            else if (dev->cbioParams.cbioRemovable &&(dcacheCtrl[i].dcActTick <
+
+            if (dev->cbioParams.cbioRemovable &&(dcacheCtrl[i].dcActTick <
                                 tick - sysClkRateGet() * DCACHE_IDLE_SECS ))
                 {
                 /* because the device has been idle for some time, */
@@ -2696,7 +3427,9 @@ void dcacheUpd (void)
 *
 * This routine displays various information regarding a disk cache, namely
 * current disk parameters, cache size, tunable parameters and performance
-* statistics. The information is displayed on the standard output.
+* statistics. Hits, misses and evictions are shown separately for metadata,
+* i.e. blocks accessed bytewise, and for data blocks. The information is
+* displayed on the standard output.
 *
 * The <dev> argument is the device handle, if it is NULL,
 * all disk caches are displayed.
@@ -2714,6 +3447,9 @@ void dcacheShow
     int index = 0 ;
     int count = 0  ;
     char state ;
+    u_long hits, misses ;
+    DL_LIST * pList ;
+    int bucket ;
 
     if( dev == NULL )
         {
@@ -2737,9 +3473,11 @@ loop_all:
 
     if( verbose) 
         {
-        printf("Cached block numbers:\n");
+        printf("Cached block numbers (protected first, P - protected):\n");
 
-        for( pTmp = (DCACHE_DESC *) DLL_FIRST( & dev->pDc->dcLru ) ;
+        for( pList = & dev->pDc->dcProt ; pList != NULL ;
+             pList = (pList == & dev->pDc->dcProt) ? & dev->pDc->dcLru : NULL )
+          for( pTmp = (DCACHE_DESC *) DLL_FIRST( pList ) ;
              pTmp != NULL ;
              pTmp = (DCACHE_DESC *) DLL_NEXT( pTmp ) )
             {
@@ -2760,7 +3498,8 @@ loop_all:
                 }
 
             if( verbose && state != ' ' )
-                printf(" blk %ld %c,", pTmp->block, state );
+                printf(" blk %ld %c%s,", pTmp->block, state,
+                        pTmp->prot ? "P" : "" );
             if( verbose && ((count % 8) == 7))
                 printf("\n");
             } /* for*/
@@ -2782,6 +3521,12 @@ loop_all:
             dev->pDc->dcReadAhead,
             dev->pDc->dcSyncInterval
             );
+    printf("   Protected %%%ld, %ld of max %ld blocks, Demotions %ld\n",
+            dev->pDc->dcProtPct,
+            dev->pDc->dcProtCount,
+            dev->pDc->dcProtMax,
+            dev->pDc->dcDemotions
+            );
 
     printf("Hit Stats: Cookie Hits %ld Miss %ld, ",
             dev->pDc->dcCookieHits,
@@ -2790,11 +3535,20 @@ loop_all:
             dev->pDc->dcHashSize,
             dev->pDc->dcHashHits,
             dev->pDc->dcHashMisses);
-    printf("   LRU Hits %ld, Misses %ld, Hit Ratio %%%ld\n",
-        dev->pDc->dcLruHits,
-        dev->pDc->dcLruMisses,
-        (100 * dev->pDc->dcLruHits) /
-                (1 + dev->pDc->dcLruHits + dev->pDc->dcLruMisses)
+    printf("   Meta Hits %ld, Misses %ld, Evictions %ld\n",
+        dev->pDc->dcMetaHits,
+        dev->pDc->dcMetaMisses,
+        dev->pDc->dcMetaEvicts
+        ) ;
+    printf("   Data Hits %ld, Misses %ld, Evictions %ld\n",
+        dev->pDc->dcDataHits,
+        dev->pDc->dcDataMisses,
+        dev->pDc->dcDataEvicts
+        ) ;
+    hits   = dev->pDc->dcMetaHits + dev->pDc->dcDataHits ;
+    misses = dev->pDc->dcMetaMisses + dev->pDc->dcDataMisses ;
+    printf("   Total Hits %ld, Misses %ld, Hit Ratio %%%ld\n",
+        hits, misses, (100 * hits) / (1 + hits + misses)
         ) ;
     printf("Write Sstats: Foreground %ld, Background %ld, "
            "Hidden %ld, Forced %ld\n",
@@ -2802,6 +3556,24 @@ loop_all:
         dev->pDc->dcWritesBackground,
         dev->pDc->dcWritesHidden,
         dev->pDc->dcWritesForced);
+    printf("   Write-behind %s, Throttled %ld, Throttle flushes %ld\n",
+        DCACHE_ASYNC(dev->pDc) ? "on" : "off",
+        dev->pDc->dcThrottles,
+        dev->pDc->dcThrottleFlushes);
+    printf("Writer latency (ticks):");
+    for( bucket = 0 ; bucket < DCACHE_LAT_BUCKETS ; bucket ++ )
+        {
+        if( bucket < 2 )
+            printf("%s%d: %ld", (bucket == 0) ? " " : ", ", bucket,
+                        dev->pDc->dcWriteLat [bucket] );
+        else if( bucket == DCACHE_LAT_BUCKETS - 1 )
+            printf(", %d+: %ld", 1 << (bucket - 1),
+                        dev->pDc->dcWriteLat [bucket] );
+        else
+            printf(", %d-%d: %ld", 1 << (bucket - 1), (1 << bucket) - 1,
+                        dev->pDc->dcWriteLat [bucket] );
+        }
+    printf("\n");
     printf("\n");       /* done */
 
 
@@ -2823,8 +3595,11 @@ void dcacheHashTest( CBIO_DEV_ID dev )
     {
     FAST DCACHE_DESC * pTmp ;
     int count = 0 ;
+    DL_LIST * pList ;
 
-    for( pTmp = (DCACHE_DESC *) DLL_FIRST( & dev->pDc->dcLru ) ;
+    for( pList = & dev->pDc->dcProt ; pList != NULL ;
+         pList = (pList == & dev->pDc->dcProt) ? & dev->pDc->dcLru : NULL )
+      for( pTmp = (DCACHE_DESC *) DLL_FIRST( pList ) ;
          pTmp != NULL ;
          pTmp = (DCACHE_DESC *) DLL_NEXT( pTmp ) )
         {
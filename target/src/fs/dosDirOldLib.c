@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01k,17oct26,agt  directory entries are transferred with dosFsMetaBytesRW()
 01j,29apr02,jkf  SPR#72255, upon file creation, set the create, modification,
                  and access time fields to match creation rather than using
                  the epoch (0).
@@ -824,7 +825,7 @@ getEntry:
     	
     /* read directory entry */
     
-    if( cbioBytesRW( workFd.pVolDesc->pCbio, workFd.curSec,
+    if( dosFsMetaBytesRW( workFd.pVolDesc->pCbio, workFd.curSec,
     		     OFFSET_IN_SEC( workFd.pVolDesc, workFd.pos),
 		     (addr_t)pDirEnt, dirEntSize, CBIO_READ,
     		     &workFd.cbioCookie ) == ERROR )
@@ -1040,7 +1041,7 @@ LOCAL STATUS dosDirOldUpdateEntry
 store:    
     /* store directory entry */
 
-    return cbioBytesRW(
+    return dosFsMetaBytesRW(
     	pFd->pVolDesc->pCbio, pFd->pFileHdl->dirHdl.sector,
     	OFFSET_IN_SEC( pFd->pVolDesc, pFd->pFileHdl->dirHdl.offset ),
 	(addr_t)dirent, pDirDesc->deDesc.dirEntSize, CBIO_WRITE,
@@ -1163,7 +1164,7 @@ LOCAL STATUS dosDirOldFileCreateInDir
     
     if( S_ISREG( creatOpt ) )
     	{
-    	return cbioBytesRW(
+    	return dosFsMetaBytesRW(
     		pFd->pVolDesc->pCbio, pFreeEnt->sector,
 		OFFSET_IN_SEC( pFd->pVolDesc, pFreeEnt->offset ),
     		(addr_t)dirent, dirEntSize, CBIO_WRITE, &cookie );
@@ -1192,7 +1193,7 @@ LOCAL STATUS dosDirOldFileCreateInDir
     	   pDirDesc->deDesc.nameLen + pDirDesc->deDesc.extLen,
     	   SPACE );
     *dirent = DOT;
-    if( cbioBytesRW(
+    if( dosFsMetaBytesRW(
     		pFd->pVolDesc->pCbio, pFd->curSec, 0, (addr_t)dirent,
     		dirEntSize, CBIO_WRITE, &pDirHdl->cookie ) == ERROR )
     	{
@@ -1227,7 +1228,7 @@ LOCAL STATUS dosDirOldFileCreateInDir
     	}
     
     *(dirent + 1) = DOT;
-    if( cbioBytesRW(
+    if( dosFsMetaBytesRW(
     		pFd->pVolDesc->pCbio, pFd->curSec,
 		OFFSET_IN_SEC(  pFd->pVolDesc, pFd->pos ), (addr_t)dirent,
     		dirEntSize, CBIO_WRITE, &pDirHdl->cookie ) == ERROR )
@@ -1242,7 +1243,7 @@ LOCAL STATUS dosDirOldFileCreateInDir
     dosDirOldNameEncode( pDirDesc, pNamePtr, dirent );
     START_CLUST_ENCODE( &pDirDesc->deDesc,
     		        pFd->pFileHdl->startClust,  dirent );
-    if( cbioBytesRW(
+    if( dosFsMetaBytesRW(
     		pFd->pVolDesc->pCbio, pDirHdl->sector,
 		OFFSET_IN_SEC( pFd->pVolDesc, pDirHdl->offset ), 
     		(addr_t)dirent, dirEntSize, CBIO_WRITE,
@@ -1645,7 +1646,7 @@ LOCAL STATUS dosDirOldVolLabel
     
     /* store in root directory */
     
-    status = cbioBytesRW(
+    status = dosFsMetaBytesRW(
     			pVolDesc->pCbio, fd.curSec,
 			OFFSET_IN_SEC( pVolDesc, fd.pos ), (addr_t)dirent, 
     			pDirDesc->deDesc.dirEntSize, CBIO_WRITE,
@@ -6,6 +6,12 @@
 /*
 modification history
 --------------------
+01u,17oct26,agt  fat16MapSet() updates the leaf summary from the runs next to
+                 the cluster instead of scanning the whole leaf
+01t,17oct26,agt  FAT entries are transferred with dosFsMetaBytesRW()
+01s,17oct26,agt  added per file extent maps for seeks within cluster chains
+01r,17oct26,agt  added in-memory free cluster map with a tree of free runs,
+                 used for group, single and contiguous allocation
 01q,10jan02,chn  Renamed some functions to clear up sector/cluster confusion
 01p,10dec01,jkf  SPR#72039, various fixes from Mr. T. Johnson.
 01o,12oct01,jkf  adapted debugging code to be more portable. 
@@ -47,11 +53,36 @@ without the ability to scale out one of these formats for systems which
 do not intend to use them.
 
 IMPLEMENTATION
-This FAT handler does not keep any part of the File Allocation Table in
+This FAT handler does not keep the File Allocation Table itself in
 memory, depending entirely on the underlying CBIO module, typically the
 Disk Cache for the ability to access any FAT entry of any size, i.e.
 byte-wise access to any particular disk sector.
 
+To find free clusters without reading the FAT, a bitmap with one bit per
+cluster is kept in memory, together with a tree which records for each
+span of clusters the longest run of free clusters within it, and the
+free runs at either end.  A run of any number of free clusters at or
+after a given cluster is found by descending the tree, in logarithmic
+time.  The map is built when a FAT12 or FAT16 volume is mounted, because
+the whole FAT is read then to count free clusters anyway, and upon the
+first allocation on a FAT32 volume, whose free count is kept on disk.
+It is updated on every write to the active FAT copy.  It takes one bit
+per cluster, plus 24 bytes per 2048 clusters, e.g. about 1MB for a 32GB
+volume with 4KB clusters; if it can not be allocated, or if the global
+<fatFreeMapEnable> is set to FALSE before mounting, free clusters are
+searched in the FAT as before.
+
+Each open file also has an extent map, a sorted array of the runs of
+contiguous clusters its chain has been found to consist of, from its
+start cluster up to the furthest point walked so far.  It is extended
+whenever the chain is followed past that point, and cut short when the
+file is truncated.  Seeking to a position the map covers takes a binary
+search of the runs instead of following the chain through the FAT,
+which makes random access to large fragmented files cheap.  The maps
+belong to file handles, which are shared by all file descriptors open on
+the same file.  The global <fatExtMapMax> limits the number of runs
+kept per file; setting it to 0 disables the maps.
+
 INITIALIZATION
 */
 
@@ -67,6 +98,7 @@ INITIALIZATION
 #include "stdlib.h"
 #include "stdio.h"
 #include "taskLib.h"
+#include "tickLib.h"
 
 #include "private/print64Lib.h"
 #include "private/dosFsLibP.h"
@@ -147,7 +179,23 @@ INITIALIZATION
 		pFatDesc->entryRead ((pFd), (copy), (entry))
 
 #define ENTRY_WRITE(pFd, copy, entry, value)	\
-		pFatDesc->entryWrite ((pFd), (copy), (entry), (value))
+		fat16EntWriteMap ((pFd), (copy), (entry), (value))
+
+/* free cluster map, one bit per cluster, and a tree leaf per 2048 of them */
+
+#define FAT_MAP_LEAF_SHIFT	11
+#define FAT_MAP_LEAF_CLUSTS	(1 << FAT_MAP_LEAF_SHIFT)
+#define FAT_MAP_LEAF_WORDS	(FAT_MAP_LEAF_CLUSTS >> 5)
+
+#define FAT_MAP_BIT(clust)	((uint32_t) 1 << ((clust) & 31))
+
+/* FAT sectors read at a time while building the map */
+
+#define FAT_MAP_BUILD_SECS	16
+
+/* initial number of runs in a file extent map */
+
+#define FAT_EXT_MAP_INIT	8
 
 
 /* typedefs */
@@ -159,6 +207,10 @@ int     fat16Debug = 0;	/* debug level */
 
 int	fatClugFac = 10000;	/* cluster allocation group size factor */
 
+BOOL	fatFreeMapEnable = TRUE;	/* keep free cluster map in memory */
+
+int	fatExtMapMax = 4096;	/* max runs kept in a file extent map */
+
 
 /* locals */
 
@@ -346,15 +398,15 @@ LOCAL uint32_t fat12EntRead
 
     /* Read entry from disk */
 
-    if (cbioBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, nBytes, CBIO_READ, 
-				&pFd->fatHdl.cbioCookie) != OK)
+    if (dosFsMetaBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, nBytes,
+			  CBIO_READ, &pFd->fatHdl.cbioCookie) != OK)
         {
         pFd->fatHdl.errCode = FAT_CBIO_ERR;
         return FAT_CBIO_ERR;				/* read error */
         }
 
     if (nBytes == 1)
-        if (cbioBytesRW (pCbio, secNum + 1, 0, (addr_t)(&valBuf[1]), 1, 
+        if (dosFsMetaBytesRW (pCbio, secNum + 1, 0, (addr_t)(&valBuf[1]), 1, 
 				CBIO_READ, &pFd->fatHdl.cbioCookie) != OK)
             {
             pFd->fatHdl.errCode = FAT_CBIO_ERR;
@@ -451,12 +503,12 @@ LOCAL STATUS fat12EntWrite
 
     /* Read previous entry value */
 
-    if (cbioBytesRW (pCbio, secNum, secOff,(addr_t) valBuf, nBytes, 
+    if (dosFsMetaBytesRW (pCbio, secNum, secOff,(addr_t) valBuf, nBytes, 
 			CBIO_READ, &cookie) != OK)
         return ERROR;				/* read error */
 
     if (nBytes == 1)
-        if (cbioBytesRW (pCbio, secNum + 1, 0,(addr_t) (&valBuf[1]), 1, 
+        if (dosFsMetaBytesRW (pCbio, secNum + 1, 0,(addr_t) (&valBuf[1]), 1, 
 				CBIO_READ, &pFd->fatHdl.cbioCookie) != OK)
             return ERROR;			/* read error */
 
@@ -475,12 +527,12 @@ LOCAL STATUS fat12EntWrite
 
     /* Write entry to disk */
 
-    if (cbioBytesRW (pCbio, secNum, secOff,(addr_t)valBuf, nBytes, CBIO_WRITE, 
-				&cookie) != OK)
+    if (dosFsMetaBytesRW (pCbio, secNum, secOff,(addr_t)valBuf, nBytes,
+			  CBIO_WRITE, &cookie) != OK)
         return ERROR;
 
     if (nBytes == 1)
-        if (cbioBytesRW (pCbio, secNum + 1, 0, (addr_t)(&valBuf [1]), 1, 
+        if (dosFsMetaBytesRW (pCbio, secNum + 1, 0, (addr_t)(&valBuf [1]), 1, 
 				CBIO_WRITE, &pFd->fatHdl.cbioCookie) != OK)
         return ERROR;
 
@@ -536,7 +588,7 @@ LOCAL uint32_t fat16EntRead
 
     /* Read entry from disk */
 
-    if (cbioBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, 2, CBIO_READ, 
+    if (dosFsMetaBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, 2, CBIO_READ, 
 				&pFd->fatHdl.cbioCookie) != OK)
         {
         pFd->fatHdl.errCode = FAT_CBIO_ERR;
@@ -590,175 +642,1097 @@ LOCAL STATUS fat16EntWrite
 
     entry <<= 1;
 
-    /* Number of sector containing the entry */
+    /* Number of sector containing the entry */
+
+    secNum = pFatDesc->fatStartSec + copyNum * pVolDesc->secPerFat +
+            (entry >> pVolDesc->secSizeShift);
+
+    /* Mirror last modified FAT sector if entry is situated in other sector */
+
+    if (pFd->pFileHdl->fatSector != secNum &&
+        copyNum == pVolDesc->pFatDesc->activeCopyNum)
+        {
+        fat16MirrorSect (pFd);
+        pFd->pFileHdl->fatSector = secNum;
+        }
+
+    /* Offset of the entry in the sector */
+
+    secOff = entry & (pVolDesc->bytesPerSec - 1);
+
+    valBuf [0] = value        & 0xff;	/* this byte gets low bits */
+    valBuf [1] = (value >> 8) & 0xff;	/* next byte gets high bits */
+
+    /* Write entry to disk */
+
+    return dosFsMetaBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, 2,
+			     CBIO_WRITE, &pFd->fatHdl.cbioCookie);
+    } /* fat16EntWrite */
+
+/*******************************************************************************
+* 
+* fat32EntRead - read FAT entry from disk
+* 
+* This routine reads the file allocation table (FAT) entry from a dosFs
+* volume.
+*
+* This routine only reads from the first copy of the FAT on disk, even if
+* other copies exist.
+* 
+* RETURNS: Contents of the entry, or FAT_CBIO_ERR if error accessing disk.
+*/
+
+LOCAL uint32_t fat32EntRead
+    (
+    FAST DOS_FILE_DESC_ID	pFd,	/* pointer to file descriptor */
+    FAST uint32_t		copyNum,/* fat copy number */
+    FAST uint32_t		entry	/* entry number */
+    )
+    {
+    FAST DOS_VOLUME_DESC_ID	pVolDesc = pFd->pVolDesc;
+					/* pointer to volume descriptor */
+    FAST CBIO_DEV_ID		pCbio = pVolDesc->pCbio;
+					/* pointer to CBIO device */
+    FAST MS_FAT_DESC_ID	pFatDesc = (void *) pVolDesc->pFatDesc;
+					/* pointer to FAT descriptor */
+    FAST block_t		secNum;	/* sector number to read/write */
+    FAST off_t			secOff;	/* offset in the sector */
+         uint8_t		valBuf [4];
+         uint8_t		highByteMask = 0x0f;
+
+    /* do not mask high bits when non active copy is being written */
+
+    if (copyNum != pVolDesc->pFatDesc->activeCopyNum)
+    	highByteMask = 0xff;
+					/* buffer for value in the entry */
+
+    assert ( copyNum < pVolDesc->nFats);
+    assert ( (entry >= DOS_MIN_CLUST) && (entry < pFatDesc->nFatEnts) );
+
+    /* Offset of the entry in the FAT in bytes */
+
+    entry <<= 2;
+
+    /* Number of sector containing the entry */
+
+    secNum = pFatDesc->fatStartSec + copyNum * pVolDesc->secPerFat +
+            (entry >> pVolDesc->secSizeShift);
+
+    /* Offset of the entry in the sector */
+
+    secOff = entry & (pVolDesc->bytesPerSec - 1);
+
+    /* Read entry from disk */
+
+    if (dosFsMetaBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, 4, CBIO_READ, 
+			     &pFd->fatHdl.cbioCookie) != OK)
+        {
+        pFd->fatHdl.errCode = FAT_CBIO_ERR;
+        return FAT_CBIO_ERR;				/* read error */
+        }
+
+    return (valBuf [0] | (valBuf [1] << 8) | (valBuf [2] << 16) | 
+            ((valBuf [3] & highByteMask) << 24));/* mask highest 4 bits */
+    } /* fat32EntRead */
+
+/*******************************************************************************
+* 
+* fat32EntWrite - write FAT entry to disk
+* 
+* This routine writes the file allocation table (FAT) entry to a dosFs
+* volume.
+*
+* This routine only writes to the first copy of the FAT on disk, even if
+* other copies exist.
+* 
+* RETURNS: OK, or ERROR if error accessing disk.
+*/
+
+LOCAL STATUS fat32EntWrite
+    (
+    FAST DOS_FILE_DESC_ID	pFd,	/* pointer to file descriptor */
+    FAST uint32_t		copyNum,/* fat copy number */
+    FAST uint32_t		entry,	/* entry number */
+    FAST uint32_t		value	/* value to write */
+    )
+    {
+    FAST DOS_VOLUME_DESC_ID	pVolDesc = pFd->pVolDesc;
+					/* pointer to volume descriptor */
+    FAST CBIO_DEV_ID		pCbio = pVolDesc->pCbio;
+					/* pointer to CBIO device */
+    FAST MS_FAT_DESC_ID	pFatDesc = (void *) pVolDesc->pFatDesc;
+					/* pointer to FAT descriptor */
+    FAST block_t		secNum;	/* sector number to read/write */
+    FAST off_t			secOff;	/* offset in the sector */
+         uint8_t		valBuf [4];
+					/* buffer for value in the entry */
+         uint8_t		highByteMask = 0x0f;
+
+    /* do not mask high bits when non active copy is being written */
+
+    if (copyNum != pVolDesc->pFatDesc->activeCopyNum)
+    	highByteMask = 0xff;
+
+    assert ( copyNum < pVolDesc->nFats);
+    assert ( (entry >= DOS_MIN_CLUST) && (entry < pFatDesc->nFatEnts) );
+    assert ( highByteMask == 0xff ||
+             ( (value == pFatDesc->dos_fat_avail) || 
+               ((value >= DOS_MIN_CLUST) && (value < pFatDesc->nFatEnts)) || 
+               (value == pFatDesc->dos_fat_eof) ) );
+
+    /* Offset of the entry in the FAT in bytes */
+
+    entry <<= 2;
+
+    /* Number of sector containing the entry */
+
+    secNum = pFatDesc->fatStartSec + copyNum * pVolDesc->secPerFat +
+            (entry >> pVolDesc->secSizeShift);
+
+    /* Mirror last modified FAT sector if entry is situated in other sector */
+
+    if (pFd->pFileHdl->fatSector != secNum && highByteMask != 0xff )
+        {
+        fat16MirrorSect (pFd);
+        pFd->pFileHdl->fatSector = secNum;
+        }
+
+    /* Offset of the entry in the sector */
+
+    secOff = entry & (pVolDesc->bytesPerSec - 1);
+
+    valBuf [0] = value         & 0xff;	/*  */
+    valBuf [1] = (value >> 8)  & 0xff;	/*  */
+    valBuf [2] = (value >> 16) & 0xff;	/*  */
+    valBuf [3] = (value >> 24) & highByteMask;	/*  */
+
+    /* Write entry to disk */
+
+    return dosFsMetaBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, 4,
+			     CBIO_WRITE, &pFd->fatHdl.cbioCookie);
+    } /* fat32EntWrite */
+
+/*******************************************************************************
+*
+* fat16MapLeafSum - summarize free runs in one leaf of the free cluster map
+* 
+* RETURNS: N/A.
+*/
+
+LOCAL void fat16MapLeafSum
+    (
+    FAST MS_FAT_DESC_ID	pFatDesc,	/* pointer to FAT descriptor */
+    FAST uint32_t	leaf		/* leaf number */
+    )
+    {
+    FAST uint32_t *	pWord = pFatDesc->pFreeMap + leaf * FAT_MAP_LEAF_WORDS;
+    FAST FAT_MAP_NODE *	pNode = pFatDesc->pMapTree + pFatDesc->mapLeaves + leaf;
+    FAST uint32_t	word;		/* bitmap word */
+    FAST uint32_t	run = 0;	/* free clusters just seen */
+    FAST uint32_t	longest = 0;	/* longest run so far */
+    FAST int		ix;
+    FAST int		bit;
+    BOOL		inPre = TRUE;	/* no allocated cluster seen yet */
+
+    for (ix = 0; ix < FAT_MAP_LEAF_WORDS; ix++)
+        {
+        word = pWord [ix];
+
+        if (word == 0xffffffff)
+            {
+            run += 32;
+            continue;
+            }
+
+        if (word == 0)
+            {
+            /* only the first of these allocated clusters ends a run */
+
+            if (inPre)
+                {
+                pNode->pre = run;
+                inPre = FALSE;
+                }
+
+            if (run > longest)
+                longest = run;
+
+            run = 0;
+            continue;
+            }
+
+        for (bit = 0; bit < 32; bit++, word >>= 1)
+            {
+            if (word & 1)
+                {
+                run++;
+                continue;
+                }
+
+            if (inPre)
+                {
+                pNode->pre = run;
+                inPre = FALSE;
+                }
+
+            if (run > longest)
+                longest = run;
+
+            run = 0;
+            }
+        }
+
+    if (inPre)
+        pNode->pre = run;		/* all of it is free */
+
+    pNode->suf = run;
+    pNode->max = max (longest, run);
+    } /* fat16MapLeafSum */
+
+/*******************************************************************************
+*
+* fat16MapNodeSum - summarize free runs of a tree node from its children
+* 
+* <len> is the number of clusters covered by each of the children.
+*
+* RETURNS: N/A.
+*/
+
+LOCAL void fat16MapNodeSum
+    (
+    MS_FAT_DESC_ID	pFatDesc,	/* pointer to FAT descriptor */
+    uint32_t		node,		/* node number */
+    uint32_t		len		/* clusters in each child */
+    )
+    {
+    FAST FAT_MAP_NODE *	pNode = &pFatDesc->pMapTree [node];
+    FAST FAT_MAP_NODE *	pLeft = &pFatDesc->pMapTree [2 * node];
+    FAST FAT_MAP_NODE *	pRight = pLeft + 1;
+
+    pNode->pre = (pLeft->pre == len) ? len + pRight->pre : pLeft->pre;
+    pNode->suf = (pRight->suf == len) ? len + pLeft->suf : pRight->suf;
+    pNode->max = max (max (pLeft->max, pRight->max),
+                      pLeft->suf + pRight->pre);
+    } /* fat16MapNodeSum */
+
+/*******************************************************************************
+*
+* fat16MapRunUp - count free clusters from a cluster upwards
+* 
+* RETURNS: number of free clusters from <clust> on, stopping before <end>.
+*/
+
+LOCAL uint32_t fat16MapRunUp
+    (
+    MS_FAT_DESC_ID	pFatDesc,	/* pointer to FAT descriptor */
+    FAST uint32_t	clust,		/* first cluster to look at */
+    FAST uint32_t	end		/* cluster not to look at */
+    )
+    {
+    FAST uint32_t *	pMap = pFatDesc->pFreeMap;
+    FAST uint32_t	run = 0;
+
+    while (clust < end)
+        {
+        if (((clust & 31) == 0) && (end - clust >= 32) &&
+            (pMap [clust >> 5] == 0xffffffff))
+            {
+            run += 32;
+            clust += 32;
+            continue;
+            }
+
+        if ((pMap [clust >> 5] & FAT_MAP_BIT (clust)) == 0)
+            break;
+
+        run++;
+        clust++;
+        }
+
+    return run;
+    } /* fat16MapRunUp */
+
+/*******************************************************************************
+*
+* fat16MapRunDown - count free clusters from a cluster downwards
+* 
+* RETURNS: number of free clusters immediately below <clust>, not looking
+* below <first>.
+*/
+
+LOCAL uint32_t fat16MapRunDown
+    (
+    MS_FAT_DESC_ID	pFatDesc,	/* pointer to FAT descriptor */
+    FAST uint32_t	clust,		/* cluster above the ones to look at */
+    FAST uint32_t	first		/* lowest cluster to look at */
+    )
+    {
+    FAST uint32_t *	pMap = pFatDesc->pFreeMap;
+    FAST uint32_t	run = 0;
+
+    while (clust > first)
+        {
+        if (((clust & 31) == 0) && (clust - first >= 32) &&
+            (pMap [(clust >> 5) - 1] == 0xffffffff))
+            {
+            run += 32;
+            clust -= 32;
+            continue;
+            }
+
+        clust--;
+
+        if ((pMap [clust >> 5] & FAT_MAP_BIT (clust)) == 0)
+            break;
+
+        run++;
+        }
+
+    return run;
+    } /* fat16MapRunDown */
+
+/*******************************************************************************
+*
+* fat16MapSet - mark a cluster free or allocated in the free cluster map
+* 
+* The summary of the cluster's leaf is updated from the free runs on
+* either side of the cluster, which are the only ones that change.  Only
+* allocating a cluster in the middle of the leaf's longest run needs the
+* whole leaf to be summarized again.  Each node up to the root is then
+* summarized from its children.
+*
+* The caller must have taken the allocation semaphore.
+*
+* RETURNS: N/A.
+*/
+
+LOCAL void fat16MapSet
+    (
+    FAST MS_FAT_DESC_ID	pFatDesc,	/* pointer to FAT descriptor */
+    FAST uint32_t	clust,		/* cluster number */
+    BOOL		isFree		/* TRUE if cluster is now free */
+    )
+    {
+    FAST uint32_t *	pWord = &pFatDesc->pFreeMap [clust >> 5];
+    FAST uint32_t	bit = FAT_MAP_BIT (clust);
+    uint32_t		leaf = clust >> FAT_MAP_LEAF_SHIFT;
+    uint32_t		first = leaf << FAT_MAP_LEAF_SHIFT;
+    FAT_MAP_NODE *	pNode = &pFatDesc->pMapTree [pFatDesc->mapLeaves + leaf];
+    uint32_t		below;		/* free clusters just below */
+    uint32_t		above;		/* free clusters just above */
+    uint32_t		run;		/* run through <clust> when free */
+    FAST uint32_t	node;
+    FAST uint32_t	len;
+
+    if (((*pWord & bit) != 0) == isFree)
+        return;				/* no change */
+
+    below = fat16MapRunDown (pFatDesc, clust, first);
+    above = fat16MapRunUp (pFatDesc, clust + 1, first + FAT_MAP_LEAF_CLUSTS);
+    run = below + 1 + above;
+
+    if (isFree)
+        {
+        *pWord |= bit;
+
+        /* the runs on either side are joined */
+
+        if (below == clust - first)
+            pNode->pre = run;
+
+        if (above == first + FAT_MAP_LEAF_CLUSTS - 1 - clust)
+            pNode->suf = run;
+
+        if (run > pNode->max)
+            pNode->max = run;
+        }
+    else
+        {
+        *pWord &= ~bit;
+
+        /* the run through <clust> is split */
+
+        if (below == clust - first)
+            pNode->pre = below;
+
+        if (above == first + FAT_MAP_LEAF_CLUSTS - 1 - clust)
+            pNode->suf = above;
+
+        if (run == pNode->max)
+            fat16MapLeafSum (pFatDesc, leaf);	/* may have been the longest */
+        }
+
+    /* summarize each node up to the root */
+
+    for (node = (pFatDesc->mapLeaves + leaf) >> 1,
+         len = FAT_MAP_LEAF_CLUSTS; 
+         node > 0; 
+         node >>= 1, len <<= 1)
+        {
+        fat16MapNodeSum (pFatDesc, node, len);
+        }
+    } /* fat16MapSet */
+
+/*******************************************************************************
+*
+* fat16MapSearch - search a subtree of the free cluster map for a free run
+* 
+* This routine searches the span of <len> clusters starting at <first>,
+* which is covered by <node>, for <number> contiguous free clusters
+* starting at or after cluster <from>.  <pRun> holds the number of free
+* clusters immediately preceding the span, and is updated on return to
+* the number of free clusters at its end.  Subtrees without a long enough
+* run are passed over by their summary, so only the nodes on the paths to
+* <from> and to the run found are descended into.
+*
+* RETURNS: first cluster of the run, or 0 if there is none in this span.
+*/
+
+LOCAL uint32_t fat16MapSearch
+    (
+    FAST MS_FAT_DESC_ID	pFatDesc,	/* pointer to FAT descriptor */
+    uint32_t		node,		/* subtree root */
+    uint32_t		first,		/* first cluster covered by <node> */
+    uint32_t		len,		/* number of clusters covered */
+    uint32_t		from,		/* lowest cluster to start the run */
+    uint32_t		number,		/* number of clusters needed */
+    uint32_t *		pRun		/* free clusters before <first> */
+    )
+    {
+    FAST FAT_MAP_NODE *	pNode = &pFatDesc->pMapTree [node];
+    FAST uint32_t	clust;
+    FAST uint32_t	word;
+    uint32_t		start;
+
+    if (first + len <= from)
+        return 0;			/* all of it is before <from> */
+
+    if (first >= from)
+        {
+        if (*pRun + pNode->pre >= number)
+            return first - *pRun;	/* run spans into this one */
+
+        if (pNode->max < number)
+            {
+            *pRun = (pNode->pre == len) ? *pRun + len : pNode->suf;
+            return 0;
+            }
+        }
+
+    if (node >= pFatDesc->mapLeaves)
+        {
+        /* leaf, look at the bits */
+
+        for (clust = max (first, from); clust < first + len; clust++)
+            {
+            word = pFatDesc->pFreeMap [clust >> 5] >> (clust & 31);
+
+            if ((clust & 31) == 0)
+                {
+                if (word == 0)
+                    {
+                    *pRun = 0;
+                    clust += 31;
+                    continue;
+                    }
+
+                if ((word == 0xffffffff) && (*pRun + 32 < number))
+                    {
+                    *pRun += 32;
+                    clust += 31;
+                    continue;
+                    }
+                }
+
+            if ((word & 1) == 0)
+                *pRun = 0;
+            else if (++(*pRun) >= number)
+                return clust + 1 - *pRun;
+            }
+
+        return 0;
+        }
+
+    len >>= 1;
+
+    start = fat16MapSearch (pFatDesc, 2 * node, first, len,
+                            from, number, pRun);
+    if (start != 0)
+        return start;
+
+    return fat16MapSearch (pFatDesc, 2 * node + 1, first + len, len,
+                           from, number, pRun);
+    } /* fat16MapSearch */
+
+/*******************************************************************************
+*
+* fat16MapFind - find contiguous free clusters in the free cluster map
+* 
+* RETURNS: first cluster of the lowest run of <number> free clusters
+* starting at or after <from>, or 0 if there is none.
+*/
+
+LOCAL uint32_t fat16MapFind
+    (
+    MS_FAT_DESC_ID	pFatDesc,	/* pointer to FAT descriptor */
+    uint32_t		from,		/* lowest cluster to start the run */
+    uint32_t		number		/* number of clusters needed */
+    )
+    {
+    uint32_t		run = 0;
+
+    if ((number == 0) || (pFatDesc->pMapTree [1].max < number))
+        return 0;
+
+    return fat16MapSearch (pFatDesc, 1, 0,
+                           pFatDesc->mapLeaves << FAT_MAP_LEAF_SHIFT,
+                           from, number, &run);
+    } /* fat16MapFind */
+
+/*******************************************************************************
+*
+* fat16MapFree - discard the free cluster map
+* 
+* RETURNS: N/A.
+*/
+
+LOCAL void fat16MapFree
+    (
+    MS_FAT_DESC_ID	pFatDesc	/* pointer to FAT descriptor */
+    )
+    {
+    if (pFatDesc->pFreeMap != NULL)
+        KHEAP_FREE ((char *) pFatDesc->pFreeMap);
+
+    if (pFatDesc->pMapTree != NULL)
+        KHEAP_FREE ((char *) pFatDesc->pMapTree);
+
+    pFatDesc->pFreeMap = NULL;
+    pFatDesc->pMapTree = NULL;
+    pFatDesc->mapLeaves = 0;
+    } /* fat16MapFree */
+
+/*******************************************************************************
+*
+* fat16MapBuild - build the free cluster map from the active FAT copy
+* 
+* FAT16 and FAT32 tables are read a number of sectors at a time, rather
+* than an entry at a time, to keep the cost of building the map close to
+* that of reading the FAT once.  The free clusters counter is set from
+* the map.  The caller must have taken the allocation semaphore.
+*
+* RETURNS: OK, or ERROR if out of memory or error accessing disk.
+*/
+
+LOCAL STATUS fat16MapBuild
+    (
+    FAST DOS_FILE_DESC_ID	pFd	/* pointer to file descriptor */
+    )
+    {
+    FAST DOS_VOLUME_DESC_ID	pVolDesc = pFd->pVolDesc;
+					/* pointer to volume descriptor */
+    FAST MS_FAT_DESC_ID	pFatDesc = (void *) pVolDesc->pFatDesc;
+					/* pointer to FAT descriptor */
+    FAST uint32_t		clust;		/* cluster number */
+    FAST uint32_t		fatEntry;	/* FAT entry */
+    FAST uint8_t *		pEnt;		/* entry in sector buffer */
+    FAST uint32_t		freeCount = 0;	/* free clusters found */
+         uint8_t *		pBuf = NULL;	/* FAT sectors buffer */
+         block_t		secNum;		/* FAT sector to read */
+         uint32_t		nSecs;		/* sectors read at a time */
+         uint32_t		secsLeft;	/* sectors left to read */
+         uint32_t		entSize;	/* bytes per FAT entry */
+         uint32_t		node;
+         uint32_t		len;
+         u_long			startTick = tickGet ();
+
+    /* tree leaves and nodes, for a power of 2 number of leaves */
+
+    pFatDesc->mapLeaves = 1;
+    while ((pFatDesc->mapLeaves << FAT_MAP_LEAF_SHIFT) < pFatDesc->nFatEnts)
+        pFatDesc->mapLeaves <<= 1;
+
+    pFatDesc->pFreeMap = (uint32_t *) KHEAP_ALLOC (pFatDesc->mapLeaves *
+                                   FAT_MAP_LEAF_WORDS * sizeof (uint32_t));
+    pFatDesc->pMapTree = (FAT_MAP_NODE *) KHEAP_ALLOC (2 *
+                                   pFatDesc->mapLeaves * sizeof (FAT_MAP_NODE));
+
+    if ((pFatDesc->pFreeMap == NULL) || (pFatDesc->pMapTree == NULL))
+        goto build_error;
+
+    bzero ((char *) pFatDesc->pFreeMap,
+           pFatDesc->mapLeaves * FAT_MAP_LEAF_WORDS * sizeof (uint32_t));
+
+    entSize = (pVolDesc->fatType == FAT32) ? 4 : 2;
+
+    if (pVolDesc->fatType != FAT12)
+        pBuf = (uint8_t *) KHEAP_ALLOC (FAT_MAP_BUILD_SECS *
+                                        pVolDesc->bytesPerSec);
+
+    if (pBuf == NULL)
+        {
+        /* FAT12 entries straddle sectors, read those one at a time */
+
+        for (clust = DOS_MIN_CLUST; clust < pFatDesc->nFatEnts; clust++)
+            {
+            fatEntry = ENTRY_READ (pFd, pFatDesc->dosFatDesc.activeCopyNum,
+                                   clust);
+
+            if ((fatEntry == FAT_CBIO_ERR) &&
+                (pFd->fatHdl.errCode == FAT_CBIO_ERR))
+                goto build_error;
+
+            if (fatEntry == pFatDesc->dos_fat_avail)
+                {
+                pFatDesc->pFreeMap [clust >> 5] |= FAT_MAP_BIT (clust);
+                freeCount++;
+                }
+            }
+        }
+    else
+        {
+        secNum = pFatDesc->fatStartSec + 
+                 pFatDesc->dosFatDesc.activeCopyNum * pVolDesc->secPerFat;
+        secsLeft = pVolDesc->secPerFat;
+        clust = 0;
+
+        while ((clust < pFatDesc->nFatEnts) && (secsLeft > 0))
+            {
+            nSecs = min (secsLeft, FAT_MAP_BUILD_SECS);
+
+            if (cbioBlkRW (pVolDesc->pCbio, secNum, nSecs, (addr_t) pBuf,
+                           CBIO_READ, NULL) != OK)
+                {
+                KHEAP_FREE ((char *) pBuf);
+                goto build_error;
+                }
+
+            for (pEnt = pBuf;
+                 (pEnt < pBuf + (nSecs << pVolDesc->secSizeShift)) &&
+                 (clust < pFatDesc->nFatEnts);
+                 pEnt += entSize, clust++)
+                {
+                if (entSize == 2)
+                    fatEntry = pEnt [0] | (pEnt [1] << 8);
+                else
+                    fatEntry = (pEnt [0] | (pEnt [1] << 8) | 
+                                (pEnt [2] << 16) | (pEnt [3] << 24)) &
+                               0x0fffffff;
+
+                if ((fatEntry == pFatDesc->dos_fat_avail) &&
+                    (clust >= DOS_MIN_CLUST))
+                    {
+                    pFatDesc->pFreeMap [clust >> 5] |= FAT_MAP_BIT (clust);
+                    freeCount++;
+                    }
+                }
+
+            secNum += nSecs;
+            secsLeft -= nSecs;
+            }
+
+        KHEAP_FREE ((char *) pBuf);
+        }
+
+    /* summarize the leaves, and then the tree, level by level upwards */
+
+    for (node = 0; node < pFatDesc->mapLeaves; node++)
+        fat16MapLeafSum (pFatDesc, node);
+
+    for (node = pFatDesc->mapLeaves >> 1, len = FAT_MAP_LEAF_CLUSTS; 
+         node > 0; 
+         node >>= 1, len <<= 1)
+        {
+        for (clust = node; clust < 2 * node; clust++)
+            fat16MapNodeSum (pFatDesc, clust, len);
+        }
+
+    pFatDesc->fatEntFreeCnt = freeCount;
+    pFatDesc->mapBuildTicks = tickGet () - startTick;
+
+    DBG_MSG (1, "free cluster map: %ld free clusters, %ld ticks\n", 
+             freeCount, pFatDesc->mapBuildTicks,3,4,5,6);
+    return OK;
+
+build_error:
+    fat16MapFree (pFatDesc);
+    pFatDesc->mapFailed = TRUE;
+    return ERROR;
+    } /* fat16MapBuild */
+
+/*******************************************************************************
+*
+* fat16MapCheck - make sure the free cluster map is there
+* 
+* Builds the map upon first use, unless it is disabled or could not be
+* built before.
+*
+* RETURNS: OK if the map may be used, or ERROR.
+*/
+
+LOCAL STATUS fat16MapCheck
+    (
+    DOS_FILE_DESC_ID	pFd	/* pointer to file descriptor */
+    )
+    {
+    MS_FAT_DESC_ID	pFatDesc = (void *) pFd->pVolDesc->pFatDesc;
+    STATUS		stat = OK;
+
+    if (pFatDesc->pFreeMap != NULL)
+        return OK;
+
+    if ((! fatFreeMapEnable) || pFatDesc->mapFailed)
+        return ERROR;
+
+    semTake (pFatDesc->allocSem, WAIT_FOREVER);
+
+    if (pFatDesc->pFreeMap == NULL)
+        stat = fat16MapBuild (pFd);
+
+    semGive (pFatDesc->allocSem);
+
+    return stat;
+    } /* fat16MapCheck */
+
+/*******************************************************************************
+*
+* fat16EntWriteMap - write FAT entry and update free cluster map
+* 
+* All writes of FAT entries go through here, so that the free cluster map
+* follows the active FAT copy.
+*
+* RETURNS: OK, or ERROR if error accessing disk.
+*/
+
+LOCAL STATUS fat16EntWriteMap
+    (
+    FAST DOS_FILE_DESC_ID	pFd,	/* pointer to file descriptor */
+    FAST uint32_t		copyNum,/* fat copy number */
+    FAST uint32_t		entry,	/* entry number */
+    FAST uint32_t		value	/* value to write */
+    )
+    {
+    FAST MS_FAT_DESC_ID	pFatDesc = (void *) pFd->pVolDesc->pFatDesc;
+					/* pointer to FAT descriptor */
+
+    if (pFatDesc->entryWrite (pFd, copyNum, entry, value) != OK)
+        return ERROR;
+
+    if ((pFatDesc->pFreeMap != NULL) &&
+        (copyNum == pFatDesc->dosFatDesc.activeCopyNum))
+        {
+        semTake (pFatDesc->allocSem, WAIT_FOREVER);
+        fat16MapSet (pFatDesc, entry, (value == pFatDesc->dos_fat_avail));
+        semGive (pFatDesc->allocSem);
+        }
+
+    return OK;
+    } /* fat16EntWriteMap */
+
+/*******************************************************************************
+*
+* fat16ExtMapGet - get extent map of file
+* 
+* Extent maps are kept for the file handles of the volume only, not for
+* temporary copies of them.  A map found describing another chain, since
+* the handle was reused or the file was truncated to nothing, is emptied.
+*
+* RETURNS: pointer to extent map, or NULL if there is none for the file.
+*/
+
+LOCAL FAT_EXT_MAP * fat16ExtMapGet
+    (
+    DOS_FILE_DESC_ID	pFd		/* pointer to file descriptor */
+    )
+    {
+    FAST DOS_VOLUME_DESC_ID	pVolDesc = pFd->pVolDesc;
+					/* pointer to volume descriptor */
+    FAST MS_FAT_DESC_ID	pFatDesc = (void *) pVolDesc->pFatDesc;
+					/* pointer to FAT descriptor */
+    FAST DOS_FILE_HDL_ID	pFileHdl = pFd->pFileHdl;
+					/* pointer to file handle */
+    FAST FAT_EXT_MAP *		pMap;
+
+    if ((fatExtMapMax <= 0) || (pFatDesc->pExtMaps == NULL) ||
+        (pFileHdl < pVolDesc->pFhdlList) ||
+        (pFileHdl >= pVolDesc->pFhdlList + pFatDesc->nExtMaps))
+        return NULL;
+
+    pMap = &pFatDesc->pExtMaps [pFileHdl - pVolDesc->pFhdlList];
+
+    if (pMap->startClust != pFileHdl->startClust)
+        {
+        pMap->startClust = pFileHdl->startClust;
+        pMap->nClusts = 0;
+        pMap->nExts = 0;
+        pMap->hint = 0;
+        }
+
+    if ((pMap->startClust < DOS_MIN_CLUST) ||
+        (pMap->startClust >= pFatDesc->nFatEnts))
+        return NULL;
+
+    return pMap;
+    } /* fat16ExtMapGet */
+
+/*******************************************************************************
+*
+* fat16ExtLookup - find the run holding a cluster of file
+* 
+* RETURNS: pointer to run, or NULL if <logClust> is not mapped yet.
+*/
+
+LOCAL FAT_EXTENT * fat16ExtLookup
+    (
+    FAST FAT_EXT_MAP *	pMap,		/* pointer to extent map */
+    FAST uint32_t	logClust	/* cluster number within file */
+    )
+    {
+    FAST FAT_EXTENT *	pExt;
+    FAST uint32_t	low;
+    FAST uint32_t	high;
+    FAST uint32_t	ix;
 
-    secNum = pFatDesc->fatStartSec + copyNum * pVolDesc->secPerFat +
-            (entry >> pVolDesc->secSizeShift);
+    if (logClust >= pMap->nClusts)
+        return NULL;
 
-    /* Mirror last modified FAT sector if entry is situated in other sector */
+    /* try the last run used and the one after it first */
 
-    if (pFd->pFileHdl->fatSector != secNum &&
-        copyNum == pVolDesc->pFatDesc->activeCopyNum)
+    for (ix = pMap->hint; (ix < pMap->nExts) && (ix <= pMap->hint + 1); ix++)
         {
-        fat16MirrorSect (pFd);
-        pFd->pFileHdl->fatSector = secNum;
+        pExt = &pMap->pExt [ix];
+
+        if ((logClust >= pExt->logClust) &&
+            (logClust < pExt->logClust + pExt->nClusts))
+            {
+            pMap->hint = ix;
+            return pExt;
+            }
         }
 
-    /* Offset of the entry in the sector */
+    /* binary search for the last run starting at or before <logClust> */
 
-    secOff = entry & (pVolDesc->bytesPerSec - 1);
+    low = 0;
+    high = pMap->nExts - 1;
 
-    valBuf [0] = value        & 0xff;	/* this byte gets low bits */
-    valBuf [1] = (value >> 8) & 0xff;	/* next byte gets high bits */
+    while (low < high)
+        {
+        ix = (low + high + 1) >> 1;
 
-    /* Write entry to disk */
+        if (pMap->pExt [ix].logClust <= logClust)
+            low = ix;
+        else
+            high = ix - 1;
+        }
 
-    return cbioBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, 2, CBIO_WRITE, 
-				&pFd->fatHdl.cbioCookie);
-    } /* fat16EntWrite */
+    pMap->hint = low;
+    return &pMap->pExt [low];
+    } /* fat16ExtLookup */
 
 /*******************************************************************************
-* 
-* fat32EntRead - read FAT entry from disk
-* 
-* This routine reads the file allocation table (FAT) entry from a dosFs
-* volume.
 *
-* This routine only reads from the first copy of the FAT on disk, even if
-* other copies exist.
+* fat16ExtPhysFind - find the run holding a cluster on disk
 * 
-* RETURNS: Contents of the entry, or FAT_CBIO_ERR if error accessing disk.
+* This routine finds which cluster of the file <physClust> is.  Chains are
+* mostly followed forward, so the last run used and the one after it are
+* looked at first.
+*
+* RETURNS: pointer to run, or NULL if <physClust> is not mapped.
 */
 
-LOCAL uint32_t fat32EntRead
+LOCAL FAT_EXTENT * fat16ExtPhysFind
     (
-    FAST DOS_FILE_DESC_ID	pFd,	/* pointer to file descriptor */
-    FAST uint32_t		copyNum,/* fat copy number */
-    FAST uint32_t		entry	/* entry number */
+    FAST FAT_EXT_MAP *	pMap,		/* pointer to extent map */
+    FAST uint32_t	physClust,	/* cluster number on disk */
+    uint32_t *		pLogClust	/* where to return file cluster */
     )
     {
-    FAST DOS_VOLUME_DESC_ID	pVolDesc = pFd->pVolDesc;
-					/* pointer to volume descriptor */
-    FAST CBIO_DEV_ID		pCbio = pVolDesc->pCbio;
-					/* pointer to CBIO device */
-    FAST MS_FAT_DESC_ID	pFatDesc = (void *) pVolDesc->pFatDesc;
-					/* pointer to FAT descriptor */
-    FAST block_t		secNum;	/* sector number to read/write */
-    FAST off_t			secOff;	/* offset in the sector */
-         uint8_t		valBuf [4];
-         uint8_t		highByteMask = 0x0f;
+    FAST FAT_EXTENT *	pExt;
+    FAST uint32_t	ix;
+    FAST uint32_t	count;
 
-    /* do not mask high bits when non active copy is being written */
+    if (pMap->nExts == 0)
+        return NULL;
 
-    if (copyNum != pVolDesc->pFatDesc->activeCopyNum)
-    	highByteMask = 0xff;
-					/* buffer for value in the entry */
+    for (ix = pMap->hint, count = 0; count < pMap->nExts; count++)
+        {
+        pExt = &pMap->pExt [ix];
 
-    assert ( copyNum < pVolDesc->nFats);
-    assert ( (entry >= DOS_MIN_CLUST) && (entry < pFatDesc->nFatEnts) );
+        if ((physClust >= pExt->physClust) &&
+            (physClust < pExt->physClust + pExt->nClusts))
+            {
+            pMap->hint = ix;
+            *pLogClust = pExt->logClust + (physClust - pExt->physClust);
+            return pExt;
+            }
 
-    /* Offset of the entry in the FAT in bytes */
+        if (++ix == pMap->nExts)
+            ix = 0;
+        }
 
-    entry <<= 2;
+    return NULL;
+    } /* fat16ExtPhysFind */
 
-    /* Number of sector containing the entry */
+/*******************************************************************************
+*
+* fat16ExtAppend - add clusters following the mapped part of a file
+* 
+* Nothing is done unless <logClust> is the first cluster not mapped yet,
+* or if the map is full.
+*
+* RETURNS: N/A.
+*/
 
-    secNum = pFatDesc->fatStartSec + copyNum * pVolDesc->secPerFat +
-            (entry >> pVolDesc->secSizeShift);
+LOCAL void fat16ExtAppend
+    (
+    FAST FAT_EXT_MAP *	pMap,		/* pointer to extent map */
+    uint32_t		logClust,	/* cluster number within file */
+    uint32_t		physClust,	/* cluster number on disk */
+    uint32_t		nClusts		/* number of clusters */
+    )
+    {
+    FAST FAT_EXTENT *	pExt;
+    FAT_EXTENT *	pNew;
+    uint32_t		maxExts;
 
-    /* Offset of the entry in the sector */
+    if ((logClust != pMap->nClusts) || (nClusts == 0))
+        return;
 
-    secOff = entry & (pVolDesc->bytesPerSec - 1);
+    if (pMap->nExts > 0)
+        {
+        pExt = &pMap->pExt [pMap->nExts - 1];
 
-    /* Read entry from disk */
+        if (pExt->physClust + pExt->nClusts == physClust)
+            {
+            pExt->nClusts += nClusts;	/* contiguous with last run */
+            pMap->nClusts += nClusts;
+            return;
+            }
+        }
 
-    if (cbioBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, 4, CBIO_READ, 
-			     &pFd->fatHdl.cbioCookie) != OK)
+    if (pMap->nExts == pMap->maxExts)
         {
-        pFd->fatHdl.errCode = FAT_CBIO_ERR;
-        return FAT_CBIO_ERR;				/* read error */
+        if (pMap->maxExts >= (uint32_t) fatExtMapMax)
+            return;			/* stop mapping this file */
+
+        maxExts = (pMap->maxExts == 0) ? FAT_EXT_MAP_INIT : 
+                                          2 * pMap->maxExts;
+        maxExts = min (maxExts, (uint32_t) fatExtMapMax);
+
+        pNew = (FAT_EXTENT *) KHEAP_REALLOC ((char *) pMap->pExt,
+                                             maxExts * sizeof (FAT_EXTENT));
+        if (pNew == NULL)
+            return;
+
+        pMap->pExt = pNew;
+        pMap->maxExts = maxExts;
         }
 
-    return (valBuf [0] | (valBuf [1] << 8) | (valBuf [2] << 16) | 
-            ((valBuf [3] & highByteMask) << 24));/* mask highest 4 bits */
-    } /* fat32EntRead */
+    pExt = &pMap->pExt [pMap->nExts++];
+    pExt->logClust = logClust;
+    pExt->physClust = physClust;
+    pExt->nClusts = nClusts;
+
+    pMap->nClusts += nClusts;
+    } /* fat16ExtAppend */
 
 /*******************************************************************************
-* 
-* fat32EntWrite - write FAT entry to disk
-* 
-* This routine writes the file allocation table (FAT) entry to a dosFs
-* volume.
 *
-* This routine only writes to the first copy of the FAT on disk, even if
-* other copies exist.
+* fat16ExtTrunc - forget mapping of a file from a cluster onward
 * 
-* RETURNS: OK, or ERROR if error accessing disk.
+* RETURNS: N/A.
 */
 
-LOCAL STATUS fat32EntWrite
+LOCAL void fat16ExtTrunc
     (
-    FAST DOS_FILE_DESC_ID	pFd,	/* pointer to file descriptor */
-    FAST uint32_t		copyNum,/* fat copy number */
-    FAST uint32_t		entry,	/* entry number */
-    FAST uint32_t		value	/* value to write */
+    FAST FAT_EXT_MAP *	pMap,		/* pointer to extent map */
+    FAST uint32_t	logClust	/* first cluster to forget */
     )
     {
-    FAST DOS_VOLUME_DESC_ID	pVolDesc = pFd->pVolDesc;
-					/* pointer to volume descriptor */
-    FAST CBIO_DEV_ID		pCbio = pVolDesc->pCbio;
-					/* pointer to CBIO device */
-    FAST MS_FAT_DESC_ID	pFatDesc = (void *) pVolDesc->pFatDesc;
-					/* pointer to FAT descriptor */
-    FAST block_t		secNum;	/* sector number to read/write */
-    FAST off_t			secOff;	/* offset in the sector */
-         uint8_t		valBuf [4];
-					/* buffer for value in the entry */
-         uint8_t		highByteMask = 0x0f;
+    FAST FAT_EXTENT *	pExt;
 
-    /* do not mask high bits when non active copy is being written */
+    if (logClust >= pMap->nClusts)
+        return;
 
-    if (copyNum != pVolDesc->pFatDesc->activeCopyNum)
-    	highByteMask = 0xff;
+    while (pMap->nExts > 0)
+        {
+        pExt = &pMap->pExt [pMap->nExts - 1];
 
-    assert ( copyNum < pVolDesc->nFats);
-    assert ( (entry >= DOS_MIN_CLUST) && (entry < pFatDesc->nFatEnts) );
-    assert ( highByteMask == 0xff ||
-             ( (value == pFatDesc->dos_fat_avail) || 
-               ((value >= DOS_MIN_CLUST) && (value < pFatDesc->nFatEnts)) || 
-               (value == pFatDesc->dos_fat_eof) ) );
+        if (pExt->logClust < logClust)
+            {
+            pExt->nClusts = logClust - pExt->logClust;
+            break;
+            }
 
-    /* Offset of the entry in the FAT in bytes */
+        pMap->nExts--;
+        }
 
-    entry <<= 2;
+    pMap->nClusts = logClust;
+    pMap->hint = 0;
+    } /* fat16ExtTrunc */
 
-    /* Number of sector containing the entry */
+/*******************************************************************************
+*
+* fat16ExtInval - empty extent maps of a chain
+* 
+* Used when a chain is changed other than through its file handle.
+* <startClust> 0 empties all maps of the volume.
+*
+* RETURNS: N/A.
+*/
 
-    secNum = pFatDesc->fatStartSec + copyNum * pVolDesc->secPerFat +
-            (entry >> pVolDesc->secSizeShift);
+LOCAL void fat16ExtInval
+    (
+    MS_FAT_DESC_ID	pFatDesc,	/* pointer to FAT descriptor */
+    uint32_t		startClust	/* start cluster of chain, or 0 */
+    )
+    {
+    FAST FAT_EXT_MAP *	pMap;
 
-    /* Mirror last modified FAT sector if entry is situated in other sector */
+    if (pFatDesc->pExtMaps == NULL)
+        return;
 
-    if (pFd->pFileHdl->fatSector != secNum && highByteMask != 0xff )
+    for (pMap = pFatDesc->pExtMaps; 
+         pMap < pFatDesc->pExtMaps + pFatDesc->nExtMaps;
+         pMap++)
         {
-        fat16MirrorSect (pFd);
-        pFd->pFileHdl->fatSector = secNum;
+        if ((startClust == 0) || (pMap->startClust == startClust))
+            {
+            pMap->nClusts = 0;
+            pMap->nExts = 0;
+            pMap->hint = 0;
+            }
         }
+    } /* fat16ExtInval */
 
-    /* Offset of the entry in the sector */
+/*******************************************************************************
+*
+* fat16ExtFree - free extent maps of volume
+* 
+* RETURNS: N/A.
+*/
 
-    secOff = entry & (pVolDesc->bytesPerSec - 1);
+LOCAL void fat16ExtFree
+    (
+    MS_FAT_DESC_ID	pFatDesc	/* pointer to FAT descriptor */
+    )
+    {
+    int			ix;
 
-    valBuf [0] = value         & 0xff;	/*  */
-    valBuf [1] = (value >> 8)  & 0xff;	/*  */
-    valBuf [2] = (value >> 16) & 0xff;	/*  */
-    valBuf [3] = (value >> 24) & highByteMask;	/*  */
+    if (pFatDesc->pExtMaps == NULL)
+        return;
 
-    /* Write entry to disk */
+    for (ix = 0; ix < pFatDesc->nExtMaps; ix++)
+        {
+        if (pFatDesc->pExtMaps [ix].pExt != NULL)
+            KHEAP_FREE ((char *) pFatDesc->pExtMaps [ix].pExt);
+        }
 
-    return cbioBytesRW (pCbio, secNum, secOff, (addr_t)valBuf, 4, CBIO_WRITE, 
-				&pFd->fatHdl.cbioCookie);
-    } /* fat32EntWrite */
+    KHEAP_FREE ((char *) pFatDesc->pExtMaps);
+
+    pFatDesc->pExtMaps = NULL;
+    pFatDesc->nExtMaps = 0;
+    } /* fat16ExtFree */
 
 /*******************************************************************************
 *
@@ -803,9 +1777,13 @@ LOCAL STATUS fat16ContigGet
     FAST uint32_t		nextClust;	/* next cluster number */
     FAST uint32_t		cluster;	/* cluster number */
     FAST uint32_t		maxClust;	/* maximum cluster number */
+    FAST FAT_EXT_MAP *		pMap;		/* file extent map */
+    FAST FAT_EXTENT *		pExt = NULL;	/* run holding <startClust> */
+         uint32_t		prevClust;	/* last cluster passed */
+         uint32_t		logClust;	/* cluster number in file */
 
     startClust = nextClust = pFatHdl->nextClust;
-    cluster    = pFatHdl->lastClust;
+    cluster    = prevClust = pFatHdl->lastClust;
 
     if ((startClust < DOS_MIN_CLUST) || (startClust >= pFatDesc->nFatEnts))
         {
@@ -847,24 +1825,60 @@ LOCAL STATUS fat16ContigGet
     else
         {	/* out of contiguous area */
 
-        /* Count number of contiguous clusters starting from <startClust> */
+        if ((pMap = fat16ExtMapGet (pFd)) != NULL)
+            pExt = fat16ExtPhysFind (pMap, startClust, &logClust);
+
+        if (pExt != NULL)
+            {
+            /* the run is in the extent map, take it from there */
+
+            maxClust = pExt->physClust + pExt->nClusts;
+            cluster = min (startClust + numClusts, maxClust);
 
-        maxClust = startClust + numClusts;
-        if (maxClust > pFatDesc->nFatEnts)
-            maxClust = pFatDesc->nFatEnts;
-        cluster = startClust;			/* initialize cluster number */
+            if (cluster < maxClust)
+                nextClust = cluster;
+            else if (pExt < &pMap->pExt [pMap->nExts - 1])
+                nextClust = (pExt + 1)->physClust;
+            else
+                nextClust = ENTRY_READ (pFd, 
+                                        pFatDesc->dosFatDesc.activeCopyNum,
+                                        cluster - 1);	/* end of map */
 
-        while (cluster < maxClust)
+            DBG_MSG (2, "Get from extent map.\n", 1,2,3,4,5,6);
+            }
+        else
             {
-            nextClust = ENTRY_READ (pFd, pFatDesc->dosFatDesc.activeCopyNum,
-                                    cluster);	/* follow chain */
+            /* Count number of contiguous clusters starting from <startClust> */
+
+            maxClust = startClust + numClusts;
+            if (maxClust > pFatDesc->nFatEnts)
+                maxClust = pFatDesc->nFatEnts;
+            cluster = startClust;		/* initialize cluster number */
 
-            if (nextClust != ++cluster)
-                break;				/* end of contiguous area */
+            while (cluster < maxClust)
+                {
+                nextClust = ENTRY_READ (pFd, 
+                                        pFatDesc->dosFatDesc.activeCopyNum,
+                                        cluster);	/* follow chain */
+
+                if (nextClust != ++cluster)
+                    break;			/* end of contiguous area */
+                }
             }
 
         if (pFatHdl->errCode == FAT_CBIO_ERR)
             return ERROR;
+
+        /* Extend the extent map, if the run follows the mapped part */
+
+        if ((pMap != NULL) && (pExt == NULL))
+            {
+            if (startClust == pFileHdl->startClust)
+                fat16ExtAppend (pMap, 0, startClust, cluster - startClust);
+            else if (fat16ExtPhysFind (pMap, prevClust, &logClust) != NULL)
+                fat16ExtAppend (pMap, logClust + 1, startClust, 
+                                cluster - startClust);
+            }
         }
 #ifdef	__unused
     assert ( ((nextClust >= DOS_MIN_CLUST)&&
@@ -1028,6 +2042,29 @@ LOCAL STATUS fat16GetNext
 
     semTake (pFatDesc->allocSem, WAIT_FOREVER);
 
+    if (fat16MapCheck (pFd) == OK)
+        {
+        /* the free cluster map finds the same runs without reading FAT */
+
+        firstClust = fat16MapFind (pFatDesc, startClust, numClusts);
+
+        if (firstClust == 0)
+            firstClust = fat16MapFind (pFatDesc, DOS_MIN_CLUST, numClusts);
+
+        if (firstClust != 0)
+            {
+            contigCount = numClusts;
+            goto group_alloc;
+            }
+
+        firstClust = fat16MapFind (pFatDesc, startClust, 1);
+
+        if (firstClust == 0)
+            firstClust = fat16MapFind (pFatDesc, DOS_MIN_CLUST, 1);
+
+        goto group_alloc_one;
+        }
+
     for (pass = 0; pass < 2; pass++)
         {
         while (curClust <= maxClust)
@@ -1064,6 +2101,8 @@ LOCAL STATUS fat16GetNext
         contigCount = 0;
         } /* for */
 
+group_alloc_one:	/* No group found, allocate a single cluster */
+
     if (firstClust == 0)
         {
         errnoSet (S_dosFsLib_DISK_FULL);
@@ -1159,6 +2198,8 @@ LOCAL STATUS fat16Truncate
     FAST uint32_t		curClust;	/* current cluster */
     FAST uint32_t		nextClust;	/* next cluster in chain */
     FAST uint32_t		cluster;	/* cluster to truncate from */
+    FAST FAT_EXT_MAP *		pMap;		/* file extent map */
+         uint32_t		logClust;	/* cluster number in file */
 
     if (sector == FH_FILE_START)
         {
@@ -1230,6 +2271,15 @@ LOCAL STATUS fat16Truncate
          (curClust >= pFileHdl->startClust) )
         pFileHdl->contigEndPlus1 = curClust;
 
+    /* Forget the freed part of the chain in the extent map */
+
+    if ((pMap = fat16ExtMapGet (pFd)) == NULL)
+        fat16ExtInval (pFatDesc, pFileHdl->startClust);
+    else if (sector == FH_FILE_START)
+        fat16ExtTrunc (pMap, 0);
+    else if (fat16ExtPhysFind (pMap, curClust, &logClust) != NULL)
+        fat16ExtTrunc (pMap, logClust);
+
     if (pFatDesc->groupAllocStart == 0)
         pFatDesc->groupAllocStart = curClust;
 
@@ -1292,6 +2342,10 @@ LOCAL STATUS fat16Seek
     FAST uint32_t		count;		/* count of clusters */
     FAST uint32_t		cluster;	/* cluster to seek from */
     FAST uint32_t		clustOff;	/*  */
+    FAST FAT_EXT_MAP *		pMap = NULL;	/* file extent map */
+    FAST FAT_EXTENT *		pExt;		/* run holding target */
+         uint32_t		logClust = 0;	/* <cluster> number in file */
+         BOOL			logKnown = FALSE;
 
     if (sector == FH_FILE_START)
         {
@@ -1331,6 +2385,37 @@ LOCAL STATUS fat16Seek
 
     sectOff %= pVolDesc->secPerClust;
 
+    /* 
+     * Find the target in the extent map, or else go as far as the map
+     * reaches, and map the rest of the way while following the chain.
+     */
+
+    if ((clustOff > 0) && ((pMap = fat16ExtMapGet (pFd)) != NULL))
+        {
+        if (sector == FH_FILE_START)
+            {
+            logClust = 0;
+            logKnown = TRUE;
+            }
+        else
+            logKnown = (fat16ExtPhysFind (pMap, cluster, &logClust) != NULL);
+
+        if (logKnown && (pMap->nClusts > 0))
+            {
+            count = min (logClust + clustOff, pMap->nClusts - 1);
+            pExt = fat16ExtLookup (pMap, count);
+
+            cluster = pExt->physClust + (count - pExt->logClust);
+            clustOff -= count - logClust;
+            logClust = count;
+
+            if (clustOff == 0)
+                pFatDesc->extHits++;
+            }
+        else if (logKnown)
+            fat16ExtAppend (pMap, 0, cluster, 1);
+        }
+
     /* Skip contiguous area */
 
     if ( (cluster < pFd->pFileHdl->contigEndPlus1) && 
@@ -1339,6 +2424,7 @@ LOCAL STATUS fat16Seek
         count = min (clustOff, pFd->pFileHdl->contigEndPlus1 - cluster - 1);
         cluster += count;
         clustOff -= count;
+        logClust += count;
         }
 
     for (count = 0; count < clustOff; count++)
@@ -1351,6 +2437,11 @@ LOCAL STATUS fat16Seek
         if ((nextClust < DOS_MIN_CLUST) || (nextClust >= pFatDesc->nFatEnts))
             return ERROR;
 
+        pFatDesc->extWalks++;
+
+        if (logKnown)
+            fat16ExtAppend (pMap, ++logClust, nextClust, 1);
+
         cluster = nextClust;			/* do next cluster */
         }
 
@@ -1492,6 +2583,18 @@ LOCAL size_t fat16MaxContigClustersGet
     FAST uint32_t		maxStart;	/*  */
     FAST uint32_t		maxCount;	/*  */
 
+    if (fat16MapCheck (pFd) == OK)
+        {
+        /* the root of the map tree knows the longest free run */
+
+        semTake (pFatDesc->allocSem, WAIT_FOREVER);
+        maxCount = pFatDesc->pMapTree [1].max;
+        *pMaxStart = fat16MapFind (pFatDesc, DOS_MIN_CLUST, maxCount);
+        semGive (pFatDesc->allocSem);
+
+        return (maxCount);
+        }
+
     firstContig = DOS_MIN_CLUST;
     contigCount = 0;
     maxStart    = 0;
@@ -1589,6 +2692,19 @@ LOCAL STATUS fat16ContigAlloc
 
     semTake (pFatDesc->allocSem, WAIT_FOREVER);
 
+    if (fat16MapCheck (pFd) == OK)
+        {
+        bestStart = fat16MapFind (pFatDesc, DOS_MIN_CLUST, number);
+
+        if (bestStart == 0)
+            {
+            errnoSet (S_dosFsLib_NO_CONTIG_SPACE);
+            goto contig_alloc_error;
+            }
+
+        goto contig_alloc;
+        }
+
     for (curClust = DOS_MIN_CLUST; 
     /* firstContig <= (pFatDesc->nFatEnts - number); ??? for 1st fit ??? */
          curClust < (pFatDesc->nFatEnts - number);	
@@ -1716,6 +2832,24 @@ LOCAL void fat16Show
 
     print64Fine (" - free space on volume:	", fat16NFree (&fileDesc), 
                 " bytes\n", 10);
+
+    if (pFatDesc->pFreeMap != NULL)
+        {
+        printf (" - free cluster map:		%ld bytes, built in %ld ticks\n",
+            (pFatDesc->mapLeaves * FAT_MAP_LEAF_WORDS * sizeof (uint32_t)) +
+            (2 * pFatDesc->mapLeaves * sizeof (FAT_MAP_NODE)),
+            pFatDesc->mapBuildTicks);
+        printf (" - largest free extent:	%ld clusters\n",
+            pFatDesc->pMapTree [1].max);
+        }
+    else
+        {
+        printf (" - free cluster map:		%s\n",
+            pFatDesc->mapFailed ? "failed" : "not built");
+        }
+
+    printf (" - seeks from extent maps:	%ld, FAT entries followed: %ld\n",
+        pFatDesc->extHits, pFatDesc->extWalks);
     } /* fat16Show */
 
 /*******************************************************************************
@@ -1736,6 +2870,10 @@ STATUS fat16ClustValueSet
     {
     DOS_VOLUME_DESC_ID	pVolDesc = pFd->pVolDesc;
     MS_FAT_DESC_ID	pFatDesc = (void *) pVolDesc->pFatDesc;
+
+    /* the chain may belong to an open file, forget what is known of it */
+
+    fat16ExtInval (pFatDesc, 0);
     
     switch (value)
         {
@@ -1801,6 +2939,15 @@ STATUS fat16ClustValueSet
     	    	    return ERROR;
     	    	}
 
+    	    /* the free cluster map is rebuilt upon next allocation */
+
+    	    if (copyNum == pFatDesc->dosFatDesc.activeCopyNum)
+    	    	{
+    	    	semTake (pFatDesc->allocSem, WAIT_FOREVER);
+    	    	fat16MapFree (pFatDesc);
+    	    	semGive (pFatDesc->allocSem);
+    	    	}
+
     	    return (OK);
     	    }
 
@@ -1878,6 +3025,14 @@ LOCAL void fat16VolUnmount
     DOS_VOLUME_DESC_ID	pVolDesc	/*  */
     )
     {
+    MS_FAT_DESC_ID	pFatDesc = (void *) pVolDesc->pFatDesc;
+
+    if (pFatDesc != NULL)
+        {
+        fat16MapFree (pFatDesc);
+        fat16ExtFree (pFatDesc);
+        }
+
     return;
     } /* fat16VolUnmount */
 
@@ -1916,6 +3071,13 @@ STATUS fat16VolMount
 
         pVolDesc->pFatDesc->volUnmount( pVolDesc );
         }
+    else if (pVolDesc->pFatDesc != NULL &&
+             pVolDesc->pFatDesc->volUnmount == fat16VolUnmount)
+        {
+        /* discard free cluster map of previous volume */
+
+        fat16VolUnmount (pVolDesc);
+        }
 
     /* Allocate FAT handler descriptor */
 
@@ -2033,6 +3195,31 @@ STATUS fat16VolMount
 	}
 
     pFat16Desc->clustAllocStart = DOS_MIN_CLUST;
+
+    /* extent maps for file handles, files are just not mapped if no memory */
+
+    pFat16Desc->pExtMaps = (FAT_EXT_MAP *) KHEAP_ALLOC (pVolDesc->maxFiles *
+                                                    sizeof (FAT_EXT_MAP));
+    if (pFat16Desc->pExtMaps != NULL)
+        {
+        bzero ((char *) pFat16Desc->pExtMaps,
+               pVolDesc->maxFiles * sizeof (FAT_EXT_MAP));
+        pFat16Desc->nExtMaps = pVolDesc->maxFiles;
+        }
+
+    /*
+     * FAT12/16 tables are small enough to build the free cluster map
+     * right away, which also counts free clusters.  FAT32 volumes get
+     * their free count from FSINFO and build the map upon first
+     * allocation instead, to keep mount time short.
+     */
+
+    if (fatFreeMapEnable && (pVolDesc->fatType != FAT32))
+        {
+        semTake (pFat16Desc->allocSem, WAIT_FOREVER);
+        (void) fat16MapBuild (&fileDesc);
+        semGive (pFat16Desc->allocSem);
+        }
     
     fat16NFree (&fileDesc);	/* fill 'fatEntFreeCnt' if it equals -1 */
 
@@ -6,6 +6,8 @@
 /*
 modification history
 --------------------
+02r,17oct26,agt  added dosFsMetaBytesRW() to mark FAT and directory sectors
+		 as metadata for the disk cache
 02q,02may02,jkf  Corrects SPR#76501, 72603. Avoids 65085 and 33221.
                  and a performance improvement for FIOSYNC.
 02p,30apr02,jkf  SPR#62786, rename should preserve time and date fields
@@ -2134,6 +2136,48 @@ int dosFsVolIsFat12
 	}
     } /* dosFsVolIsFat12 */
 
+/*******************************************************************************
+*
+* dosFsMetaBytesRW - transfer bytes of a FAT or directory sector
+*
+* This routine is cbioBytesRW() for file system metadata.  When the
+* transfer moves <pCookie> to another sector, the CBIO device is told
+* with CBIO_CACHE_META that the sector holds metadata, so that a disk
+* cache may keep it apart from file data.  Further transfers through
+* the same cookie within that sector do not repeat the hint.
+*
+* RETURNS: OK or ERROR.
+*
+* NOMANUAL
+*/
+
+STATUS dosFsMetaBytesRW
+    (
+    CBIO_DEV_ID	pCbio,		/* CBIO handle */
+    block_t	sec,		/* sector of the transfer */
+    off_t	offset,		/* offset into sector in bytes */
+    addr_t	buffer,		/* address of data buffer */
+    size_t	nBytes,		/* number of bytes to transfer */
+    CBIO_RW	rw,		/* direction of transfer R/W */
+    cookie_t *	pCookie		/* pointer to cookie */
+    )
+    {
+    cookie_t	cookie = *pCookie;
+
+    if( cbioBytesRW( pCbio, sec, offset, buffer, nBytes, rw,
+		     pCookie ) == ERROR )
+	{
+	return ERROR;
+	}
+
+    /* only a hint, layers which do not cache may refuse it */
+
+    if( *pCookie != cookie )
+	(void) cbioIoctl( pCbio, CBIO_CACHE_META, (addr_t)sec );
+
+    return OK;
+    } /* dosFsMetaBytesRW */
+
 /*******************************************************************************
 *
 * dosFsVolMount - prepare to use dosFs volume
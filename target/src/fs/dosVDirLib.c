@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01q,17oct26,agt  directory entries are transferred with dosFsMetaBytesRW()
 01p,10dec01,jkf  SPR#72039, various fixes from Mr. T. Johnson.
 01o,09nov01,jkf  SPR#70968, chkdsk destroys boot sector
 01n,21aug01,jkf  SPR#69031, common code for both AE & 5.x.
@@ -1138,7 +1139,7 @@ getEntry:
 
     /* read directory entry */
     
-    if( cbioBytesRW(workFd.pVolDesc->pCbio, workFd.curSec,
+    if( dosFsMetaBytesRW(workFd.pVolDesc->pCbio, workFd.curSec,
     		    OFFSET_IN_SEC( workFd.pVolDesc, workFd.pos ),
 		    (addr_t)pDirEnt, dirEntSize, CBIO_READ,
     		    &workFd.cbioCookie ) == ERROR )
@@ -1196,7 +1197,7 @@ LOCAL STATUS dosVDirDeStore
     
     /* store data */
     
-    if( cbioBytesRW( pVolDesc->pCbio, pFd->curSec,
+    if( dosFsMetaBytesRW( pVolDesc->pCbio, pFd->curSec,
                      OFFSET_IN_SEC( pVolDesc, pFd->pos ) + offset,
     		pData, nBytes, CBIO_WRITE, &pFd->cbioCookie ) == ERROR )
     	{
@@ -1294,7 +1295,7 @@ LOCAL STATUS dosVDirEntryDel
     
     if( nEnt == 0 )
     	{
-        if( cbioBytesRW(pVolDesc->pCbio, workFd.curSec,
+        if( dosFsMetaBytesRW(pVolDesc->pCbio, workFd.curSec,
 		OFFSET_IN_SEC( pVolDesc, workFd.pos ),
     		(addr_t)dirent, DOS_DIRENT_STD_LEN, 
 		CBIO_READ, &cookie ) == ERROR )
@@ -2055,7 +2056,8 @@ LOCAL STATUS dosVDirUpdateEntry
     
     /* store directory entry */
 
-    return cbioBytesRW( pFd->pVolDesc->pCbio, pFd->pFileHdl->dirHdl.sector,
+    return dosFsMetaBytesRW( pFd->pVolDesc->pCbio,
+		pFd->pFileHdl->dirHdl.sector,
     		OFFSET_IN_SEC( pFd->pVolDesc, pFd->pFileHdl->dirHdl.offset ),
 		(addr_t)dirent, pDirDesc->deDesc.dirEntSize, CBIO_WRITE,
     		&pFd->pFileHdl->dirHdl.cookie );
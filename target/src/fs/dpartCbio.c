@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+01t,17oct26,agt  translate the block number of CBIO_CACHE_META
 01s,14jan02,jkf  SPR#72533,dpartDevCreate failed with BLK_DEV, & doc edits.
 01r,12dec01,jkf  fixing diab build warnings.
 01q,09dec01,jkf  SPR#71637, fix for SPR#68387 caused ready changed bugs.
@@ -490,6 +491,7 @@ LOCAL STATUS dpartBlkCopy
 * CBIO_CACHE_FLUSH - Flush any dirty cached data
 * CBIO_CACHE_INVAL - Flush & Invalidate all cached data
 * CBIO_CACHE_NEWBLK - Allocate scratch block
+* CBIO_CACHE_META - Block holds file system metadata
 *
 * 
 * command - ioctl() command being issued
@@ -565,9 +567,10 @@ LOCAL STATUS dpartIoctl
 		    CBIO_READYCHANGED(dev) = FALSE;
 		break;
 
-	/* NEWBLK is the only ioctl where block# is coded in arg */
+	/* NEWBLK and META are the only ioctls where block# is coded in arg */
 
 	case CBIO_CACHE_NEWBLK:
+	case CBIO_CACHE_META:
 	    arg += dev->cbioParams.blockOffset ;
 
 	    /*FALLTHROUGH*/
@@ -43,6 +43,7 @@
 /*
 modification history
 --------------------
+01v,17oct26,agt  queue if_slowtimo() with netJobReservedAdd()
 01u,25apr02,vvv  removed unused ifAttachChange (SPR #74391)
 01t,06mar02,vvv  clean up multicast memberships when interface is detached
 		 (SPR #72486)
@@ -118,7 +119,7 @@ DESCRIPTION
 
 #include "logLib.h"
 
-IMPORT STATUS netJobAdd (FUNCPTR, int, int, int, int, int);
+IMPORT STATUS netJobReservedAdd (FUNCPTR, int, int, int, int, int);
 extern void pfctlinput(int cmd, struct sockaddr * sa);
 extern int sysClkRateGet();
 extern void in_ifaddr_remove ();
@@ -857,7 +858,7 @@ void if_slowtimoRestart
     int stackNum
     )
     {
-    netJobAdd ((FUNCPTR)if_slowtimo, stackNum, 0, 0, 0, 0);
+    netJobReservedAdd ((FUNCPTR)if_slowtimo, stackNum, 0, 0, 0, 0);
     }
 
 /*
@@ -915,7 +916,7 @@ void if_slowtimo
 #ifdef VIRTUAL_STACK
 	    (FUNCPTR) if_slowtimoRestart, (int) stackNum);
 #else
-	    (FUNCPTR) netJobAdd, (int) if_slowtimo);
+	    (FUNCPTR) netJobReservedAdd, (int) if_slowtimo);
 #endif
     }
 
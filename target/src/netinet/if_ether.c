@@ -47,6 +47,7 @@
 /*
 modification history
 --------------------
+01v,17oct26,agt  queue the ARP timer with netJobReservedAdd()
 01u,24jun02,wap  optimize away some bcopy()s in arpresolve()
 01t,21may02,vvv  fixed ARP timer overflow problem (SPR #63908)
 01s,24jan02,vvv  fixed arpintr memory leak (SPR #72577)
@@ -148,7 +149,7 @@ modification history
 
 /* externs */
 
-IMPORT STATUS netJobAdd (FUNCPTR, int, int, int, int, int);
+IMPORT STATUS netJobReservedAdd (FUNCPTR, int, int, int, int, int);
 IMPORT int sysClkRateGet ();
 
 
@@ -234,7 +235,7 @@ void arptimerRestart
     int stackNum
     )
     {
-    netJobAdd ((FUNCPTR)arptimer, stackNum, 0, 0, 0, 0);
+    netJobReservedAdd ((FUNCPTR)arptimer, stackNum, 0, 0, 0, 0);
     }
 
 void arptimer
@@ -271,8 +272,8 @@ arptimer(arg)
     int s = splnet();
     register struct llinfo_arp *la = llinfo_arp.la_next;
 
-    wdStart (arptimerWd, arpt_prune * sysClkRateGet(), (FUNCPTR) netJobAdd,
-	     (int)arptimer);
+    wdStart (arptimerWd, arpt_prune * sysClkRateGet(),
+	     (FUNCPTR) netJobReservedAdd, (int)arptimer);
 
     while (la != &llinfo_arp) 
 	{
@@ -361,7 +362,7 @@ arp_rtrequest(req, rt, sa)
 	 */
 		arpinit_done = 1;
 		arptimerWd = wdCreate ();
-		netJobAdd ((FUNCPTR)arptimer, 0, 0, 0, 0, 0);
+		netJobReservedAdd ((FUNCPTR)arptimer, 0, 0, 0, 0, 0);
 	}
 #endif /* VIRTUAL_STACK */
 	if (rt->rt_flags & RTF_GATEWAY)
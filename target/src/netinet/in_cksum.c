@@ -40,16 +40,275 @@
 /*
 modification history
 --------------------
+01c,17oct26,agt  added word at a time checksum core, in_cksum_partial(),
+                 in_cksum_copy() and in_cksum_copydata()
 01b,12oct01,rae  merge from truestack ver 01c base o1a (compiler warnings)
 01a,03mar96,vin  created from BSD4.4 stuff.
 */
 
+/*
+DESCRIPTION
+This module computes the internet checksum (RFC 1071) of mbuf chains for
+the network stack, and provides primitives to checksum plain buffers and
+to copy data and checksum it in one pass.  The primitives return partial
+sums, folded to 16 bits but not complemented, so that the sums of
+adjacent pieces of a packet may be combined; the <offset> argument gives
+the position of a piece within the packet, of which only the parity
+matters.
+
+When INCHKSUM_PORTABLE is defined, buffers are summed in C, 32 bits at a
+time, with the carries out of the accumulator counted separately and
+folded in at the end.  Otherwise the architecture dependent routine
+cksum() does the summing, and copying is done separately with bcopy().
+*/
+
 #include "vxWorks.h"
 #include "net/systm.h"
 #include "net/mbuf.h"
+#include "stdio.h"
+#include "string.h"
 
 #ifdef INCHKSUM_PORTABLE
-#include "stdio.h"
+
+/* fold a 32 bit one's complement sum to 16 bits */
+
+#define CKSUM_FOLD(x)	{ x = (x >> 16) + (x & 0xffff); \
+			  x = (x >> 16) + (x & 0xffff); \
+			  x = (x >> 16) + (x & 0xffff); }
+
+/* exchange the bytes of a 16 bit sum */
+
+#define CKSUM_SWAP(x)	(((x >> 8) & 0xff) | ((x & 0xff) << 8))
+
+/* add a 32 bit word to the accumulator, counting carries */
+
+#define CKSUM_ADD(acc, carry, w)	{ acc += (w); carry += (acc < (w)); }
+
+/*******************************************************************************
+*
+* in_cksumWords - sum an aligned buffer 32 bits at a time
+*
+* Sums <len> bytes at <p>, which must be 4 byte aligned, as 16 bit words.
+* If <q> is not NULL, the words are copied there as they are summed.
+*
+* RETURNS: the partial sum, folded to 16 bits.
+*
+* NOMANUAL
+*/
+
+LOCAL u_long in_cksumWords
+    (
+    FAST UINT32 *	p,		/* buffer to sum, 4 byte aligned */
+    FAST UINT32 *	q,		/* where to copy it, or NULL */
+    FAST int		len		/* bytes to sum */
+    )
+    {
+    FAST UINT32		acc = 0;	/* one's complement accumulator */
+    FAST UINT32		carry = 0;	/* carries out of <acc> */
+    FAST UINT32		w0;
+    FAST UINT32		w1;
+    FAST UINT32		w2;
+    FAST UINT32		w3;
+    union
+	{
+	u_char	c[2];
+	u_short	s;
+	} u;
+
+    if (q == NULL)
+	{
+	while (len >= 32)
+	    {
+	    w0 = p[0]; w1 = p[1]; w2 = p[2]; w3 = p[3];
+	    CKSUM_ADD (acc, carry, w0); CKSUM_ADD (acc, carry, w1);
+	    CKSUM_ADD (acc, carry, w2); CKSUM_ADD (acc, carry, w3);
+	    w0 = p[4]; w1 = p[5]; w2 = p[6]; w3 = p[7];
+	    CKSUM_ADD (acc, carry, w0); CKSUM_ADD (acc, carry, w1);
+	    CKSUM_ADD (acc, carry, w2); CKSUM_ADD (acc, carry, w3);
+	    p += 8;
+	    len -= 32;
+	    }
+	}
+    else
+	{
+	while (len >= 16)
+	    {
+	    w0 = p[0]; w1 = p[1]; w2 = p[2]; w3 = p[3];
+	    q[0] = w0; q[1] = w1; q[2] = w2; q[3] = w3;
+	    CKSUM_ADD (acc, carry, w0); CKSUM_ADD (acc, carry, w1);
+	    CKSUM_ADD (acc, carry, w2); CKSUM_ADD (acc, carry, w3);
+	    p += 4;
+	    q += 4;
+	    len -= 16;
+	    }
+	}
+
+    while (len >= 4)
+	{
+	w0 = *p++;
+	if (q != NULL)
+	    *q++ = w0;
+	CKSUM_ADD (acc, carry, w0);
+	len -= 4;
+	}
+
+    if (len >= 2)
+	{
+	w0 = *(u_short *) p;
+	if (q != NULL)
+	    *(u_short *) q = (u_short) w0;
+	CKSUM_ADD (acc, carry, w0);
+	p = (UINT32 *) ((u_short *) p + 1);
+	q = (q != NULL) ? (UINT32 *) ((u_short *) q + 1) : NULL;
+	len -= 2;
+	}
+
+    if (len == 1)
+	{
+	u.c[0] = *(u_char *) p;
+	u.c[1] = 0;
+	if (q != NULL)
+	    *(u_char *) q = u.c[0];
+	w0 = u.s;
+	CKSUM_ADD (acc, carry, w0);
+	}
+
+    /* each carry out of 32 bits is worth 1 in one's complement */
+
+    acc = (acc >> 16) + (acc & 0xffff) + carry;
+    CKSUM_FOLD (acc);
+
+    return (acc);
+    }
+
+/*******************************************************************************
+*
+* in_cksumBuf - sum, and optionally copy, a buffer of any alignment
+*
+* RETURNS: <sum> plus the partial sum of the buffer, folded to 16 bits.
+*
+* NOMANUAL
+*/
+
+LOCAL u_long in_cksumBuf
+    (
+    u_long		sum,		/* partial sum so far */
+    u_char *		p,		/* buffer to sum */
+    u_char *		q,		/* where to copy it, or NULL */
+    int			len,		/* bytes to sum */
+    int			offset		/* offset of buffer in packet */
+    )
+    {
+    u_long		acc = 0;
+    BOOL		swap = (offset & 1);
+    union
+	{
+	u_char	c[2];
+	u_short	s;
+	} u;
+
+    if (len <= 0)
+	return (sum);
+
+    /*
+     * Sum from an even address.  A buffer at an odd address is summed
+     * as if it had a zero byte in front, which shifts every byte to the
+     * other half of its word, so the result has to be swapped back.
+     */
+
+    if ((u_long) p & 1)
+	{
+	u.c[0] = 0;
+	u.c[1] = *p++;
+	if (q != NULL)
+	    *q++ = u.c[1];
+	acc = u.s;
+	len--;
+	swap = !swap;
+	}
+
+    if (((u_long) p & 2) && (len >= 2))
+	{
+	acc += *(u_short *) p;
+	if (q != NULL)
+	    {
+	    q[0] = p[0];
+	    q[1] = p[1];
+	    q += 2;
+	    }
+	p += 2;
+	len -= 2;
+	}
+
+    if ((q == NULL) || ((((u_long) q) & 3) == 0))
+	acc += in_cksumWords ((UINT32 *) p, (UINT32 *) q, len);
+    else
+	{
+	/* destination is not aligned alike, copy separately */
+
+	bcopy ((char *) p, (char *) q, len);
+	acc += in_cksumWords ((UINT32 *) p, NULL, len);
+	}
+
+    CKSUM_FOLD (acc);
+
+    if (swap)
+	acc = CKSUM_SWAP (acc);
+
+    sum += acc;
+    CKSUM_FOLD (sum);
+
+    return (sum);
+    }
+
+/*******************************************************************************
+*
+* in_cksum_partial - add the checksum of a buffer to a partial sum
+*
+* This routine adds the one's complement sum of the <len> bytes at <buf>
+* to <sum>, which is the partial sum of the packet the buffer is part of,
+* and <offset> is the position of the buffer within the packet.
+*
+* RETURNS: partial sum, folded to 16 bits.
+*
+* NOMANUAL
+*/
+
+u_long in_cksum_partial
+    (
+    u_long		sum,		/* partial sum so far */
+    caddr_t		buf,		/* buffer to sum */
+    int			len,		/* bytes to sum */
+    int			offset		/* offset of buffer in packet */
+    )
+    {
+    return (in_cksumBuf (sum, (u_char *) buf, NULL, len, offset));
+    }
+
+/*******************************************************************************
+*
+* in_cksum_copy - copy a buffer and add its checksum to a partial sum
+*
+* This routine copies <len> bytes from <src> to <dst>, reading the data
+* once, and adds their one's complement sum to the partial sum <sum>, as
+* in_cksum_partial() does.  The buffers must not overlap.
+*
+* RETURNS: partial sum, folded to 16 bits.
+*
+* NOMANUAL
+*/
+
+u_long in_cksum_copy
+    (
+    caddr_t		src,		/* buffer to copy and sum */
+    caddr_t		dst,		/* where to copy it */
+    int			len,		/* bytes to copy */
+    u_long		sum,		/* partial sum so far */
+    int			offset		/* offset of buffer in packet */
+    )
+    {
+    return (in_cksumBuf (sum, (u_char *) src, (u_char *) dst, len, offset));
+    }
 
 /*
  * Checksum routine for Internet Protocol family headers (Portable Version).
@@ -58,108 +317,26 @@ modification history
  * code and should be modified for each CPU to be as fast as possible.
  */
 
-#define ADDCARRY(x)  (x > 65535 ? x -= 65535 : x)
-#define REDUCE {l_util.l = sum; sum = l_util.s[0] + l_util.s[1]; ADDCARRY(sum);}
-
 int
 in_cksum(m, len)
 	register struct mbuf *m;
 	register int len;
 {
-	register u_short *w;
-	register int sum = 0;
-	register int mlen = 0;
-	int byte_swapped = 0;
-
-	union {
-		char	c[2];
-		u_short	s;
-	} s_util;
-	union {
-		u_short s[2];
-		long	l;
-	} l_util;
+	register int mlen;
+	register int off = 0;
+	u_long sum = 0;
 
 	for (;m && len; m = m->m_next) {
-		if (m->m_len == 0)
+		if ((mlen = m->m_len) == 0)
 			continue;
-		w = mtod(m, u_short *);
-		if (mlen == -1) {
-			/*
-			 * The first byte of this mbuf is the continuation
-			 * of a word spanning between this mbuf and the
-			 * last mbuf.
-			 *
-			 * s_util.c[0] is already saved when scanning previous 
-			 * mbuf.
-			 */
-			s_util.c[1] = *(char *)w;
-			sum += s_util.s;
-			w = (u_short *)((char *)w + 1);
-			mlen = m->m_len - 1;
-			len--;
-		} else
-			mlen = m->m_len;
 		if (len < mlen)
 			mlen = len;
+		sum = in_cksumBuf(sum, mtod(m, u_char *), NULL, mlen, off);
+		off += mlen;
 		len -= mlen;
-		/*
-		 * Force to even boundary.
-		 */
-		if ((1 & (int) w) && (mlen > 0)) {
-			REDUCE;
-			sum <<= 8;
-			s_util.c[0] = *(u_char *)w;
-			w = (u_short *)((char *)w + 1);
-			mlen--;
-			byte_swapped = 1;
-		}
-		/*
-		 * Unroll the loop to make overhead from
-		 * branches &c small.
-		 */
-		while ((mlen -= 32) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			sum += w[4]; sum += w[5]; sum += w[6]; sum += w[7];
-			sum += w[8]; sum += w[9]; sum += w[10]; sum += w[11];
-			sum += w[12]; sum += w[13]; sum += w[14]; sum += w[15];
-			w += 16;
-		}
-		mlen += 32;
-		while ((mlen -= 8) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			w += 4;
-		}
-		mlen += 8;
-		if (mlen == 0 && byte_swapped == 0)
-			continue;
-		REDUCE;
-		while ((mlen -= 2) >= 0) {
-			sum += *w++;
-		}
-		if (byte_swapped) {
-			REDUCE;
-			sum <<= 8;
-			byte_swapped = 0;
-			if (mlen == -1) {
-				s_util.c[1] = *(char *)w;
-				sum += s_util.s;
-				mlen = 0;
-			} else
-				mlen = -1;
-		} else if (mlen == -1)
-			s_util.c[0] = *(char *)w;
 	}
 	if (len)
 		printf("cksum: out of data\n");
-	if (mlen == -1) {
-		/* The last mbuf has odd # of bytes. Follow the
-		   standard (the odd byte may be shifted left by 8 bits
-		   or not as determined by endian-ness of the machine) */
-		s_util.c[1] = 0;
-		sum += s_util.s;
-	}
-	REDUCE;
 	return (~sum & 0xffff);
 }
 
@@ -204,4 +381,105 @@ int in_cksum (m, len)
     return (~sum & 0xffff);
     }
 
+/*******************************************************************************
+*
+* in_cksum_partial - add the checksum of a buffer to a partial sum
+*
+* This routine adds the one's complement sum of the <len> bytes at <buf>
+* to <sum>, which is the partial sum of the packet the buffer is part of,
+* and <offset> is the position of the buffer within the packet.
+*
+* RETURNS: partial sum, folded to 16 bits.
+*
+* NOMANUAL
+*/
+
+u_long in_cksum_partial
+    (
+    u_long		sum,		/* partial sum so far */
+    caddr_t		buf,		/* buffer to sum */
+    int			len,		/* bytes to sum */
+    int			offset		/* offset of buffer in packet */
+    )
+    {
+    if (len <= 0)
+	return (sum);
+
+    return ((u_long) cksum ((int) sum, (u_short *) buf, len, offset));
+    }
+
+/*******************************************************************************
+*
+* in_cksum_copy - copy a buffer and add its checksum to a partial sum
+*
+* This routine copies <len> bytes from <src> to <dst> and adds their one's
+* complement sum to the partial sum <sum>, as in_cksum_partial() does.
+* The architecture dependent cksum() sums the copy while it is still in
+* the data cache.
+*
+* RETURNS: partial sum, folded to 16 bits.
+*
+* NOMANUAL
+*/
+
+u_long in_cksum_copy
+    (
+    caddr_t		src,		/* buffer to copy and sum */
+    caddr_t		dst,		/* where to copy it */
+    int			len,		/* bytes to copy */
+    u_long		sum,		/* partial sum so far */
+    int			offset		/* offset of buffer in packet */
+    )
+    {
+    bcopy (src, dst, len);
+    return (in_cksum_partial (sum, dst, len, offset));
+    }
+
 #endif /* INCHKSUM_PORTABLE */
+
+/*******************************************************************************
+*
+* in_cksum_copydata - copy data out of an mbuf chain and checksum it
+*
+* This routine copies <len> bytes starting <off> bytes into the mbuf chain
+* <m> to the buffer <cp>, like m_copydata(), and adds their sum to the
+* partial sum <sum>.  <cksumOff> is the offset of the data within the
+* packet that is being checksummed.
+*
+* RETURNS: partial sum, folded to 16 bits.
+*
+* NOMANUAL
+*/
+
+u_long in_cksum_copydata
+    (
+    FAST struct mbuf *	m,		/* chain to copy from */
+    FAST int		off,		/* where to start in chain */
+    FAST int		len,		/* bytes to copy */
+    FAST caddr_t	cp,		/* where to copy to */
+    u_long		sum,		/* partial sum so far */
+    int			cksumOff	/* offset of data in packet */
+    )
+    {
+    FAST int		count;
+
+    while ((m != NULL) && (off >= m->m_len))
+	{
+	off -= m->m_len;
+	m = m->m_next;
+	}
+
+    while ((m != NULL) && (len > 0))
+	{
+	count = min (m->m_len - off, len);
+	sum = in_cksum_copy (mtod (m, caddr_t) + off, cp, count, sum,
+			     cksumOff);
+	cp += count;
+	cksumOff += count;
+	len -= count;
+	off = 0;
+	m = m->m_next;
+	}
+
+    return (sum);
+    }
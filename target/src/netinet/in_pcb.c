@@ -41,6 +41,8 @@
 /*
 modification history
 --------------------
+01h,17oct26,agt  added a local port hash for in_pcblookup() and the
+		 ephemeral port search in in_pcbbind()
 01g,12oct01,rae  merge from truestack ver 01k, base 01f (SPR #69867 etc.)
 01f,05oct97,vin  changed ip_freemoptions for new multicasting changes.
 01e,01jul97,vin  added rtMissMsgHook for scalability of routing sockets.
@@ -89,6 +91,39 @@ struct	in_addr   zeroin_addr;
 #define IN_IFADDR in_ifaddr
 #endif
 
+#ifndef VIRTUAL_STACK
+/*
+ * Every PCB with a local port is also on a chain of the port hash table,
+ * keyed on the port and the pcbinfo it belongs to, so that in_pcblookup()
+ * -- the wildcard lookup used by in_pcbbind() to check a requested port
+ * and to find a free ephemeral one -- only looks at the PCBs bound to the
+ * port it wants instead of every PCB of the protocol.  The chain linkage
+ * is kept after the struct inpcb, in the same MT_PCB buffer, and is
+ * brought up to date by in_pcbrehash() whenever the local port changes.
+ */
+
+#define INP_PORTHASH_SIZE	512		/* must be a power of 2 */
+#define INP_PORTHASH(pcbinfo, lport)					\
+	((((u_long)(pcbinfo) >> 4) ^ (lport) ^ ((lport) >> 9))		\
+	 & (INP_PORTHASH_SIZE - 1))
+
+struct inpportext
+    {
+    struct inpcb *	px_next;	/* next PCB in port hash bucket */
+    struct inpcb **	px_pprev;	/* link to this PCB */
+    u_short		px_lport;	/* port hashed under, 0 if none */
+    };
+
+#define INP_PORTEXT(inp)	((struct inpportext *)((inp) + 1))
+#define INP_EXTLEN		sizeof (struct inpportext)
+
+LOCAL struct inpcb *	inPortHashTbl [INP_PORTHASH_SIZE];
+
+LOCAL void in_pcbporthash (struct inpcb * inp);
+#else
+#define INP_EXTLEN		0
+#endif /* VIRTUAL_STACK */
+
 #ifdef WV_INSTRUMENTATION
 #ifdef INCLUDE_WVNET
     /* Set common fields of event identifiers for this module. */
@@ -108,7 +143,8 @@ in_pcballoc(so, pcbinfo)
 	register struct inpcb *inp;
 	int s;
 
-	MALLOC(inp, struct inpcb *, sizeof(*inp), MT_PCB, M_DONTWAIT);
+	MALLOC(inp, struct inpcb *, sizeof(*inp) + INP_EXTLEN, MT_PCB,
+	    M_DONTWAIT);
 	if (inp == NULL)
             {
 #ifdef WV_INSTRUMENTATION
@@ -120,7 +156,7 @@ in_pcballoc(so, pcbinfo)
 
             return (ENOBUFS);
             }
-	bzero((caddr_t)inp, sizeof(*inp));
+	bzero((caddr_t)inp, sizeof(*inp) + INP_EXTLEN);
 	inp->inp_pcbinfo = pcbinfo;
 	inp->inp_socket = so;
 	s = splnet();
@@ -544,6 +580,10 @@ in_pcbdetach(inp)
 	s = splnet();
 	LIST_REMOVE(inp, inp_hash);
 	LIST_REMOVE(inp, inp_list);
+#ifndef VIRTUAL_STACK
+	inp->inp_lport = 0;
+	in_pcbporthash(inp);
+#endif /* VIRTUAL_STACK */
 	splx(s);
 	FREE(inp, MT_PCB);
 }
@@ -730,10 +770,25 @@ in_pcblookup(pcbinfo, faddr, fport_arg, laddr, lport_arg, wild_okay)
 	int matchwild = 3, wildcard;
 	u_short fport = fport_arg, lport = lport_arg;
 	int s;
+#ifndef VIRTUAL_STACK
+	int byport = (lport != 0);
+#endif /* VIRTUAL_STACK */
 
 	s = splnet();
 
+#ifdef VIRTUAL_STACK
 	for (inp = pcbinfo->listhead->lh_first; inp != NULL; inp = inp->inp_list.le_next) {
+#else
+	/*
+	 * PCBs without a local port are not in the port hash; an
+	 * unbound lookup still has to search the whole list.
+	 */
+	for (inp = byport ? inPortHashTbl[INP_PORTHASH(pcbinfo, lport)] :
+	    pcbinfo->listhead->lh_first; inp != NULL;
+	    inp = byport ? INP_PORTEXT(inp)->px_next : inp->inp_list.le_next) {
+		if (inp->inp_pcbinfo != pcbinfo)
+			continue;
+#endif /* VIRTUAL_STACK */
 		if (inp->inp_lport != lport)
 			continue;
 		wildcard = 0;
@@ -861,5 +916,53 @@ in_pcbrehash(inp)
 		inp->inp_lport, inp->inp_fport, inp->inp_pcbinfo->hashmask)];
 
 	LIST_INSERT_HEAD(head, inp, inp_hash);
+#ifndef VIRTUAL_STACK
+	in_pcbporthash(inp);
+#endif /* VIRTUAL_STACK */
 	splx(s);
 }
+
+#ifndef VIRTUAL_STACK
+/*******************************************************************************
+*
+* in_pcbporthash - move a PCB to the port hash chain for its local port
+*
+* This routine puts <inp> on the port hash chain for its current local
+* port, taking it off the chain for the port it was last hashed under.
+* A PCB whose local port is zero is on no chain.  Must be called at
+* splnet.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void in_pcbporthash
+    (
+    struct inpcb *		inp		/* PCB to move */
+    )
+    {
+    struct inpportext *		pExt = INP_PORTEXT (inp);
+    struct inpcb **		ppHead;
+
+    if (pExt->px_lport == inp->inp_lport)
+	return;
+
+    if (pExt->px_lport != 0)
+	{
+	if (pExt->px_next != NULL)
+	    INP_PORTEXT (pExt->px_next)->px_pprev = pExt->px_pprev;
+	*pExt->px_pprev = pExt->px_next;
+	}
+
+    if ((pExt->px_lport = inp->inp_lport) != 0)
+	{
+	ppHead = &inPortHashTbl [INP_PORTHASH (inp->inp_pcbinfo,
+					       inp->inp_lport)];
+	if ((pExt->px_next = *ppHead) != NULL)
+	    INP_PORTEXT (pExt->px_next)->px_pprev = &pExt->px_next;
+	pExt->px_pprev = ppHead;
+	*ppHead = inp;
+	}
+    }
+#endif /* VIRTUAL_STACK */
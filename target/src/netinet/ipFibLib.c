@@ -0,0 +1,780 @@
+/* ipFibLib.c - compiled IP forwarding table */
+
+/* Copyright 2002 Wind River Systems, Inc. */
+#include "copyright_wrs.h"
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  written.
+*/
+
+/*
+DESCRIPTION
+This library keeps a compiled copy of the AF_INET routing table, built
+for fast longest-prefix lookups, alongside the radix tree.  It is a
+multibit trie with a stride of eight bits: a prefix of length <len> is
+stored, expanded, in the node at level (<len> - 1) / 8, so that a lookup
+makes at most four indexed loads and no backtracking.
+
+The library installs itself in front of the rnh_addaddr, rnh_deladdr and
+rnh_matchaddr routines of the AF_INET radix head.  Every route added to
+or deleted from the tree, by rtrequest() or otherwise, is therefore
+reflected in the trie as it happens, and route lookups by rtalloc1(),
+rtalloc2() and routeLookup() use the trie.
+
+The radix key of an AF_INET route also includes the TOS bits and the
+sin_zero bytes of the sockaddr_in.  The trie only holds routes whose key
+has zero in those bytes, and only answers lookups whose key has zero in
+them, which is the case for forwarded traffic and for all TOS 0 traffic;
+other lookups are passed to rn_match() as before.  If the tree holds a
+route the trie cannot represent exactly, such as one with a
+non-contiguous mask, all lookups are passed to rn_match() until it is
+removed.  The same happens if memory for the trie runs out; the trie is
+then rebuilt from the tree at the next route change.
+
+Setting 'ipFibEnabled' to FALSE makes all lookups use rn_match(); the
+trie is still maintained.
+
+INCLUDE FILES:
+
+SEE ALSO: routeLib
+*/
+
+#include "vxWorks.h"
+#include "stdio.h"
+#include "net/mbuf.h"
+#include "sys/socket.h"
+#include "net/socketvar.h"
+#include "net/route.h"
+#include "net/radix.h"
+#include "net/systm.h"
+#include "netinet/in.h"
+
+/* defines */
+
+#define IP_FIB_STRIDE		8		/* bits per level */
+#define IP_FIB_SLOTS		(1 << IP_FIB_STRIDE)
+#define IP_FIB_LEVELS		(32 / IP_FIB_STRIDE)
+#define IP_FIB_HASH_SIZE	1024		/* prefix table, power of 2 */
+
+#define IP_FIB_MASK(len)	\
+	((len) == 0 ? 0 : (u_long) (0xffffffffUL << (32 - (len))))
+
+#define IP_FIB_HASH(prefix, len)					\
+	((((prefix) >> 20) ^ ((prefix) >> 10) ^ (prefix) ^ (len))	\
+	 & (IP_FIB_HASH_SIZE - 1))
+
+/* typedefs */
+
+typedef struct ipFibSlot	/* one entry of a trie node */
+    {
+    struct radix_node *	pLeaf;		/* best route of this level */
+    struct ipFibNode *	pChild;		/* node for longer prefixes */
+    u_char		len;		/* prefix length of pLeaf */
+    } IP_FIB_SLOT;
+
+typedef struct ipFibNode	/* a trie node */
+    {
+    IP_FIB_SLOT		slot [IP_FIB_SLOTS];
+    int			used;		/* slots with a route or child */
+    } IP_FIB_NODE;
+
+typedef struct ipFibRoute	/* a route known to the trie */
+    {
+    struct ipFibRoute *	pNext;		/* next in hash chain */
+    struct radix_node *	pLeaf;		/* the route's radix leaf */
+    u_long		prefix;		/* address, host order */
+    int			len;		/* prefix length */
+    BOOL		contig;		/* FALSE if mask not contiguous */
+    BOOL		inTrie;		/* FALSE if not in trie */
+    } IP_FIB_ROUTE;
+
+/* globals */
+
+BOOL	ipFibEnabled = TRUE;		/* use the trie for lookups */
+u_long	ipFibLookups;			/* lookups answered by the trie */
+u_long	ipFibPassed;			/* lookups passed to rn_match() */
+
+/* locals */
+
+LOCAL struct radix_node_head *	ipFibHead;	/* AF_INET radix head */
+LOCAL IP_FIB_NODE *		ipFibRoot;	/* level 0 node */
+LOCAL struct radix_node *	ipFibDefault;	/* route for 0/0 */
+LOCAL IP_FIB_ROUTE **		ipFibHashTbl;	/* routes by prefix */
+LOCAL BOOL			ipFibValid;	/* trie matches the tree */
+LOCAL int			ipFibUnsafe;	/* routes not in the trie */
+LOCAL int			ipFibRoutes;	/* routes in the trie */
+LOCAL int			ipFibNodes;	/* trie nodes allocated */
+
+LOCAL struct radix_node * (*ipFibAddRtn) ();	/* original rnh_addaddr */
+LOCAL struct radix_node * (*ipFibDelRtn) ();	/* original rnh_deladdr */
+LOCAL struct radix_node * (*ipFibMatchRtn) ();	/* original rnh_matchaddr */
+
+/* forward declarations */
+
+LOCAL struct radix_node * ipFibAddAddr (void * v, void * mask,
+					struct radix_node_head * head,
+					struct radix_node nodes[]);
+LOCAL struct radix_node * ipFibDelAddr (void * v, void * mask,
+					struct radix_node_head * head);
+LOCAL struct radix_node * ipFibMatchAddr (void * v,
+					  struct radix_node_head * head);
+LOCAL BOOL	ipFibKeyGet (struct radix_node * pLeaf, u_long * pPrefix,
+			     int * pLen, BOOL * pContig);
+LOCAL void	ipFibRouteAdd (struct radix_node * pLeaf);
+LOCAL void	ipFibRouteDel (struct radix_node * pLeaf);
+LOCAL STATUS	ipFibTrieAdd (IP_FIB_ROUTE * pRoute);
+LOCAL void	ipFibTrieDel (IP_FIB_ROUTE * pRoute);
+LOCAL IP_FIB_ROUTE * ipFibRouteFind (u_long prefix, int len);
+LOCAL void	ipFibNodeFree (IP_FIB_NODE * pNode);
+LOCAL void	ipFibFlush (void);
+LOCAL int	ipFibRebuildOne (struct radix_node * pLeaf, void * arg);
+LOCAL void	ipFibRebuild (void);
+
+/*******************************************************************************
+*
+* ipFibInit - attach the compiled forwarding table to the AF_INET routes
+*
+* This routine is called by route_init() once the AF_INET radix tree has
+* been created.  It builds the trie from the routes already in the tree
+* and installs the routines that keep it up to date.
+*
+* RETURNS: OK, or ERROR if there is no memory for the prefix table.
+*
+* NOMANUAL
+*/
+
+STATUS ipFibInit
+    (
+    struct radix_node_head *	pHead		/* AF_INET radix head */
+    )
+    {
+    int		s;
+
+    if (pHead == NULL || ipFibHead != NULL)
+	return (ERROR);
+
+    R_Malloc (ipFibHashTbl, IP_FIB_ROUTE **,
+	      IP_FIB_HASH_SIZE * sizeof (IP_FIB_ROUTE *));
+    if (ipFibHashTbl == NULL)
+	return (ERROR);
+    Bzero (ipFibHashTbl, IP_FIB_HASH_SIZE * sizeof (IP_FIB_ROUTE *));
+
+    s = splnet ();
+
+    ipFibHead = pHead;
+    ipFibAddRtn = pHead->rnh_addaddr;
+    ipFibDelRtn = pHead->rnh_deladdr;
+    ipFibMatchRtn = pHead->rnh_matchaddr;
+
+    ipFibRebuild ();
+
+    pHead->rnh_addaddr = ipFibAddAddr;
+    pHead->rnh_deladdr = ipFibDelAddr;
+    pHead->rnh_matchaddr = ipFibMatchAddr;
+
+    splx (s);
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* ipFibAddAddr - add a route to the radix tree and to the trie
+*
+* RETURNS: the radix leaf of the new route, or NULL.
+*
+* NOMANUAL
+*/
+
+LOCAL struct radix_node * ipFibAddAddr
+    (
+    void *			v,		/* key */
+    void *			mask,		/* netmask, or NULL */
+    struct radix_node_head *	head,		/* radix head */
+    struct radix_node		nodes[]		/* nodes of new route */
+    )
+    {
+    struct radix_node *		pLeaf;
+
+    if ((pLeaf = (*ipFibAddRtn) (v, mask, head, nodes)) == NULL)
+	return (NULL);
+
+    if (ipFibValid)
+	ipFibRouteAdd (pLeaf);
+    else
+	ipFibRebuild ();
+
+    return (pLeaf);
+    }
+
+/*******************************************************************************
+*
+* ipFibDelAddr - delete a route from the radix tree and from the trie
+*
+* RETURNS: the radix leaf of the deleted route, or NULL.
+*
+* NOMANUAL
+*/
+
+LOCAL struct radix_node * ipFibDelAddr
+    (
+    void *			v,		/* key */
+    void *			mask,		/* netmask, or NULL */
+    struct radix_node_head *	head		/* radix head */
+    )
+    {
+    struct radix_node *		pLeaf;
+
+    if ((pLeaf = (*ipFibDelRtn) (v, mask, head)) == NULL)
+	return (NULL);
+
+    if (ipFibValid)
+	ipFibRouteDel (pLeaf);
+    else
+	ipFibRebuild ();
+
+    return (pLeaf);
+    }
+
+/*******************************************************************************
+*
+* ipFibMatchAddr - find the best route for a destination
+*
+* A lookup with a plain key -- zero TOS and zero sin_zero -- is answered
+* from the trie; anything else, or any lookup while the trie does not
+* represent the tree exactly, is passed to rn_match().
+*
+* RETURNS: the radix leaf of the best matching route, or NULL.
+*
+* NOMANUAL
+*/
+
+LOCAL struct radix_node * ipFibMatchAddr
+    (
+    void *			v,		/* key */
+    struct radix_node_head *	head		/* radix head */
+    )
+    {
+    struct sockaddr_in *	pDst = (struct sockaddr_in *) v;
+    u_char *			pKey = (u_char *) v;
+    struct radix_node *		pBest;
+    IP_FIB_NODE *		pNode;
+    IP_FIB_SLOT *		pSlot;
+    u_long			addr;
+    int				shift;
+
+    if (!ipFibEnabled || !ipFibValid || ipFibUnsafe != 0 ||
+	pDst->sin_len != sizeof (struct sockaddr_in) || pKey[3] != 0 ||
+	((u_long *) pDst->sin_zero)[0] != 0 ||
+	((u_long *) pDst->sin_zero)[1] != 0)
+	{
+	ipFibPassed++;
+	return ((*ipFibMatchRtn) (v, head));
+	}
+
+    ipFibLookups++;
+
+    addr = ntohl (pDst->sin_addr.s_addr);
+    pBest = ipFibDefault;
+
+    for (pNode = ipFibRoot, shift = 32 - IP_FIB_STRIDE; pNode != NULL;
+	 pNode = pSlot->pChild, shift -= IP_FIB_STRIDE)
+	{
+	pSlot = &pNode->slot [(addr >> shift) & (IP_FIB_SLOTS - 1)];
+	if (pSlot->pLeaf != NULL)
+	    pBest = pSlot->pLeaf;
+	}
+
+    return (pBest);
+    }
+
+/*******************************************************************************
+*
+* ipFibKeyGet - get the IPv4 prefix of a radix leaf
+*
+* This routine works out the prefix and length that a route matches for
+* plain keys.  The route's key is the masked destination, starting with
+* the TOS byte at offset 3; the mask is NULL for host routes, and its
+* first byte gives its length.
+*
+* RETURNS: FALSE if the route can never match a plain key.
+*
+* NOMANUAL
+*/
+
+LOCAL BOOL ipFibKeyGet
+    (
+    struct radix_node *	pLeaf,		/* radix leaf of route */
+    u_long *		pPrefix,	/* where to return prefix */
+    int *		pLen,		/* where to return prefix length */
+    BOOL *		pContig		/* where to return mask contiguity */
+    )
+    {
+    u_char *		pKey = (u_char *) pLeaf->rn_key;
+    u_char *		pMask = (u_char *) pLeaf->rn_mask;
+    int			keyLen;
+    u_long		mask;
+    int			ix;
+
+    if (pKey[3] != 0)
+	return (FALSE);			/* TOS route */
+
+    keyLen = (pMask == NULL) ? sizeof (struct sockaddr_in) : pMask[0];
+    for (ix = 8; ix < keyLen; ix++)
+	if (pKey[ix] != 0)
+	    return (FALSE);		/* key in sin_zero */
+
+    mask = 0;
+    for (ix = 4; ix < 8; ix++)
+	{
+	mask <<= 8;
+	if (pMask == NULL)
+	    mask |= 0xff;
+	else if (ix < keyLen)
+	    mask |= pMask[ix];
+	}
+
+    *pPrefix = ntohl (((struct sockaddr_in *) pKey)->sin_addr.s_addr) & mask;
+
+    for (*pLen = 0; *pLen < 32 && (mask & (0x80000000UL >> *pLen)); (*pLen)++)
+	;
+    *pContig = (mask == IP_FIB_MASK (*pLen));
+
+    return (TRUE);
+    }
+
+/*******************************************************************************
+*
+* ipFibRouteFind - find the route for a prefix that is in the trie
+*
+* RETURNS: the route, or NULL.
+*
+* NOMANUAL
+*/
+
+LOCAL IP_FIB_ROUTE * ipFibRouteFind
+    (
+    u_long		prefix,		/* prefix, host order */
+    int			len		/* prefix length */
+    )
+    {
+    IP_FIB_ROUTE *	pRoute;
+
+    for (pRoute = ipFibHashTbl [IP_FIB_HASH (prefix, len)]; pRoute != NULL;
+	 pRoute = pRoute->pNext)
+	if (pRoute->prefix == prefix && pRoute->len == len && pRoute->inTrie)
+	    return (pRoute);
+
+    return (NULL);
+    }
+
+/*******************************************************************************
+*
+* ipFibRouteAdd - enter a route just added to the radix tree
+*
+* A route with a non-contiguous mask, or a second route for a prefix
+* already in the trie (the radix tree can tell them apart by TOS mask
+* bits or sin_zero mask bytes), is recorded but not put in the trie, and
+* lookups go to rn_match() while it exists.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void ipFibRouteAdd
+    (
+    struct radix_node *	pLeaf		/* radix leaf of route */
+    )
+    {
+    IP_FIB_ROUTE *	pRoute;
+    u_long		prefix;
+    int			len;
+    BOOL		contig;
+
+    if (!ipFibKeyGet (pLeaf, &prefix, &len, &contig))
+	return;
+
+    R_Malloc (pRoute, IP_FIB_ROUTE *, sizeof (IP_FIB_ROUTE));
+    if (pRoute == NULL)
+	{
+	ipFibFlush ();
+	return;
+	}
+
+    pRoute->pLeaf = pLeaf;
+    pRoute->prefix = prefix;
+    pRoute->len = len;
+    pRoute->contig = contig;
+    pRoute->inTrie = FALSE;
+    pRoute->pNext = ipFibHashTbl [IP_FIB_HASH (prefix, len)];
+    ipFibHashTbl [IP_FIB_HASH (prefix, len)] = pRoute;
+
+    if (!contig || ipFibRouteFind (prefix, len) != NULL)
+	{
+	ipFibUnsafe++;
+	return;
+	}
+
+    pRoute->inTrie = TRUE;
+    if (ipFibTrieAdd (pRoute) != OK)
+	ipFibFlush ();
+    }
+
+/*******************************************************************************
+*
+* ipFibRouteDel - remove a route just deleted from the radix tree
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void ipFibRouteDel
+    (
+    struct radix_node *	pLeaf		/* radix leaf of route */
+    )
+    {
+    IP_FIB_ROUTE **	ppRoute;
+    IP_FIB_ROUTE *	pRoute;
+    IP_FIB_ROUTE *	pTwin;
+    u_long		prefix;
+    int			len;
+    BOOL		contig;
+
+    if (!ipFibKeyGet (pLeaf, &prefix, &len, &contig))
+	return;
+
+    for (ppRoute = &ipFibHashTbl [IP_FIB_HASH (prefix, len)];
+	 (pRoute = *ppRoute) != NULL; ppRoute = &pRoute->pNext)
+	if (pRoute->pLeaf == pLeaf)
+	    break;
+
+    if (pRoute == NULL)
+	return;
+
+    *ppRoute = pRoute->pNext;
+
+    if (!pRoute->inTrie)
+	{
+	ipFibUnsafe--;
+	Free (pRoute);
+	return;
+	}
+
+    ipFibTrieDel (pRoute);
+    Free (pRoute);
+
+    /* a twin for the same prefix can now go in the trie */
+
+    for (pTwin = ipFibHashTbl [IP_FIB_HASH (prefix, len)]; pTwin != NULL;
+	 pTwin = pTwin->pNext)
+	{
+	if (pTwin->prefix == prefix && pTwin->len == len && pTwin->contig)
+	    {
+	    ipFibUnsafe--;
+	    pTwin->inTrie = TRUE;
+	    if (ipFibTrieAdd (pTwin) != OK)
+		ipFibFlush ();
+	    break;
+	    }
+	}
+    }
+
+/*******************************************************************************
+*
+* ipFibTrieAdd - put a route in the trie
+*
+* The route replaces, in each slot its prefix covers, any route of a
+* shorter prefix at the same level.
+*
+* RETURNS: OK, or ERROR if a node could not be allocated.
+*
+* NOMANUAL
+*/
+
+LOCAL STATUS ipFibTrieAdd
+    (
+    IP_FIB_ROUTE *	pRoute		/* route to add */
+    )
+    {
+    IP_FIB_NODE **	ppNode = &ipFibRoot;
+    IP_FIB_NODE *	pNode;
+    IP_FIB_SLOT *	pSlot;
+    int			level;
+    int			shift;
+    int			ix;
+    int			last;
+
+    ipFibRoutes++;
+
+    if (pRoute->len == 0)
+	{
+	ipFibDefault = pRoute->pLeaf;
+	return (OK);
+	}
+
+    for (level = 0; ; level++)
+	{
+	if ((pNode = *ppNode) == NULL)
+	    {
+	    R_Malloc (pNode, IP_FIB_NODE *, sizeof (IP_FIB_NODE));
+	    if (pNode == NULL)
+		return (ERROR);
+	    Bzero (pNode, sizeof (IP_FIB_NODE));
+	    ipFibNodes++;
+	    *ppNode = pNode;
+	    }
+
+	shift = 32 - IP_FIB_STRIDE * (level + 1);
+	ix = (pRoute->prefix >> shift) & (IP_FIB_SLOTS - 1);
+
+	if (pRoute->len <= IP_FIB_STRIDE * (level + 1))
+	    break;
+
+	pSlot = &pNode->slot [ix];
+	if (pSlot->pLeaf == NULL && pSlot->pChild == NULL)
+	    pNode->used++;
+	ppNode = &pSlot->pChild;
+	}
+
+    last = ix + (1 << (IP_FIB_STRIDE * (level + 1) - pRoute->len));
+
+    for (; ix < last; ix++)
+	{
+	pSlot = &pNode->slot [ix];
+	if (pSlot->pLeaf == NULL)
+	    {
+	    if (pSlot->pChild == NULL)
+		pNode->used++;
+	    }
+	else if (pSlot->len > pRoute->len)
+	    continue;
+	pSlot->pLeaf = pRoute->pLeaf;
+	pSlot->len = pRoute->len;
+	}
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* ipFibTrieDel - take a route out of the trie
+*
+* Each slot that held the route gets the next longest prefix of the same
+* level that covers it, if there is one.  Nodes left empty are freed.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void ipFibTrieDel
+    (
+    IP_FIB_ROUTE *	pRoute		/* route to delete */
+    )
+    {
+    IP_FIB_NODE *	pPath [IP_FIB_LEVELS];
+    IP_FIB_NODE *	pNode;
+    IP_FIB_SLOT *	pSlot;
+    IP_FIB_ROUTE *	pCover;
+    u_long		addr;
+    int			level;
+    int			shift;
+    int			ix;
+    int			last;
+    int			len;
+
+    ipFibRoutes--;
+
+    if (pRoute->len == 0)
+	{
+	ipFibDefault = NULL;
+	return;
+	}
+
+    level = (pRoute->len - 1) / IP_FIB_STRIDE;
+    pNode = ipFibRoot;
+    for (ix = 0; ix < level && pNode != NULL; ix++)
+	{
+	pPath [ix] = pNode;
+	shift = 32 - IP_FIB_STRIDE * (ix + 1);
+	pNode = pNode->slot [(pRoute->prefix >> shift) & (IP_FIB_SLOTS - 1)].pChild;
+	}
+    if (pNode == NULL)
+	return;
+    pPath [level] = pNode;
+
+    shift = 32 - IP_FIB_STRIDE * (level + 1);
+    ix = (pRoute->prefix >> shift) & (IP_FIB_SLOTS - 1);
+    last = ix + (1 << (IP_FIB_STRIDE * (level + 1) - pRoute->len));
+
+    for (; ix < last; ix++)
+	{
+	pSlot = &pNode->slot [ix];
+	if (pSlot->pLeaf != pRoute->pLeaf)
+	    continue;
+
+	addr = (pRoute->prefix & ~((u_long) (IP_FIB_SLOTS - 1) << shift)) |
+	       ((u_long) ix << shift);
+	pCover = NULL;
+	for (len = pRoute->len - 1;
+	     pCover == NULL && len > IP_FIB_STRIDE * level; len--)
+	    pCover = ipFibRouteFind (addr & IP_FIB_MASK (len), len);
+
+	if (pCover != NULL)
+	    {
+	    pSlot->pLeaf = pCover->pLeaf;
+	    pSlot->len = pCover->len;
+	    }
+	else
+	    {
+	    pSlot->pLeaf = NULL;
+	    pSlot->len = 0;
+	    if (pSlot->pChild == NULL)
+		pNode->used--;
+	    }
+	}
+
+    /* free the nodes this has left empty, from the bottom up */
+
+    for (; level >= 0 && pPath [level]->used == 0; level--)
+	{
+	Free (pPath [level]);
+	ipFibNodes--;
+	if (level == 0)
+	    {
+	    ipFibRoot = NULL;
+	    break;
+	    }
+	shift = 32 - IP_FIB_STRIDE * level;
+	pSlot = &pPath [level - 1]->slot [(pRoute->prefix >> shift) &
+					  (IP_FIB_SLOTS - 1)];
+	pSlot->pChild = NULL;
+	if (pSlot->pLeaf == NULL)
+	    pPath [level - 1]->used--;
+	}
+    }
+
+/*******************************************************************************
+*
+* ipFibNodeFree - free a trie node and all the nodes below it
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void ipFibNodeFree
+    (
+    IP_FIB_NODE *	pNode		/* node to free */
+    )
+    {
+    int			ix;
+
+    for (ix = 0; ix < IP_FIB_SLOTS; ix++)
+	if (pNode->slot [ix].pChild != NULL)
+	    ipFibNodeFree (pNode->slot [ix].pChild);
+
+    Free (pNode);
+    ipFibNodes--;
+    }
+
+/*******************************************************************************
+*
+* ipFibFlush - empty the trie and mark it out of date
+*
+* This routine is called when memory runs out while the trie is being
+* updated.  Lookups go to rn_match() until ipFibRebuild() succeeds.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void ipFibFlush (void)
+    {
+    IP_FIB_ROUTE *	pRoute;
+    int			ix;
+
+    ipFibValid = FALSE;
+
+    if (ipFibRoot != NULL)
+	ipFibNodeFree (ipFibRoot);
+    ipFibRoot = NULL;
+    ipFibDefault = NULL;
+
+    for (ix = 0; ix < IP_FIB_HASH_SIZE; ix++)
+	{
+	while ((pRoute = ipFibHashTbl [ix]) != NULL)
+	    {
+	    ipFibHashTbl [ix] = pRoute->pNext;
+	    Free (pRoute);
+	    }
+	}
+
+    ipFibRoutes = 0;
+    ipFibUnsafe = 0;
+    }
+
+/*******************************************************************************
+*
+* ipFibRebuildOne - enter one route while rebuilding the trie
+*
+* RETURNS: 0, or 1 to stop the walk if memory has run out.
+*
+* NOMANUAL
+*/
+
+LOCAL int ipFibRebuildOne
+    (
+    struct radix_node *	pLeaf,		/* radix leaf of route */
+    void *		arg		/* unused */
+    )
+    {
+    ipFibRouteAdd (pLeaf);
+    return (ipFibValid ? 0 : 1);
+    }
+
+/*******************************************************************************
+*
+* ipFibRebuild - rebuild the trie from the radix tree
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void ipFibRebuild (void)
+    {
+    ipFibFlush ();
+    ipFibValid = TRUE;
+
+    if (ipFibHead->rnh_walktree (ipFibHead, ipFibRebuildOne, NULL) != 0)
+	ipFibFlush ();
+    }
+
+/*******************************************************************************
+*
+* ipFibShow - display the state of the compiled forwarding table
+*
+* This routine displays the number of routes and nodes in the trie and
+* how many lookups it has answered.
+*
+* RETURNS: N/A
+*/
+
+void ipFibShow (void)
+    {
+    printf ("compiled forwarding table %s%s\n",
+	    ipFibEnabled ? "enabled" : "disabled",
+	    !ipFibValid ? ", out of date (no memory)" :
+	    ipFibUnsafe ? ", bypassed (unrepresentable routes)" : "");
+    printf ("    %d routes, %d not representable\n", ipFibRoutes,
+	    ipFibUnsafe);
+    printf ("    %d nodes, %d bytes\n", ipFibNodes,
+	    ipFibNodes * (int) sizeof (IP_FIB_NODE));
+    printf ("    %lu lookups from trie, %lu passed to radix tree\n",
+	    ipFibLookups, ipFibPassed);
+    }
@@ -41,6 +41,12 @@
 /*
 modification history
 --------------------
+02b,17oct26,agt  ipReAssemble() takes the fragment list before freeing the
+		 reassembly header mbuf that holds it.
+02a,17oct26,agt  replaced the single ipforward_rt in ip_forward() with a
+		 hashed flow cache checked against rtmodified
+01z,17oct26,agt  hashed the reassembly queues; added ipReassMaxBytes limit
+		 with oldest-first eviction and ipReassShow()
 01y,15apr02,wap  reinstate netJobAdd removal changes
 01x,29mar02,wap  back out the previous change (needs more investigation)
 01w,21mar02,rae  ipintr called directly (SPR #74604)
@@ -83,6 +89,7 @@ modification history
 #include "net/protosw.h"
 #include "sys/socket.h"
 #include "errno.h"
+#include "stdlib.h"
 
 #include "net/if.h"
 #include "net/route.h"
@@ -110,6 +117,7 @@ extern void _insque();
 extern void _remque();
 extern int sysClkRateGet();
 extern int routeDrain();
+extern int printf ();
 
 #ifndef VIRTUAL_STACK
 extern VOIDFUNCPTR _icmpErrorHook;
@@ -172,6 +180,75 @@ u_short	ip_id;				/* ip packet ctr, for ids */
 int	ip_nhops = 0;
 #endif /* VIRTUAL_STACK */
 
+#ifndef VIRTUAL_STACK
+/*
+ * Reassembly queues are found through a hash table keyed on
+ * (src, dst, id, proto) as well as being on the ipq list, which is
+ * kept newest first.  The memory held by queued fragments is limited
+ * to ipReassMaxBytes; when a fragment would go over it, the oldest
+ * queues are freed to make room.  The hash linkage and counters for
+ * each queue are kept after the struct ipq, in the same MT_FTABLE
+ * buffer.
+ */
+
+#define IPREASS_HASH_SIZE	64		/* must be a power of 2 */
+#define IPREASS_HASH(src, dst, id, p)					\
+	((((src) >> 16) ^ (src) ^ ((dst) >> 16) ^ (dst) ^ (id) ^ (p))	\
+	 & (IPREASS_HASH_SIZE - 1))
+
+struct ipqext
+    {
+    struct ipq *	ix_hnext;	/* next queue in hash bucket */
+    struct ipq **	ix_hpprev;	/* link to this queue */
+    int			ix_bytes;	/* bytes held by the fragments */
+    int			ix_frags;	/* fragments received */
+    };
+
+#define IPQ_EXT(fp)	((struct ipqext *)((fp) + 1))
+
+LOCAL struct ipq *	ipReassHashTbl [IPREASS_HASH_SIZE];
+
+int	ipReassMaxBytes = 256 * 1024;	/* limit on bytes awaiting reassembly */
+int	ipReassBytes;			/* bytes awaiting reassembly */
+u_long	ipReassEvicts;			/* queues freed to stay in the limit */
+
+LOCAL void ipReassLink (struct ipq * fp);
+
+/*
+ * Forwarded packets find their route through a direct-mapped cache
+ * keyed on the destination address, in place of the single
+ * ipforward_rt, so that alternating destinations do not each force a
+ * fresh lookup.  An entry is only trusted while 'rtmodified' still has
+ * the value it had when the entry was filled; any route added to or
+ * deleted from the table makes every entry stale.  The resolved
+ * gateway and link-layer address stay with the route (rt_gwroute and
+ * its ARP entry) and are found through it.  ipFlowCacheSize is rounded
+ * down to a power of 2 by ip_init(); zero falls back to ipforward_rt.
+ */
+
+#define IPFLOW_HASH(dst)						\
+	(((dst) ^ ((dst) >> 8) ^ ((dst) >> 16) ^ ((dst) >> 24)) & ipFlowMask)
+
+struct ipflow
+    {
+    struct route	ipf_ro;		/* route to the destination */
+    int			ipf_gen;	/* rtmodified when filled */
+    };
+
+IMPORT int	rtmodified;		/* route table generation */
+
+LOCAL struct ipflow *	ipFlowTbl;	/* flow cache */
+LOCAL u_long		ipFlowMask;	/* entries in ipFlowTbl - 1 */
+
+int	ipFlowCacheSize = 256;		/* flow cache entries */
+u_long	ipFlowLookups;			/* packets forwarded through cache */
+u_long	ipFlowMisses;			/* lookups that needed rtalloc2() */
+
+LOCAL struct route * ipFlowGet (struct in_addr dst);
+#endif /* VIRTUAL_STACK */
+
+LOCAL void ipReassUnlink (struct ipq * fp);
+
 #ifdef WV_INSTRUMENTATION
 #ifdef INCLUDE_WVNET
     /* Set common fields of event identifiers for this module. */
@@ -255,6 +332,12 @@ ip_init()
 #else
 	ipq.next = ipq.prev = &ipq;
 	ip_id = iptime() & 0xffff;
+
+	for (i = 1; i * 2 <= ipFlowCacheSize; i *= 2)
+		;
+	if (ipFlowCacheSize > 0 &&
+	    (ipFlowTbl = (struct ipflow *)calloc (i, sizeof (struct ipflow))))
+		ipFlowMask = i - 1;
 #endif
 	ipintrq.ifq_maxlen = ipqmaxlen;
 	return;
@@ -625,7 +708,10 @@ ours:
 #ifdef VIRTUAL_STACK
 		for (fp = _ipq.next; fp != &_ipq; fp = fp->next)
 #else
-		for (fp = ipq.next; fp != &ipq; fp = fp->next)
+		for (fp = ipReassHashTbl [IPREASS_HASH (ip->ip_src.s_addr,
+							ip->ip_dst.s_addr,
+							ip->ip_id, ip->ip_p)];
+		     fp != NULL; fp = IPQ_EXT (fp)->ix_hnext)
 #endif
 			if (ip->ip_id == fp->ipq_id &&
 			    ip->ip_src.s_addr == fp->ipq_src.s_addr &&
@@ -739,23 +825,47 @@ LOCAL struct mbuf * ipReAssemble
     FAST struct ipasfrag *	pIpHdrFrag = NULL; /* ipfragment header */
     FAST int		        len; 
     FAST struct mbuf *		pMbufTmp;	   /* pointer to mbuf */
+    int				bytes;		   /* bytes held by queue */
+    BOOL			complete;	   /* no holes in queue */
+#ifndef VIRTUAL_STACK
+    struct ipq *		pOldest;	   /* oldest queue */
+#endif
     
     pIpHdr = mtod (pMbuf, struct ip *); 
     pMbuf->m_nextpkt = NULL; 
+
+#ifndef VIRTUAL_STACK
+    /*
+     * Make room for this fragment by freeing the oldest queues.  The
+     * fragment is dropped instead if that would mean freeing its own.
+     */
+    bytes = pIpHdr->ip_len + (pIpHdr->ip_hl << 2);
+    while (ipReassBytes + bytes > ipReassMaxBytes)
+	{
+	pOldest = ipq.prev;
+	if (pOldest == &ipq || pOldest == pIpFragQueue)
+	    goto dropFrag;
+	ipstat.ips_fragdropped++;
+	ipReassEvicts++;
+	ip_freef (pOldest);
+	}
+#endif /* VIRTUAL_STACK */
+
     /*
      * If first fragment to arrive, create a reassembly queue.
      */
     if (pIpFragQueue == 0)
 	{
+#ifdef VIRTUAL_STACK
 	if ((pMbufTmp = mBufClGet (M_DONTWAIT, MT_FTABLE, sizeof(struct ipq),
 				   TRUE)) == NULL)
 	    goto dropFrag;
-	pIpFragQueue = mtod(pMbufTmp, struct ipq *);
-#ifdef VIRTUAL_STACK
-	insque(pIpFragQueue, &_ipq);
 #else
-	insque(pIpFragQueue, &ipq);
+	if ((pMbufTmp = mBufClGet (M_DONTWAIT, MT_FTABLE, sizeof(struct ipq) +
+				   sizeof(struct ipqext), TRUE)) == NULL)
+	    goto dropFrag;
 #endif
+	pIpFragQueue = mtod(pMbufTmp, struct ipq *);
 	pIpFragQueue->ipq_ttl = ipfragttl;	/* configuration parameter */
 	pIpFragQueue->ipq_p = pIpHdr->ip_p;
 	pIpFragQueue->ipq_id = pIpHdr->ip_id;
@@ -763,6 +873,11 @@ LOCAL struct mbuf * ipReAssemble
 	pIpFragQueue->ipq_dst = ((struct ip *)pIpHdr)->ip_dst;
 	pIpFragQueue->pMbufHdr   = pMbufTmp; 	/* back pointer to mbuf */
 	pIpFragQueue->pMbufPkt = pMbuf; 	/* first fragment received */
+#ifdef VIRTUAL_STACK
+	insque(pIpFragQueue, &_ipq);
+#else
+	ipReassLink (pIpFragQueue);
+#endif
 	goto ipChkReAssembly; 
 	}
 
@@ -820,19 +935,38 @@ LOCAL struct mbuf * ipReAssemble
 
     ipChkReAssembly:
     len = 0; 
+    bytes = 0;
+    complete = TRUE;
     for (pMbPktFrag = pIpFragQueue->pMbufPkt; pMbPktFrag != NULL;
 	 pMbPktFrag = pMbPktFrag->m_nextpkt)
 	{
 	pIpHdrFrag = mtod(pMbPktFrag, struct ipasfrag *); 
 	if ((USHORT)pIpHdrFrag->ip_off != len)
-	    return (NULL); 
+	    complete = FALSE;
 	len += pIpHdrFrag->ip_len; 
+	bytes += pIpHdrFrag->ip_len + (pIpHdrFrag->ip_hl << 2);
 	}    
+
+#ifndef VIRTUAL_STACK
+    ipReassBytes += bytes - IPQ_EXT (pIpFragQueue)->ix_bytes;
+    IPQ_EXT (pIpFragQueue)->ix_bytes = bytes;
+    IPQ_EXT (pIpFragQueue)->ix_frags++;
+#endif
+
+    if (!complete)
+	return (NULL); 
     if (pIpHdrFrag->ipf_mff & 1)	/* last fragment's mff bit still set */
 	return (NULL); 
 
-    /* reassemble and concatenate all fragments */
+    /* take the queue off the lists; its fragments are about to be joined */
+    ipReassUnlink (pIpFragQueue);
+
+    /* the queue lives in the header mbuf, so take the fragments first */
+
     pMbuf = pIpFragQueue->pMbufPkt; 
+    (void) m_free (pIpFragQueue->pMbufHdr); 
+
+    /* reassemble and concatenate all fragments */
     pMbufTmp = pMbuf->m_nextpkt; 
     pMbuf->m_nextpkt = NULL; 
 
@@ -852,8 +986,6 @@ LOCAL struct mbuf * ipReAssemble
     if (len > 0xffff - (pIpHdrFrag->ip_hl << 2))  /* ping of death */
         goto dropFrag;                            /* drop entire chain */
     pIpHdrFrag->ipf_mff &= ~1;
-    remque(pIpFragQueue);
-    (void) m_free (pIpFragQueue->pMbufHdr); 
 
     /* some debugging cruft by sklower, below, will go away soon */
     if (pMbuf->m_flags & M_PKTHDR)
@@ -912,10 +1044,180 @@ ip_freef(fp)
 	    m_freem (*pPtrMbuf); 
 	    *pPtrMbuf = pMbuf; 
 	    }
-	remque(fp);
+	ipReassUnlink(fp);
 	(void) m_free(fp->pMbufHdr);
 }
 
+#ifndef VIRTUAL_STACK
+/*******************************************************************************
+*
+* ipReassLink - put a new reassembly queue on the ipq list and in the hash
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void ipReassLink
+    (
+    struct ipq *	fp		/* new reassembly queue */
+    )
+    {
+    struct ipqext *	pExt = IPQ_EXT (fp);
+    struct ipq **	ppHead;
+
+    insque (fp, &ipq);
+
+    ppHead = &ipReassHashTbl [IPREASS_HASH (fp->ipq_src.s_addr,
+					    fp->ipq_dst.s_addr,
+					    fp->ipq_id, fp->ipq_p)];
+    if ((pExt->ix_hnext = *ppHead) != NULL)
+	IPQ_EXT (*ppHead)->ix_hpprev = &pExt->ix_hnext;
+    pExt->ix_hpprev = ppHead;
+    *ppHead = fp;
+
+    pExt->ix_bytes = 0;
+    pExt->ix_frags = 0;
+    }
+#endif /* VIRTUAL_STACK */
+
+/*******************************************************************************
+*
+* ipReassUnlink - take a reassembly queue off the ipq list and out of the hash
+*
+* The bytes held by the queue are no longer counted against the
+* reassembly limit.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void ipReassUnlink
+    (
+    struct ipq *	fp		/* reassembly queue */
+    )
+    {
+#ifndef VIRTUAL_STACK
+    struct ipqext *	pExt = IPQ_EXT (fp);
+
+    if ((*pExt->ix_hpprev = pExt->ix_hnext) != NULL)
+	IPQ_EXT (pExt->ix_hnext)->ix_hpprev = pExt->ix_hpprev;
+    ipReassBytes -= pExt->ix_bytes;
+    pExt->ix_bytes = 0;
+#endif /* VIRTUAL_STACK */
+
+    remque (fp);
+    }
+
+#ifndef VIRTUAL_STACK
+/*******************************************************************************
+*
+* ipReassShow - display the IP reassembly queues
+*
+* This routine displays each datagram awaiting reassembly, oldest first,
+* with the fragments received for it so far and the bytes they hold,
+* followed by the totals against the 'ipReassMaxBytes' limit.
+*
+* RETURNS: N/A
+*/
+
+void ipReassShow (void)
+    {
+    struct ipq *	fp;
+    int			s;
+
+    s = splnet ();
+
+    printf ("%-10s %-10s %-6s %-5s %-5s %-7s %s\n",
+	    "Source", "Dest", "Id", "Proto", "Frags", "Bytes", "TTL");
+
+    for (fp = ipq.prev; fp != &ipq; fp = fp->prev)
+	printf ("%08lx   %08lx   %-6u %-5u %-5d %-7d %d\n",
+		(u_long) ntohl (fp->ipq_src.s_addr),
+		(u_long) ntohl (fp->ipq_dst.s_addr),
+		(u_int) fp->ipq_id, (u_int) fp->ipq_p,
+		IPQ_EXT (fp)->ix_frags, IPQ_EXT (fp)->ix_bytes,
+		(int) fp->ipq_ttl);
+
+    printf ("bytes queued %d, limit %d, queues evicted %lu\n",
+	    ipReassBytes, ipReassMaxBytes, ipReassEvicts);
+
+    splx (s);
+    }
+
+/*******************************************************************************
+*
+* ipFlowGet - get the forwarding flow cache entry for a destination
+*
+* This routine returns the cached route for <dst>.  If the route table
+* has changed since the entry was filled, the entry's route is released
+* first so that ip_forward() looks it up again.
+*
+* RETURNS: the route to use for <dst>, possibly empty.
+*
+* NOMANUAL
+*/
+
+LOCAL struct route * ipFlowGet
+    (
+    struct in_addr	dst		/* destination of the packet */
+    )
+    {
+    struct ipflow *	pFlow;
+
+    if (ipFlowTbl == NULL)
+	return (&ipforward_rt);
+
+    ipFlowLookups++;
+
+    pFlow = &ipFlowTbl [IPFLOW_HASH (dst.s_addr)];
+    if (pFlow->ipf_gen != rtmodified)
+	{
+	if (pFlow->ipf_ro.ro_rt != NULL)
+	    {
+	    RTFREE (pFlow->ipf_ro.ro_rt);
+	    pFlow->ipf_ro.ro_rt = NULL;
+	    }
+	pFlow->ipf_gen = rtmodified;
+	}
+
+    return (&pFlow->ipf_ro);
+    }
+
+/*******************************************************************************
+*
+* ipFlowShow - display the forwarding flow cache
+*
+* This routine displays the size of the flow cache, how many entries
+* hold a current route, and how many forwarded packets needed a route
+* lookup.
+*
+* RETURNS: N/A
+*/
+
+void ipFlowShow (void)
+    {
+    int		inUse = 0;
+    int		ix;
+    int		s;
+
+    s = splnet ();
+
+    if (ipFlowTbl != NULL)
+	for (ix = 0; ix <= ipFlowMask; ix++)
+	    if (ipFlowTbl [ix].ipf_ro.ro_rt != NULL &&
+		ipFlowTbl [ix].ipf_gen == rtmodified)
+		inUse++;
+
+    printf ("flow cache entries %lu, in use %d\n",
+	    ipFlowTbl != NULL ? ipFlowMask + 1 : 0, inUse);
+    printf ("lookups %lu, misses %lu\n", ipFlowLookups, ipFlowMisses);
+
+    splx (s);
+    }
+#endif /* VIRTUAL_STACK */
+
 n_time
 iptime()
 {
@@ -1397,6 +1699,7 @@ ip_forward(m, srcrt)
 	struct mbuf *mcopy;
 	n_long dest;
 	struct ifnet *destifp;
+	struct route *ro;
 
 #ifdef WV_INSTRUMENTATION
 #ifdef INCLUDE_WVNET
@@ -1441,20 +1744,28 @@ ip_forward(m, srcrt)
 	}
 	ip->ip_ttl -= IPTTLDEC;
 
-	sin = (struct sockaddr_in *)&ipforward_rt.ro_dst;
-	if ((rt = ipforward_rt.ro_rt) == 0 ||
+#ifdef VIRTUAL_STACK
+	ro = &ipforward_rt;
+#else
+	ro = ipFlowGet (ip->ip_dst);
+#endif /* VIRTUAL_STACK */
+	sin = (struct sockaddr_in *)&ro->ro_dst;
+	if ((rt = ro->ro_rt) == 0 ||
             (rt->rt_flags & RTF_UP) == 0 ||
 	    ip->ip_dst.s_addr != sin->sin_addr.s_addr) {
-		if (ipforward_rt.ro_rt) {
-			RTFREE(ipforward_rt.ro_rt);
-			ipforward_rt.ro_rt = 0;
+		if (ro->ro_rt) {
+			RTFREE(ro->ro_rt);
+			ro->ro_rt = 0;
 		}
 		sin->sin_family = AF_INET;
 		sin->sin_len = sizeof(*sin);
 		sin->sin_addr = ip->ip_dst;
 
-		ipforward_rt.ro_rt = rtalloc2 (&ipforward_rt.ro_dst);
-		if (ipforward_rt.ro_rt == 0) {
+#ifndef VIRTUAL_STACK
+		ipFlowMisses++;
+#endif /* VIRTUAL_STACK */
+		ro->ro_rt = rtalloc2 (&ro->ro_dst);
+		if (ro->ro_rt == 0) {
 #ifdef VIRTUAL_STACK
 			_ipstat.ips_noroute++;
 #else
@@ -1465,7 +1776,7 @@ ip_forward(m, srcrt)
 					     ICMP_UNREACH_HOST, dest, 0);
 			return;
 		}
-		rt = ipforward_rt.ro_rt;
+		rt = ro->ro_rt;
 	}
 
 	/*
@@ -1524,7 +1835,7 @@ ip_forward(m, srcrt)
 
         m->m_flags |= M_FORWARD;
 
-	error = ip_output(m, (struct mbuf *)0, &ipforward_rt, IP_FORWARDING
+	error = ip_output(m, (struct mbuf *)0, ro, IP_FORWARDING
 #ifdef DIRECTED_BROADCAST
 			    | IP_ALLOWBROADCAST
 #endif
@@ -1585,8 +1896,8 @@ ip_forward(m, srcrt)
 	case EMSGSIZE:
 		type = ICMP_UNREACH;
 		code = ICMP_UNREACH_NEEDFRAG;
-		if (ipforward_rt.ro_rt)
-			destifp = ipforward_rt.ro_rt->rt_ifp;
+		if (ro->ro_rt)
+			destifp = ro->ro_rt->rt_ifp;
 #ifdef VIRTUAL_STACK
 		_ipstat.ips_cantfrag++;
 #else
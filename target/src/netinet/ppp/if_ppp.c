@@ -81,6 +81,8 @@
 /*
 modification history
 --------------------
+01z,17oct26,agt  keep sc_qlen when the read job cannot be queued, and drain
+		 oversized reads in pieces
 01y,20may02,vvv  modified receive mechanism to use ipintr without queueing
 01x,28mar02,jmp  Increased again read buffer size for solaris simulator and
 		 added global variable simPppRBufSize to make this buffer
@@ -1185,11 +1187,16 @@ pppintr(unit, c)
 
     ++sc->sc_qlen;
 
+    /*
+     * If the network job queue is full the read is not queued, and the
+     * characters are left counted in sc_qlen for the next job to read.
+     */
+
     if (sc->sc_qlen > PPPBUFSIZE)
         {
-        netJobAdd((FUNCPTR) ppp_tty_read, (int)unit, (int) sc,
-                  (int) sc->sc_qlen, 0, 0);
-        sc->sc_qlen = 0;
+        if (netJobAdd((FUNCPTR) ppp_tty_read, (int)unit, (int) sc,
+                      (int) sc->sc_qlen, 0, 0) == OK)
+            sc->sc_qlen = 0;
         return (FALSE);
         }
      
@@ -1202,9 +1209,9 @@ pppintr(unit, c)
 
     if ((c & 0xff) == PPP_FLAG) 
         {
-        netJobAdd((FUNCPTR) ppp_tty_read, (int)unit, (int) sc, 
-                      (int) sc->sc_qlen, 0, 0);
-        sc->sc_qlen = 0;
+        if (netJobAdd((FUNCPTR) ppp_tty_read, (int)unit, (int) sc,
+                      (int) sc->sc_qlen, 0, 0) == OK)
+            sc->sc_qlen = 0;
         }
 
     return (FALSE);
@@ -1223,17 +1230,23 @@ ppp_tty_read(unit, sc, count)
     register int num;
     char buf[PPPBUFSIZE + 2];
 
-    /* count should never be greater than PPPBUFSIZE+1 */
-
-    num = read(sc->sc_fd, buf, count);
+    /*
+     * count is at most PPPBUFSIZE+1, unless earlier read jobs could not be
+     * queued and their characters were added to this one.
+     */
 
     if (count > PPPBUFSIZE)
        {
        /* The received packet is greater than the MTU - Drop the packet */
+       for (; count > 0; count -= num)
+           if ((num = read(sc->sc_fd, buf, min (count, sizeof (buf)))) <= 0)
+               break;
        sc->sc_if.if_ierrors++;
        return;
        }
 
+    num = read(sc->sc_fd, buf, count);
+
     if ((ppp_if[unit]->lcp_fsm.state) != OPENED)
         {
         if (strncmp("CLIENT", buf, strlen("CLIENT") )==0)
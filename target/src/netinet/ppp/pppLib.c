@@ -23,6 +23,7 @@
 /*
 modification history
 --------------------
+01z,17oct26,agt  queue the hangup signal with netJobReservedAdd()
 01x,04dec00,adb  enabled PPP_HOOK_DISCONNECT in pppDelete
 01w,23oct00,cn   Fix for spr 34068, cleanup of clients' addresses structures.
 01y,19oct00,cn   Fix for spr 34657, cleanup of callout structures.
@@ -232,6 +233,8 @@ int ppp_task_options		= VX_FP_TASK | VX_DEALLOC_STACK;
 int ppp_task_stack_size		= 0x4000;
 char *ppp_task_name		= "tPPP";
 
+IMPORT STATUS netJobReservedAdd ();
+
 /* prototypes */
 
 static int  baud_rate_of __ARGS((int));
@@ -911,7 +914,8 @@ void pppDelete
 	        wp = next;
 	        }
 
-	    netJobAdd ((FUNCPTR)kill, ppp_if[unit]->task_id, SIGTERM, 0, 0, 0);
+	    netJobReservedAdd ((FUNCPTR)kill, ppp_if[unit]->task_id, SIGTERM,
+			       0, 0, 0);
 	    }
     }
 
@@ -41,6 +41,8 @@
 /*
 modification history
 --------------------
+01u,17oct26,agt  queue routeKillCheck() with netJobReservedAdd()
+01t,17oct26,agt  attach compiled forwarding table in route_init
 01s,14mar02,vvv  fixed route addition check for dest=gateway in rt_setgate
 		 (SPR #74244)
 01r,24jan02,niq  fixed call to new address message hook (SPR #71670)
@@ -175,8 +177,11 @@ LOCAL ULONG wvNetEventId;       /* Event identifier: see wvNetLib.h */
 LOCAL void routeKillCheck (void);
 LOCAL int routeUpdate (struct radix_node *, void *);
 
-IMPORT STATUS   netJobAdd (FUNCPTR routine, int param1, int param2, int param3,
-                           int param4, int param5);
+IMPORT STATUS   netJobReservedAdd (FUNCPTR routine, int param1, int param2,
+                                   int param3, int param4, int param5);
+#ifndef VIRTUAL_STACK
+IMPORT STATUS	ipFibInit (struct radix_node_head *);
+#endif
 
 #ifndef VIRTUAL_STACK
 /*
@@ -286,7 +291,7 @@ STATUS routeStorageCreate (void)
     routePendInterval = sysClkRateGet() * ROUTE_PEND_MAXIMUM;
     routePendMinimum = sysClkRateGet() * ROUTE_PEND_MINIMUM;
 
-    wdStart (routeKillTimer, routeKillInterval, netJobAdd,
+    wdStart (routeKillTimer, routeKillInterval, netJobReservedAdd,
              (int)routeKillCheck);
 
     return (OK);
@@ -310,6 +315,7 @@ route_init()
 
 	rn_init();	/* initialize all zeroes, all ones, mask table */
 	rtable_init((void **)rt_tables);
+	ipFibInit (rt_tables[AF_INET]);	/* compiled forwarding table */
 
         routeKillTimer = wdCreate ();
         if (routeKillTimer == NULL)
@@ -319,7 +325,8 @@ route_init()
         routePendInterval = sysClkRateGet() * ROUTE_PEND_MAXIMUM;
         routePendMinimum = sysClkRateGet() * ROUTE_PEND_MINIMUM;
 
-        wdStart (routeKillTimer, routeKillInterval, netJobAdd, (int) routeKillCheck);
+        wdStart (routeKillTimer, routeKillInterval, netJobReservedAdd,
+                 (int) routeKillCheck);
 
 	return (OK);
 }
@@ -394,7 +401,7 @@ void routeKillCheck (void)
      */
 
     now = count.nextstop - tickGet ();
-    wdStart (routeKillTimer, now, netJobAdd, (int)routeKillCheck); 
+    wdStart (routeKillTimer, now, netJobReservedAdd, (int)routeKillCheck);
 
     return;
     }
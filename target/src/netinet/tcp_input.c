@@ -41,6 +41,10 @@
 /*
 modification history
 --------------------
+01k,17oct26,agt  added SACK, and NewReno partial-ACK handling in fast recovery
+01j,17oct26,agt  arm timers with tcp_timer_set() and delayed ACKs with
+		 tcp_delack(); idle and rtt times from tcp_idle_reset() and
+		 tcp_rtt()
 01i,06mar02,vvv  fixed tcp_input to wake application only when space in send
 		 buffer exceeds low water mark (SPR #72177)
 01h,12oct01,rae  merge from truestack ver 01n, base o1f (SPRs 69629, 70328,
@@ -102,6 +106,16 @@ IMPORT int tcp_mssdflt;
 #endif /* VIRTUAL_STACK */
 
 IMPORT unsigned long (*pTcpRandHook)(void);
+IMPORT void tcp_timer_set ();
+IMPORT void tcp_delack ();
+IMPORT void tcp_idle_reset ();
+IMPORT int tcp_rtt ();
+IMPORT void tcp_sack_option ();
+IMPORT void tcp_sack_rcvd ();
+IMPORT int tcp_inrecovery ();
+IMPORT int tcp_recovery_enter ();
+IMPORT void tcp_recovery_dupack ();
+IMPORT int tcp_recovery_ack ();
 
 extern void _remque ();
 extern void _insque ();
@@ -160,7 +174,7 @@ LOCAL ULONG wvNetEventId;       /* Event identifier: see wvNetLib.h */
 	if ((ti)->ti_seq == (tp)->rcv_nxt && \
 	    (tp)->seg_next == (struct tcpiphdr *)(tp) && \
 	    (tp)->t_state == TCPS_ESTABLISHED) { \
-		(tp)->t_flags |= TF_DELACK; \
+		tcp_delack(tp); \
 		(tp)->rcv_nxt += (ti)->ti_len; \
 		flags = (ti)->ti_flags & TH_FIN; \
 		tcpstat.tcps_rcvpack++;\
@@ -270,6 +284,7 @@ tcp_reass(tp, ti, m)
 	 * Stick new segment in its place.
 	 */
 	insque(ti, q->ti_prev);
+	tcp_sack_rcvd(tp, ti->ti_seq, (int)ti->ti_len);
 
 present:
 	/*
@@ -316,6 +331,7 @@ tcp_input(m, iphlen)
 	register int tiflags;
 	struct socket *so = NULL;
 	int todrop, acked, ourfinisacked, needoutput = 0;
+	int partialack = 0;
 	short ostate = 0;
 	struct in_addr laddr;
 	int dropsocket = 0;
@@ -560,8 +576,8 @@ pcbMatchFound:
 	 * Segment received on connection.
 	 * Reset idle time and keep-alive timer.
 	 */
-	tp->t_idle = 0;
-	tp->t_timer[TCPT_KEEP] = tcp_keepidle;
+	tcp_idle_reset(tp);
+	tcp_timer_set(tp, TCPT_KEEP, tcp_keepidle);
 
 	/*
 	 * Process options if not in LISTEN state,
@@ -604,7 +620,8 @@ pcbMatchFound:
 		if (ti->ti_len == 0) {
 			if (SEQ_GT(ti->ti_ack, tp->snd_una) &&
 			    SEQ_LEQ(ti->ti_ack, tp->snd_max) &&
-			    tp->snd_cwnd >= tp->snd_wnd) {
+			    tp->snd_cwnd >= tp->snd_wnd &&
+			    tcp_inrecovery(tp) == 0) {
 				/*
 				 * this is a pure ack for outstanding data.
 				 */
@@ -613,7 +630,7 @@ pcbMatchFound:
 					tcp_xmit_timer(tp, tcp_now-ts_ecr+1);
 				else if (tp->t_rtt &&
 					    SEQ_GT(ti->ti_ack, tp->t_rtseq))
-					tcp_xmit_timer(tp, tp->t_rtt);
+					tcp_xmit_timer(tp, tcp_rtt(tp));
 				acked = ti->ti_ack - tp->snd_una;
 
 #ifdef WV_INSTRUMENTATION
@@ -641,9 +658,9 @@ pcbMatchFound:
 				 * decide between more output or persist.
 				 */
 				if (tp->snd_una == tp->snd_max)
-					tp->t_timer[TCPT_REXMT] = 0;
+					tcp_timer_set(tp, TCPT_REXMT, 0);
 				else if (tp->t_timer[TCPT_PERSIST] == 0)
-					tp->t_timer[TCPT_REXMT] = tp->t_rxtcur;
+					tcp_timer_set(tp, TCPT_REXMT, tp->t_rxtcur);
 
 				if ((so->so_snd.sb_want > 0) ||
 				    (so->so_snd.sb_sel)      ||
@@ -690,7 +707,7 @@ pcbMatchFound:
 			if (ti->ti_flags & TH_PUSH)
 				tp->t_flags |= TF_ACKNOW;
 			else
-				tp->t_flags |= TF_DELACK;
+				tcp_delack(tp);
 			return;
 		}
 	}
@@ -796,7 +813,7 @@ pcbMatchFound:
 		tcp_rcvseqinit(tp);
 		tp->t_flags |= TF_ACKNOW;
 		tp->t_state = TCPS_SYN_RECEIVED;
-		tp->t_timer[TCPT_KEEP] = tcp_keepinit;
+		tcp_timer_set(tp, TCPT_KEEP, tcp_keepinit);
 		dropsocket = 0;		/* committed to socket */
 		tcpstat.tcps_accepts++;
 
@@ -840,7 +857,7 @@ pcbMatchFound:
 			tp->snd_una = ti->ti_ack;
 			if (SEQ_LT(tp->snd_nxt, tp->snd_una))
 				tp->snd_nxt = tp->snd_una;
-                        tp->t_timer[TCPT_REXMT] = 0;
+                        tcp_timer_set(tp, TCPT_REXMT, 0);
 		}
 		tp->irs = ti->ti_seq;
 		tcp_rcvseqinit(tp);
@@ -872,7 +889,7 @@ pcbMatchFound:
 			 * use its rtt as our initial srtt & rtt var.
 			 */
 			if (tp->t_rtt)
-				tcp_xmit_timer(tp, tp->t_rtt);
+				tcp_xmit_timer(tp, tcp_rtt(tp));
 		} else
 			tp->t_state = TCPS_SYN_RECEIVED;
 
@@ -1227,23 +1244,17 @@ trimthenstep6:
 				 * so bump cwnd by the amount in the receiver
 				 * to keep a constant cwnd packets in the
 				 * network.
+				 *
+				 * With SACK, the holes the receiver reports
+				 * are resent instead, as the data in flight
+				 * allows.  Fast recovery lasts until all the
+				 * data outstanding when it began is acked;
+				 * see tcp_recovery_enter() and friends.
 				 */
 				if (tp->t_timer[TCPT_REXMT] == 0 ||
 				    ti->ti_ack != tp->snd_una)
 					tp->t_dupacks = 0;
-				else if (++tp->t_dupacks == tcprexmtthresh) {
-					tcp_seq onxt = tp->snd_nxt;
-					u_int win =
-					    min(tp->snd_wnd, tp->snd_cwnd) / 2 /
-						tp->t_maxseg;
-
-					if (win < 2)
-						win = 2;
-					tp->snd_ssthresh = win * tp->t_maxseg;
-					tp->t_timer[TCPT_REXMT] = 0;
-					tp->t_rtt = 0;
-					tp->snd_nxt = ti->ti_ack;
-					tp->snd_cwnd = tp->t_maxseg;
+				else if (tcp_inrecovery(tp)) {
 
 #ifdef WV_INSTRUMENTATION
 #ifdef INCLUDE_WVNET    /* WV_NET_WARNING event */
@@ -1254,14 +1265,9 @@ trimthenstep6:
 #endif  /* INCLUDE_WVNET */
 #endif
 
-					(void) tcp_output(tp);
-					tp->snd_cwnd = tp->snd_ssthresh +
-					       tp->t_maxseg * tp->t_dupacks;
-					if (SEQ_GT(onxt, tp->snd_nxt))
-						tp->snd_nxt = onxt;
+					tcp_recovery_dupack(tp);
 					goto drop;
-				} else if (tp->t_dupacks > tcprexmtthresh) {
-					tp->snd_cwnd += tp->t_maxseg;
+				} else if (++tp->t_dupacks == tcprexmtthresh) {
 
 #ifdef WV_INSTRUMENTATION
 #ifdef INCLUDE_WVNET    /* WV_NET_WARNING event */
@@ -1272,25 +1278,33 @@ trimthenstep6:
 #endif  /* INCLUDE_WVNET */
 #endif
 
-					(void) tcp_output(tp);
+					/*
+					 * Not for acks of data sent before
+					 * the last recovery or timeout.
+					 */
+					if (tcp_recovery_enter(tp) == 0) {
+						tp->t_dupacks = 0;
+						break;
+					}
 					goto drop;
 				}
 			} else
 				tp->t_dupacks = 0;
 			break;
 		}
-		/*
-		 * If the congestion window was inflated to account
-		 * for the other side's cached packets, retract it.
-		 */
-		if (tp->t_dupacks > tcprexmtthresh &&
-		    tp->snd_cwnd > tp->snd_ssthresh)
-			tp->snd_cwnd = tp->snd_ssthresh;
 		tp->t_dupacks = 0;
 		if (SEQ_GT(ti->ti_ack, tp->snd_max)) {
 			tcpstat.tcps_rcvacktoomuch++;
 			goto dropafterack;
 		}
+		/*
+		 * In fast recovery, an ack for all the data outstanding
+		 * when it began ends it and retracts the congestion
+		 * window.  A partial ack resends the next missing data
+		 * and leaves the window alone.
+		 */
+		if ((partialack = tcp_recovery_ack(tp, ti->ti_ack)) != 0)
+			needoutput = 1;
 		acked = ti->ti_ack - tp->snd_una;
 		tcpstat.tcps_rcvackpack++;
 		tcpstat.tcps_rcvackbyte += acked;
@@ -1307,7 +1321,7 @@ trimthenstep6:
 		if (ts_present)
 			tcp_xmit_timer(tp, tcp_now-ts_ecr+1);
 		else if (tp->t_rtt && SEQ_GT(ti->ti_ack, tp->t_rtseq))
-			tcp_xmit_timer(tp,tp->t_rtt);
+			tcp_xmit_timer(tp, tcp_rtt(tp));
 
 		/*
 		 * If all outstanding data is acked, stop retransmit
@@ -1316,10 +1330,10 @@ trimthenstep6:
 		 * timer, using current (possibly backed-off) value.
 		 */
 		if (ti->ti_ack == tp->snd_max) {
-			tp->t_timer[TCPT_REXMT] = 0;
+			tcp_timer_set(tp, TCPT_REXMT, 0);
 			needoutput = 1;
 		} else if (tp->t_timer[TCPT_PERSIST] == 0)
-			tp->t_timer[TCPT_REXMT] = tp->t_rxtcur;
+			tcp_timer_set(tp, TCPT_REXMT, tp->t_rxtcur);
 		/*
 		 * When new data is acked, open the congestion window.
 		 * If the window gives us less than ssthresh packets
@@ -1327,7 +1341,7 @@ trimthenstep6:
 		 * Otherwise open linearly: maxseg per window
 		 * (maxseg * (maxseg / cwnd) per packet).
 		 */
-		{
+		if (partialack == 0) {
 		register u_int cw = tp->snd_cwnd;
 		register u_int incr = tp->t_maxseg;
 
@@ -1373,7 +1387,7 @@ trimthenstep6:
 				 */
 				if (so->so_state & SS_CANTRCVMORE) {
 					soisdisconnected(so);
-					tp->t_timer[TCPT_2MSL] = tcp_maxidle;
+					tcp_timer_set(tp, TCPT_2MSL, tcp_maxidle);
 				}
 
 #ifdef WV_INSTRUMENTATION
@@ -1408,7 +1422,7 @@ trimthenstep6:
 
 				tp->t_state = TCPS_TIME_WAIT;
 				tcp_canceltimers(tp);
-				tp->t_timer[TCPT_2MSL] = 2 * TCPTV_MSL;
+				tcp_timer_set(tp, TCPT_2MSL, 2 * TCPTV_MSL);
 				soisdisconnected(so);
 			}
 			break;
@@ -1441,7 +1455,7 @@ trimthenstep6:
 #endif  /* INCLUDE_WVNET */
 #endif
 
-			tp->t_timer[TCPT_2MSL] = 2 * TCPTV_MSL;
+			tcp_timer_set(tp, TCPT_2MSL, 2 * TCPTV_MSL);
 			goto dropafterack;
 		}
 	}
@@ -1624,7 +1638,7 @@ dodata:							/* XXX */
 
 			tp->t_state = TCPS_TIME_WAIT;
 			tcp_canceltimers(tp);
-			tp->t_timer[TCPT_2MSL] = 2 * TCPTV_MSL;
+			tcp_timer_set(tp, TCPT_2MSL, 2 * TCPTV_MSL);
 			soisdisconnected(so);
 			break;
 
@@ -1641,7 +1655,7 @@ dodata:							/* XXX */
 #endif  /* INCLUDE_WVNET */
 #endif
 
-			tp->t_timer[TCPT_2MSL] = 2 * TCPTV_MSL;
+			tcp_timer_set(tp, TCPT_2MSL, 2 * TCPTV_MSL);
 			break;
 		}
 	}
@@ -1742,6 +1756,9 @@ tcp_dooptions(tp, cp, cnt, ti, ts_present, ts_val, ts_ecr)
 		switch (opt) {
 
 		default:
+			/* SACK-permitted and SACK options */
+			tcp_sack_option(tp, cp, min(optlen, cnt),
+			    (int)ti->ti_flags);
 			continue;
 
 		case TCPOPT_MAXSEG:
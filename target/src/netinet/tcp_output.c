@@ -41,6 +41,11 @@
 /*
 modification history
 --------------------
+01j,17oct26,agt  added SACK options and SACK loss recovery retransmissions
+01i,17oct26,agt  arm timers with tcp_timer_set(); idle and rtt times from
+		 tcp_idle() and tcp_rtt_start()
+01h,17oct26,agt  copy small segments into the header cluster and checksum
+		 them while copying (tcp_copysum)
 01g,05jun02,vvv  reworked previous change to fix performance degradation
 01f,06mar02,vvv  fixed Nagle algorithm to handle large writes correctly
 		 (SPR #72213)
@@ -91,6 +96,15 @@ DESCRIPTION
 #ifdef notyet
 extern struct mbuf *m_copypack();
 #endif
+extern u_long in_cksum_partial ();
+extern u_long in_cksum_copydata ();
+extern void tcp_timer_set ();
+extern int tcp_idle ();
+extern void tcp_rtt_start ();
+extern int tcp_sack_synopt ();
+extern int tcp_sack_addopt ();
+extern long tcp_sack_output ();
+extern void tcp_sack_sent ();
 
 #ifdef VIRTUAL_STACK
 #include "netinet/vsLib.h"
@@ -107,7 +121,14 @@ LOCAL ULONG wvNetEventId;       /* Event identifier: see wvNetLib.h */
 #endif    /* INCLUDE_WVNET */
 #endif
 
-#define MAX_TCPOPTLEN	32	/* max # bytes that go in options */
+#define MAX_TCPOPTLEN	40	/* max # bytes that go in options */
+
+/*
+ * Segments with no more than this many bytes of data are copied into
+ * the header cluster, and summed on the way, instead of being attached
+ * to it by reference with m_copy().  0 disables the copy.
+ */
+int	tcp_copysum = 256;
 
 /*
  * Tcp output routine: figure out what should be sent and send it.
@@ -124,7 +145,12 @@ tcp_output(tp)
 	register struct tcpiphdr *ti;
 	u_char opt[MAX_TCPOPTLEN];
 	unsigned optlen, hdrlen;
+	u_long dataSum;		/* partial sum of copied data */
+	BOOL dataCopied;	/* data is in header cluster */
 	int idle, sendalot, sndBufLen;
+	tcp_seq sackseq;	/* hole to resend in SACK recovery */
+	long sacklen, sackwin;
+	int sackrxmt;		/* segment is from a SACK hole */
 	
 	BOOL     pktSent = FALSE;   /* TRUE if a packet has been sent to IP */
 
@@ -135,7 +161,7 @@ tcp_output(tp)
 	 * to send, then transmit; otherwise, investigate further.
 	 */
 	idle = (tp->snd_max == tp->snd_una);
-	if (idle && tp->t_idle >= tp->t_rxtcur)
+	if (idle && tcp_idle(tp) >= tp->t_rxtcur)
 		/*
 		 * We have been idle for "a while" and no acks are
 		 * expected to clock out any data we send --
@@ -146,10 +172,30 @@ tcp_output(tp)
 	sndBufLen = so->so_snd.sb_cc;  /* number of bytes in socket buffer */
 again:
 	sendalot = 0;
+	dataCopied = FALSE;
+	sackrxmt = 0;
 	off = tp->snd_nxt - tp->snd_una;
 	win = min(tp->snd_wnd, tp->snd_cwnd);
 
 	flags = tcp_outflags[tp->t_state];
+	/*
+	 * In SACK loss recovery, resend the next hole if there is
+	 * room in the pipe for it; otherwise send new data only
+	 * within that room.
+	 */
+	if (tp->t_force == 0 &&
+	    (sackwin = tcp_sack_output(tp, &sackseq, &sacklen)) >= 0) {
+		if (sacklen > 0) {
+			off = sackseq - tp->snd_una;
+			len = sacklen;
+			flags &= ~TH_FIN;
+			sackrxmt = 1;
+			sendalot = 1;
+			win = sbspace(&so->so_rcv);
+			goto send;
+		}
+		win = min(tp->snd_wnd, off + sackwin);
+	}
 	/*
 	 * If in persist timeout with window of 0, send 1 byte.
 	 * Otherwise, if window is small but nonzero
@@ -178,7 +224,7 @@ again:
 				flags &= ~TH_FIN;
 			win = 1;
 		} else {
-			tp->t_timer[TCPT_PERSIST] = 0;
+			tcp_timer_set(tp, TCPT_PERSIST, 0);
 			tp->t_rxtshift = 0;
 		}
 	}
@@ -198,7 +244,7 @@ again:
 		 */
 		len = 0;
 		if (win == 0) {
-			tp->t_timer[TCPT_REXMT] = 0;
+			tcp_timer_set(tp, TCPT_REXMT, 0);
 			tp->snd_nxt = tp->snd_una;
 		}
 	}
@@ -351,6 +397,7 @@ send:
 					tp->request_r_scale);
 				optlen += 4;
 			}
+			optlen += tcp_sack_synopt(tp, flags, opt + optlen);
 		}
  	}
  
@@ -372,6 +419,14 @@ send:
  		optlen += TCPOLEN_TSTAMP_APPA;
  	}
 
+	/*
+	 * Report out-of-order data we hold with a SACK option.
+	 */
+	if ((flags & (TH_SYN|TH_RST)) == 0 &&
+	    tp->seg_next != (struct tcpiphdr *)tp)
+		optlen += tcp_sack_addopt(tp, opt + optlen,
+		    MAX_TCPOPTLEN - optlen);
+
  	hdrlen += optlen;
  
 	/*
@@ -408,7 +463,7 @@ send:
 	if (len) {
 		if (tp->t_force && len == 1)
 			tcpstat.tcps_sndprobe++;
-		else if (SEQ_LT(tp->snd_nxt, tp->snd_max)) {
+		else if (sackrxmt || SEQ_LT(tp->snd_nxt, tp->snd_max)) {
 			tcpstat.tcps_sndrexmitpack++;
 			tcpstat.tcps_sndrexmitbyte += len;
 		} else {
@@ -427,20 +482,42 @@ send:
 		m->m_len += hdrlen;
 		m->m_data -= hdrlen;
 #else
-		/* allocates a small enough cluster for the header */
-		m = mHdrClGet(M_DONTWAIT, MT_HEADER, (max_linkhdr + hdrlen),
-			      TRUE);
-		if (m == NULL) {
-			error = ENOBUFS;
-			goto out;
+		/*
+		 * A small segment is copied in behind the header, and
+		 * summed while it is copied, so that it is only read
+		 * once and the header and data go out in one cluster.
+		 * Fall back to sharing the data if that cluster can't
+		 * be had.
+		 */
+		m = NULL;
+		if (len <= tcp_copysum) {
+			m = mHdrClGet(M_DONTWAIT, MT_HEADER,
+				      (max_linkhdr + hdrlen + len), TRUE);
+			if (m != NULL) {
+				m->m_data += max_linkhdr;
+				dataSum = in_cksum_copydata(so->so_snd.sb_mb,
+				    off, (int) len, mtod(m, caddr_t) + hdrlen,
+				    0, (int) hdrlen);
+				m->m_len = hdrlen + len;
+				dataCopied = TRUE;
+			}
 		}
-		m->m_data += max_linkhdr;
-		m->m_len  = hdrlen;
-		m->m_next = m_copy(so->so_snd.sb_mb, off, (int) len);
-		if (m->m_next == 0) {
-			(void) m_free(m);
-			error = ENOBUFS;
-			goto out;
+		if (m == NULL) {
+			/* allocates a small enough cluster for the header */
+			m = mHdrClGet(M_DONTWAIT, MT_HEADER,
+				      (max_linkhdr + hdrlen), TRUE);
+			if (m == NULL) {
+				error = ENOBUFS;
+				goto out;
+			}
+			m->m_data += max_linkhdr;
+			m->m_len  = hdrlen;
+			m->m_next = m_copy(so->so_snd.sb_mb, off, (int) len);
+			if (m->m_next == 0) {
+				(void) m_free(m);
+				error = ENOBUFS;
+				goto out;
+			}
 		}
 #endif
 		/*
@@ -512,7 +589,10 @@ send:
 	 * case, since we know we aren't doing a retransmission.
 	 * (retransmit and persist are mutually exclusive...)
 	 */
-	if (len || (flags & (TH_SYN|TH_FIN)) || tp->t_timer[TCPT_PERSIST])
+	if (sackrxmt)
+		ti->ti_seq = htonl(sackseq);
+	else if (len || (flags & (TH_SYN|TH_FIN)) ||
+	    tp->t_timer[TCPT_PERSIST])
 		ti->ti_seq = htonl(tp->snd_nxt);
 	else
 		ti->ti_seq = htonl(tp->snd_max);
@@ -552,13 +632,20 @@ send:
 	if (len + optlen)
 		ti->ti_len = htons((u_short)(sizeof (struct tcphdr) +
 		    optlen + len));
-	ti->ti_sum = in_cksum(m, (int)(hdrlen + len));
+	if (dataCopied)
+		ti->ti_sum = ~in_cksum_partial(dataSum, (caddr_t)ti,
+		    (int)hdrlen, 0) & 0xffff;
+	else
+		ti->ti_sum = in_cksum(m, (int)(hdrlen + len));
 
 	/*
 	 * In transmit state, time the transmission and arrange for
 	 * the retransmit.  In persist state, just set snd_max.
+	 * A resent SACK hole leaves snd_nxt alone.
 	 */
-	if (tp->t_force == 0 || tp->t_timer[TCPT_PERSIST] == 0) {
+	if (sackrxmt)
+		tcp_sack_sent(tp, sackseq, len);
+	else if (tp->t_force == 0 || tp->t_timer[TCPT_PERSIST] == 0) {
 		tcp_seq startseq = tp->snd_nxt;
 
 		/*
@@ -580,7 +667,7 @@ send:
 			 * not currently timing anything.
 			 */
 			if (tp->t_rtt == 0) {
-				tp->t_rtt = 1;
+				tcp_rtt_start(tp);
 				tp->t_rtseq = startseq;
 				tcpstat.tcps_segstimed++;
 			}
@@ -596,9 +683,9 @@ send:
 		 */
 		if (tp->t_timer[TCPT_REXMT] == 0 &&
 		    tp->snd_nxt != tp->snd_una) {
-			tp->t_timer[TCPT_REXMT] = tp->t_rxtcur;
+			tcp_timer_set(tp, TCPT_REXMT, tp->t_rxtcur);
 			if (tp->t_timer[TCPT_PERSIST]) {
-				tp->t_timer[TCPT_PERSIST] = 0;
+				tcp_timer_set(tp, TCPT_PERSIST, 0);
 				tp->t_rxtshift = 0;
 			}
 		}
@@ -666,7 +753,7 @@ out:
 	     * due to errors.
 	     */
 
-	    if (! pktSent)
+	    if (! pktSent && ! sackrxmt)
 		{
 		if (! SEQ_GT(tp->snd_up, tp->snd_nxt)) 
 		    {
@@ -711,7 +798,7 @@ out:
 			 */
 			if (tp->t_rtt == 0) 
 			    {
-			    tp->t_rtt = 1;
+			    tcp_rtt_start(tp);
 			    tp->t_rtseq = startseq;
 			    tcpstat.tcps_segstimed++;
 			    }
@@ -728,10 +815,10 @@ out:
 		    if (tp->t_timer[TCPT_REXMT] == 0 &&
 			tp->snd_nxt != tp->snd_una) 
 			{
-			tp->t_timer[TCPT_REXMT] = tp->t_rxtcur;
+			tcp_timer_set(tp, TCPT_REXMT, tp->t_rxtcur);
 			if (tp->t_timer[TCPT_PERSIST]) 
 			    {
-			    tp->t_timer[TCPT_PERSIST] = 0;
+			    tcp_timer_set(tp, TCPT_PERSIST, 0);
 			    tp->t_rxtshift = 0;
 			    }
 			}
@@ -788,15 +875,17 @@ tcp_setpersist(tp)
 	register struct tcpcb *tp;
 {
 	register int t = ((tp->t_srtt >> 2) + tp->t_rttvar) >> 1;
+	int persist;
 
 	if (tp->t_timer[TCPT_REXMT])
 		panic("tcp_output REXMT");
 	/*
 	 * Start/restart persistance timer.
 	 */
-	TCPT_RANGESET(tp->t_timer[TCPT_PERSIST],
+	TCPT_RANGESET(persist,
 	    t * tcp_backoff[tp->t_rxtshift],
 	    TCPTV_PERSMIN, TCPTV_PERSMAX);
+	tcp_timer_set(tp, TCPT_PERSIST, persist);
 	if (tp->t_rxtshift < TCP_MAXRXTSHIFT)
 		tp->t_rxtshift++;
 }
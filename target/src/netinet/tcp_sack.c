@@ -0,0 +1,864 @@
+/* tcp_sack.c - TCP selective acknowledgments and loss recovery */
+
+/* Copyright 2002 Wind River Systems, Inc. */
+#include "copyright_wrs.h"
+
+/*
+modification history
+--------------------
+01b,17oct26,agt  resend snd_una when recovery starts with an empty scoreboard;
+		 keep the retransmit timer running through a recovery.
+01a,17oct26,agt  written.
+*/
+
+/*
+DESCRIPTION
+This library adds selective acknowledgments (RFC 2018) and NewReno
+partial-ACK handling (RFC 6582) to TCP loss recovery.
+
+A connection uses SACK when both SYNs carry the SACK-permitted option;
+'tcp_do_sack' controls whether this side offers it.  The receiver then
+describes the out-of-order data in its reassembly queue with a SACK
+option on each ACK, most recently received block first.  The sender keeps
+the blocks it is told about in a small scoreboard and, once three
+duplicate ACKs start a recovery, retransmits only the holes between
+them.  How much it may send is governed by an estimate of the data still
+in the network (the "pipe"): the data above the highest SACKed sequence
+number, plus the retransmissions not yet acknowledged.  tcp_output()
+asks tcp_sack_output() what to send next.
+
+Without SACK, recovery follows NewReno: a partial ACK -- one that
+acknowledges some but not all of the data outstanding when recovery
+began -- retransmits the next unacknowledged segment at once rather than
+waiting for a timeout, and recovery only ends when all of that data has
+been acknowledged.  In both cases, duplicate ACKs for data sent before a
+recovery or a retransmission timeout do not start a new recovery.
+
+The state this library keeps for a connection is allocated after the
+tcpcb, following the timer state, by tcp_newtcpcb().
+
+INCLUDE FILES:
+
+SEE ALSO: tcpShow
+*/
+
+#include "vxWorks.h"
+#include "stdio.h"
+#include "net/mbuf.h"
+#include "net/protosw.h"
+#include "sys/socket.h"
+#include "net/socketvar.h"
+#include "net/route.h"
+
+#include "netinet/in.h"
+#include "netinet/in_pcb.h"
+#include "netinet/in_systm.h"
+#include "netinet/ip.h"
+#include "netinet/ip_var.h"
+#include "netinet/tcp.h"
+#include "netinet/tcp_fsm.h"
+#include "netinet/tcp_seq.h"
+#include "netinet/tcp_timer.h"
+#include "netinet/tcp_var.h"
+#include "netinet/tcpip.h"
+
+#ifdef VIRTUAL_STACK
+#include "netinet/vsLib.h"
+#endif
+
+/* defines */
+
+#ifndef TCPOPT_SACK_PERMITTED
+#define TCPOPT_SACK_PERMITTED	4		/* RFC 2018 */
+#define TCPOLEN_SACK_PERMITTED	2
+#endif
+#ifndef TCPOPT_SACK
+#define TCPOPT_SACK		5
+#endif
+
+#define TCPOLEN_SACK_BLOCK	8		/* one left/right edge pair */
+#define TCP_SACK_MAXOPT		4		/* blocks in one option */
+#define TCP_SACK_SBSIZE		8		/* blocks in the scoreboard */
+
+/* sx_flags */
+
+#define SACKF_REQ		0x01		/* we offered SACK */
+#define SACKF_RCVD		0x02		/* peer offered SACK */
+#define SACKF_RECOVERY		0x04		/* in fast recovery */
+#define SACKF_RECOVER_SET	0x08		/* sx_recover is valid */
+#define SACKF_FORCE		0x10		/* resend first hole regardless */
+#define SACKF_NEWSACK		0x20		/* scoreboard grew */
+
+#define SACK_ON(sx)	(((sx)->sx_flags & (SACKF_REQ | SACKF_RCVD)) == \
+			 (SACKF_REQ | SACKF_RCVD))
+
+#define tptosackext(tp)	\
+	((struct tcp_sackext *)((char *)((tp) + 1) + tcp_tmextlen))
+
+/* typedefs */
+
+struct tcp_sackblk		/* a range of sequence space */
+    {
+    tcp_seq		sb_start;	/* first sequence number */
+    tcp_seq		sb_end;		/* sequence number after last */
+    };
+
+struct tcp_sackext		/* SACK and recovery state of a tcpcb */
+    {
+    int			sx_flags;	/* SACKF_xxx */
+    tcp_seq		sx_recover;	/* snd_max when recovery began */
+    tcp_seq		sx_rxtnext;	/* holes below this have been resent */
+    int			sx_nblks;	/* blocks in sx_sb */
+    struct tcp_sackblk	sx_sb [TCP_SACK_SBSIZE]; /* SACKed data, ascending */
+    struct tcp_sackblk	sx_rcvlast;	/* last out-of-order data received */
+
+    u_long		sx_recoveries;	/* fast recoveries entered */
+    u_long		sx_partialacks;	/* partial ACKs during recovery */
+    u_long		sx_sackrxmts;	/* segments resent from SACK holes */
+    u_long		sx_timeouts;	/* recoveries ended by timeout */
+    u_long		sx_blksrcvd;	/* SACK blocks received */
+    u_long		sx_blkssent;	/* SACK blocks sent */
+    };
+
+/* globals */
+
+int	tcp_do_sack = 1;		/* offer SACK on new connections */
+int	tcp_sackextlen = sizeof (struct tcp_sackext);
+
+u_long	tcp_recoveries;			/* fast recoveries entered */
+u_long	tcp_partialacks;		/* partial ACKs during recovery */
+u_long	tcp_sackrexmits;		/* segments resent from SACK holes */
+
+/* externals */
+
+IMPORT int	tcp_tmextlen;
+IMPORT void	tcp_timer_set ();
+
+/* forward declarations */
+
+LOCAL void	tcp_sack_prune (struct tcpcb * tp, struct tcp_sackext * sx);
+LOCAL void	tcp_sack_doack (struct tcpcb * tp, struct tcp_sackext * sx,
+				u_char * cp, int optlen);
+LOCAL void	tcp_sack_insert (struct tcp_sackext * sx, tcp_seq start,
+				 tcp_seq end);
+
+/*******************************************************************************
+*
+* tcp_sack_attach - initialize the SACK state of a new tcpcb
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void tcp_sack_attach
+    (
+    struct tcpcb *	tp		/* new control block */
+    )
+    {
+    bzero ((char *) tptosackext (tp), sizeof (struct tcp_sackext));
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_option - process a SACK-permitted or SACK option
+*
+* tcp_dooptions() passes every option it does not handle itself to this
+* routine.  SACK-permitted is only honoured on a SYN; SACK blocks are
+* only used once both sides have offered SACK.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void tcp_sack_option
+    (
+    struct tcpcb *	tp,		/* control block */
+    u_char *		cp,		/* option */
+    int			optlen,		/* option length */
+    int			tiflags		/* segment flags */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+
+    switch (cp[0])
+	{
+	case TCPOPT_SACK_PERMITTED:
+	    if (optlen == TCPOLEN_SACK_PERMITTED && (tiflags & TH_SYN) &&
+		tcp_do_sack)
+		sx->sx_flags |= SACKF_RCVD;
+	    break;
+
+	case TCPOPT_SACK:
+	    if (SACK_ON (sx) && optlen > 2 &&
+		(optlen - 2) % TCPOLEN_SACK_BLOCK == 0 &&
+		TCPS_HAVEESTABLISHED (tp->t_state))
+		tcp_sack_doack (tp, sx, cp + 2, optlen - 2);
+	    break;
+	}
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_synopt - add the SACK-permitted option to a SYN
+*
+* The option is offered on a SYN if 'tcp_do_sack' is set, and on a
+* SYN-ACK only if the peer offered it too.
+*
+* RETURNS: the number of option bytes added, 0 or 4.
+*
+* NOMANUAL
+*/
+
+int tcp_sack_synopt
+    (
+    struct tcpcb *	tp,		/* control block */
+    int			flags,		/* segment flags */
+    u_char *		opt		/* where to put the option */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+
+    if (!tcp_do_sack ||
+	((flags & TH_ACK) && (sx->sx_flags & SACKF_RCVD) == 0))
+	return (0);
+
+    sx->sx_flags |= SACKF_REQ;
+
+    opt[0] = TCPOPT_NOP;
+    opt[1] = TCPOPT_NOP;
+    opt[2] = TCPOPT_SACK_PERMITTED;
+    opt[3] = TCPOLEN_SACK_PERMITTED;
+    return (4);
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_rcvd - note the latest out-of-order segment received
+*
+* tcp_reass() calls this routine for each segment it queues, so that the
+* next SACK option can report the block holding it first.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void tcp_sack_rcvd
+    (
+    struct tcpcb *	tp,		/* control block */
+    tcp_seq		seq,		/* first sequence number queued */
+    int			len		/* bytes queued */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+
+    sx->sx_rcvlast.sb_start = seq;
+    sx->sx_rcvlast.sb_end = seq + len;
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_addopt - add a SACK option describing the reassembly queue
+*
+* This routine builds the blocks of contiguous data in the reassembly
+* queue.  The block holding the most recently received segment goes
+* first, followed by the others in ascending order, as many as fit in
+* <room> bytes.
+*
+* RETURNS: the number of option bytes added.
+*
+* NOMANUAL
+*/
+
+int tcp_sack_addopt
+    (
+    struct tcpcb *	tp,		/* control block */
+    u_char *		opt,		/* where to put the option */
+    int			room		/* bytes free for options */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+    struct tcp_sackblk		blks [TCP_SACK_MAXOPT];
+    struct tcp_sackblk		last;
+    struct tcpiphdr *		q;
+    tcp_seq			start;
+    tcp_seq			end;
+    BOOL			haveLast = FALSE;
+    int				nmax;
+    int				n = 0;
+    int				ix;
+    u_char *			cp;
+
+    if (!SACK_ON (sx) || tp->seg_next == (struct tcpiphdr *) tp)
+	return (0);
+
+    if ((nmax = (room - 4) / TCPOLEN_SACK_BLOCK) > TCP_SACK_MAXOPT)
+	nmax = TCP_SACK_MAXOPT;
+    if (nmax <= 0)
+	return (0);
+
+    for (q = tp->seg_next; q != (struct tcpiphdr *) tp; )
+	{
+	start = q->ti_seq;
+	end = start + q->ti_len;
+	for (q = (struct tcpiphdr *) q->ti_next;
+	     q != (struct tcpiphdr *) tp && SEQ_LEQ (q->ti_seq, end);
+	     q = (struct tcpiphdr *) q->ti_next)
+	    if (SEQ_GT (q->ti_seq + q->ti_len, end))
+		end = q->ti_seq + q->ti_len;
+
+	if (!haveLast && SEQ_LEQ (start, sx->sx_rcvlast.sb_start) &&
+	    SEQ_LT (sx->sx_rcvlast.sb_start, end))
+	    {
+	    last.sb_start = start;
+	    last.sb_end = end;
+	    haveLast = TRUE;
+	    }
+	else if (n < nmax)
+	    {
+	    blks [n].sb_start = start;
+	    blks [n].sb_end = end;
+	    n++;
+	    }
+	}
+
+    if (haveLast)
+	{
+	for (ix = (n < nmax) ? n : nmax - 1; ix > 0; ix--)
+	    blks [ix] = blks [ix - 1];
+	blks [0] = last;
+	if (n < nmax)
+	    n++;
+	}
+
+    opt[0] = TCPOPT_NOP;
+    opt[1] = TCPOPT_NOP;
+    opt[2] = TCPOPT_SACK;
+    opt[3] = 2 + n * TCPOLEN_SACK_BLOCK;
+
+    for (ix = 0, cp = opt + 4; ix < n; ix++, cp += TCPOLEN_SACK_BLOCK)
+	{
+	start = htonl (blks [ix].sb_start);
+	end = htonl (blks [ix].sb_end);
+	bcopy ((char *) &start, (char *) cp, sizeof (start));
+	bcopy ((char *) &end, (char *) cp + 4, sizeof (end));
+	}
+
+    sx->sx_blkssent += n;
+    return (4 + n * TCPOLEN_SACK_BLOCK);
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_doack - enter the blocks of a received SACK option
+*
+* Blocks that lie outside the unacknowledged data are ignored.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void tcp_sack_doack
+    (
+    struct tcpcb *		tp,	/* control block */
+    struct tcp_sackext *	sx,	/* its SACK state */
+    u_char *			cp,	/* first block */
+    int				len	/* bytes of blocks */
+    )
+    {
+    tcp_seq			start;
+    tcp_seq			end;
+    int				ix;
+
+    tcp_sack_prune (tp, sx);
+
+    for (; len >= TCPOLEN_SACK_BLOCK;
+	 cp += TCPOLEN_SACK_BLOCK, len -= TCPOLEN_SACK_BLOCK)
+	{
+	bcopy ((char *) cp, (char *) &start, sizeof (start));
+	bcopy ((char *) cp + 4, (char *) &end, sizeof (end));
+	NTOHL (start);
+	NTOHL (end);
+
+	if (SEQ_LEQ (end, start) || SEQ_LEQ (end, tp->snd_una) ||
+	    SEQ_GT (end, tp->snd_max))
+	    continue;
+	if (SEQ_LT (start, tp->snd_una))
+	    start = tp->snd_una;
+
+	sx->sx_blksrcvd++;
+
+	for (ix = 0; ix < sx->sx_nblks; ix++)
+	    if (SEQ_LEQ (sx->sx_sb [ix].sb_start, start) &&
+		SEQ_GEQ (sx->sx_sb [ix].sb_end, end))
+		break;
+	if (ix < sx->sx_nblks)
+	    continue;				/* nothing new */
+
+	tcp_sack_insert (sx, start, end);
+	sx->sx_flags |= SACKF_NEWSACK;
+	}
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_insert - merge a block into the scoreboard
+*
+* Blocks that overlap or touch the new one are merged with it.  If the
+* scoreboard overflows, the highest block is forgotten; that data will
+* simply be thought to be still in the network.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void tcp_sack_insert
+    (
+    struct tcp_sackext *	sx,	/* SACK state */
+    tcp_seq			start,	/* new block */
+    tcp_seq			end
+    )
+    {
+    struct tcp_sackblk		blks [TCP_SACK_SBSIZE + 1];
+    struct tcp_sackblk *	sb;
+    BOOL			done = FALSE;
+    int				n = 0;
+    int				ix;
+
+    for (ix = 0; ix < sx->sx_nblks; ix++)
+	{
+	sb = &sx->sx_sb [ix];
+	if (SEQ_LT (sb->sb_end, start))
+	    blks [n++] = *sb;
+	else if (SEQ_GT (sb->sb_start, end))
+	    {
+	    if (!done)
+		{
+		blks [n].sb_start = start;
+		blks [n++].sb_end = end;
+		done = TRUE;
+		}
+	    blks [n++] = *sb;
+	    }
+	else
+	    {
+	    if (SEQ_LT (sb->sb_start, start))
+		start = sb->sb_start;
+	    if (SEQ_GT (sb->sb_end, end))
+		end = sb->sb_end;
+	    }
+	}
+
+    if (!done)
+	{
+	blks [n].sb_start = start;
+	blks [n++].sb_end = end;
+	}
+
+    if (n > TCP_SACK_SBSIZE)
+	n = TCP_SACK_SBSIZE;
+
+    bcopy ((char *) blks, (char *) sx->sx_sb, n * sizeof (blks [0]));
+    sx->sx_nblks = n;
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_prune - drop scoreboard blocks the cumulative ACK has covered
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void tcp_sack_prune
+    (
+    struct tcpcb *		tp,	/* control block */
+    struct tcp_sackext *	sx	/* its SACK state */
+    )
+    {
+    int				ix;
+
+    for (ix = 0; ix < sx->sx_nblks && SEQ_LEQ (sx->sx_sb [ix].sb_end,
+					       tp->snd_una); ix++)
+	;
+
+    if (ix > 0)
+	{
+	sx->sx_nblks -= ix;
+	bcopy ((char *) &sx->sx_sb [ix], (char *) sx->sx_sb,
+	       sx->sx_nblks * sizeof (sx->sx_sb [0]));
+	}
+
+    if (sx->sx_nblks > 0 && SEQ_LT (sx->sx_sb [0].sb_start, tp->snd_una))
+	sx->sx_sb [0].sb_start = tp->snd_una;
+
+    if (SEQ_LT (sx->sx_rxtnext, tp->snd_una))
+	sx->sx_rxtnext = tp->snd_una;
+    }
+
+/*******************************************************************************
+*
+* tcp_inrecovery - tell whether a connection is in fast recovery
+*
+* RETURNS: non-zero if <tp> is in fast recovery.
+*
+* NOMANUAL
+*/
+
+int tcp_inrecovery
+    (
+    struct tcpcb *	tp		/* control block */
+    )
+    {
+    return (tptosackext (tp)->sx_flags & SACKF_RECOVERY);
+    }
+
+/*******************************************************************************
+*
+* tcp_recovery_enter - start fast recovery on the third duplicate ACK
+*
+* The slow start threshold is halved.  With SACK, the congestion window
+* becomes the new threshold and tcp_output() resends the holes as the
+* pipe allows, starting with the first one.  Without SACK, the first
+* unacknowledged segment is resent and the window is inflated by the
+* segments the duplicate ACKs show have left the network.
+*
+* RETURNS: 0 if the ACK is for data sent before the last recovery or
+* timeout and no recovery was started, otherwise 1.
+*
+* NOMANUAL
+*/
+
+int tcp_recovery_enter
+    (
+    struct tcpcb *	tp		/* control block */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+    tcp_seq			onxt;
+    u_int			win;
+
+    if ((sx->sx_flags & SACKF_RECOVER_SET) &&
+	SEQ_LEQ (tp->snd_una, sx->sx_recover))
+	return (0);
+
+    win = min (tp->snd_wnd, tp->snd_cwnd) / 2 / tp->t_maxseg;
+    if (win < 2)
+	win = 2;
+    tp->snd_ssthresh = win * tp->t_maxseg;
+
+    sx->sx_recover = tp->snd_max;
+    sx->sx_flags |= SACKF_RECOVERY | SACKF_RECOVER_SET;
+    sx->sx_recoveries++;
+    tcp_recoveries++;
+
+    tcp_timer_set (tp, TCPT_REXMT, 0);
+    tp->t_rtt = 0;
+
+    if (SACK_ON (sx))
+	{
+	tcp_sack_prune (tp, sx);
+	sx->sx_rxtnext = tp->snd_una;
+	sx->sx_flags |= SACKF_FORCE;
+	sx->sx_flags &= ~SACKF_NEWSACK;
+	tp->snd_cwnd = tp->snd_ssthresh;
+	(void) tcp_output (tp);
+
+	/* the timer was stopped above; if nothing went out, restart it */
+
+	if (tp->t_timer[TCPT_REXMT] == 0)
+	    tcp_timer_set (tp, TCPT_REXMT, tp->t_rxtcur);
+	return (1);
+	}
+
+    onxt = tp->snd_nxt;
+    tp->snd_nxt = tp->snd_una;
+    tp->snd_cwnd = tp->t_maxseg;
+    (void) tcp_output (tp);
+    tp->snd_cwnd = tp->snd_ssthresh + tp->t_maxseg * tp->t_dupacks;
+    if (SEQ_GT (onxt, tp->snd_nxt))
+	tp->snd_nxt = onxt;
+    return (1);
+    }
+
+/*******************************************************************************
+*
+* tcp_recovery_dupack - handle a further duplicate ACK during recovery
+*
+* With SACK, a duplicate ACK that reports new blocks has shrunk the pipe
+* and tcp_output() may send again.  One that does not -- or any one
+* without SACK -- inflates the congestion window by a segment, as the
+* segment it acknowledges has left the network.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void tcp_recovery_dupack
+    (
+    struct tcpcb *	tp		/* control block */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+
+    if (!SACK_ON (sx) || (sx->sx_flags & SACKF_NEWSACK) == 0)
+	tp->snd_cwnd += tp->t_maxseg;
+    sx->sx_flags &= ~SACKF_NEWSACK;
+
+    (void) tcp_output (tp);
+    }
+
+/*******************************************************************************
+*
+* tcp_recovery_ack - handle an ACK for new data
+*
+* This routine is called before snd_una is advanced to <ack>.  An ACK
+* that covers all the data outstanding when recovery began ends the
+* recovery, with the congestion window set to the slow start threshold
+* or to what is still in flight plus one segment, whichever is less.
+* A partial ACK keeps the connection in recovery and restarts the
+* retransmit timer: without SACK, the segment at <ack> is resent at once
+* and the window deflated by the data acknowledged; with SACK, the caller
+* just calls tcp_output() once the ACK has been processed.
+*
+* RETURNS: 1 if the connection is still in recovery, otherwise 0.
+*
+* NOMANUAL
+*/
+
+int tcp_recovery_ack
+    (
+    struct tcpcb *	tp,		/* control block */
+    tcp_seq		ack		/* acknowledgment number */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+    tcp_seq			onxt;
+    u_long			ocwnd;
+    u_long			acked;
+    u_long			flight;
+
+    if ((sx->sx_flags & SACKF_RECOVERY) == 0)
+	return (0);
+
+    if (SEQ_GEQ (ack, sx->sx_recover))
+	{
+	sx->sx_flags &= ~(SACKF_RECOVERY | SACKF_FORCE | SACKF_NEWSACK);
+	flight = tp->snd_max - ack;
+	tp->snd_cwnd = min (tp->snd_ssthresh, flight + tp->t_maxseg);
+	return (0);
+	}
+
+    sx->sx_partialacks++;
+    tcp_partialacks++;
+
+    /* restart rather than stop the timer, tcp_output() may send nothing */
+
+    tcp_timer_set (tp, TCPT_REXMT, tp->t_rxtcur);
+    tp->t_rtt = 0;
+
+    if (SACK_ON (sx))
+	return (1);
+
+    acked = ack - tp->snd_una;
+    onxt = tp->snd_nxt;
+    ocwnd = tp->snd_cwnd;
+    tp->snd_nxt = ack;
+    tp->snd_cwnd = tp->t_maxseg + acked;
+    tp->t_flags |= TF_ACKNOW;
+    (void) tcp_output (tp);
+    tp->snd_cwnd = ocwnd;
+    if (SEQ_GT (onxt, tp->snd_nxt))
+	tp->snd_nxt = onxt;
+
+    if (tp->snd_cwnd > acked)
+	tp->snd_cwnd -= acked;
+    else
+	tp->snd_cwnd = 0;
+    tp->snd_cwnd += tp->t_maxseg;
+    return (1);
+    }
+
+/*******************************************************************************
+*
+* tcp_recovery_timeout - end any recovery when the retransmit timer fires
+*
+* The scoreboard is cleared, since the receiver may discard data it has
+* SACKed, and duplicate ACKs for data already sent will not start a
+* new fast recovery.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void tcp_recovery_timeout
+    (
+    struct tcpcb *	tp		/* control block */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+
+    if (sx->sx_flags & SACKF_RECOVERY)
+	sx->sx_timeouts++;
+
+    sx->sx_flags &= ~(SACKF_RECOVERY | SACKF_FORCE | SACKF_NEWSACK);
+    sx->sx_flags |= SACKF_RECOVER_SET;
+    sx->sx_recover = tp->snd_max;
+    sx->sx_nblks = 0;
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_output - decide what tcp_output() may send during SACK recovery
+*
+* The pipe is the data above the highest SACKed sequence number plus the
+* resent data below it that is neither acknowledged nor SACKed; the room
+* left is the congestion window less the pipe.  If there is a hole that
+* has not been resent yet, and it fits in that room (the first hole of a
+* recovery is resent regardless), up to one segment of it is returned
+* in <pSeq> and <pLen>.  Otherwise <pLen> is zero and only new data may
+* be sent, up to the room returned -- none while a hole is waiting.
+*
+* If the scoreboard is empty when the recovery starts, the duplicate ACKs
+* still show that the segment at snd_una is lost; it is the first hole.
+*
+* RETURNS: the room in the pipe, or -1 if not in SACK recovery.
+*
+* NOMANUAL
+*/
+
+long tcp_sack_output
+    (
+    struct tcpcb *	tp,		/* control block */
+    tcp_seq *		pSeq,		/* where to return hole to resend */
+    long *		pLen		/* where to return its length */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+    struct tcp_sackblk *	sb;
+    tcp_seq			fack;
+    tcp_seq			rxtend;
+    tcp_seq			seq;
+    long			pipe;
+    long			cwin;
+    long			len;
+    int				ix;
+
+    *pLen = 0;
+
+    if ((sx->sx_flags & SACKF_RECOVERY) == 0 || !SACK_ON (sx))
+	return (-1);
+
+    tcp_sack_prune (tp, sx);
+
+    fack = (sx->sx_nblks > 0) ? sx->sx_sb [sx->sx_nblks - 1].sb_end :
+				tp->snd_una;
+
+    /* resent data below fack that is still in the network */
+
+    rxtend = SEQ_LT (sx->sx_rxtnext, fack) ? sx->sx_rxtnext : fack;
+    pipe = (long) (tp->snd_max - fack) + (long) (rxtend - tp->snd_una);
+    for (ix = 0, sb = sx->sx_sb; ix < sx->sx_nblks; ix++, sb++)
+	{
+	if (SEQ_GEQ (sb->sb_start, rxtend))
+	    break;
+	pipe -= (long) ((SEQ_LT (sb->sb_end, rxtend) ? sb->sb_end : rxtend) -
+			sb->sb_start);
+	}
+
+    cwin = (long) tp->snd_cwnd - pipe;
+    if (cwin < 0)
+	cwin = 0;
+
+    /* find the first hole at or above sx_rxtnext */
+
+    seq = sx->sx_rxtnext;
+    for (ix = 0, sb = sx->sx_sb; ix < sx->sx_nblks; ix++, sb++)
+	{
+	if (SEQ_LEQ (sb->sb_end, seq))
+	    continue;
+	if (SEQ_GT (sb->sb_start, seq))
+	    break;
+	seq = sb->sb_end;
+	}
+
+    if (SEQ_LT (seq, fack))
+	len = (long) (sb->sb_start - seq);
+    else if ((sx->sx_flags & SACKF_FORCE) && (sx->sx_nblks == 0) &&
+	     SEQ_LT (seq, tp->snd_max))
+	len = (long) (tp->snd_max - seq);	/* seq is snd_una */
+    else
+	return (cwin);
+
+    if (len > tp->t_maxseg)
+	len = tp->t_maxseg;
+
+    if ((sx->sx_flags & SACKF_FORCE) || cwin >= len)
+	{
+	sx->sx_flags &= ~SACKF_FORCE;
+	*pSeq = seq;
+	*pLen = len;
+	return (cwin);
+	}
+
+    return (0);
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_sent - record the resending of part of a hole
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void tcp_sack_sent
+    (
+    struct tcpcb *	tp,		/* control block */
+    tcp_seq		seq,		/* first sequence number resent */
+    long		len		/* bytes resent */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+
+    if (SEQ_GT (seq + len, sx->sx_rxtnext))
+	sx->sx_rxtnext = seq + len;
+    sx->sx_sackrxmts++;
+    tcp_sackrexmits++;
+
+    if (tp->t_timer[TCPT_REXMT] == 0)
+	tcp_timer_set (tp, TCPT_REXMT, tp->t_rxtcur);
+    }
+
+/*******************************************************************************
+*
+* tcp_sack_print - print the SACK and recovery state of a connection
+*
+* This routine prints one line of the tcpRecoveryShow() table.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void tcp_sack_print
+    (
+    struct tcpcb *	tp		/* control block */
+    )
+    {
+    struct tcp_sackext *	sx = tptosackext (tp);
+
+    printf ("%-4s %-3s %6lu %7lu %7lu %7lu %8lu %8lu",
+	    SACK_ON (sx) ? "on" : "off",
+	    (sx->sx_flags & SACKF_RECOVERY) ? "yes" : "no",
+	    sx->sx_recoveries, sx->sx_partialacks, sx->sx_sackrxmts,
+	    sx->sx_timeouts, sx->sx_blksrcvd, sx->sx_blkssent);
+    }
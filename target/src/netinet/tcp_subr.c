@@ -41,6 +41,8 @@
 /*
 modification history
 --------------------
+01g,17oct26,agt  allocate SACK and recovery state after the timer state
+01f,17oct26,agt  allocate TCP timer state after the tcpcb (tcp_tmextlen)
 01e,18apr02,vvv  trigger slow-start in response to ICMP fragmentation-needed
 		 message (SPR #75058)
 01d,12oct01,rae  merge from truestack ver 01o, base 01c (SPRs 70049,
@@ -107,6 +109,11 @@ extern	struct inpcb * tcp_last_inpcb;
 
 #endif /* VIRTUAL_STACK */
 extern void _remque();
+extern int tcp_tmextlen;
+extern void tcp_timer_attach ();
+extern int tcp_sackextlen;
+extern void tcp_sack_attach ();
+extern void tcp_timer_detach ();
 extern int random();
 
 #ifdef WV_INSTRUMENTATION
@@ -339,10 +346,13 @@ tcp_newtcpcb(inp)
 {
 	register struct tcpcb *tp;
 
-	MALLOC(tp, struct tcpcb *, sizeof(*tp), MT_PCB, M_DONTWAIT);
+	MALLOC(tp, struct tcpcb *, sizeof(*tp) + tcp_tmextlen + tcp_sackextlen,
+	    MT_PCB, M_DONTWAIT);
 	if (tp == NULL)
 		return ((struct tcpcb *)0);
 	bzero((char *) tp, sizeof(struct tcpcb));
+	tcp_timer_attach(tp);
+	tcp_sack_attach(tp);
 	tp->seg_next = tp->seg_prev = (struct tcpiphdr *)tp;
 	tp->t_maxseg = tp->t_maxsize = tcp_mssdflt;
 
@@ -517,6 +527,7 @@ tcp_close(tp)
 	}
 	if (tp->t_template)
 		(void) m_free(tp->t_template);
+	tcp_timer_detach(tp);
 	FREE(tp, MT_PCB); 
 	inp->inp_ppcb = 0;
 	soisdisconnected(so);
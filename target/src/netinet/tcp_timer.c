@@ -41,6 +41,9 @@
 /*
 modification history
 --------------------
+01f,17oct26,agt  end fast recovery on a retransmit timeout
+01e,17oct26,agt  replaced per-tick scan of all tcpcbs with timing wheels and
+		 a delayed-ACK queue; added tcp_rexmtfine
 01d,12oct01,rae  merge from truestack ver 01g, base 01f (cleanup, rand hook ...)
 01c,08mar97,vin  added changes to accomodate changes in pcb structure.
 01b,30oct96,vin  changed calls to tcp_respond, mtod(tp->t_template ...).
@@ -49,6 +52,25 @@ modification history
 
 /*
 DESCRIPTION
+The TCP timers are kept on timing wheels rather than being counted down
+in every control block on every tick.  Each armed timer of a connection
+is hashed into a wheel slot by its expiry tick, so tcp_slowtimo() only
+visits the timers in the one slot for the current tick; a timer longer
+than the wheel is passed over, at the cost of one comparison, once per
+revolution until it is due.  Idle time and round trip time are kept as
+the tick they started on instead of as counters, and tcp_fasttimo()
+only visits connections that have a delayed ACK pending.
+
+The t_timer[] entries of the control block still say whether each timer
+is armed, but they are no longer decremented; timers must be armed and
+cancelled with tcp_timer_set().
+
+When 'tcp_rexmtfine' is set, retransmit timers are armed on a second
+wheel driven by tcp_fasttimo(), so that they expire within a fast tick
+of their due time instead of anywhere within the slow tick they fall in.
+
+Under VIRTUAL_STACK the timers are counted down by a scan of all control
+blocks, as before.
 */
 
 #include "vxWorks.h"
@@ -92,10 +114,62 @@ int	tcp_keepcnt = TCPTV_KEEPCNT;
 int	tcp_keepinit = TCPTV_KEEP_INIT;
 int	tcp_maxpersistidle = TCPTV_KEEP_IDLE;   /* max idle time in persist */
 int     tcp_maxidle;
+int	tcp_rexmtfine = 0;	/* retransmit timer on the fast wheel */
+
+#endif /* VIRTUAL_STACK */
+
+#ifndef VIRTUAL_STACK
+
+#define	TCP_WHEEL_SIZE	512	/* slots per wheel, a power of 2 */
+#define	TCP_WHEEL_MASK	(TCP_WHEEL_SIZE - 1)
+
+/* an armed timer, hashed into a wheel slot by its expiry tick */
+
+struct tcp_tment {
+	struct tcp_tment *	te_next;	/* next timer in slot */
+	struct tcp_tment **	te_pprev;	/* link to us, NULL if idle */
+	u_long			te_expire;	/* wheel tick it expires on */
+	struct tcpcb *		te_tp;		/* connection it belongs to */
+	int			te_timer;	/* TCPT_xxx */
+};
+
+/*
+ * Timer state of a connection.  tcp_newtcpcb() allocates this directly
+ * after the tcpcb itself, so that the control block layout seen by the
+ * rest of the stack does not change.
+ */
+struct tcp_tmext {
+	struct tcp_tment	tx_ent[TCPT_NTIMERS];	/* the timers */
+	struct tcp_tmext *	tx_dnext;	/* delayed ACK queue link */
+	struct tcp_tmext **	tx_dpprev;	/* link to us, NULL if idle */
+	struct tcpcb *		tx_tp;		/* connection */
+	u_long			tx_idlebase;	/* tick of last activity */
+	u_long			tx_rttbase;	/* tick rtt timing started */
+};
+
+#define	tptotmext(tp)	((struct tcp_tmext *)((tp) + 1))
+
+struct tcp_wheel {
+	struct tcp_tment *	tw_slot[TCP_WHEEL_SIZE];
+	u_long			tw_now;		/* current tick */
+};
+
+LOCAL struct tcp_wheel	tcp_slowwheel;	/* PR_SLOWHZ timers */
+LOCAL struct tcp_wheel	tcp_fastwheel;	/* PR_FASTHZ retransmit timers */
+LOCAL struct tcp_tmext *tcp_delackq;	/* connections owing an ACK */
+
+int	tcp_tmextlen = sizeof (struct tcp_tmext);
+
+LOCAL void tcp_wheel_run (struct tcp_wheel *);
+
+#else
+
+int	tcp_tmextlen = 0;
 
 #endif /* VIRTUAL_STACK */
 
 IMPORT unsigned long (*pTcpRandHook)(void);
+IMPORT void tcp_recovery_timeout ();
 
 #ifdef WV_INSTRUMENTATION
 #ifdef INCLUDE_WVNET
@@ -114,7 +188,12 @@ LOCAL ULONG wvNetEventId;       /* Event identifier: see wvNetLib.h */
 void
 tcp_fasttimo()
 {
+#ifdef VIRTUAL_STACK
 	register struct inpcb *inp;
+#else
+	struct tcp_tmext *work;
+	register struct tcp_tmext *tx;
+#endif
 	register struct tcpcb *tp;
 	int s;
 
@@ -127,6 +206,7 @@ tcp_fasttimo()
 
         s = splnet();
 
+#ifdef VIRTUAL_STACK
         for (inp = tcb.lh_first; inp != NULL; inp = inp->inp_list.le_next) {
 		if ((tp = (struct tcpcb *)inp->inp_ppcb) &&
 		    (tp->t_flags & TF_DELACK)) {
@@ -136,24 +216,52 @@ tcp_fasttimo()
 			(void) tcp_output(tp);
 		}
         }
+#else
+	/*
+	 * Take the whole delayed ACK queue, so that connections queued
+	 * again by tcp_output() wait for the next tick.  A connection
+	 * that has sent its ACK since it was queued has no TF_DELACK.
+	 */
+	if ((work = tcp_delackq) != NULL) {
+		work->tx_dpprev = &work;
+		tcp_delackq = NULL;
+	}
+	while ((tx = work) != NULL) {
+		if ((work = tx->tx_dnext) != NULL)
+			work->tx_dpprev = &work;
+		tx->tx_dpprev = NULL;
+		tp = tx->tx_tp;
+		if (tp->t_flags & TF_DELACK) {
+			tp->t_flags &= ~TF_DELACK;
+			tp->t_flags |= TF_ACKNOW;
+			tcpstat.tcps_delack++;
+			(void) tcp_output(tp);
+		}
+	}
+
+	tcp_fastwheel.tw_now++;
+	tcp_wheel_run(&tcp_fastwheel);
+#endif /* VIRTUAL_STACK */
 	splx(s);
 }
 
 /*
  * Tcp protocol timeout routine called every 500 ms.
- * Updates the timers in all active tcb's and
- * causes finite state machine actions if timers expire.
+ * Causes finite state machine actions for the timers
+ * that expire on this tick.
  */
 void
 tcp_slowtimo()
 {
+	int s = splnet();
+#ifdef VIRTUAL_STACK
 	register struct inpcb *ip, *ipnxt;
 	register struct tcpcb *tp;
-	int s = splnet();
 #ifdef BSDDEBUG
         int ostate;
 #endif
 	register int i;
+#endif /* VIRTUAL_STACK */
 
 #ifdef WV_INSTRUMENTATION
 #ifdef INCLUDE_WVNET    /* WV_NET_INFO event */
@@ -164,6 +272,7 @@ tcp_slowtimo()
 
 	tcp_maxidle = tcp_keepcnt * tcp_keepintvl;
 
+#ifdef VIRTUAL_STACK
 	/*
 	 * Search through tcb's and update active timers.
 	 */
@@ -201,8 +310,10 @@ tcp_slowtimo()
 tpgone:
 		;
 	}
-
-
+#else
+	tcp_slowwheel.tw_now++;
+	tcp_wheel_run(&tcp_slowwheel);
+#endif /* VIRTUAL_STACK */
 
 	tcp_iss += TCP_ISSINCR/PR_SLOWHZ +
 	           ((0x0000ffff) & (pTcpRandHook() >> 16));
@@ -215,6 +326,99 @@ tpgone:
 	splx(s);
 }
 
+#ifndef VIRTUAL_STACK
+/*
+ * Run the timers in the slot for the current tick of wheel w.
+ * The slot is taken as a whole first: timers that are not due
+ * until a later revolution go back into it, and timers armed by
+ * tcp_timers() go into the wheel without being seen again now.
+ * A connection closed by tcp_timers() removes its other timers
+ * from the work list as it goes.
+ */
+LOCAL void
+tcp_wheel_run(w)
+	register struct tcp_wheel *w;
+{
+	struct tcp_tment **slot = &w->tw_slot[w->tw_now & TCP_WHEEL_MASK];
+	struct tcp_tment *work;
+	register struct tcp_tment *te;
+	register struct tcpcb *tp;
+#ifdef BSDDEBUG
+        int ostate;
+#endif
+
+	if ((work = *slot) != NULL) {
+		work->te_pprev = &work;
+		*slot = NULL;
+	}
+	while ((te = work) != NULL) {
+		if ((work = te->te_next) != NULL)
+			work->te_pprev = &work;
+		if (te->te_expire != w->tw_now) {
+			if ((te->te_next = *slot) != NULL)
+				te->te_next->te_pprev = &te->te_next;
+			*slot = te;
+			te->te_pprev = slot;
+			continue;
+		}
+		te->te_pprev = NULL;
+		tp = te->te_tp;
+		if (tp->t_state == TCPS_LISTEN)
+			continue;
+		tp->t_timer[te->te_timer] = 0;
+#ifdef BSDDEBUG
+		ostate = tp->t_state;
+#endif
+		tp = tcp_timers(tp, te->te_timer);
+#ifdef BSDDEBUG
+		if (tp != NULL &&
+		    tp->t_inpcb->inp_socket->so_options & SO_DEBUG)
+			(*tcpTraceRtn)(TA_USER, ostate, tp,
+				       (struct tcpiphdr *)0, PRU_SLOWTIMO);
+#endif
+	}
+}
+#endif /* VIRTUAL_STACK */
+
+/*
+ * Arm timer "timer" of tp to go off in "value" slow ticks,
+ * or cancel it if "value" is zero.
+ */
+void
+tcp_timer_set(tp, timer, value)
+	register struct tcpcb *tp;
+	int timer;
+	int value;
+{
+#ifndef VIRTUAL_STACK
+	register struct tcp_tment *te = &tptotmext(tp)->tx_ent[timer];
+	register struct tcp_wheel *w;
+	struct tcp_tment **slot;
+
+	if (te->te_pprev != NULL) {
+		if ((*te->te_pprev = te->te_next) != NULL)
+			te->te_next->te_pprev = te->te_pprev;
+		te->te_pprev = NULL;
+	}
+#endif
+	tp->t_timer[timer] = value;
+#ifndef VIRTUAL_STACK
+	if (value <= 0)
+		return;
+	if (timer == TCPT_REXMT && tcp_rexmtfine) {
+		w = &tcp_fastwheel;
+		value = (value * PR_FASTHZ + PR_SLOWHZ - 1) / PR_SLOWHZ;
+	} else
+		w = &tcp_slowwheel;
+	te->te_expire = w->tw_now + value;
+	slot = &w->tw_slot[te->te_expire & TCP_WHEEL_MASK];
+	if ((te->te_next = *slot) != NULL)
+		te->te_next->te_pprev = &te->te_next;
+	*slot = te;
+	te->te_pprev = slot;
+#endif
+}
+
 /*
  * Cancel all timers for TCP tp.
  */
@@ -225,7 +429,123 @@ tcp_canceltimers(tp)
 	register int i;
 
 	for (i = 0; i < TCPT_NTIMERS; i++)
-		tp->t_timer[i] = 0;
+		tcp_timer_set(tp, i, 0);
+}
+
+/*
+ * Initialize the timer state of a new tcpcb.
+ * tcp_newtcpcb() allocates tcp_tmextlen bytes for it after tp.
+ */
+void
+tcp_timer_attach(tp)
+	register struct tcpcb *tp;
+{
+#ifndef VIRTUAL_STACK
+	register struct tcp_tmext *tx = tptotmext(tp);
+	register int i;
+
+	bzero((char *)tx, sizeof (*tx));
+	for (i = 0; i < TCPT_NTIMERS; i++) {
+		tx->tx_ent[i].te_tp = tp;
+		tx->tx_ent[i].te_timer = i;
+	}
+	tx->tx_tp = tp;
+	tx->tx_idlebase = tcp_slowwheel.tw_now;
+#endif
+}
+
+/*
+ * Take tp off the timer wheels and the delayed ACK
+ * queue before it is freed.
+ */
+void
+tcp_timer_detach(tp)
+	register struct tcpcb *tp;
+{
+#ifndef VIRTUAL_STACK
+	register struct tcp_tmext *tx = tptotmext(tp);
+
+	tcp_canceltimers(tp);
+	if (tx->tx_dpprev != NULL) {
+		if ((*tx->tx_dpprev = tx->tx_dnext) != NULL)
+			tx->tx_dnext->tx_dpprev = tx->tx_dpprev;
+		tx->tx_dpprev = NULL;
+	}
+#endif
+}
+
+/*
+ * Mark tp as owing a delayed ACK, to be sent by the next
+ * tcp_fasttimo() unless tcp_output() sends one first.
+ */
+void
+tcp_delack(tp)
+	register struct tcpcb *tp;
+{
+#ifndef VIRTUAL_STACK
+	register struct tcp_tmext *tx = tptotmext(tp);
+
+	if (tx->tx_dpprev == NULL) {
+		if ((tx->tx_dnext = tcp_delackq) != NULL)
+			tcp_delackq->tx_dpprev = &tx->tx_dnext;
+		tcp_delackq = tx;
+		tx->tx_dpprev = &tcp_delackq;
+	}
+#endif
+	tp->t_flags |= TF_DELACK;
+}
+
+/*
+ * Idle time, in slow ticks, since tcp_idle_reset() was last called.
+ */
+int
+tcp_idle(tp)
+	register struct tcpcb *tp;
+{
+#ifdef VIRTUAL_STACK
+	return (tp->t_idle);
+#else
+	return ((int)(tcp_slowwheel.tw_now - tptotmext(tp)->tx_idlebase));
+#endif
+}
+
+void
+tcp_idle_reset(tp)
+	register struct tcpcb *tp;
+{
+#ifdef VIRTUAL_STACK
+	tp->t_idle = 0;
+#else
+	tptotmext(tp)->tx_idlebase = tcp_slowwheel.tw_now;
+#endif
+}
+
+/*
+ * Start timing a segment for a round trip time measurement.
+ * t_rtt is non-zero while one is being timed, and tcp_rtt()
+ * gives its value so far: one more than the slow ticks since.
+ */
+void
+tcp_rtt_start(tp)
+	register struct tcpcb *tp;
+{
+	tp->t_rtt = 1;
+#ifndef VIRTUAL_STACK
+	tptotmext(tp)->tx_rttbase = tcp_slowwheel.tw_now;
+#endif
+}
+
+int
+tcp_rtt(tp)
+	register struct tcpcb *tp;
+{
+#ifdef VIRTUAL_STACK
+	return (tp->t_rtt);
+#else
+	if (tp->t_rtt == 0)
+		return (0);
+	return ((int)(tcp_slowwheel.tw_now - tptotmext(tp)->tx_rttbase) + 1);
+#endif
 }
 
 int	tcp_backoff[TCP_MAXRXTSHIFT + 1] =
@@ -261,8 +581,8 @@ tcp_timers(tp, timer)
 	 */
 	case TCPT_2MSL:
 		if (tp->t_state != TCPS_TIME_WAIT &&
-		    tp->t_idle <= tcp_maxidle)
-			tp->t_timer[TCPT_2MSL] = tcp_keepintvl;
+		    tcp_idle(tp) <= tcp_maxidle)
+			tcp_timer_set(tp, TCPT_2MSL, tcp_keepintvl);
 		else
 			tp = tcp_close(tp);
 		break;
@@ -284,7 +604,7 @@ tcp_timers(tp, timer)
 		rexmt = TCP_REXMTVAL(tp) * tcp_backoff[tp->t_rxtshift];
 		TCPT_RANGESET(tp->t_rxtcur, rexmt,
 		    tp->t_rttmin, TCPTV_REXMTMAX);
-		tp->t_timer[TCPT_REXMT] = tp->t_rxtcur;
+		tcp_timer_set(tp, TCPT_REXMT, tp->t_rxtcur);
 		/*
 		 * If losing, let the lower level know and try for
 		 * a better route.  Also, if we backed off this far,
@@ -298,6 +618,7 @@ tcp_timers(tp, timer)
 			tp->t_rttvar += (tp->t_srtt >> TCP_RTT_SHIFT);
 			tp->t_srtt = 0;
 		}
+		tcp_recovery_timeout(tp);
 		tp->snd_nxt = tp->snd_una;
 		/*
 		 * If timing a segment in this window, stop the timer.
@@ -352,8 +673,8 @@ tcp_timers(tp, timer)
 		 * backoff that we would use if retransmitting.
 		 */
 		if (tp->t_rxtshift == TCP_MAXRXTSHIFT &&
-		    (tp->t_idle >= tcp_maxpersistidle ||
-		    tp->t_idle >= TCP_REXMTVAL(tp) * tcp_totbackoff)) {
+		    (tcp_idle(tp) >= tcp_maxpersistidle ||
+		    tcp_idle(tp) >= TCP_REXMTVAL(tp) * tcp_totbackoff)) {
 			tcpstat.tcps_persistdrop++;
 			tp = tcp_drop(tp, ETIMEDOUT);
 			break;
@@ -374,7 +695,7 @@ tcp_timers(tp, timer)
 			goto dropit;
 		if (tp->t_inpcb->inp_socket->so_options & SO_KEEPALIVE &&
 		    tp->t_state <= TCPS_CLOSE_WAIT) {
-		    	if (tp->t_idle >= tcp_keepidle + tcp_maxidle)
+		    	if (tcp_idle(tp) >= tcp_keepidle + tcp_maxidle)
 				goto dropit;
 			/*
 			 * Send a packet designed to force a response
@@ -404,9 +725,9 @@ tcp_timers(tp, timer)
 				    (struct mbuf *)NULL,
 				    tp->rcv_nxt, tp->snd_una - 1, 0);
 #endif
-			tp->t_timer[TCPT_KEEP] = tcp_keepintvl;
+			tcp_timer_set(tp, TCPT_KEEP, tcp_keepintvl);
 		} else
-			tp->t_timer[TCPT_KEEP] = tcp_keepidle;
+			tcp_timer_set(tp, TCPT_KEEP, tcp_keepidle);
 		break;
 	dropit:
 		tcpstat.tcps_keepdrops++;
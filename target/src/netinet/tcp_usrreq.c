@@ -41,6 +41,7 @@
 /*
 modification history
 --------------------
+03j,17oct26,agt  arm the keepalive timer with tcp_timer_set()
 03i,05jun02,vvv  fixed Nagle for large writes (SPR #72213)
 03h,21mar02,wap  avoid making local port of TCP connection the same as
                  the foreign port (SPR #73104)
@@ -98,6 +99,7 @@ DESCRIPTION
 IMPORT int tcp_keepinit;
 #endif /* VIRTUAL_STACK */
 IMPORT unsigned long (*pTcpRandHook)(void);
+IMPORT void tcp_timer_set ();
 
 LOCAL void	tcpTraceStub ();
 LOCAL void	tcpReportStub ();
@@ -301,7 +303,7 @@ tcp_usrreq(so, req, m, nam, control)
 		soisconnecting(so);
 		tcpstat.tcps_connattempt++;
 		tp->t_state = TCPS_SYN_SENT;
-               	tp->t_timer[TCPT_KEEP] = tcp_keepinit;
+               	tcp_timer_set(tp, TCPT_KEEP, tcp_keepinit);
      		tp->iss = tcp_iss;
 		tcp_iss += TCP_ISSINCR/4 + ((0x0000ffff) & (pTcpRandHook() >> 16));
 		tcp_sendseqinit(tp);
@@ -41,6 +41,7 @@
 /*
 modification history
 --------------------
+01e,17oct26,agt  restart the protocol timers with netJobReservedAdd()
 01d,12oct01,rae  merge from truestack ver 01e, base 01c (SPR #69112 etc.)
 01c,01jul97,vin  modified for making routing sockets scalable, removed
 		 unnecessary max_datalen, added addDomain function.
@@ -63,6 +64,7 @@ modification history
 #else
 IMPORT void netJobAdd ();
 #endif
+IMPORT STATUS netJobReservedAdd (FUNCPTR, int, int, int, int, int);
 
 IMPORT int  sysClkRateGet(); 
 
@@ -249,7 +251,7 @@ static void pfslowtimoRestart
     int stackNumber
     )
     {
-    netJobAdd ((FUNCPTR)pfslowtimo, stackNumber, 2, 3, 4, 5);
+    netJobReservedAdd ((FUNCPTR)pfslowtimo, stackNumber, 2, 3, 4, 5);
     }
 
 static void pfslowtimo
@@ -281,7 +283,7 @@ static void pfslowtimo (void)
     wdStart (pfslowtimoWd, sysClkRateGet()/2, (FUNCPTR) pfslowtimoRestart,
              (int) myStackNum);
 #else
-    wdStart (pfslowtimoWd, sysClkRateGet()/2, (FUNCPTR) netJobAdd,
+    wdStart (pfslowtimoWd, sysClkRateGet()/2, (FUNCPTR) netJobReservedAdd,
              (int) pfslowtimo);
 #endif
     }
@@ -292,7 +294,7 @@ static void pffasttimoRestart
     int stackNumber
     )
     {
-    netJobAdd ((FUNCPTR)pffasttimo, stackNumber, 2, 3, 4, 5);
+    netJobReservedAdd ((FUNCPTR)pffasttimo, stackNumber, 2, 3, 4, 5);
     }
 
 static void pffasttimo
@@ -325,7 +327,7 @@ static void pffasttimo (void)
     wdStart (pffasttimoWd, sysClkRateGet()/5, (FUNCPTR) pffasttimoRestart, 
              (int) stackNum);
 #else
-    wdStart (pffasttimoWd, sysClkRateGet()/5, (FUNCPTR) netJobAdd, 
+    wdStart (pffasttimoWd, sysClkRateGet()/5, (FUNCPTR) netJobReservedAdd,
              (int) pffasttimo);
 #endif
     }
@@ -5,6 +5,9 @@
 /*
 modification history
 --------------------
+03m,17oct26,agt  steer every packet by addresses and protocol, read the header
+                 through a copy
+03l,17oct26,agt  steer IP packets to the network job queue of their flow
 03k,15may02,tcr  Make WV_NETEVENT_ETHEROUT_NOBUFS match uses elsewhere
 03j,24apr02,rae  Fixed muxTxRestart race condition (SPR #74565)
 03i,19apr02,wap  call ip_mloopback() rather than calling looutput() directly
@@ -191,6 +194,10 @@ IMPORT void if_dettach(struct ifnet *ifp);
 IMPORT void ip_mloopback(struct ifnet *, struct mbuf *, struct sockaddr_in *,
                     struct rtentry *rt);
 
+IMPORT int netJobQueues;
+IMPORT STATUS netJobQueueAdd (int, FUNCPTR, int, int, int, int, int);
+IMPORT int netJobQueueSelect (ULONG, ULONG, int);
+
 /* globals */
 
 #ifdef ROUTER_STACK
@@ -226,11 +233,64 @@ LOCAL void ipError (END_OBJ* pEnd, END_ERR* pError, void * pSpare);
 LOCAL int ipOutputResume (struct mbuf*, struct sockaddr*, void*, void*);
 LOCAL int ipMcastResume (struct mbuf* pMbuf, struct sockaddr* ipDstAddr,
                              void* pIfp, void* rt);
+#ifndef VIRTUAL_STACK
+LOCAL BOOL ipJobSteer (long type, M_BLK_ID pMblk);
+#endif /* VIRTUAL_STACK */
 
 #ifdef IP_DEBUG
 int ipDebug 	=	FALSE;
 #endif
 
+#ifndef VIRTUAL_STACK
+/******************************************************************************
+*
+* ipJobSteer - pass an IP packet to the network job queue of its flow
+*
+* When there is more than one network job queue, this routine picks the
+* queue for the packet from its addresses and protocol, and if that is not
+* queue 0, which netTask() serves and which drivers deliver packets from,
+* has ipintr() run on the packet by that queue's task.  Ports are not
+* used, as fragments carry none; every packet of a flow, fragmented or
+* not, must go to the same queue to be handled in order.
+*
+* The header is copied out of the mBlk, as a driver need not have
+* aligned it.  A first mBlk too short to hold it is left to ipintr().
+*
+* RETURNS: TRUE if the packet has been taken, FALSE if it should be
+* handed to the protocol by the caller.
+*
+* NOMANUAL
+*/
+
+LOCAL BOOL ipJobSteer
+    (
+    long		type,		/* frame type */
+    M_BLK_ID		pMblk		/* packet, at its IP header */
+    )
+    {
+    struct ip		ipHdr;
+    int			queue;
+
+    if ((netJobQueues <= 1) || (type != ETHERTYPE_IP) ||
+        (pMblk->mBlkHdr.mLen < (int) sizeof (struct ip)))
+        return (FALSE);
+
+    bcopy (mtod (pMblk, char *), (char *) &ipHdr, sizeof (struct ip));
+
+    queue = netJobQueueSelect (ipHdr.ip_src.s_addr, ipHdr.ip_dst.s_addr,
+                               ipHdr.ip_p);
+
+    if (queue == 0)
+        return (FALSE);		/* ours; netTask runs queue 0 */
+
+    if (netJobQueueAdd (queue, (FUNCPTR) ipintr, (int) pMblk,
+                        0, 0, 0, 0) != OK)
+        netMblkClChainFree (pMblk);	/* counted as queue overflow */
+
+    return (TRUE);
+    }
+#endif /* VIRTUAL_STACK */
+
 /******************************************************************************
 *
 * ipReceiveRtn - Send a packet from the MUX to the Protocol
@@ -401,6 +461,11 @@ BOOL ipReceiveRtn
         }
 #endif /* ROUTER_STACK */
 
+#ifndef VIRTUAL_STACK
+    if (ipJobSteer (type, pMblk))
+        return (TRUE);
+#endif /* VIRTUAL_STACK */
+
     do_protocol_with_type (type, pMblk , &pDrvCtrl->idr, 
                            pMblk->mBlkPktHdr.len);
     return (TRUE);
@@ -500,6 +565,11 @@ LOCAL BOOL ipTkReceiveRtn
         }
 #endif /* ROUTER_STACK */
 
+#ifndef VIRTUAL_STACK
+    if (ipJobSteer (type, pMblk))
+        return (TRUE);
+#endif /* VIRTUAL_STACK */
+
     do_protocol_with_type (type, pMblk , (struct arpcom* )pIfp, 
                            pMblk->mBlkHdr.mLen);
 
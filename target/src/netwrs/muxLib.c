@@ -5,6 +5,12 @@
 /*
 modification history
 --------------------
+04d,17oct26,agt  adaptive devices take polled receive buffers from a tuple
+                 cache
+04c,17oct26,agt  lock interrupts around the adaptive device list walk of
+                 muxAdaptRcvCount() and the list updates
+04b,17oct26,agt  queue flag change notices with netJobReservedAdd()
+04a,17oct26,agt  added muxReceiveChain() and adaptive interrupt/poll mode
 03z,10may02,wap  Remove unnecessary redeclaration of endList (SPR #74201)
 03y,07may02,kbw  man page edits
 03x,25apr02,vvv  return on muxTkBindUpdate error in muxBind (SPR #74042)
@@ -132,6 +138,21 @@ to add new drivers or services.  For example, if you add a new MUX-based
 Likewise, if you add a new MUX-based service, any existing END can use the 
 MUX to access the new service.  
 
+An END that has a batch of frames to hand up may pass them to
+muxReceiveChain(), linked through 'mBlkHdr.mNextPkt', instead of calling
+muxReceive() once for each.  The checks on the device are done once for
+the batch, and when no SNARF or promiscuous service is bound, the service
+that took the previous frame of the same type is tried first.
+
+Besides the fixed polled mode of muxPollStart(), an END may be put in the
+adaptive mode with muxAdaptDevAdd().  Such a device is left in interrupt
+mode until it delivers <muxAdaptRateHigh> frames within one clock tick;
+it is then switched to polled mode, and 'tMuxAdaptTask' takes up to
+<muxAdaptPollBudget> frames from it per poll, handing each poll's frames
+up with muxReceiveChain().  After <muxAdaptIdlePolls> polls in a row find
+nothing, the device is returned to interrupt mode.  muxAdaptShow()
+displays the frames received in each mode and the switches made.
+
 INCLUDE FILES: errno.h, lstLib.h, logLib.h, string.h, m2Lib.h, bufLib.h, if.h,
 end.h, muxLib.h, vxWorks.h, taskLib.h, stdio.h, errnoLib.h, if_ether.h,
 netLib.h, semLib.h, rebootLib.h
@@ -147,6 +168,8 @@ SEE ALSO
 /* includes */
 #include "vxWorks.h"
 #include "taskLib.h"
+#include "tickLib.h"
+#include "intLib.h"
 #include "stdio.h"
 #include "errno.h"
 #include "errnoLib.h"
@@ -201,9 +224,71 @@ LOCAL int 	muxPollDevCount;
 LOCAL int 	muxPollDevMax;
 
 IMPORT STATUS muxTkReceive (void *, M_BLK_ID, long, long, BOOL, void *);
+IMPORT STATUS netJobReservedAdd (FUNCPTR, int, int, int, int, int);
+
+typedef struct netTupleCache NET_TUPLE_CACHE;	/* netBufLib tuple cache */
+
+IMPORT NET_TUPLE_CACHE * netTupleCacheCreate (NET_POOL_ID, int, UCHAR, int);
+IMPORT void	netTupleCacheDelete (NET_TUPLE_CACHE *);
+IMPORT M_BLK_ID	netTupleCacheGet (NET_TUPLE_CACHE *, int);
+
 LOCAL void    muxEndFlagsNotify (void * pCookie, long endFlags); 
 LOCAL STATUS  muxDevStopAllImmediate (void);
 
+/* receive demux shortcut, valid for one batch of frames */
+
+typedef struct
+    {
+    BOOL		enabled;	/* no SNARF or PROMISC services */
+    long		type;		/* frame type last delivered */
+    NET_PROTOCOL *	pProto;		/* service that was first to match */
+    } MUX_RCV_CACHE;
+
+LOCAL STATUS  muxRcvCheck (END_OBJ * pEnd, NET_PROTOCOL ** ppProto);
+LOCAL STATUS  muxRcvDeliver (END_OBJ * pEnd, NET_PROTOCOL * pFirst,
+			     M_BLK_ID pMblk, MUX_RCV_CACHE * pCache);
+
+/* adaptive interrupt/poll mode */
+
+#define MUX_ADAPT_INTR		0	/* device interrupts for frames */
+#define MUX_ADAPT_POLL_REQ	1	/* switch to polling requested */
+#define MUX_ADAPT_POLL		2	/* device is polled */
+
+typedef struct
+    {
+    void *		pCookie;	/* device cookie */
+    END_OBJ *		pEnd;		/* device */
+    int			mode;		/* MUX_ADAPT_xxx */
+    ULONG		tick;		/* tick <tickFrames> were counted in */
+    int			tickFrames;	/* frames received in <tick> */
+    int			idlePolls;	/* successive empty polls */
+    M_BLK_ID		pSpare;		/* buffer for the next pollRcv */
+    NET_TUPLE_CACHE *	pCache;		/* receive buffers, or NULL */
+    ULONG		intrFrames;	/* frames received by interrupt */
+    ULONG		pollFrames;	/* frames received by polling */
+    ULONG		polls;		/* polls made */
+    ULONG		emptyPolls;	/* polls finding no frame */
+    ULONG		toPoll;		/* switches to polled mode */
+    ULONG		toIntr;		/* switches to interrupt mode */
+    } MUX_ADAPT_DEV;
+
+LOCAL MUX_ADAPT_DEV *	pMuxAdaptDevs;		/* adaptive devices */
+LOCAL int		muxAdaptDevCount;	/* entries in use */
+LOCAL int		muxAdaptDevMax;		/* entries allocated */
+LOCAL SEM_ID		muxAdaptLock;		/* serializes list users */
+LOCAL SEM_ID		muxAdaptWake;		/* wakes tMuxAdaptTask */
+LOCAL int		muxAdaptTaskId;		/* tMuxAdaptTask */
+
+LOCAL void    muxAdaptRcvCount (END_OBJ * pEnd);
+LOCAL int     muxAdaptPoll (MUX_ADAPT_DEV * pDev);
+void	      muxAdaptTask (void);
+
+/* globals */
+
+int muxAdaptRateHigh	= 50;	/* frames per tick that start polling */
+int muxAdaptPollBudget	= 32;	/* max frames taken per poll */
+int muxAdaptIdlePolls	= 2;	/* empty polls that end polling */
+
 
 /*******************************************************************************
 *
@@ -1048,48 +1133,176 @@ STATUS muxReceive
     {
     NET_PROTOCOL * 	pProto;
     END_OBJ * 		pEnd;
-    long 		type;
-    LL_HDR_INFO  	llHdrInfo; 
-    int 		count;
 
     pEnd = (END_OBJ *)pCookie;
 
-    if (pEnd == NULL)
+    if (muxRcvCheck (pEnd, &pProto) == ERROR)
         {
-        errnoSet(S_muxLib_NO_DEVICE);
         if (pMblk)
             netMblkClChainFree (pMblk);
         return (ERROR);
         }
 
-    /* Grab a new block and parse out the header information. */
+    if (muxAdaptDevCount > 0)
+        muxAdaptRcvCount (pEnd);
 
-    count = lstCount (&pEnd->protocols);
-    if (count <= 0)
+    return (muxRcvDeliver (pEnd, pProto, pMblk, NULL));
+    }
+
+/*****************************************************************************
+* 
+* muxReceiveChain - handle a batch of packets from a device driver
+*
+* An END calls this routine to transfer several received frames to the
+* bound services at once.  The frames are linked through the 'mNextPkt'
+* field of their first 'mBlk', and each is delivered exactly as
+* muxReceive() would deliver it, in order.  The device is checked once for
+* the whole batch and, when no SNARF or promiscuous service is bound, the
+* service list is only searched for the first frame of each type.
+*
+* NOTE: The stack receive routine installed by a protocol must not alter
+* the packet if it returns FALSE.
+*
+* RETURNS: OK, or ERROR if the device has no services to deliver to, in
+* which case all the frames are freed.
+*
+* ERRNO: S_muxLib_NO_DEVICE
+*
+* NOMANUAL
+*/
+
+STATUS muxReceiveChain
+    (
+    void *   pCookie, 	/* device identifier from driver's load routine */
+    M_BLK_ID pMblkList 	/* frames, linked through mNextPkt */
+    )
+    {
+    NET_PROTOCOL * 	pProto;
+    END_OBJ * 		pEnd;
+    M_BLK_ID		pMblk;
+    MUX_RCV_CACHE	cache;
+
+    pEnd = (END_OBJ *)pCookie;
+
+    if (muxRcvCheck (pEnd, &pProto) == ERROR)
         {
-        if (pMblk)
+        while ((pMblk = pMblkList) != NULL)
+            {
+            pMblkList = pMblk->mBlkHdr.mNextPkt;
+            pMblk->mBlkHdr.mNextPkt = NULL;
             netMblkClChainFree (pMblk);
+            }
         return (ERROR);
         }
 
+    cache.enabled = TRUE;
+    cache.pProto = NULL;
+    cache.type = 0;
+
+    for (; pProto != NULL; pProto = (NET_PROTOCOL *)lstNext (&pProto->node))
+        {
+        if (pProto->type == MUX_PROTO_SNARF ||
+            pProto->type == MUX_PROTO_PROMISC)
+            {
+            cache.enabled = FALSE;
+            break;
+            }
+        }
+
     pProto = (NET_PROTOCOL *)lstFirst (&pEnd->protocols); 
-    if (pProto == NULL)
+
+    while ((pMblk = pMblkList) != NULL)
         {
-        if (pMblk)
-            netMblkClChainFree (pMblk);
+        pMblkList = pMblk->mBlkHdr.mNextPkt;
+        pMblk->mBlkHdr.mNextPkt = NULL;
+
+        if (muxAdaptDevCount > 0)
+            muxAdaptRcvCount (pEnd);
+
+        (void) muxRcvDeliver (pEnd, pProto, pMblk, &cache);
+        }
+
+    return (OK);
+    }
+
+/*****************************************************************************
+* 
+* muxRcvCheck - check that a device has services to receive frames
+*
+* This routine does the checks of muxReceive() that depend only on the
+* device, and gives the first service bound to it in <ppProto>.
+*
+* RETURNS: OK, or ERROR if frames from the device should be dropped.
+*
+* ERRNO: S_muxLib_NO_DEVICE
+*
+* NOMANUAL
+*/
+
+LOCAL STATUS muxRcvCheck
+    (
+    END_OBJ *		pEnd,		/* device frames came from */
+    NET_PROTOCOL **	ppProto		/* where to return first service */
+    )
+    {
+    NET_PROTOCOL * 	pProto;
+    int 		count;
+
+    if (pEnd == NULL)
+        {
+        errnoSet(S_muxLib_NO_DEVICE);
         return (ERROR);
         }
 
+    /* Grab a new block and parse out the header information. */
+
+    count = lstCount (&pEnd->protocols);
+    if (count <= 0)
+        return (ERROR);
+
+    pProto = (NET_PROTOCOL *)lstFirst (&pEnd->protocols); 
+    if (pProto == NULL)
+        return (ERROR);
+
     /* Ignore incoming data if an output protocol is the only entry. */
 
     if (count == 1 && pProto->type == MUX_PROTO_OUTPUT)
-        {
-        if (pMblk)
-            netMblkClChainFree (pMblk);
         return (ERROR);
-        }
 
-    if (muxPacketDataGet (pProto->pNptCookie, pMblk, &llHdrInfo) == ERROR)
+    *ppProto = pProto;
+    return (OK);
+    }
+
+/*****************************************************************************
+* 
+* muxRcvDeliver - deliver one received frame to the bound services
+*
+* This routine offers the frame <pMblk> to the services bound to <pEnd>,
+* starting with <pFirst>, and frees it if none takes it.  If <pCache> is
+* not NULL and is enabled, the search starts from the service that was
+* first to match the previous frame of the same type; that is only valid
+* when there are no SNARF or promiscuous services, which would have to be
+* offered the frame first.
+*
+* RETURNS: OK, or ERROR if the frame header could not be parsed.
+*
+* NOMANUAL
+*/
+
+LOCAL STATUS muxRcvDeliver
+    (
+    END_OBJ *		pEnd,		/* device frame came from */
+    NET_PROTOCOL *	pFirst,		/* first service bound to it */
+    M_BLK_ID		pMblk,		/* received frame */
+    MUX_RCV_CACHE *	pCache		/* demux shortcut, or NULL */
+    )
+    {
+    NET_PROTOCOL * 	pProto;
+    long 		type;
+    LL_HDR_INFO  	llHdrInfo; 
+    BOOL		matched = FALSE;
+
+    if (muxPacketDataGet (pFirst->pNptCookie, pMblk, &llHdrInfo) == ERROR)
         {
         if (pEnd->flags & END_MIB_2233)
             {
@@ -1111,6 +1324,14 @@ STATUS muxReceive
 
     type = llHdrInfo.pktType;
 
+    pProto = pFirst;
+    if ((pCache != NULL) && pCache->enabled && (pCache->pProto != NULL) &&
+        (pCache->type == type))
+        {
+        pProto = pCache->pProto;
+        matched = TRUE;
+        }
+
     /*
      * Loop through the protocol list.
      * If a service's receive routine returns TRUE, it has consumed the
@@ -1139,6 +1360,13 @@ STATUS muxReceive
             pProto->type == MUX_PROTO_PROMISC ||
             pProto->type == type)
             {
+            if ((pCache != NULL) && !matched)
+                {
+                pCache->type = type;
+                pCache->pProto = pProto;
+                matched = TRUE;
+                }
+
             if ( (*pProto->stackRcvRtn) (pProto->pNptCookie, type, pMblk,
                                          &llHdrInfo, pProto->pSpare) == TRUE)
                 return (OK);
@@ -1433,8 +1661,8 @@ STATUS muxIoctl
 
         if (cmd == (int) EIOCSFLAGS && error == OK && (endFlags ^ pEnd->flags))
             {
-            netJobAdd ( (FUNCPTR)muxEndFlagsNotify, (int)pCookie,
-                       (int)pEnd->flags, 0, 0, 0);
+            netJobReservedAdd ((FUNCPTR)muxEndFlagsNotify, (int)pCookie,
+                               (int)pEnd->flags, 0, 0, 0);
             }
         }
 
@@ -3329,6 +3557,443 @@ BOOL muxPollDevStat
     return (TRUE);
     }
 
+/*****************************************************************************
+*
+* muxAdaptStart - initialize and start the MUX adaptive polling task
+*
+* This routine sets up the adaptive interrupt/poll mode for up to <numDev>
+* devices and spawns 'tMuxAdaptTask' at <priority>, which should be the
+* priority of 'tNetTask', to do the polling.  Devices are then put in the
+* mode with muxAdaptDevAdd().
+*
+* RETURNS: OK or ERROR
+*/
+
+STATUS muxAdaptStart
+    (
+    int numDev,     /* Maximum number of devices in adaptive mode. */
+    int priority    /* tMuxAdaptTask priority, usually that of tNetTask. */
+    )
+    {
+    if (numDev <= 0 || priority < 0 || priority > 255)
+	return (ERROR);
+
+    if (muxAdaptTaskId != 0)
+	return (ERROR);
+
+    pMuxAdaptDevs = (MUX_ADAPT_DEV *) KHEAP_ALLOC (numDev *
+						   sizeof (MUX_ADAPT_DEV));
+    if (pMuxAdaptDevs == NULL)
+	return (ERROR);
+    bzero ((char *) pMuxAdaptDevs, numDev * sizeof (MUX_ADAPT_DEV));
+
+    muxAdaptLock = semMCreate (SEM_Q_PRIORITY | SEM_DELETE_SAFE |
+			       SEM_INVERSION_SAFE);
+    muxAdaptWake = semBCreate (SEM_Q_PRIORITY, SEM_EMPTY);
+    if (muxAdaptLock == NULL || muxAdaptWake == NULL)
+	goto muxAdaptStartError;
+
+    muxAdaptDevMax = numDev;
+    muxAdaptDevCount = 0;
+
+    muxAdaptTaskId = taskSpawn ("tMuxAdaptTask", priority, 0, 0x4000,
+				(FUNCPTR) muxAdaptTask,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    if (muxAdaptTaskId == ERROR)
+	{
+	muxAdaptTaskId = 0;
+	goto muxAdaptStartError;
+	}
+
+    return (OK);
+
+muxAdaptStartError:
+    if (muxAdaptLock != NULL)
+	semDelete (muxAdaptLock);
+    if (muxAdaptWake != NULL)
+	semDelete (muxAdaptWake);
+    muxAdaptLock = muxAdaptWake = NULL;
+    KHEAP_FREE ((char *) pMuxAdaptDevs);
+    pMuxAdaptDevs = NULL;
+    return (ERROR);
+    }
+
+/*****************************************************************************
+*
+* muxAdaptDevAdd - put a device in adaptive interrupt/poll mode
+*
+* This routine adds an END to the devices whose receive mode is switched
+* between interrupts and polling according to load.  The device starts
+* out in interrupt mode.  It must not also be on the 'tMuxPollTask' list,
+* and NPT devices are not supported.
+*
+* RETURNS: OK or ERROR
+*/
+
+STATUS muxAdaptDevAdd
+    (
+    int unit,			/* Device unit number */
+    char *pName			/* Device name */
+    )
+    {
+    void *		pCookie;
+    END_OBJ *		pEnd;
+    MUX_ADAPT_DEV *	pDev;
+    int			i;
+    int			level;
+
+    if (!muxAdaptTaskId)
+	return (ERROR);
+
+    pCookie = muxTkCookieGet (pName, unit);
+    if (!pCookie || TK_DRV_CHECK (pCookie) || muxPollDevStat (unit, pName))
+	return (ERROR);
+
+    pEnd = PCOOKIE_TO_ENDOBJ (pCookie);
+    if (pEnd == NULL || pEnd->pFuncTable->pollRcv == NULL)
+	return (ERROR);
+
+    semTake (muxAdaptLock, WAIT_FOREVER);
+
+    for (i = 0; i < muxAdaptDevCount; i++)
+	{
+	if (pMuxAdaptDevs[i].pEnd == pEnd)
+	    break;
+	}
+
+    if (i < muxAdaptDevCount || muxAdaptDevCount == muxAdaptDevMax)
+	{
+	semGive (muxAdaptLock);
+	return (ERROR);
+	}
+
+    /* fill the entry in before muxAdaptRcvCount() can see it */
+
+    pDev = &pMuxAdaptDevs[muxAdaptDevCount];
+    bzero ((char *) pDev, sizeof (MUX_ADAPT_DEV));
+    pDev->pCookie = pCookie;
+    pDev->pEnd = pEnd;
+    pDev->mode = MUX_ADAPT_INTR;
+
+    /*
+     * Only tMuxAdaptTask gets buffers for the device, so it may have a
+     * tuple cache; without one, muxAdaptPoll() uses netTupleGet2().
+     */
+
+    pDev->pCache = netTupleCacheCreate (pEnd->pNetPool, GET_IFMTU (pEnd),
+					MT_DATA, 2 * muxAdaptPollBudget);
+
+    level = intLock ();
+    muxAdaptDevCount++;
+    intUnlock (level);
+
+    semGive (muxAdaptLock);
+    return (OK);
+    }
+
+/*****************************************************************************
+*
+* muxAdaptDevDel - take a device out of adaptive interrupt/poll mode
+*
+* This routine removes a device added by muxAdaptDevAdd(), returning it to
+* interrupt mode if it is being polled.
+*
+* RETURNS: OK or ERROR
+*/
+
+STATUS muxAdaptDevDel
+    (
+    int unit,			/* Device unit number */
+    char *pName			/* Device name */
+    )
+    {
+    void *		pCookie;
+    MUX_ADAPT_DEV *	pDev;
+    int			i;
+    int			level;
+
+    pCookie = muxTkCookieGet (pName, unit);
+
+    if (!muxAdaptTaskId || !pCookie)
+	return (ERROR);
+
+    semTake (muxAdaptLock, WAIT_FOREVER);
+
+    for (i = 0; i < muxAdaptDevCount; i++)
+	{
+	if (pMuxAdaptDevs[i].pCookie == pCookie)
+	    break;
+	}
+
+    if (i == muxAdaptDevCount)
+	{
+	semGive (muxAdaptLock);
+	return (ERROR);
+	}
+
+    pDev = &pMuxAdaptDevs[i];
+    if (pDev->mode == MUX_ADAPT_POLL)
+	muxIoctl (pCookie, EIOCPOLLSTOP, NULL);
+    if (pDev->pSpare != NULL)
+	netMblkClChainFree (pDev->pSpare);
+    if (pDev->pCache != NULL)
+	netTupleCacheDelete (pDev->pCache);
+
+    /*
+     * Order does not matter; move the last entry into the hole.  This is
+     * done with interrupts locked, as muxAdaptRcvCount() walks the list
+     * without the mutex.
+     */
+
+    level = intLock ();
+    if (i != --muxAdaptDevCount)
+	*pDev = pMuxAdaptDevs[muxAdaptDevCount];
+    intUnlock (level);
+
+    bzero ((char *) &pMuxAdaptDevs[muxAdaptDevCount], sizeof (MUX_ADAPT_DEV));
+
+    semGive (muxAdaptLock);
+    return (OK);
+    }
+
+/*****************************************************************************
+*
+* muxAdaptRcvCount - account for a frame received from an adaptive device
+*
+* This routine is called by muxReceive() and muxReceiveChain() for each
+* frame.  If the frame came by interrupt from a device in adaptive mode,
+* and it is the <muxAdaptRateHigh>th in the current tick, the device is
+* marked for polling and 'tMuxAdaptTask' is woken to switch it over; the
+* switch is not made here, since the driver is still in its receive loop.
+*
+* The list is walked with interrupts locked rather than under
+* <muxAdaptLock>: the receive path must not pend on a mutex that is held
+* across driver ioctls, and muxAdaptDevAdd() and muxAdaptDevDel() change
+* the list with interrupts locked.  The list holds few entries.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void muxAdaptRcvCount
+    (
+    END_OBJ *		pEnd		/* device frame came from */
+    )
+    {
+    MUX_ADAPT_DEV *	pDev;
+    ULONG		now;
+    BOOL		wake = FALSE;
+    int			level;
+    int			i;
+
+    level = intLock ();
+
+    for (i = 0; i < muxAdaptDevCount; i++)
+	{
+	pDev = &pMuxAdaptDevs[i];
+	if (pDev->pEnd != pEnd)
+	    continue;
+
+	if (pDev->mode != MUX_ADAPT_INTR)
+	    break;			/* polled frames are counted there */
+
+	pDev->intrFrames++;
+
+	now = tickGet ();
+	if (now != pDev->tick)
+	    {
+	    pDev->tick = now;
+	    pDev->tickFrames = 0;
+	    }
+
+	if (++pDev->tickFrames >= muxAdaptRateHigh)
+	    {
+	    pDev->mode = MUX_ADAPT_POLL_REQ;
+	    wake = TRUE;
+	    }
+	break;
+	}
+
+    intUnlock (level);
+
+    if (wake)
+	semGive (muxAdaptWake);
+    }
+
+/*****************************************************************************
+*
+* muxAdaptPoll - take a budget of frames from a polled device
+*
+* This routine polls the device up to <muxAdaptPollBudget> times and hands
+* the frames it gets up the stack as one batch.  Buffers come from the
+* device's tuple cache, which takes them from the pool in batches.
+*
+* RETURNS: the number of frames received.
+*
+* NOMANUAL
+*/
+
+LOCAL int muxAdaptPoll
+    (
+    MUX_ADAPT_DEV *	pDev		/* device to poll */
+    )
+    {
+    END_OBJ *		pEnd = pDev->pEnd;
+    M_BLK_ID		pHead = NULL;
+    M_BLK_ID		pTail = NULL;
+    int			nFrames = 0;
+
+    while (nFrames < muxAdaptPollBudget)
+	{
+	/* We check to see if there is already a mblk, if not get one */
+
+	if (pDev->pSpare == NULL)
+	    {
+	    if (pDev->pCache != NULL)
+		pDev->pSpare = netTupleCacheGet (pDev->pCache, M_DONTWAIT);
+	    else
+		pDev->pSpare = netTupleGet2 (pEnd->pNetPool, GET_IFMTU (pEnd),
+					     FALSE);
+	    if (pDev->pSpare == NULL)
+		break;
+	    }
+
+	if (pEnd->pFuncTable->pollRcv (pEnd, pDev->pSpare) != OK)
+	    break;
+
+	pDev->pSpare->mBlkHdr.mNextPkt = NULL;
+	if (pTail == NULL)
+	    pHead = pDev->pSpare;
+	else
+	    pTail->mBlkHdr.mNextPkt = pDev->pSpare;
+	pTail = pDev->pSpare;
+	pDev->pSpare = NULL;
+	nFrames++;
+	}
+
+    if (pHead != NULL)
+	muxReceiveChain (pEnd, pHead);
+
+    pDev->polls++;
+    pDev->pollFrames += nFrames;
+
+    return (nFrames);
+    }
+
+/*****************************************************************************
+*
+* muxAdaptTask - the routine that runs as the MUX adaptive polling task
+*
+* While no device needs polling this task sleeps.  Woken by
+* muxAdaptRcvCount(), it puts the devices marked for polling into polled
+* mode, then polls each polled device once per cycle, yielding between
+* cycles to tasks of its own priority.  A device that has had nothing for
+* <muxAdaptIdlePolls> polls running is put back in interrupt mode.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void muxAdaptTask (void)
+    {
+    MUX_ADAPT_DEV *	pDev;
+    BOOL		polling;
+    int			i;
+
+    FOREVER
+	{
+	polling = FALSE;
+
+	semTake (muxAdaptLock, WAIT_FOREVER);
+
+	for (i = 0; i < muxAdaptDevCount; i++)
+	    {
+	    pDev = &pMuxAdaptDevs[i];
+
+	    if (pDev->mode == MUX_ADAPT_POLL_REQ)
+		{
+		if (muxIoctl (pDev->pCookie, EIOCPOLLSTART, NULL) == OK)
+		    {
+		    pDev->mode = MUX_ADAPT_POLL;
+		    pDev->idlePolls = 0;
+		    pDev->toPoll++;
+		    }
+		else
+		    {
+		    pDev->tickFrames = 0;
+		    pDev->mode = MUX_ADAPT_INTR;
+		    }
+		}
+
+	    if (pDev->mode != MUX_ADAPT_POLL)
+		continue;
+
+	    if (muxAdaptPoll (pDev) > 0)
+		pDev->idlePolls = 0;
+	    else
+		{
+		pDev->emptyPolls++;
+		if (++pDev->idlePolls >= muxAdaptIdlePolls)
+		    {
+		    muxIoctl (pDev->pCookie, EIOCPOLLSTOP, NULL);
+		    pDev->tickFrames = 0;
+		    pDev->mode = MUX_ADAPT_INTR;
+		    pDev->toIntr++;
+		    continue;
+		    }
+		}
+
+	    polling = TRUE;
+	    }
+
+	semGive (muxAdaptLock);
+
+	if (polling)
+	    taskDelay (0);
+	else
+	    semTake (muxAdaptWake, WAIT_FOREVER);
+	}
+    }
+
+/*****************************************************************************
+*
+* muxAdaptShow - display the devices in adaptive interrupt/poll mode
+*
+* This routine shows, for each device in adaptive mode, its current mode,
+* the frames it has delivered by interrupt and by polling, the polls made
+* and how many found nothing, and the switches between modes.
+*
+* RETURNS: N/A
+*/
+
+void muxAdaptShow (void)
+    {
+    MUX_ADAPT_DEV *	pDev;
+    int			i;
+
+    if (!muxAdaptTaskId)
+	return;
+
+    printf ("%-8s %-5s %10s %10s %10s %10s %8s %8s\n", "device", "mode",
+	    "intrFrames", "pollFrames", "polls", "empty", "toPoll", "toIntr");
+
+    semTake (muxAdaptLock, WAIT_FOREVER);
+
+    for (i = 0; i < muxAdaptDevCount; i++)
+	{
+	pDev = &pMuxAdaptDevs[i];
+	printf ("%-6s%-2d %-5s %10ld %10ld %10ld %10ld %8ld %8ld\n",
+		pDev->pEnd->devObject.name, pDev->pEnd->devObject.unit,
+		(pDev->mode == MUX_ADAPT_POLL) ? "poll" : "intr",
+		pDev->intrFrames, pDev->pollFrames, pDev->polls,
+		pDev->emptyPolls, pDev->toPoll, pDev->toIntr);
+	}
+
+    semGive (muxAdaptLock);
+    }
+
 #ifdef ROUTER_STACK
 
 /****************************************************************************
@@ -6,6 +6,9 @@
 /*
 modification history
 --------------------
+01t,17oct26,agt  doc: note the MUX adaptive-mode tuple caches
+01s,17oct26,agt  added tuple caches; netMblkClChainFree() frees runs of a
+		 chain under one interrupt lock
 01r,07may02,kbw  man page edits
 01q,15oct01,rae  merge from truestack ver 01w, base 01n (SPR #65195 etc.)
 01p,08feb01,kbw  fixing a man page format problem
@@ -47,6 +50,20 @@ joined with a cluster.  Thus, the actual vehicle for passing data is
 not merely an `mBlk' structure but an `mBlk'-`clBlk'-cluster
 construct.
  
+Getting a ready-made `mBlk'-`clBlk'-cluster tuple from the pool takes three
+trips through the pool's free lists, each under its own interrupt lock.  A
+consumer that allocates many tuples of one size, such as a driver filling
+its receive ring, can instead create a tuple cache with
+netTupleCacheCreate() and allocate from it with netTupleCacheGet().  The
+cache keeps up to <depth> joined tuples, refilling and draining them in
+batches under a single lock, and returns them with netTupleCacheFree().
+Tuples held in a cache count as free in the pool statistics shown by
+netPoolShow(), which are brought up to date on every refill and drain.
+A cache has no lock of its own, so it must only be used by one task, or
+only at interrupt level by one driver.
+The MUX gives each device it polls in adaptive mode a tuple cache (see
+muxAdaptDevAdd()).
+
 To use this feature, include the following component:
 INCLUDE_NETWRS_NETBUFLIB
 
@@ -109,6 +126,7 @@ Two mBlks sharing the same cluster:
 
 #include "vxWorks.h"
 #include "stdlib.h"
+#include "stdio.h"
 #include "intLib.h"
 #include "string.h"
 #include "semaphore.h"
@@ -165,6 +183,39 @@ LOCAL STATUS 		_mClGet (NET_POOL_ID pNetPool, M_BLK_ID pMblk,
 LOCAL CL_POOL_ID 	_clPoolIdGet (NET_POOL_ID pNetPool, int	bufSize,
                                       BOOL bestFit);
 
+/* tuple cache; the tuples are linked through mNextPkt */
+
+typedef struct netTupleCache
+    {
+    NET_POOL_ID		pNetPool;	/* pool the tuples come from */
+    CL_POOL_ID		pClPool;	/* cluster pool the tuples use */
+    UCHAR		type;		/* mBlk type of tuples handed out */
+    int			depth;		/* max tuples held */
+    int			batch;		/* tuples moved per refill/drain */
+    int			count;		/* tuples held */
+    M_BLK_ID		pHead;		/* tuples held */
+    int			pendGet;	/* gets not yet in pool stats */
+    int			pendPut;	/* frees not yet in pool stats */
+    ULONG		hits;		/* gets served by the cache */
+    ULONG		refills;	/* batches taken from the pool */
+    ULONG		drains;		/* batches given back to the pool */
+    } NET_TUPLE_CACHE;
+
+#define NET_CHAIN_FREE_BATCH	16	/* mBlks freed per interrupt lock */
+
+LOCAL int	_tupleCacheRefill (NET_TUPLE_CACHE * pCache);
+LOCAL void	_tupleCacheDrain (NET_TUPLE_CACHE * pCache, int num);
+LOCAL void	_tupleCacheSync (NET_TUPLE_CACHE * pCache);
+LOCAL M_BLK_ID	_mBlkClChainRunFree (NET_POOL_ID pNetPool, M_BLK_ID pMblk);
+
+NET_TUPLE_CACHE * netTupleCacheCreate (NET_POOL_ID pNetPool, int bufSize,
+				       UCHAR type, int depth);
+void		netTupleCacheDelete (NET_TUPLE_CACHE * pCache);
+void		netTupleCacheFlush (NET_TUPLE_CACHE * pCache);
+M_BLK_ID	netTupleCacheGet (NET_TUPLE_CACHE * pCache, int canWait);
+void		netTupleCacheFree (NET_TUPLE_CACHE * pCache, M_BLK_ID pMblk);
+void		netTupleCacheShow (NET_TUPLE_CACHE * pCache);
+
 LOCAL POOL_FUNC dfltFuncTbl =		/* default pool function table */
     {
     _poolInit,
@@ -1515,14 +1566,112 @@ void netMblkClChainFree
     )
     {
     NET_POOL_ID 	pNetPool;
+    M_BLK_ID		pNext;
 
     while (pMblk != NULL)
         {
         pNetPool = MBLK_TO_NET_POOL(pMblk);
+
+        /*
+         * Runs of mBlks from pools using the default function table are
+         * freed several at a time.  Anything the run can't take, such as
+         * a cluster with a free routine of its own, is freed singly.
+         */
+
+        if (pNetPool->pFuncTbl == &dfltFuncTbl &&
+            (pNext = _mBlkClChainRunFree (pNetPool, pMblk)) != pMblk)
+            {
+            pMblk = pNext;
+            continue;
+            }
+
         pMblk 	 = (*pNetPool->pFuncTbl->pMblkClFreeRtn) (pNetPool, pMblk);
         }
     }
 
+/*******************************************************************************
+*
+* _mBlkClChainRunFree - free a run of mBlk/cluster pairs under one lock
+*
+* This routine frees mBlks from the head of the chain <pMblk>, together
+* with their clBlks and clusters when this drops the last reference, as
+* _mBlkClFree() would, but takes the interrupt lock once for up to
+* NET_CHAIN_FREE_BATCH of them.  It stops at an mBlk from another pool, at
+* one whose clBlk belongs to a pool with its own function table, and at one
+* whose cluster has a free routine that would have to be called.
+*
+* RETURNS: the first mBlk not freed, which is <pMblk> if none was.
+*
+* NOMANUAL
+*/
+
+LOCAL M_BLK_ID _mBlkClChainRunFree
+    (
+    NET_POOL_ID		pNetPool,	/* pool of the mBlks */
+    M_BLK_ID		pMblk		/* chain to free */
+    )
+    {
+    M_BLK_ID		pNext;
+    CL_BLK_ID		pClBlk;
+    CL_BUF_ID		pClBuf;
+    CL_POOL_ID		pClPool;
+    int			num;
+    FAST int		level;
+
+    level = intLock ();
+
+    for (num = 0; (pMblk != NULL) && (num < NET_CHAIN_FREE_BATCH); num++)
+        {
+        if (MBLK_TO_NET_POOL(pMblk) != pNetPool ||
+            pMblk->mBlkHdr.mType == MT_FREE)
+            break;
+
+        pClBlk = M_HASCL(pMblk) ? pMblk->pClBlk : NULL;
+        if (pClBlk != NULL)
+            {
+            if (pClBlk->pNetPool == NULL ||
+                pClBlk->pNetPool->pFuncTbl != &dfltFuncTbl ||
+                (pClBlk->clRefCnt == 1 && pClBlk->pClFreeRtn != NULL &&
+                 pClBlk->clNode.pClBuf != NULL))
+                break;
+
+            /* as _clBlkFree () */
+
+            pClBuf = (CL_BUF_ID) pClBlk->clNode.pClBuf;
+            if (pClBuf == NULL || --(pClBlk->clRefCnt) == 0)
+                {
+                if (pClBuf != NULL)
+                    {
+                    pClPool		= CL_BUF_TO_CL_POOL (pClBuf);
+                    pClBuf->pClNext	= pClPool->pClHead;
+                    pClPool->pClHead	= pClBuf;
+                    pClPool->pNetPool->clMask |=
+                        CL_LOG2_TO_CL_SIZE(pClPool->clLg2);
+                    pClPool->clNumFree++;
+                    }
+                pClBlk->clNode.pClBlkNext = pClBlk->pNetPool->pClBlkHead;
+                pClBlk->pNetPool->pClBlkHead = pClBlk;
+                }
+            }
+
+        /* as _mBlkFree () */
+
+        pNext = pMblk->mBlkHdr.mNext;
+        pMblk->mBlkHdr.mNextPkt = NULL;
+        pNetPool->pPoolStat->mTypes [pMblk->mBlkHdr.mType]--;
+        pNetPool->pPoolStat->mTypes [MT_FREE]++;
+        pMblk->mBlkHdr.mType 	= MT_FREE;
+        pMblk->mBlkHdr.mNext 	= pNetPool->pmBlkHead;
+        pNetPool->pmBlkHead 	= pMblk;
+
+        pMblk = pNext;
+        }
+
+    intUnlock (level);
+
+    return (pMblk);
+    }
+
 /*******************************************************************************
 *
 * netMblkGet - get an `mBlk' from a memory pool
@@ -2294,3 +2443,402 @@ Error:
     }
 
 
+
+/*******************************************************************************
+*
+* netTupleCacheCreate - create a cache of `mBlk'-`clBlk'-cluster tuples
+*
+* This routine creates a cache of tuples from <pNetPool> whose clusters are
+* big enough for <bufSize> bytes, and whose `mBlk's are given the type
+* <type> when they are handed out.  The cache holds at most <depth>
+* tuples, and moves them to and from the pool half that many at a time.
+* The pool must use the default pool function table.
+*
+* The cache is not locked, so it must only be used by one task, or only at
+* interrupt level by one driver.
+*
+* RETURNS: a cache handle, or NULL.
+*
+* ERRNO:
+*  S_netBufLib_NETPOOL_INVALID
+*  S_netBufLib_CLSIZE_INVALID
+*
+* NOMANUAL
+*/
+
+NET_TUPLE_CACHE * netTupleCacheCreate
+    (
+    NET_POOL_ID		pNetPool,	/* pool to cache tuples from */
+    int			bufSize,	/* size of the buffers */
+    UCHAR		type,		/* type of the mBlks */
+    int			depth		/* max tuples to hold */
+    )
+    {
+    NET_TUPLE_CACHE *	pCache;
+    CL_POOL_ID		pClPool;
+
+    if (pNetPool == NULL || pNetPool->pFuncTbl != &dfltFuncTbl)
+        {
+        errno = S_netBufLib_NETPOOL_INVALID;
+        return (NULL);
+        }
+
+    if ((pClPool = _clPoolIdGet (pNetPool, bufSize, TRUE)) == NULL)
+        {
+        errno = S_netBufLib_CLSIZE_INVALID;
+        return (NULL);
+        }
+
+    if ((pCache = (NET_TUPLE_CACHE *) KHEAP_ALLOC (sizeof (NET_TUPLE_CACHE)))
+        == NULL)
+        return (NULL);
+    bzero ((char *) pCache, sizeof (NET_TUPLE_CACHE));
+
+    pCache->pNetPool	= pNetPool;
+    pCache->pClPool	= pClPool;
+    pCache->type	= type;
+    pCache->depth	= max (depth, 2);
+    pCache->batch	= pCache->depth / 2;
+
+    return (pCache);
+    }
+
+/*******************************************************************************
+*
+* netTupleCacheDelete - delete a tuple cache
+*
+* This routine gives all the tuples held by <pCache> back to its pool, and
+* frees the cache.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void netTupleCacheDelete
+    (
+    NET_TUPLE_CACHE *	pCache		/* cache to delete */
+    )
+    {
+    if (pCache == NULL)
+        return;
+
+    netTupleCacheFlush (pCache);
+    KHEAP_FREE ((char *) pCache);
+    }
+
+/*******************************************************************************
+*
+* netTupleCacheFlush - give the tuples held by a cache back to the pool
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void netTupleCacheFlush
+    (
+    NET_TUPLE_CACHE *	pCache		/* cache to flush */
+    )
+    {
+    _tupleCacheDrain (pCache, pCache->count);
+    }
+
+/*******************************************************************************
+*
+* netTupleCacheGet - get an `mBlk'-`clBlk'-cluster tuple from a cache
+*
+* This routine returns a tuple from <pCache>, refilling the cache from its
+* pool if it is empty.  If the pool has no whole tuples of the cache's
+* size left, the tuple is got as netTupleGet() would get it, waiting if
+* <canWait> is M_WAIT.
+*
+* RETURNS: M_BLK_ID or NULL.
+*
+* ERRNO:
+*  S_netBufLib_NO_POOL_MEMORY
+*
+* NOMANUAL
+*/
+
+M_BLK_ID netTupleCacheGet
+    (
+    NET_TUPLE_CACHE *	pCache,		/* cache to get from */
+    int			canWait		/* M_WAIT/M_DONTWAIT */
+    )
+    {
+    M_BLK_ID		pMblk;
+    CL_BLK_ID		pClBlk;
+
+    if (pCache->pHead == NULL && _tupleCacheRefill (pCache) == 0)
+        return (netTupleGet (pCache->pNetPool, pCache->pClPool->clSize,
+                             canWait, pCache->type, TRUE));
+
+    pMblk = pCache->pHead;
+    pCache->pHead = pMblk->mBlkHdr.mNextPkt;
+    pCache->count--;
+    pCache->pendGet++;
+    pCache->hits++;
+
+    pClBlk = pMblk->pClBlk;
+    pClBlk->clRefCnt	    = 1;
+
+    pMblk->mBlkHdr.mType    = pCache->type;
+    pMblk->mBlkHdr.mNext    = NULL;
+    pMblk->mBlkHdr.mNextPkt = NULL;
+    pMblk->mBlkHdr.mFlags   = M_EXT;
+    pMblk->mBlkHdr.mData    = pClBlk->clNode.pClBuf;
+    pMblk->mBlkHdr.mLen	    = 0;
+
+    return (pMblk);
+    }
+
+/*******************************************************************************
+*
+* netTupleCacheFree - free a chain of tuples into a cache
+*
+* This routine frees the `mBlk' chain <pMblk> like netMblkClChainFree(),
+* except that tuples that could have come from <pCache> - of its pool,
+* cluster size and type, and with the only reference to their cluster -
+* are kept in the cache, if there is room, to be handed out again.  When
+* the cache is full, a batch of its tuples is first given back to the pool.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void netTupleCacheFree
+    (
+    NET_TUPLE_CACHE *	pCache,		/* cache to free into */
+    M_BLK_ID		pMblk		/* chain to free */
+    )
+    {
+    M_BLK_ID		pNext;
+    CL_BLK_ID		pClBlk;
+
+    while (pMblk != NULL)
+        {
+        pClBlk = pMblk->pClBlk;
+
+        if (MBLK_TO_NET_POOL(pMblk) != pCache->pNetPool ||
+            pMblk->mBlkHdr.mType != pCache->type || !M_HASCL(pMblk) ||
+            pClBlk->pNetPool != pCache->pNetPool ||
+            pClBlk->clRefCnt != 1 || pClBlk->pClFreeRtn != NULL ||
+            pClBlk->clNode.pClBuf == NULL ||
+            CL_BUF_TO_CL_POOL (pClBlk->clNode.pClBuf) != pCache->pClPool)
+            {
+            pMblk = netMblkClFree (pMblk);
+            continue;
+            }
+
+        if (pCache->count >= pCache->depth)
+            _tupleCacheDrain (pCache, pCache->batch);
+
+        pNext = pMblk->mBlkHdr.mNext;
+
+        pClBlk->clSize		= pCache->pClPool->clSize;
+        pMblk->mBlkHdr.mType	= MT_FREE;
+        pMblk->mBlkHdr.mNext	= NULL;
+        pMblk->mBlkHdr.mNextPkt	= pCache->pHead;
+        pCache->pHead		= pMblk;
+        pCache->count++;
+        pCache->pendPut++;
+
+        pMblk = pNext;
+        }
+    }
+
+/*******************************************************************************
+*
+* netTupleCacheShow - display tuple cache statistics
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void netTupleCacheShow
+    (
+    NET_TUPLE_CACHE *	pCache		/* cache to display */
+    )
+    {
+    printf ("cluster size: %d  held: %d/%d  hits: %ld  refills: %ld  "
+            "drains: %ld\n", pCache->pClPool->clSize, pCache->count,
+            pCache->depth, pCache->hits, pCache->refills, pCache->drains);
+    }
+
+/*******************************************************************************
+*
+* _tupleCacheSync - bring the pool statistics up to date for a cache
+*
+* Tuples held by a cache are counted as free in the pool statistics, so
+* each get and free through the cache changes them.  The changes are saved
+* up and applied by this routine, which must be called with interrupts
+* locked.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void _tupleCacheSync
+    (
+    NET_TUPLE_CACHE *	pCache		/* cache to account for */
+    )
+    {
+    int			inUse = pCache->pendGet - pCache->pendPut;
+    M_STAT *		pStat = pCache->pNetPool->pPoolStat;
+
+    pStat->mTypes [MT_FREE]		-= inUse;
+    pStat->mTypes [pCache->type]	+= inUse;
+    pCache->pClPool->clNumFree		-= inUse;
+    pCache->pClPool->clUsage		+= pCache->pendGet;
+
+    pCache->pendGet = 0;
+    pCache->pendPut = 0;
+    }
+
+/*******************************************************************************
+*
+* _tupleCacheRefill - take a batch of tuples from the pool into a cache
+*
+* This routine unlinks up to a batch of mBlks, clBlks and clusters from the
+* pool's free lists under one interrupt lock, then joins them up into
+* tuples.  It takes no more of any one than it can find of all three.
+*
+* RETURNS: the number of tuples added.
+*
+* NOMANUAL
+*/
+
+LOCAL int _tupleCacheRefill
+    (
+    NET_TUPLE_CACHE *	pCache		/* cache to refill */
+    )
+    {
+    NET_POOL_ID		pNetPool = pCache->pNetPool;
+    CL_POOL_ID		pClPool = pCache->pClPool;
+    M_BLK_ID		pMblk;
+    M_BLK_ID		pMblkHead;
+    CL_BLK_ID		pClBlk;
+    CL_BLK_ID		pClBlkHead;
+    CL_BUF_ID		pClBuf;
+    CL_BUF_ID		pClBufHead;
+    int			num;
+    int			ix;
+    FAST int		level;
+
+    level = intLock ();
+
+    _tupleCacheSync (pCache);
+
+    pMblkHead	= pMblk   = pNetPool->pmBlkHead;
+    pClBlkHead	= pClBlk  = pNetPool->pClBlkHead;
+    pClBufHead	= pClBuf  = pClPool->pClHead;
+
+    for (num = 0; num < pCache->batch; num++)
+        {
+        if (pMblk == NULL || pClBlk == NULL || pClBuf == NULL)
+            break;
+
+        pNetPool->pmBlkHead	= pMblk->mBlkHdr.mNext;
+        pNetPool->pClBlkHead	= pClBlk->clNode.pClBlkNext;
+        pClPool->pClHead	= pClBuf->pClNext;
+
+        pMblk	= pNetPool->pmBlkHead;
+        pClBlk	= pNetPool->pClBlkHead;
+        pClBuf	= pClPool->pClHead;
+        }
+
+    if (num > 0 && pClPool->pClHead == NULL)
+        pNetPool->clMask &= ~(CL_LOG2_TO_CL_SIZE(pClPool->clLg2));
+
+    intUnlock (level);
+
+    if (num == 0)
+        return (0);
+
+    /* join them up; the three lists are still linked in order */
+
+    for (ix = 0; ix < num; ix++)
+        {
+        pMblk		= pMblkHead;
+        pClBlk		= pClBlkHead;
+        pClBuf		= pClBufHead;
+        pMblkHead	= pMblk->mBlkHdr.mNext;
+        pClBlkHead	= pClBlk->clNode.pClBlkNext;
+        pClBufHead	= pClBuf->pClNext;
+
+        pClBlk->clNode.pClBuf	= (caddr_t) pClBuf;
+        pClBlk->clSize		= pClPool->clSize;
+        pClBlk->pClFreeRtn	= NULL;
+        pClBlk->clRefCnt	= 0;
+        pClBlk->pNetPool	= pNetPool;
+
+        pMblk->pClBlk		= pClBlk;
+        pMblk->mBlkHdr.mNext	= NULL;
+        pMblk->mBlkHdr.mNextPkt	= pCache->pHead;
+        pCache->pHead		= pMblk;
+        }
+
+    pCache->count += num;
+    pCache->refills++;
+
+    return (num);
+    }
+
+/*******************************************************************************
+*
+* _tupleCacheDrain - give a batch of tuples from a cache back to the pool
+*
+* This routine takes up to <num> tuples from <pCache> apart and puts their
+* mBlks, clBlks and clusters back on the pool's free lists under one
+* interrupt lock.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void _tupleCacheDrain
+    (
+    NET_TUPLE_CACHE *	pCache,		/* cache to drain */
+    int			num		/* max tuples to give back */
+    )
+    {
+    NET_POOL_ID		pNetPool = pCache->pNetPool;
+    CL_POOL_ID		pClPool = pCache->pClPool;
+    M_BLK_ID		pMblk;
+    CL_BLK_ID		pClBlk;
+    CL_BUF_ID		pClBuf;
+    FAST int		level;
+
+    level = intLock ();
+
+    while (num-- > 0 && (pMblk = pCache->pHead) != NULL)
+        {
+        pCache->pHead = pMblk->mBlkHdr.mNextPkt;
+        pCache->count--;
+
+        pClBlk = pMblk->pClBlk;
+        pClBuf = (CL_BUF_ID) pClBlk->clNode.pClBuf;
+
+        pClBuf->pClNext			= pClPool->pClHead;
+        pClPool->pClHead		= pClBuf;
+        pClBlk->clNode.pClBlkNext	= pNetPool->pClBlkHead;
+        pNetPool->pClBlkHead		= pClBlk;
+        pMblk->mBlkHdr.mNextPkt		= NULL;
+        pMblk->mBlkHdr.mNext		= pNetPool->pmBlkHead;
+        pNetPool->pmBlkHead		= pMblk;
+        }
+
+    if (pClPool->pClHead != NULL)
+        pNetPool->clMask |= CL_LOG2_TO_CL_SIZE(pClPool->clLg2);
+
+    _tupleCacheSync (pCache);
+
+    intUnlock (level);
+
+    pCache->drains++;
+    }
@@ -6,6 +6,12 @@
 /*
 modification history
 --------------------
+03t,17oct26,agt  netJobQueueSelect() hashes addresses and protocol, no ports.
+03s,17oct26,agt  reserved queue 0 space for jobs that must not be dropped,
+		 added netJobReservedAdd()
+03r,17oct26,agt  added multiple job queues with flow steering, batched
+		 draining and per-queue statistics; overflow now drops the
+		 job instead of panicking
 03q,07may02,kbw  man page edits
 03p,15oct01,rae  merge from truestack ver 04a, base 03o, (SPRs 69112, 32626 etc.)
 03o,16mar99,spm  recovered orphaned code from tor1_0_1.sens1_1 (SPR #25770)
@@ -109,6 +115,25 @@ removes routines that were added to the job queue.  This facility is used
 by network interfaces in order to have interrupt-level processing at
 task level.
 
+The job queue may be split into several queues, each drained by its own
+task, by setting the global <netJobQueues> before netLibInit() is called.
+Queue 0 is always served by netTask() and is where netJobAdd() places its
+jobs.  The other queues are served by tasks named tNetTask1, tNetTask2 and
+so on, and are fed with netJobQueueAdd(), normally with a queue chosen by
+netJobQueueSelect() from the addresses and protocol of a packet, so that
+the packets of one flow are always handled by the same task, in order, while
+a busy flow cannot hold up the jobs on the other queues.  The protocol
+code serializes on splnet(), so the queues isolate flows from one another
+rather than run them in parallel.  Each task runs at most <netJobBatch>
+jobs per pass before letting other tasks of its priority run, and
+netJobQueueShow() displays the depth and overflow counts of each queue.
+
+A full job queue drops the job, and netJobAdd() or netJobQueueAdd()
+returns ERROR.  The last NET_JOB_RESERVED slots of queue 0 are kept for
+netJobReservedAdd(), which the protocol timers and other control jobs use,
+so that a burst of received packets cannot stop the stack's timers, which
+are only restarted by the queued job itself.
+
 The routine netLibInit() initializes the network and spawns the network
 task netTask().  This is done automatically when INCLUDE_NET_LIB is defined.
 
@@ -130,6 +155,7 @@ SEE ALSO: routeLib, hostLib, netDrv, netHelp(),
 #include "sockLib.h"
 #include "logLib.h"
 #include "intLib.h"
+#include "stdio.h"
 #include "netLib.h"
 #include "remLib.h"
 #include "net/mbuf.h"
@@ -171,20 +197,39 @@ typedef struct
 
 #define JOB_RING_SIZE (85 * sizeof (TODO_NODE))
 
+#define NET_JOB_QUEUES_MAX	8	/* max # of job queues */
+#define NET_JOB_BATCH_MAX	32	/* max # of jobs taken per pass */
+#define NET_JOB_RESERVED	32	/* queue 0 slots for reserved jobs */
+
+typedef struct
+    {
+    RING_ID	ringId;		/* ring buffer of jobs to do */
+    SEMAPHORE	sem;		/* work-to-do sync-semaphore */
+    int		taskId;		/* task draining this queue */
+    int		reserved;	/* slots only reserved jobs may use */
+    ULONG	jobs;		/* jobs run */
+    ULONG	wakeups;	/* times the task was woken */
+    ULONG	depthMax;	/* most jobs ever waiting */
+    ULONG	overflows;	/* jobs dropped, ring full */
+    } NET_JOB_Q;
+
 /* local variables */
 
-LOCAL SEMAPHORE netTaskSem;		/* netTask work-to-do sync-semaphore */
-LOCAL RING_ID   netJobRing;		/* ring buffer of net jobs to do */
+LOCAL NET_JOB_Q netJobQ [NET_JOB_QUEUES_MAX];	/* job queues */
+LOCAL void	netJobQDrain (NET_JOB_Q * pQ);
+LOCAL STATUS	netJobPut (NET_JOB_Q * pQ, TODO_NODE * pNode, int reserved);
 
 /* global variables */
 
-SEM_ID netTaskSemId = &netTaskSem;
+SEM_ID netTaskSemId = &netJobQ[0].sem;
 
 int netTaskId;
 int netTaskPriority  = 50;
 int netTaskOptions   = VX_SUPERVISOR_MODE | VX_UNBREAKABLE;
 int netTaskStackSize = 10000;
 int netLibInitialized = FALSE;
+int netJobQueues     = 1;	/* # of job queues, set before netLibInit */
+int netJobBatch      = 16;	/* jobs run per pass before yielding */
 
 #ifndef VIRTUAL_STACK
 int _protoSwIndex    = 0; 	/* index for number of protocols initialized */
@@ -277,6 +322,8 @@ void netLibGeneralInit (void)
 
 STATUS netLibInit (void)
     {
+    int		ix;
+    char	taskName [16];
 
     if (netLibInitialized)
 #ifndef VIRTUAL_STACK
@@ -294,18 +341,52 @@ STATUS netLibInit (void)
 
     netLibInitialized = TRUE;
 
-    if ((netJobRing = rngCreate (JOB_RING_SIZE)) == (RING_ID) NULL)
-	panic ("netLibInit: couldn't create job ring\n");
+    if (netJobQueues < 1)
+	netJobQueues = 1;
+    if (netJobQueues > NET_JOB_QUEUES_MAX)
+	netJobQueues = NET_JOB_QUEUES_MAX;
+
+    netJobQ[0].reserved = NET_JOB_RESERVED;
+
+    for (ix = 0; ix < netJobQueues; ix++)
+	{
+	if ((netJobQ[ix].ringId = rngCreate (JOB_RING_SIZE +
+			netJobQ[ix].reserved * sizeof (TODO_NODE))) == NULL)
+	    panic ("netLibInit: couldn't create job ring\n");
+	semBInit (&netJobQ[ix].sem, SEM_Q_PRIORITY, SEM_EMPTY);
+	}
 
     if (rebootHookAdd ((FUNCPTR) ifresetImmediate) == ERROR)
 	logMsg ("netLibInit: unable to add reset hook\n", 0, 0, 0, 0, 0, 0);
-    semBInit (netTaskSemId, SEM_Q_PRIORITY, SEM_EMPTY);
 
     netLibGeneralInit ();	     /* General initialization of the network */
 
     netTaskId = taskSpawn ("tNetTask", netTaskPriority,
 		           netTaskOptions, netTaskStackSize,
 			   (FUNCPTR) netTask, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    netJobQ[0].taskId = netTaskId;
+
+    /* 
+     * A queue without a task would swallow its jobs, so if a worker
+     * can't be spawned the queues from there on are given up.
+     */
+
+    for (ix = 1; ix < netJobQueues; ix++)
+	{
+	sprintf (taskName, "tNetTask%d", ix);
+	netJobQ[ix].taskId = taskSpawn (taskName, netTaskPriority,
+				        netTaskOptions, netTaskStackSize,
+				        (FUNCPTR) netJobQDrain,
+				        (int) &netJobQ[ix],
+				        0, 0, 0, 0, 0, 0, 0, 0, 0);
+	if (netJobQ[ix].taskId == ERROR)
+	    {
+	    logMsg ("netLibInit: couldn't spawn %s\n", (int) taskName,
+		    0, 0, 0, 0, 0);
+	    netJobQueues = ix;
+	    break;
+	    }
+	}
 
     return (netTaskId == ERROR ? ERROR : OK);
     }
@@ -337,33 +418,76 @@ STATUS netLibInit (void)
 * SEE ALSO: netLibInit()
 *
 * INTERNAL
-* netTask() reads messages from a ring buffer which is filled by calling
+* netTask() reads messages from job queue 0, which is filled by calling
 * netJobAdd().
 */
 
 void netTask (void)
     {
-    TODO_NODE 	jobNode;
+    netJobQDrain (&netJobQ[0]);
+    }
+
+/*******************************************************************************
+*
+* netJobQDrain - run the jobs on a network job queue
+*
+* This is the body of netTask() and of the other network job tasks.  Jobs
+* are taken off the ring <netJobBatch> at a time and then run; when a full
+* batch has been run and more are waiting, the task yields the CPU to any
+* other ready task of the same priority, such as the task of another job
+* queue, before going on.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void netJobQDrain
+    (
+    NET_JOB_Q *	pQ		/* queue to serve */
+    )
+    {
+    TODO_NODE 	jobs [NET_JOB_BATCH_MAX];
+    int		batch;
+    int		nJobs;
+    int		ix;
 
     FOREVER
 	{
 	/* wait for somebody to wake us up */
 
-	semTake (netTaskSemId, WAIT_FOREVER);
+	semTake (&pQ->sem, WAIT_FOREVER);
+	pQ->wakeups++;
 
 	/* process requests in the toDo list */
 
-	while (rngIsEmpty (netJobRing) == FALSE)
+	FOREVER
 	    {
-	    if (rngBufGet (netJobRing, (char *) &jobNode,
-			   sizeof (jobNode)) != sizeof (jobNode))
+	    batch = min (max (netJobBatch, 1), NET_JOB_BATCH_MAX);
+
+	    for (nJobs = 0; nJobs < batch; nJobs++)
 		{
-		panic ("netTask: netJobRing overflow!\n");
+		if (rngIsEmpty (pQ->ringId))
+		    break;
+
+		if (rngBufGet (pQ->ringId, (char *) &jobs[nJobs],
+			       sizeof (TODO_NODE)) != sizeof (TODO_NODE))
+		    {
+		    panic ("netTask: netJobRing overflow!\n");
+		    }
 		}
 
-	    (*(jobNode.routine)) (jobNode.param1, jobNode.param2,
-				  jobNode.param3, jobNode.param4,
-				  jobNode.param5);
+	    for (ix = 0; ix < nJobs; ix++)
+		(*(jobs[ix].routine)) (jobs[ix].param1, jobs[ix].param2,
+				       jobs[ix].param3, jobs[ix].param4,
+				       jobs[ix].param5);
+
+	    pQ->jobs += nJobs;
+
+	    if ((nJobs < batch) || rngIsEmpty (pQ->ringId))
+		break;
+
+	    taskDelay (0);
 	    }
 	}
     }
@@ -376,8 +500,10 @@ void netTask (void)
 * to be added to the network job queue.
 * Only network interfaces should use this function, usually
 * to have their interrupt level processing done at task level.
+* If the queue is full the job is not added; jobs that must not be
+* lost are added with netJobReservedAdd().
 *
-* RETURNS: OK or ERROR
+* RETURNS: OK or ERROR if the queue is full.
 *
 * NOMANUAL
 */
@@ -392,9 +518,79 @@ STATUS netJobAdd
     int param5
     )
     {
-    FAST int oldlevel;
+    return (netJobQueueAdd (0, routine, param1, param2, param3, param4,
+			    param5));
+    }
+
+/*******************************************************************************
+*
+* netJobQueueAdd - add a routine to one of the network job queues
+*
+* This routine is like netJobAdd(), but puts the job on job queue <queue>,
+* taken modulo the number of queues, to be run by that queue's task.  Jobs
+* on one queue are run in the order they were added.  If the queue is
+* full the job is not added, and is counted as an overflow; queue 0 counts
+* as full when only the slots kept for netJobReservedAdd() are left.
+*
+* RETURNS: OK or ERROR if the queue is full.
+*
+* NOMANUAL
+*/
+
+STATUS netJobQueueAdd
+    (
+    int queue,
+    FUNCPTR routine,
+    int param1,
+    int param2,
+    int param3,
+    int param4,
+    int param5
+    )
+    {
+    FAST NET_JOB_Q * pQ;
+    TODO_NODE newNode;
+
+    pQ = &netJobQ [(unsigned) queue % (unsigned) netJobQueues];
+
+    newNode.routine = routine;
+    newNode.param1 = param1;
+    newNode.param2 = param2;
+    newNode.param3 = param3;
+    newNode.param4 = param4;
+    newNode.param5 = param5;
+
+    return (netJobPut (pQ, &newNode, pQ->reserved));
+    }
+
+/*******************************************************************************
+*
+* netJobReservedAdd - add a job that must not be dropped to the job queue
+*
+* This routine is like netJobAdd(), but may also use the slots of job queue
+* 0 kept back from netJobAdd() and netJobQueueAdd().  It is meant for jobs
+* whose loss would stop part of the stack, such as protocol timers that
+* are restarted only by the queued job, and for other control jobs.  Each
+* such source has at most a few jobs queued at a time, so the reserve is
+* never used up; if it is, the system panics, as a full job queue always
+* did before jobs could be dropped.
+*
+* RETURNS: OK
+*
+* NOMANUAL
+*/
+
+STATUS netJobReservedAdd
+    (
+    FUNCPTR routine,
+    int param1,
+    int param2,
+    int param3,
+    int param4,
+    int param5
+    )
+    {
     TODO_NODE newNode;
-    BOOL ok;
 
     newNode.routine = routine;
     newNode.param1 = param1;
@@ -403,23 +599,128 @@ STATUS netJobAdd
     newNode.param4 = param4;
     newNode.param5 = param5;
 
+    if (netJobPut (&netJobQ[0], &newNode, 0) != OK)
+	panic ("netJobReservedAdd: ring buffer overflow!\n");
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* netJobPut - put a job on a network job queue
+*
+* This routine adds the job <pNode> to the queue <pQ> and wakes up the
+* queue's task, provided that at least <reserved> slots are left free
+* after it.  Otherwise the job is counted as an overflow.
+*
+* RETURNS: OK or ERROR if the queue is full.
+*
+* NOMANUAL
+*/
+
+LOCAL STATUS netJobPut
+    (
+    NET_JOB_Q *	pQ,		/* queue to add to */
+    TODO_NODE *	pNode,		/* job to add */
+    int		reserved	/* slots to leave free */
+    )
+    {
+    FAST int oldlevel;
+    ULONG depth;
+    BOOL ok;
+
     oldlevel = intLock ();
-    ok = rngBufPut (netJobRing, (char *) &newNode, sizeof (newNode)) ==
-							sizeof (newNode);
+    ok = (rngFreeBytes (pQ->ringId) >=
+	  (int) ((reserved + 1) * sizeof (TODO_NODE))) &&
+	 (rngBufPut (pQ->ringId, (char *) pNode, sizeof (TODO_NODE)) ==
+							sizeof (TODO_NODE));
+    if (ok)
+	{
+	depth = rngNBytes (pQ->ringId) / sizeof (TODO_NODE);
+	if (depth > pQ->depthMax)
+	    pQ->depthMax = depth;
+	}
+    else
+	pQ->overflows++;
     intUnlock (oldlevel);
 
     if (!ok)
-	{
-	panic ("netJobAdd: ring buffer overflow!\n");
 	return (ERROR);
-	}
 
     /* wake up the network daemon to process the request */
 
-    semGive (netTaskSemId);
+    semGive (&pQ->sem);
 
     return (OK);
     }
+
+/*******************************************************************************
+*
+* netJobQueueSelect - choose the job queue for a flow
+*
+* This routine hashes the source and destination addresses of a packet,
+* given in network byte order, and its protocol, to pick the job queue its
+* processing should be deferred to.  The addresses of the two directions
+* of a connection are combined symmetrically, so both hash to the same
+* queue.  Ports are not used: fragments carry none, and every packet of a
+* flow, fragmented or not, has to hash to the same queue to stay in order.
+*
+* RETURNS: a job queue number.
+*
+* NOMANUAL
+*/
+
+int netJobQueueSelect
+    (
+    ULONG	srcAddr,	/* source address */
+    ULONG	dstAddr,	/* destination address */
+    int		proto		/* transport protocol */
+    )
+    {
+    FAST ULONG	hash;
+
+    if (netJobQueues <= 1)
+	return (0);
+
+    hash = (srcAddr ^ dstAddr) ^ ((ULONG) proto << 16);
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+
+    return ((int) (hash % (ULONG) netJobQueues));
+    }
+
+/*******************************************************************************
+*
+* netJobQueueShow - display the network job queues
+*
+* This routine shows, for each network job queue, the task serving it, the
+* jobs waiting and run, the deepest the queue has been and the number of
+* jobs lost because it was full.
+*
+* RETURNS: N/A
+*/
+
+void netJobQueueShow (void)
+    {
+    int		ix;
+    NET_JOB_Q *	pQ;
+
+    printf ("%-5s %-10s %7s %7s %10s %10s %9s\n", "queue", "task",
+	    "waiting", "maxwait", "jobs", "wakeups", "overflows");
+
+    for (ix = 0; ix < netJobQueues; ix++)
+	{
+	pQ = &netJobQ [ix];
+	if (pQ->ringId == NULL)
+	    continue;
+
+	printf ("%-5d %#-10x %7d %7ld %10ld %10ld %9ld\n", ix, pQ->taskId,
+		rngNBytes (pQ->ringId) / sizeof (TODO_NODE), pQ->depthMax,
+		pQ->jobs, pQ->wakeups, pQ->overflows);
+	}
+    }
+
 /*******************************************************************************
 *
 * netErrnoSet - set network error status
@@ -7,6 +7,7 @@
 /*
 modification history
 --------------------
+01b,17oct26,agt  queue the advertisement timer with netJobReservedAdd()
 01a,29mar01,spm  file creation: copied from version 01g of tor2_0.open_stack
                  branch (wpwr VOB) for unified code base
 */
@@ -96,6 +97,7 @@ struct rdiscPacket
 
 
 /* globals */
+IMPORT STATUS netJobReservedAdd (FUNCPTR, int, int, int, int, int);
 #ifndef VIRTUAL_STACK
 IMPORT struct ifnet     *ifnet;         /* list of all network interfaces */
 IMPORT struct in_ifaddr    *in_ifaddr;
@@ -313,7 +315,7 @@ void rdiscTimerEventRestart
     int stackNum
     )
     {
-    netJobAdd ((FUNCPTR)rdiscTimerEvent, stackNum, 0, 0, 0, 0);
+    netJobReservedAdd ((FUNCPTR)rdiscTimerEvent, stackNum, 0, 0, 0, 0);
     }
 
 void rdiscTimerEvent
@@ -387,7 +389,8 @@ void rdisc ()
     status = wdStart(wdId, INITIAL_DELAY, (FUNCPTR) rdiscTimerEventRestart,
                      (int) myStackNum);
 #else
-    status = wdStart(wdId, INITIAL_DELAY, netJobAdd, (int)rdiscTimerEvent );
+    status = wdStart(wdId, INITIAL_DELAY, netJobReservedAdd,
+                     (int)rdiscTimerEvent);
 #endif /* VIRTUAL_STACK */
     if (status == ERROR) 
 	{
@@ -497,7 +500,7 @@ LOCAL void startWdTimer()
 #ifdef VIRTUAL_STACK
     wdStart(wdId, interval, (FUNCPTR)rdiscTimerEventRestart, (int) myStackNum);
 #else
-    wdStart(wdId, interval, netJobAdd, (int)rdiscTimerEvent);
+    wdStart(wdId, interval, netJobReservedAdd, (int)rdiscTimerEvent);
 #endif /* VIRTUAL_STACK */
     }
 
@@ -6,6 +6,7 @@
 /*
 modification history 
 --------------------
+01m,17oct26,agt  queue the broadcast timer with netJobReservedAdd()
 01l,07may02,kbw  man page edits
 01k,25oct00,ham  doc: cleanup for vxWorks AE 1.0.
 01j,16mar99,spm  removed references to configAll.h (SPR #25663)
@@ -92,6 +93,10 @@ SEE ALSO: sntpcLib, RFC 1769
 
 #define NSEC_BASE2 	30 	/* Integral log2 for nanosecond conversion. */
 
+/* externals */
+
+IMPORT STATUS netJobReservedAdd (FUNCPTR, int, int, int, int, int);
+
 /* forward declarations */
 
 LOCAL void sntpsMsgSend (void);
@@ -608,7 +613,7 @@ LOCAL void sntpsStart (void)
 
     if (sntpsMode == SNTP_ACTIVE)
         wdStart (sntpsTimer, sntpsInterval * sysClkRateGet (),
-                 (FUNCPTR)netJobAdd, (int)sntpsMsgSend);
+                 (FUNCPTR)netJobReservedAdd, (int)sntpsMsgSend);
     FOREVER 
         {
         result = recvfrom (sntpSocket, (caddr_t)&sntpRequest, 
@@ -742,7 +747,7 @@ void sntpsMsgSend (void)
         {
         semGive (sntpsMutexSem);
         wdStart (sntpsTimer, sntpsInterval * sysClkRateGet (),
-                 (FUNCPTR)netJobAdd, (int)sntpsMsgSend);
+                 (FUNCPTR)netJobReservedAdd, (int)sntpsMsgSend);
         return;
         }
 
@@ -758,7 +763,7 @@ void sntpsMsgSend (void)
         {
         semGive (sntpsMutexSem);
         wdStart (sntpsTimer, sntpsInterval * sysClkRateGet (),
-                 (FUNCPTR)netJobAdd, (int)sntpsMsgSend);
+                 (FUNCPTR)netJobReservedAdd, (int)sntpsMsgSend);
         return;
         }
 
@@ -777,7 +782,7 @@ void sntpsMsgSend (void)
     if (sntpSocket == -1) 
         {
         wdStart (sntpsTimer, interval * sysClkRateGet (),
-                 (FUNCPTR)netJobAdd, (int)sntpsMsgSend);
+                 (FUNCPTR)netJobReservedAdd, (int)sntpsMsgSend);
         return;
         }
 
@@ -790,7 +795,7 @@ void sntpsMsgSend (void)
         {
         close (sntpSocket);
         wdStart (sntpsTimer, interval * sysClkRateGet (),
-                 (FUNCPTR)netJobAdd, (int)sntpsMsgSend);
+                 (FUNCPTR)netJobReservedAdd, (int)sntpsMsgSend);
         return;
         }
 
@@ -834,6 +839,6 @@ void sntpsMsgSend (void)
     /* Schedule a new transmission after the broadcast interval. */
 
     wdStart (sntpsTimer, interval * sysClkRateGet (),
-             (FUNCPTR)netJobAdd, (int)sntpsMsgSend);
+             (FUNCPTR)netJobReservedAdd, (int)sntpsMsgSend);
     return;
     }
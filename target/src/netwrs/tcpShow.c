@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+01h,17oct26,agt  added tcpRecoveryShow() and fast recovery totals
 01g,10may02,kbw  making man page edits
 01f,15oct01,rae  merge from truestack ver 01h, base 01d (VIRTUAL_STACK)
 01e,14nov00,ham  fixed unnecessary dependency against tcp_debug(SPR 62272).
@@ -71,6 +72,11 @@ IMPORT struct inpcbhead * 	_pTcpPcbHead;	/* defined in netShow.c */
 
 IMPORT VOIDFUNCPTR		_pTcpPcbPrint;	/* defined in netShow.c */
 
+IMPORT u_long			tcp_recoveries;	/* defined in tcp_sack.c */
+IMPORT u_long			tcp_partialacks;
+IMPORT u_long			tcp_sackrexmits;
+IMPORT void			tcp_sack_print (struct tcpcb *);
+
 /* forward declarations */
 
 LOCAL void _tcpPcbPrint (struct inpcb * pInPcb);
@@ -225,6 +231,12 @@ void tcpstatShow (void)
        "\t%d segment%s updated rtt (of %d attempt%s)\n");
     p (tcps_rexmttimeo, "\t%d retransmit timeout%s\n");
     p (tcps_timeoutdrop, "\t\t%d connection%s dropped by rexmit timeout\n");
+    printf ("\t%d fast recovery episode%s\n", (int)tcp_recoveries,
+            plural (tcp_recoveries));
+    printf ("\t\t%d partial ack%s\n", (int)tcp_partialacks,
+            plural (tcp_partialacks));
+    printf ("\t\t%d segment%s resent from SACK holes\n",
+            (int)tcp_sackrexmits, plural (tcp_sackrexmits));
     p (tcps_persisttimeo, "\t%d persist timeout%s\n");
     p (tcps_keeptimeo, "\t%d keepalive timeout%s\n");
     p (tcps_keepprobe, "\t\t%d keepalive probe%s sent\n");
@@ -234,3 +246,44 @@ void tcpstatShow (void)
 #undef p
 #undef p2
     }
+
+/*****************************************************************************
+*
+* tcpRecoveryShow - display loss recovery statistics of TCP connections
+*
+* This routine displays, for each TCP connection, whether selective
+* acknowledgments (SACK) were negotiated, whether the connection is in
+* fast recovery, and the following counts: fast recoveries entered
+* (RECOV), partial acknowledgments received during recovery (PARTIAL),
+* segments resent from the holes the peer reported (SACKRX), recoveries
+* ended by a retransmission timeout (TIMEOUT), and SACK blocks received
+* (BLKSIN) and sent (BLKSOUT).
+*
+* RETURNS: N/A
+*/
+
+void tcpRecoveryShow (void)
+    {
+    struct inpcb *	inp;
+    struct tcpcb *	pTcpCb;
+
+    if (_pTcpPcbHead == NULL)
+        return;
+
+    printf ("PCB      SACK REC  RECOV PARTIAL  SACKRX TIMEOUT   BLKSIN  BLKSOUT"
+            " STATE\n");
+    printf ("-------- ---- --- ------ ------- ------- ------- -------- --------"
+            " -----------\n");
+
+    for (inp = _pTcpPcbHead->lh_first; inp != NULL;
+         inp = inp->inp_list.le_next)
+        {
+        if ((pTcpCb = (struct tcpcb *) inp->inp_ppcb) == NULL)
+            continue;
+
+        printf ("%-8x ", (u_int) inp);
+        tcp_sack_print (pTcpCb);
+        _tcpPcbPrint (inp);
+        printf ("\n");
+        }
+    }
@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+02n,17oct26,agt  added _func_selSetPost.
 02m,26mar02,pai  added _func_sseTaskRegsShow (SPR 74103).
 02l,14mar02,elr  replaced ftpErrorSuppress with ftplDebug (SPR 71496)
 02k,09nov01,jn   add new internal symLib api
@@ -88,6 +89,7 @@ FUNCPTR     _func_memalign;
 FUNCPTR     _func_printErr;
 FUNCPTR     _func_selPtyAdd;
 FUNCPTR     _func_selPtyDelete;
+FUNCPTR     _func_selSetPost;
 FUNCPTR     _func_pthread_setcanceltype;
 FUNCPTR     _func_selTyAdd;
 FUNCPTR     _func_selTyDelete;
@@ -0,0 +1,593 @@
+/* memCacheLib.c - memory partition size-class cache library */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+#include "copyright_wrs.h"
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  written
+*/
+
+/*
+DESCRIPTION
+This library provides an optional front end for memory partitions which
+serves small requests without searching the partition free list.  Freed
+blocks of up to 2048 bytes of user data are not coalesced straight away
+but are kept on one of eight bins, sorted by power-of-two size class from
+16 to 2048 bytes.  A later request for no more than a class's size is
+satisfied from that class's bin in constant time.
+
+The bins are shared by all tasks using the partition and are manipulated
+with preemption locked, which is cheaper than taking the partition
+semaphore and never blocks.  The partition semaphore is only taken when a
+bin has to be refilled or drained, and then only once for a whole batch
+of blocks.  An empty bin is refilled with several blocks of the class
+size at a time; a bin holding too many blocks gives the oldest back to
+the partition, where they are coalesced as usual.  Requests too large for
+any class, and requests which cannot be refilled, go through the normal
+first-fit allocator unchanged.
+
+The cache is enabled on a partition by setting the MEM_PART_SIZE_CLASS
+option with memPartOptionsSet(), and disabled by clearing it, which gives
+every cached block back to the partition.  To the partition a cached block
+is still allocated, so the statistics reported by memPartShow() and
+memPartInfoGet() count it as allocated memory; memPartShow() reports the
+amount held by the cache separately, and memPartCacheInfoGet() returns it.
+
+When MEM_BLOCK_CHECK is set, a block is checked before being cached; any
+block the cache declines is passed on to memPartFree()'s usual check and
+error handling.  Because a cached block is still marked as allocated,
+freeing the same block twice is not detected while it sits in a bin.
+
+The cache is not available for shared memory partitions.
+
+INCLUDE FILES: memCacheLib.h, memLib.h
+
+SEE ALSO: memPartLib, memLib, memShow
+*/
+
+#include "vxWorks.h"
+#include "semLib.h"
+#include "taskLib.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "errnoLib.h"
+#include "memLib.h"
+#include "memCacheLib.h"
+#include "private/memPartLibP.h"
+
+/* defines */
+
+#define MEM_CACHE_MAX_BYTES	(1 << (MEM_CACHE_MIN_SHIFT + MEM_CACHE_CLASSES - 1))
+#define MEM_CACHE_BATCH		8	/* blocks moved per refill/drain */
+#define MEM_CACHE_BIN_MAX	32	/* blocks kept per bin */
+
+/* typedefs */
+
+typedef struct memPartCache	/* MEM_PART_CACHE */
+    {
+    struct memPartCache * pNext;		/* next partition cache */
+    PART_ID		partId;			/* partition fronted */
+    char *		bin [MEM_CACHE_CLASSES];	/* free blocks by class */
+    int			binCount [MEM_CACHE_CLASSES];	/* blocks per bin */
+    MEM_CACHE_STATS	stats;			/* cache statistics */
+    } MEM_PART_CACHE;
+
+/* a cached block is linked through the first word of its user area */
+
+#define BIN_NEXT(pBlock)	(*(char **) (pBlock))
+
+/* externals */
+
+extern FUNCPTR	memPartCacheAllocRtn;
+extern FUNCPTR	memPartCacheFreeRtn;
+extern FUNCPTR	memPartCacheShowRtn;
+extern UINT	memDefaultAlignment;
+
+extern BLOCK_HDR *memPartBlockAlloc (PART_ID partId, unsigned nWords,
+				     unsigned alignment);
+extern void	memPartBlockFree (PART_ID partId, BLOCK_HDR *pHdr);
+
+/* locals */
+
+LOCAL MEM_PART_CACHE *	memPartCacheList = NULL;	/* all caches */
+
+/* forward static functions */
+
+LOCAL MEM_PART_CACHE *memPartCacheFind (PART_ID partId);
+LOCAL void *	memPartCacheAlloc (PART_ID partId, unsigned nBytes);
+LOCAL BOOL	memPartCacheFree (PART_ID partId, char *pBlock);
+LOCAL void	memPartCacheStatsShow (PART_ID partId);
+LOCAL void	memPartCacheDrain (MEM_PART_CACHE *pCache, int class,
+				   int nBlocks);
+
+/*******************************************************************************
+*
+* memPartCacheCreate - add a size-class cache to a memory partition
+*
+* This routine creates the size-class cache for <partId>, if it has none
+* yet, and installs the cache in memPartLib.  The cache is not used until
+* the MEM_PART_SIZE_CLASS option is set on the partition; memPartOptionsSet()
+* calls this routine when it is.  Once created, a cache lasts as long as
+* the system: it is emptied, but not deleted, when the option is cleared.
+*
+* RETURNS: OK, or ERROR if <partId> is not a local partition or memory for
+* the cache could not be allocated.
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR, S_memLib_NOT_ENOUGH_MEMORY
+*/
+
+STATUS memPartCacheCreate
+    (
+    PART_ID partId		/* partition to cache */
+    )
+    {
+    MEM_PART_CACHE *pCache;
+
+    if (ID_IS_SHARED (partId) ||
+	(OBJ_VERIFY (partId, memPartClassId) != OK))
+	{
+	errnoSet (S_objLib_OBJ_ID_ERROR);
+	return (ERROR);
+	}
+
+    if (memPartCacheFind (partId) != NULL)
+	return (OK);
+
+    /* the descriptor comes from the system partition, which may itself
+     * be the one being cached, so it must be obtained before the list
+     * (or the hooks) can route any allocation through it
+     */
+
+    if ((pCache = (MEM_PART_CACHE *) calloc (1, sizeof (MEM_PART_CACHE)))
+	== NULL)
+	return (ERROR);
+
+    pCache->partId = partId;
+
+    TASK_LOCK ();					/* LOCK PREEMPTION */
+
+    if (memPartCacheFind (partId) != NULL)		/* lost a race */
+	{
+	TASK_UNLOCK ();
+	free ((char *) pCache);
+	return (OK);
+	}
+
+    pCache->pNext	 = memPartCacheList;
+    memPartCacheList	 = pCache;
+
+    memPartCacheAllocRtn = (FUNCPTR) memPartCacheAlloc;
+    memPartCacheFreeRtn	 = (FUNCPTR) memPartCacheFree;
+    memPartCacheShowRtn	 = (FUNCPTR) memPartCacheStatsShow;
+
+    TASK_UNLOCK ();					/* UNLOCK PREEMPTION */
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* memPartCacheFlush - give all cached blocks back to a memory partition
+*
+* This routine empties every bin of the size-class cache of <partId>,
+* returning the blocks to the partition free list.  It is called by
+* memPartOptionsSet() when the MEM_PART_SIZE_CLASS option is cleared, and
+* may be called at any time to defragment the partition.
+*
+* RETURNS: OK, or ERROR if <partId> has no size-class cache.
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR
+*/
+
+STATUS memPartCacheFlush
+    (
+    PART_ID partId		/* partition to flush */
+    )
+    {
+    MEM_PART_CACHE *pCache;
+    int		    class;
+
+    if ((pCache = memPartCacheFind (partId)) == NULL)
+	{
+	errnoSet (S_objLib_OBJ_ID_ERROR);
+	return (ERROR);
+	}
+
+    for (class = 0; class < MEM_CACHE_CLASSES; class++)
+	{
+	while (pCache->binCount [class] > 0)
+	    memPartCacheDrain (pCache, class, MEM_CACHE_BATCH);
+	}
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* memPartCacheInfoGet - get size-class cache statistics for a partition
+*
+* This routine copies the statistics of the size-class cache of <partId>
+* into the structure pointed to by <pStats>.
+*
+* RETURNS: OK, or ERROR if <partId> has no size-class cache.
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR
+*/
+
+STATUS memPartCacheInfoGet
+    (
+    PART_ID	     partId,	/* partition to query */
+    MEM_CACHE_STATS *pStats	/* where to put the statistics */
+    )
+    {
+    MEM_PART_CACHE *pCache;
+
+    if ((pCache = memPartCacheFind (partId)) == NULL)
+	{
+	errnoSet (S_objLib_OBJ_ID_ERROR);
+	return (ERROR);
+	}
+
+    TASK_LOCK ();					/* LOCK PREEMPTION */
+    *pStats = pCache->stats;
+    TASK_UNLOCK ();					/* UNLOCK PREEMPTION */
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* memPartCacheShow - show size-class cache statistics for a partition
+*
+* This routine displays the number of blocks and bytes held in each bin of
+* the size-class cache of <partId>, followed by the cache totals.
+*
+* RETURNS: OK, or ERROR if <partId> has no size-class cache.
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR
+*/
+
+STATUS memPartCacheShow
+    (
+    PART_ID partId		/* partition to show */
+    )
+    {
+    MEM_PART_CACHE *pCache;
+    MEM_CACHE_STATS stats;
+    int		    binCount [MEM_CACHE_CLASSES];
+    int		    class;
+
+    if ((pCache = memPartCacheFind (partId)) == NULL)
+	{
+	errnoSet (S_objLib_OBJ_ID_ERROR);
+	return (ERROR);
+	}
+
+    TASK_LOCK ();					/* LOCK PREEMPTION */
+    stats = pCache->stats;
+    for (class = 0; class < MEM_CACHE_CLASSES; class++)
+	binCount [class] = pCache->binCount [class];
+    TASK_UNLOCK ();					/* UNLOCK PREEMPTION */
+
+    printf ("\n%6s %8s\n", "class", "blocks");
+    printf ("%6s %8s\n",   "------", "--------");
+
+    for (class = 0; class < MEM_CACHE_CLASSES; class++)
+	printf ("%6d %8d\n", 1 << (class + MEM_CACHE_MIN_SHIFT),
+		binCount [class]);
+
+    printf ("\n%10s %10s %10s %10s %10s\n",
+	    "bytes", "blocks", "hits", "misses", "flushes");
+    printf ("%10s %10s %10s %10s %10s\n",
+	    "----------", "----------", "----------", "----------",
+	    "----------");
+    printf ("%10lu %10lu %10lu %10lu %10lu\n", stats.numBytesCached,
+	    stats.numBlocksCached, stats.numHits, stats.numMisses,
+	    stats.numFlushes);
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* memPartCacheFind - find the size-class cache of a partition
+*
+* RETURNS: The cache descriptor, or NULL if <partId> has none.
+*
+* NOMANUAL
+*/
+
+LOCAL MEM_PART_CACHE *memPartCacheFind
+    (
+    PART_ID partId
+    )
+    {
+    MEM_PART_CACHE *pCache;
+
+    /* descriptors are only ever added, at the head, so the list can be
+     * walked without locking
+     */
+
+    for (pCache = memPartCacheList; pCache != NULL; pCache = pCache->pNext)
+	{
+	if (pCache->partId == partId)
+	    return (pCache);
+	}
+
+    return (NULL);
+    }
+
+/*******************************************************************************
+*
+* memPartCacheAlloc - allocate a block from the size-class cache
+*
+* This routine is called by memPartAlloc() through memPartCacheAllocRtn.
+* If the bin for <nBytes> is empty, it is refilled with up to
+* MEM_CACHE_BATCH blocks taken from the partition under a single semTake().
+*
+* RETURNS: A pointer to the block, or NULL if the request is too large to
+* be cached or the bin could not be refilled; memPartAlloc() then falls
+* back to the partition, which reports any error.
+*
+* NOMANUAL
+*/
+
+LOCAL void *memPartCacheAlloc
+    (
+    PART_ID  partId,		/* partition to allocate from */
+    unsigned nBytes		/* number of bytes to allocate */
+    )
+    {
+    MEM_PART_CACHE *pCache;
+    BLOCK_HDR *	    pHdr;
+    char *	    pBlock;
+    char *	    pList;
+    unsigned	    nWords;
+    unsigned long   nCached;
+    int		    class;
+    int		    ix;
+
+    if ((nBytes > MEM_CACHE_MAX_BYTES) ||
+	((pCache = memPartCacheFind (partId)) == NULL))
+	return (NULL);
+
+    for (class = 0; (1u << (class + MEM_CACHE_MIN_SHIFT)) < nBytes; class++)
+	;
+
+    TASK_LOCK ();					/* LOCK PREEMPTION */
+
+    if ((pBlock = pCache->bin [class]) != NULL)
+	{
+	pCache->bin [class] = BIN_NEXT (pBlock);
+	pCache->binCount [class]--;
+	pCache->stats.numBlocksCached--;
+	pCache->stats.numBytesCached -=
+	    2 * BLOCK_TO_HDR (pBlock)->nWords - sizeof (BLOCK_HDR);
+	pCache->stats.numHits++;
+
+	TASK_UNLOCK ();					/* UNLOCK PREEMPTION */
+	return ((void *) pBlock);
+	}
+
+    pCache->stats.numMisses++;
+
+    TASK_UNLOCK ();					/* UNLOCK PREEMPTION */
+
+    /* refill: carve a batch of class-sized blocks under one semTake */
+
+    nWords = (MEM_ROUND_UP (1 << (class + MEM_CACHE_MIN_SHIFT)) +
+	      sizeof (BLOCK_HDR)) >> 1;
+
+    if (nWords < partId->minBlockWords)
+	nWords = partId->minBlockWords;
+
+    pList   = NULL;
+    nCached = 0;
+
+    semTake (&partId->sem, WAIT_FOREVER);
+
+    for (ix = 0; ix < MEM_CACHE_BATCH; ix++)
+	{
+	if ((pHdr = memPartBlockAlloc (partId, nWords, memDefaultAlignment))
+	    == NULL)
+	    break;
+
+	pBlock		  = (char *) HDR_TO_BLOCK (pHdr);
+	BIN_NEXT (pBlock) = pList;
+	pList		  = pBlock;
+	nCached		 += 2 * pHdr->nWords - sizeof (BLOCK_HDR);
+	}
+
+    semGive (&partId->sem);
+
+    if ((pBlock = pList) == NULL)
+	return (NULL);
+
+    /* keep the first block for the caller, bin the rest */
+
+    pList    = BIN_NEXT (pBlock);
+    nCached -= 2 * BLOCK_TO_HDR (pBlock)->nWords - sizeof (BLOCK_HDR);
+
+    if (pList != NULL)
+	{
+	char *pLast;
+
+	for (pLast = pList; BIN_NEXT (pLast) != NULL; pLast = BIN_NEXT (pLast))
+	    ;
+
+	TASK_LOCK ();					/* LOCK PREEMPTION */
+
+	BIN_NEXT (pLast)	    = pCache->bin [class];
+	pCache->bin [class]	    = pList;
+	pCache->binCount [class]   += ix - 1;
+	pCache->stats.numBlocksCached += ix - 1;
+	pCache->stats.numBytesCached  += nCached;
+
+	TASK_UNLOCK ();					/* UNLOCK PREEMPTION */
+	}
+
+    return ((void *) pBlock);
+    }
+
+/*******************************************************************************
+*
+* memPartCacheFree - return a block to the size-class cache
+*
+* This routine is called by memPartFree() through memPartCacheFreeRtn.
+* A block whose user area is at least the smallest class size and less than
+* twice the largest is put on the bin of the largest class it can hold.
+* When MEM_BLOCK_CHECK is set, the block's own header and the back link of
+* the block after it are checked first; both are owned by the caller while
+* the block is allocated, so this needs no partition semaphore.  If the
+* bin grows beyond MEM_CACHE_BIN_MAX blocks, a batch of them is given back
+* to the partition.
+*
+* RETURNS: TRUE if the block was taken by the cache, or FALSE if
+* memPartFree() should free (or reject) it as usual.
+*
+* NOMANUAL
+*/
+
+LOCAL BOOL memPartCacheFree
+    (
+    PART_ID partId,		/* partition to return block to */
+    char *  pBlock		/* block to free */
+    )
+    {
+    MEM_PART_CACHE *pCache;
+    BLOCK_HDR *	    pHdr = BLOCK_TO_HDR (pBlock);
+    unsigned	    nBytes;
+    int		    class;
+    BOOL	    drain;
+
+    if ((pCache = memPartCacheFind (partId)) == NULL)
+	return (FALSE);
+
+    if ((partId->options & MEM_BLOCK_CHECK) &&
+	!(MEM_ALIGNED (pHdr) &&
+	  MEM_ALIGNED (2 * pHdr->nWords) &&
+	  (pHdr->nWords <= partId->totalWords) &&
+	  !pHdr->free &&
+	  (pHdr == PREV_HDR (NEXT_HDR (pHdr)))))
+	return (FALSE);
+
+    nBytes = 2 * pHdr->nWords - sizeof (BLOCK_HDR);
+
+    if ((nBytes < (1 << MEM_CACHE_MIN_SHIFT)) ||
+	(nBytes >= 2 * MEM_CACHE_MAX_BYTES))
+	return (FALSE);
+
+    for (class = MEM_CACHE_CLASSES - 1;
+	 (1u << (class + MEM_CACHE_MIN_SHIFT)) > nBytes; class--)
+	;
+
+    TASK_LOCK ();					/* LOCK PREEMPTION */
+
+    BIN_NEXT (pBlock)   = pCache->bin [class];
+    pCache->bin [class] = pBlock;
+    pCache->stats.numBlocksCached++;
+    pCache->stats.numBytesCached += nBytes;
+
+    drain = (++pCache->binCount [class] > MEM_CACHE_BIN_MAX);
+
+    TASK_UNLOCK ();					/* UNLOCK PREEMPTION */
+
+    if (drain)
+	memPartCacheDrain (pCache, class, MEM_CACHE_BATCH);
+
+    return (TRUE);
+    }
+
+/*******************************************************************************
+*
+* memPartCacheDrain - give blocks from one bin back to the partition
+*
+* This routine unlinks up to <nBlocks> blocks from bin <class> and frees
+* them to the partition under a single semTake().
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void memPartCacheDrain
+    (
+    MEM_PART_CACHE *pCache,	/* cache to drain */
+    int		    class,	/* bin to drain */
+    int		    nBlocks	/* maximum number of blocks to free */
+    )
+    {
+    PART_ID partId = pCache->partId;
+    char *  pList;
+    char *  pBlock;
+    int	    ix;
+
+    TASK_LOCK ();					/* LOCK PREEMPTION */
+
+    pList = pCache->bin [class];
+
+    for (ix = 0, pBlock = NULL;
+	 (ix < nBlocks) && (pCache->bin [class] != NULL); ix++)
+	{
+	pBlock = pCache->bin [class];
+	pCache->bin [class] = BIN_NEXT (pBlock);
+	pCache->stats.numBytesCached -=
+	    2 * BLOCK_TO_HDR (pBlock)->nWords - sizeof (BLOCK_HDR);
+	}
+
+    if (pBlock != NULL)
+	BIN_NEXT (pBlock) = NULL;			/* terminate batch */
+
+    pCache->binCount [class]	  -= ix;
+    pCache->stats.numBlocksCached -= ix;
+    if (ix > 0)
+	pCache->stats.numFlushes++;
+
+    TASK_UNLOCK ();					/* UNLOCK PREEMPTION */
+
+    if (ix == 0)
+	return;
+
+    semTake (&partId->sem, WAIT_FOREVER);
+
+    while (pList != NULL)
+	{
+	pBlock = pList;
+	pList  = BIN_NEXT (pBlock);
+	memPartBlockFree (partId, BLOCK_TO_HDR (pBlock));
+	}
+
+    semGive (&partId->sem);
+    }
+
+/*******************************************************************************
+*
+* memPartCacheStatsShow - show the cache line of memPartShow()
+*
+* This routine is called by memPartShow() through memPartCacheShowRtn, to
+* report the part of the current allocation held by the cache.
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+LOCAL void memPartCacheStatsShow
+    (
+    PART_ID partId
+    )
+    {
+    MEM_CACHE_STATS stats;
+
+    if (memPartCacheInfoGet (partId, &stats) != OK)
+	return;
+
+    if (stats.numBlocksCached != 0)
+	printf (" cached %10lu %9lu %10lu          -\n", stats.numBytesCached,
+		stats.numBlocksCached,
+		stats.numBytesCached / stats.numBlocksCached);
+    else
+	printf ("   no cached blocks\n");
+    }
@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+05y,17oct26,agt  memPartOptionsSet() handles MEM_PART_SIZE_CLASS
 05x,21feb99,jdi  doc: listed errnos.
 05w,01may98,cjtc moved instrumentation point in memPartRealloc to fix problem
                  with reported size of bytesPlusHeaderAlign
@@ -183,6 +184,15 @@ Check each block freed.
 Setting either of the MEM_BLOCK_ERROR options automatically 
 sets MEM_BLOCK_CHECK.
 
+The following option, defined in memCacheLib.h, puts a cache of free
+blocks sorted by size class in front of the partition, so that small
+requests are served without searching the free list; see memCacheLib.
+Clearing the option gives the cached blocks back to the partition.
+
+.iP "MEM_PART_SIZE_CLASS" 8
+Serve blocks of up to 2048 bytes from per-size-class bins.
+.LP
+
 The default options when a partition is created are:
 
     MEM_ALLOC_ERROR_LOG_FLAG
@@ -199,9 +209,9 @@ option to construct the <options> parameter.  For example:
                                  MEM_BLOCK_ERROR_LOG_FLAG);
 .CE
 
-INCLUDE FILES: memLib.h
+INCLUDE FILES: memLib.h, memCacheLib.h
 
-SEE ALSO: memPartLib, smMemLib
+SEE ALSO: memPartLib, memCacheLib, smMemLib
 
 INTERNAL
 This package is initialized by kernelInit() which calls memInit() with a
@@ -250,6 +260,7 @@ semCreate().
 #include "string.h"
 #include "errno.h"
 #include "smObjLib.h"
+#include "memCacheLib.h"
 #include "private/memPartLibP.h"
 #include "private/vmLibP.h"
 #include "private/smMemLibP.h"
@@ -367,13 +378,17 @@ STATUS memInit
 * the task was spawned with the VX_UNBREAKABLE option, in which case it
 * cannot be suspended).
 * .LP
+*
+* In addition, MEM_PART_SIZE_CLASS fronts a local partition with a
+* size-class cache, which is created the first time the option is set.
+* Clearing the option flushes the cache back to the partition.
 * 
 * These options are discussed in detail in the library manual entry for
 * memLib.
 * 
 * RETURNS: OK or ERROR.
 *
-* ERRNO: S_smObjLib_NOT_INITIALIZED
+* ERRNO: S_smObjLib_NOT_INITIALIZED, S_memLib_NOT_ENOUGH_MEMORY
 *
 * SEE ALSO: smMemLib
 */
@@ -384,6 +399,8 @@ STATUS memPartOptionsSet
     unsigned  	options    /* memory management options */
     )
     {
+    unsigned	oldOptions;
+
     if ((!memLibInstalled) && (memLibInit () != OK))	/* initialize package */
 	return (ERROR);
 
@@ -403,6 +420,11 @@ STATUS memPartOptionsSet
     if (OBJ_VERIFY (partId, memPartClassId) != OK)
 	return (ERROR);
 
+    /* the cache descriptor is allocated, so do it without the semaphore */
+
+    if ((options & MEM_PART_SIZE_CLASS) && (memPartCacheCreate (partId) != OK))
+	return (ERROR);
+
     semTake (&partId->sem, WAIT_FOREVER);
 
     /*
@@ -434,10 +456,16 @@ STATUS memPartOptionsSet
     if (options & (MEM_BLOCK_ERROR_LOG_FLAG | MEM_BLOCK_ERROR_SUSPEND_FLAG))
         options |= MEM_BLOCK_CHECK;
     
+    oldOptions	    = partId->options;
     partId->options = options;
 
     semGive (&partId->sem);
 
+    /* blocks already cached go back once the cache is no longer used */
+
+    if ((oldOptions & MEM_PART_SIZE_CLASS) && !(options & MEM_PART_SIZE_CLASS))
+	(void) memPartCacheFlush (partId);
+
     return (OK);
     }
 
@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+01u,17oct26,agt  memPartShow() reports blocks held by the size-class cache
 01t,06oct01,tam  fixed sign and formatting
 01s,05oct01,gls  moved printf in memPartInfoGet() to after semGive (SPR #20102)
 01r,26sep01,jws  move vxMP smMemPartShowRtn ptr to funcBind.c (SPR36055)
@@ -59,6 +60,7 @@ windsh,
 #include "string.h"
 #include "errno.h"
 #include "smObjLib.h"
+#include "memCacheLib.h"
 #include "private/memPartLibP.h"
 #include "private/smMemLibP.h"
 
@@ -238,6 +240,10 @@ STATUS memPartShow
     else
 	printf ("   no allocated blocks\n");
 
+    if ((partId->options & MEM_PART_SIZE_CLASS) &&
+	(memPartCacheShowRtn != NULL))
+	(* memPartCacheShowRtn) (partId);
+
     printf ("cumulative\n");
 
     if (partId->cumBlocksAllocated != 0)
@@ -0,0 +1,716 @@
+/* selSetLib.c - persistent select() interest set library */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+#include "copyright_wrs.h"
+
+/*
+modification history
+--------------------
+01c,17oct26,agt  selWakeup() finds the set through the owner's select
+                 context; dropped selSetList.
+01b,17oct26,agt  queue ready descriptors from selWakeup() and re-arm with
+                 FIONREAD instead of FIOUNSELECT/FIOSELECT.
+01a,17oct26,agt  written
+*/
+
+/*
+DESCRIPTION
+This library provides an alternative to select() for tasks which wait on
+a large, slowly changing set of file descriptors.  A call to select()
+registers a wake-up node with every selected device through the FIOSELECT
+ioctl, pends, and then removes every node again through FIOUNSELECT, so
+its cost is proportional to the number of descriptors examined rather
+than the number that are ready.
+
+A select set keeps its wake-up nodes installed in the devices' select()
+wake-up lists between waits.  Descriptors are registered once with
+selSetAdd() and withdrawn with selSetRemove().  When a device calls
+selWakeup() for a node of the set, the descriptor is appended to the
+set's ready queue, unless it is already waiting there.  selSetWait() then
+only pends on the owning task's select wake-up semaphore and takes the
+descriptors off the ready queue, so the cost of a wait depends on the
+number of ready descriptors, not on the number registered.
+
+Drivers only call selWakeup() when a device changes state, so a
+descriptor whose data was not completely read is not reported again by
+itself.  Once a ready descriptor has been serviced the caller re-arms it
+with selSetRearm().  For read descriptors this asks the driver for the
+number of bytes left with FIONREAD, and queues the descriptor again if
+there are any; the wake-up node stays where it is.  The full
+FIOUNSELECT/FIOSELECT re-query is kept for write descriptors, for
+drivers without FIONREAD, and for descriptors that were woken up more
+than once before they were reported, such as a listening socket with
+several connections pending.
+
+A select set is bound to the task that created it: the wake-up nodes
+carry that task's ID, and selWakeup() finds the set through the task's
+select context, without a search.  Only
+the owning task may call selSetWait(), and it must not call select()
+itself while the set exists.  Any task may add, remove or re-arm
+descriptors.  The set must be deleted with selSetDelete() before the
+owning task exits.
+
+INCLUDE FILES: selSetLib.h
+
+SEE ALSO: selectLib
+*/
+
+#include "vxWorks.h"
+#include "ioLib.h"
+#include "errnoLib.h"
+#include "semLib.h"
+#include "string.h"
+#include "stdlib.h"
+#include "sysLib.h"
+#include "intLib.h"
+#include "taskLib.h"
+#include "objLib.h"
+#include "selectLib.h"
+#include "selSetLib.h"
+#include "private/selectLibP.h"
+#include "private/iosLibP.h"		/* maxFiles */
+
+/* defines */
+
+#define SEL_SET_IX(type)	(((type) == SELREAD) ? 0 : 1)
+
+/* typedefs */
+
+typedef struct selSet
+    {
+    int		taskId;		/* owning task */
+    SEM_ID	mutex;		/* protects the interest sets */
+    int		width;		/* number of descriptors covered */
+    fd_set *	pInterest [2];	/* registered descriptors, read/write */
+    fd_set *	pReady [2];	/* woken up and not yet reported */
+    fd_set *	pQueued [2];	/* descriptors on the ready queue */
+    fd_set *	pMerged [2];	/* woken up again before being reported */
+    int *	pQueue;		/* ready queue, (fd << 1) | write */
+    int		queueSize;	/* 2 * width, one entry per descriptor */
+    int		queueHead;	/* next entry to report */
+    int		queueCount;	/* entries on the ready queue */
+    } SEL_SET;
+
+/* externs */
+
+extern FUNCPTR _func_selSetPost;
+
+/* globals */
+
+int mutexOptionsSelSetLib = SEM_Q_PRIORITY | SEM_DELETE_SAFE |
+			    SEM_INVERSION_SAFE;
+
+/* forward static functions */
+
+LOCAL BOOL	selSetIsValid	(SEL_SET_ID selSetId, int fd,
+				 SELECT_TYPE type);
+LOCAL STATUS	selSetIoctl	(SEL_SET_ID selSetId, int fd,
+				 SELECT_TYPE type, int ioctlFunc);
+LOCAL STATUS	selSetPost	(SEL_SET_ID selSetId,
+				 SEL_WAKEUP_NODE *pWakeupNode);
+LOCAL void	selSetQueue	(SEL_SET_ID selSetId, int fd, int ix,
+				 BOOL merge);
+
+/*******************************************************************************
+*
+* selSetCreate - create a select set for the calling task
+*
+* This routine creates an empty select set owned by the calling task and
+* directs the task's select() wake-ups to the set's ready queue.  The task
+* must have a select context, i.e. the select facility must have been
+* initialized before the task was spawned, and may own one set at a time.
+*
+* RETURNS: The ID of the new select set, or NULL if memory is insufficient,
+* the task has no select context, or it already owns a select set.
+*
+* ERRNOS
+* .iP 'S_selectLib_NO_SELECT_CONTEXT'
+* The task's select context was not initialized at task creation time.
+* .iP 'S_objLib_OBJ_UNAVAILABLE'
+* The task already owns a select set.
+* .LP
+*/
+
+SEL_SET_ID selSetCreate (void)
+    {
+    SEL_CONTEXT *pSelectContext = taskIdCurrent->pSelectContext;
+    SEL_SET *	 pSet;
+    char *	 pMem;
+    int		 fdSetBytes;
+    int		 ix;
+    int		 level;
+
+    if (pSelectContext == NULL)
+	{
+	errno = S_selectLib_NO_SELECT_CONTEXT;
+	return (NULL);
+	}
+
+    if (pSelectContext->pSelSet != NULL)
+	{
+	errno = S_objLib_OBJ_UNAVAILABLE;
+	return (NULL);
+	}
+
+    /* size the fd_sets for maxFiles, exactly as select() does */
+
+    fdSetBytes = sizeof (fd_mask) * howmany (maxFiles, NFDBITS);
+
+    pSet = (SEL_SET *) calloc (1, sizeof (SEL_SET) + 8 * fdSetBytes +
+				  2 * maxFiles * sizeof (int));
+
+    if (pSet == NULL)
+	return (NULL);
+
+    if ((pSet->mutex = semMCreate (mutexOptionsSelSetLib)) == NULL)
+	{
+	free ((char *) pSet);
+	return (NULL);
+	}
+
+    pSet->taskId    = taskIdSelf ();
+    pSet->width     = maxFiles;
+    pSet->queueSize = 2 * maxFiles;
+
+    pMem = (char *) pSet + sizeof (SEL_SET);
+
+    for (ix = 0; ix < 2; ix++)
+	{
+	pSet->pInterest [ix] = (fd_set *) pMem;
+	pSet->pReady [ix]    = (fd_set *) (pMem + 2 * fdSetBytes);
+	pSet->pQueued [ix]   = (fd_set *) (pMem + 4 * fdSetBytes);
+	pSet->pMerged [ix]   = (fd_set *) (pMem + 6 * fdSetBytes);
+	pMem += fdSetBytes;
+	}
+
+    pSet->pQueue = (int *) ((char *) pSet + sizeof (SEL_SET) +
+			    8 * fdSetBytes);
+
+    /*
+     * From now on selWakeup() hands the wake-ups of the task to
+     * selSetPost(), with the set it finds in the select context.
+     */
+
+    _func_selSetPost = (FUNCPTR) selSetPost;
+
+    semTake (&pSelectContext->wakeupSem, NO_WAIT);
+
+    level = intLock ();
+    pSelectContext->pSelSet = pSet;
+    intUnlock (level);
+
+    return (pSet);
+    }
+
+/*******************************************************************************
+*
+* selSetDelete - delete a select set
+*
+* This routine withdraws every descriptor still registered in the select
+* set from its device's wake-up list and frees the set.  It must be called
+* before the owning task exits.
+*
+* RETURNS: OK, or ERROR if the set is invalid.
+*/
+
+STATUS selSetDelete
+    (
+    SEL_SET_ID selSetId		/* select set to delete */
+    )
+    {
+    SEL_CONTEXT *pSelectContext;
+    int		 fd;
+    int		 ix;
+    int		 level;
+
+    if (selSetId == NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return (ERROR);
+	}
+
+    semTake (selSetId->mutex, WAIT_FOREVER);
+
+    for (ix = 0; ix < 2; ix++)
+	{
+	for (fd = 0; fd < selSetId->width; fd++)
+	    {
+	    if (selSetId->pInterest [ix]->fds_bits [((unsigned) fd) / NFDBITS]
+		== 0)
+		{
+		fd += NFDBITS - 1;
+		continue;
+		}
+
+	    if (FD_ISSET (fd, selSetId->pInterest [ix]))
+		selSetIoctl (selSetId, fd, (ix == 0) ? SELREAD : SELWRITE,
+			     FIOUNSELECT);
+	    }
+	}
+
+    /* no wake-up node refers to the set now, detach it from the owner */
+
+    pSelectContext = ((WIND_TCB *) selSetId->taskId)->pSelectContext;
+
+    level = intLock ();
+    if (pSelectContext->pSelSet == selSetId)
+	pSelectContext->pSelSet = NULL;
+    intUnlock (level);
+
+    semDelete (selSetId->mutex);
+    free ((char *) selSetId);
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* selSetAdd - register a descriptor with a select set
+*
+* This routine installs a wake-up node for <fd> in the device's wake-up
+* list through the FIOSELECT ioctl.  The node remains installed until
+* selSetRemove() or selSetDelete() is called.  If the device is already
+* ready the descriptor is reported by the next selSetWait().  Registering
+* a descriptor which is already in the set has no effect.
+*
+* RETURNS: OK, or ERROR if the descriptor is out of range or its driver
+* does not support select().
+*
+* ERRNOS
+* .iP 'S_selectLib_NO_SELECT_SUPPORT_IN_DRIVER'
+* The driver associated with <fd> does not support select().
+* .iP 'S_selectLib_WIDTH_OUT_OF_RANGE'
+* <fd> is greater than the maximum possible fd.
+* .LP
+*/
+
+STATUS selSetAdd
+    (
+    SEL_SET_ID	selSetId,	/* select set */
+    int		fd,		/* descriptor to register */
+    SELECT_TYPE	type		/* SELREAD or SELWRITE */
+    )
+    {
+    fd_set *pInterest;
+    STATUS  status = OK;
+
+    if (!selSetIsValid (selSetId, fd, type))
+	return (ERROR);
+
+    pInterest = selSetId->pInterest [SEL_SET_IX (type)];
+
+    semTake (selSetId->mutex, WAIT_FOREVER);
+
+    if (!FD_ISSET (fd, pInterest))
+	{
+	FD_SET (fd, pInterest);
+
+	if ((status = selSetIoctl (selSetId, fd, type, FIOSELECT)) != OK)
+	    {
+	    FD_CLR (fd, pInterest);
+
+	    if (errnoGet () == S_ioLib_UNKNOWN_REQUEST)
+		errnoSet (S_selectLib_NO_SELECT_SUPPORT_IN_DRIVER);
+	    }
+	}
+
+    semGive (selSetId->mutex);
+
+    return (status);
+    }
+
+/*******************************************************************************
+*
+* selSetRemove - withdraw a descriptor from a select set
+*
+* This routine removes the wake-up node for <fd> from the device's wake-up
+* list and discards any readiness not yet reported for it.  Removing a
+* descriptor which is not in the set has no effect.
+*
+* RETURNS: OK, or ERROR if the descriptor is out of range or the
+* FIOUNSELECT ioctl failed.
+*/
+
+STATUS selSetRemove
+    (
+    SEL_SET_ID	selSetId,	/* select set */
+    int		fd,		/* descriptor to withdraw */
+    SELECT_TYPE	type		/* SELREAD or SELWRITE */
+    )
+    {
+    int	    ix;
+    int	    level;
+    STATUS  status = OK;
+
+    if (!selSetIsValid (selSetId, fd, type))
+	return (ERROR);
+
+    ix = SEL_SET_IX (type);
+
+    semTake (selSetId->mutex, WAIT_FOREVER);
+
+    if (FD_ISSET (fd, selSetId->pInterest [ix]))
+	{
+	FD_CLR (fd, selSetId->pInterest [ix]);
+	status = selSetIoctl (selSetId, fd, type, FIOUNSELECT);
+
+	/* a queued entry stays queued, but is no longer reported */
+
+	level = intLock ();
+	FD_CLR (fd, selSetId->pReady [ix]);
+	FD_CLR (fd, selSetId->pMerged [ix]);
+	intUnlock (level);
+	}
+
+    semGive (selSetId->mutex);
+
+    return (status);
+    }
+
+/*******************************************************************************
+*
+* selSetRearm - re-query the readiness of a serviced descriptor
+*
+* This routine should be called once a descriptor returned by selSetWait()
+* has been serviced.  Any readiness posted for it in the meantime is
+* discarded, and the descriptor is queued again if it is still ready.
+*
+* For a read descriptor the driver is asked for the number of unread bytes
+* with FIONREAD; the wake-up node is left in place.  The node is removed
+* and re-installed with FIOUNSELECT and FIOSELECT, letting the driver's
+* FIOSELECT handler post the descriptor again if it is ready, for write
+* descriptors, if the driver does not support FIONREAD, or if the
+* descriptor was woken up more than once before it was reported.  In the
+* last case FIONREAD may not tell the whole story: a listening socket has
+* no data to read however many connections are pending.
+*
+* RETURNS: OK, or ERROR if the descriptor is not in the set.
+*/
+
+STATUS selSetRearm
+    (
+    SEL_SET_ID	selSetId,	/* select set */
+    int		fd,		/* serviced descriptor */
+    SELECT_TYPE	type		/* SELREAD or SELWRITE */
+    )
+    {
+    int	    ix;
+    int	    level;
+    int	    nBytes;
+    BOOL    merged;
+    STATUS  status = ERROR;
+
+    if (!selSetIsValid (selSetId, fd, type))
+	return (ERROR);
+
+    ix = SEL_SET_IX (type);
+
+    semTake (selSetId->mutex, WAIT_FOREVER);
+
+    if (!FD_ISSET (fd, selSetId->pInterest [ix]))
+	{
+	errno = S_objLib_OBJ_UNAVAILABLE;
+	semGive (selSetId->mutex);
+	return (ERROR);
+	}
+
+    /*
+     * Readiness is discarded before the device is asked, so a wake-up
+     * racing with us is either discarded and then seen by the query, or
+     * posted after it.
+     */
+
+    level = intLock ();
+    merged = FD_ISSET (fd, selSetId->pMerged [ix]);
+    FD_CLR (fd, selSetId->pMerged [ix]);
+
+    if (!merged && (type == SELREAD))
+	FD_CLR (fd, selSetId->pReady [ix]);
+    intUnlock (level);
+
+    if (!merged && (type == SELREAD) &&
+	(ioctl (fd, FIONREAD, (int) &nBytes) == OK))
+	{
+	if (nBytes > 0)
+	    {
+	    level = intLock ();
+	    selSetQueue (selSetId, fd, ix, FALSE);
+	    intUnlock (level);
+	    }
+
+	status = OK;
+	}
+    else
+	{
+	/*
+	 * The ready bit is cleared only after the node has left the
+	 * wake-up list, so a selWakeup() racing with us cannot post it
+	 * again behind our back; FIOSELECT then re-posts it if necessary.
+	 */
+
+	selSetIoctl (selSetId, fd, type, FIOUNSELECT);
+
+	level = intLock ();
+	FD_CLR (fd, selSetId->pReady [ix]);
+	intUnlock (level);
+
+	if ((status = selSetIoctl (selSetId, fd, type, FIOSELECT)) != OK)
+	    FD_CLR (fd, selSetId->pInterest [ix]);
+	}
+
+    semGive (selSetId->mutex);
+
+    return (status);
+    }
+
+/*******************************************************************************
+*
+* selSetWait - pend until descriptors in a select set become ready
+*
+* This routine takes up to <maxEvents> descriptors of the select set that
+* have been woken up since they were last reported off the set's ready
+* queue, pending if there are none.  Each one is stored in <pEvents> with
+* the type of readiness, SELREAD or SELWRITE; a descriptor ready for both
+* is reported twice.  Descriptors are reported in the order in which they
+* became ready.  <pTimeOut> has the same meaning as for select().
+*
+* Only the task which created the set may call this routine.
+*
+* RETURNS: The number of events stored, 0 if timed out, or ERROR.
+*
+* ERRNOS
+* .iP 'S_objLib_OBJ_ID_ERROR'
+* The set is invalid or not owned by the calling task.
+* .iP 'S_selectLib_WIDTH_OUT_OF_RANGE'
+* <maxEvents> is not greater than 0.
+* .LP
+*/
+
+int selSetWait
+    (
+    SEL_SET_ID	    selSetId,	/* select set */
+    SEL_SET_EVENT * pEvents,	/* ready descriptors (out) */
+    int		    maxEvents,	/* number of elements in pEvents */
+    struct timeval *pTimeOut	/* max time to wait, NULL = forever */
+    )
+    {
+    SEL_CONTEXT *pSelectContext;
+    int		 quitTime;
+    int		 clockRate;
+    int		 numFound = 0;
+    int		 entry;
+    int		 fd;
+    int		 ix;
+    int		 level;
+
+    if (selSetId == NULL || selSetId->taskId != taskIdSelf ())
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return (ERROR);
+	}
+
+    if (maxEvents <= 0)
+	{
+	errno = S_selectLib_WIDTH_OUT_OF_RANGE;
+	return (ERROR);
+	}
+
+    pSelectContext = taskIdCurrent->pSelectContext;
+
+    if (pTimeOut == NULL)
+	quitTime = WAIT_FOREVER;
+    else
+	{
+	clockRate = sysClkRateGet ();
+
+	quitTime = (pTimeOut->tv_sec * clockRate) +
+            ((((pTimeOut->tv_usec * clockRate) / 100)/100)/100);
+
+	if (quitTime == 0)
+	    quitTime = NO_WAIT;
+	}
+
+    FOREVER
+	{
+	/*
+	 * Interrupts are locked for one entry at a time.  An entry whose
+	 * readiness was discarded by selSetRearm() or selSetRemove() is
+	 * dropped.
+	 */
+
+	while (numFound < maxEvents)
+	    {
+	    level = intLock ();
+
+	    if (selSetId->queueCount == 0)
+		{
+		intUnlock (level);
+		break;
+		}
+
+	    entry = selSetId->pQueue [selSetId->queueHead];
+
+	    if (++selSetId->queueHead == selSetId->queueSize)
+		selSetId->queueHead = 0;
+
+	    selSetId->queueCount--;
+
+	    fd = entry >> 1;
+	    ix = entry & 1;
+
+	    FD_CLR (fd, selSetId->pQueued [ix]);
+
+	    if (FD_ISSET (fd, selSetId->pReady [ix]))
+		{
+		FD_CLR (fd, selSetId->pReady [ix]);
+		intUnlock (level);
+
+		pEvents [numFound].fd   = fd;
+		pEvents [numFound].type = (ix == 0) ? SELREAD : SELWRITE;
+		numFound++;
+		}
+	    else
+		intUnlock (level);
+	    }
+
+	/*
+	 * Wake-ups posted while the owner was dispatching have already
+	 * given the wake-up semaphore, so it may be taken without anything
+	 * being queued; only a wait forever goes round again.
+	 */
+
+	if ((numFound > 0) || (quitTime == NO_WAIT) ||
+	    (semTake (&pSelectContext->wakeupSem, quitTime) != OK))
+	    break;
+
+	if (quitTime != WAIT_FOREVER)
+	    quitTime = NO_WAIT;
+	}
+
+    return (numFound);
+    }
+
+/*******************************************************************************
+*
+* selSetPost - queue a descriptor woken up by selWakeup()
+*
+* This routine is called by selWakeup(), through _func_selSetPost, with
+* interrupts locked, with the select set that selWakeup() found in the
+* select context of the task of the wake-up node.
+*
+* RETURNS: OK.
+*/
+
+LOCAL STATUS selSetPost
+    (
+    SEL_SET_ID	     selSetId,
+    SEL_WAKEUP_NODE *pWakeupNode
+    )
+    {
+    if (pWakeupNode->fd >= 0 && pWakeupNode->fd < selSetId->width)
+	selSetQueue (selSetId, pWakeupNode->fd,
+		     SEL_SET_IX (pWakeupNode->type), TRUE);
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* selSetQueue - mark a descriptor ready and append it to the ready queue
+*
+* A descriptor is on the ready queue at most once, so the queue, which has
+* room for every descriptor in both directions, cannot overflow.  If the
+* descriptor is already marked ready and <merge> is TRUE, the wake-up is
+* remembered in the merged mask for selSetRearm().  The caller must lock
+* interrupts.
+*
+* RETURNS: N/A
+*/
+
+LOCAL void selSetQueue
+    (
+    SEL_SET_ID	selSetId,
+    int		fd,
+    int		ix,
+    BOOL	merge
+    )
+    {
+    int tail;
+
+    if (FD_ISSET (fd, selSetId->pReady [ix]))
+	{
+	if (merge)
+	    FD_SET (fd, selSetId->pMerged [ix]);
+	return;
+	}
+
+    FD_SET (fd, selSetId->pReady [ix]);
+
+    if (FD_ISSET (fd, selSetId->pQueued [ix]))
+	return;
+
+    FD_SET (fd, selSetId->pQueued [ix]);
+
+    tail = selSetId->queueHead + selSetId->queueCount;
+
+    if (tail >= selSetId->queueSize)
+	tail -= selSetId->queueSize;
+
+    selSetId->pQueue [tail] = (fd << 1) | ix;
+    selSetId->queueCount++;
+    }
+
+/*******************************************************************************
+*
+* selSetIoctl - issue FIOSELECT or FIOUNSELECT on behalf of the set owner
+*
+* RETURNS: The result of the ioctl.
+*/
+
+LOCAL STATUS selSetIoctl
+    (
+    SEL_SET_ID	selSetId,
+    int		fd,
+    SELECT_TYPE	type,
+    int		ioctlFunc
+    )
+    {
+    SEL_WAKEUP_NODE wakeupNode;
+
+    bzero ((char *) &wakeupNode, sizeof (wakeupNode));
+
+    wakeupNode.taskId = selSetId->taskId;
+    wakeupNode.type   = type;
+    wakeupNode.fd     = fd;
+
+    return (ioctl (fd, ioctlFunc, (int) &wakeupNode));
+    }
+
+/*******************************************************************************
+*
+* selSetIsValid - check the arguments common to the per-descriptor calls
+*
+* RETURNS: TRUE if the arguments are valid, otherwise FALSE with errno set.
+*/
+
+LOCAL BOOL selSetIsValid
+    (
+    SEL_SET_ID	selSetId,
+    int		fd,
+    SELECT_TYPE	type
+    )
+    {
+    if (selSetId == NULL || (type != SELREAD && type != SELWRITE))
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return (FALSE);
+	}
+
+    if (fd < 0 || fd >= selSetId->width)
+	{
+	errno = S_selectLib_WIDTH_OUT_OF_RANGE;
+	return (FALSE);
+	}
+
+    return (TRUE);
+    }
@@ -6,6 +6,10 @@
 /*
 modification history
 --------------------
+02e,17oct26,agt  selWakeup() finds a task's select set through its select
+		 context instead of a search.
+02d,17oct26,agt  selWakeup() hands wake-ups to selSetLib via _func_selSetPost.
+02c,17oct26,agt  made selWakeup() fd_set update atomic for selSetLib.
 02b,20may02,gls  Added semTake to select to prevent race condition (SPR #77032)
 02a,30nov01,sbs  Added documentation about FD_SETSIZE (SPR 9377)
 01z,12oct01,brk  added SELECT functionality to ptyLib (SPR 65498) 
@@ -66,7 +70,7 @@ with the INCLUDE_SELECT component.
 
 INCLUDE FILES: selectLib.h
 
-SEE ALSO:
+SEE ALSO: selSetLib,
 .pG "I/O System"
 */
 
@@ -91,6 +95,10 @@ SEE ALSO:
 #include "private/selectLibP.h"
 #include "private/iosLibP.h"		/* maxFiles */
 
+/* externs */
+
+extern FUNCPTR _func_selSetPost;	/* selSetLib wake-up hook */
+
 /* global variables */
 
 int mutexOptionsSelectLib = SEM_Q_FIFO | SEM_DELETE_SAFE;
@@ -604,20 +612,37 @@ void selWakeup
     )
     {
     SEL_CONTEXT *pSelectContext;
+    int		 level;
 
     pSelectContext = ((WIND_TCB *)pWakeupNode->taskId)->pSelectContext;
 
-    switch (pWakeupNode->type)
+    /*
+     * If the task owns a select set (selSetLib), the wake-up goes on the
+     * set's ready queue, which its owner empties while wake-ups are still
+     * being posted, so each update must be atomic with respect to the
+     * owner.
+     */
+
+    level = intLock ();
+
+    if (pSelectContext->pSelSet != NULL)
+	(* _func_selSetPost) (pSelectContext->pSelSet, pWakeupNode);
+    else
 	{
-	case SELREAD:
-	    FD_SET(pWakeupNode->fd, pSelectContext->pReadFds);
-	    break;
+	switch (pWakeupNode->type)
+	    {
+	    case SELREAD:
+		FD_SET(pWakeupNode->fd, pSelectContext->pReadFds);
+		break;
 
-	case SELWRITE:
-	    FD_SET(pWakeupNode->fd, pSelectContext->pWriteFds);
-	    break;
+	    case SELWRITE:
+		FD_SET(pWakeupNode->fd, pSelectContext->pWriteFds);
+		break;
+	    }
 	}
 
+    intUnlock (level);
+
     semGive (&pSelectContext->wakeupSem);
     }
 
@@ -881,6 +906,7 @@ LOCAL STATUS selTaskCreateHook
 					     fdSetBytes);
 
      pSelectContext->pendedOnSelect = FALSE;   /* task is not pending */
+     pSelectContext->pSelSet        = NULL;    /* task owns no select set */
 
 
      /* initialize the task's wakeup binary semaphore */
@@ -0,0 +1,279 @@
+/* taskTlsLib.c - task local storage slot library */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+#include "copyright_wrs.h"
+
+/*
+modification history
+--------------------
+01b,17oct26,agt  TLS errors have status codes of their own.
+01a,17oct26,agt  written.
+*/
+
+/*
+DESCRIPTION
+This library provides task local storage: a table of TASK_TLS_MAX pointer
+slots private to each task.  A facility that needs a private value per task
+obtains a slot index, or key, once with taskTlsKeyCreate(), usually when it
+is initialized.  Each task then reads and writes its own value for that key
+with taskTlsGet() and taskTlsSet(), or with the TASK_TLS_GET() macro, which
+is a single indexed load.
+
+Task variables (see taskVarLib) give each task a private copy of a variable
+at a fixed address by saving and restoring every task variable of the tasks
+involved at each task switch, so every task variable adds to the task
+switch time.  Task local storage is built on a single task variable,
+<taskTlsTable>, which points to the calling task's slot table.  A task with
+a slot table therefore costs one task variable switch whatever the number
+of slots in use, and a task that uses none costs nothing.
+
+A task's slot table is allocated by the first taskTlsSet() the task makes,
+and freed when the task is deleted.  Until then, taskTlsGet() returns NULL
+for every key.  Keys are never released.
+
+Facilities that already use taskVarAdd() keep working unchanged.  Where a
+facility has several task variables, moving them into slots, or into a
+structure held in one slot, removes them from the task switch path.
+taskVarLib itself is not built on slots: a task variable is a fixed
+address that its users read directly, so its value has to be switched in
+and out of that address whatever the storage behind it.
+
+INCLUDE FILES: taskTlsLib.h
+
+SEE ALSO: taskVarLib, taskHookLib,
+.pG "Basic OS"
+*/
+
+#include "vxWorks.h"
+#include "stdlib.h"
+#include "errnoLib.h"
+#include "taskLib.h"
+#include "taskHookLib.h"
+#include "taskVarLib.h"
+#include "taskTlsLib.h"
+
+/* globals */
+
+void **	taskTlsTable = NULL;		/* calling task's slot table */
+
+/* locals */
+
+LOCAL int	taskTlsNextKey;		/* next key to hand out */
+
+/* forward static functions */
+
+static void taskTlsDeleteHook (WIND_TCB *pTcb);
+
+
+/*******************************************************************************
+*
+* taskTlsLibInit - initialize the task local storage facility
+*
+* This routine installs the task delete hook that frees the slot tables of
+* deleted tasks.  It is called automatically by taskTlsKeyCreate().
+* After the first invocation of this routine, subsequent invocations have
+* no effect.
+*
+* The task variables facility is initialized first, so that the delete hook
+* of this library runs before the one of taskVarLib and still finds the
+* slot table of the task.  A facility whose own delete hook uses task local
+* storage should call taskTlsLibInit() before adding that hook.
+*
+* RETURNS: OK, or ERROR if the task delete hook could not be installed.
+*
+* SEE ALSO: taskVarInit()
+*/
+
+STATUS taskTlsLibInit (void)
+    {
+    static BOOL taskTlsInstalled = FALSE;	/* TRUE = facility installed */
+
+    if (!taskTlsInstalled)
+	{
+	if ((taskVarInit () != OK) ||
+	    (taskDeleteHookAdd ((FUNCPTR)taskTlsDeleteHook) != OK))
+	    {
+	    return (ERROR);
+	    }
+
+	taskTlsInstalled = TRUE;
+	}
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* taskTlsDeleteHook - free the slot table of a deleted task
+*
+* The slot table is found through the task's private value of
+* <taskTlsTable>, which taskVarLib has not yet deleted.  Values stored in
+* the slots are not freed; they belong to the facilities that stored them.
+*/
+
+LOCAL void taskTlsDeleteHook
+    (
+    WIND_TCB *pTcb
+    )
+    {
+    void **	pTable;
+    int		errnoCopy = errnoGet ();
+
+    /* tasks that never stored a value have no slot table to free */
+
+    pTable = (void **) taskVarGet ((int) pTcb, (int *) &taskTlsTable);
+
+    if ((pTable != NULL) && (pTable != (void **) ERROR))
+	free ((char *) pTable);
+
+    errnoSet (errnoCopy);
+    }
+
+/*******************************************************************************
+*
+* taskTlsKeyCreate - allocate a task local storage slot
+*
+* This routine allocates a slot in the slot table of every task and returns
+* its index.  The slot initially holds NULL in every task.  The index stays
+* valid until reboot, so it is normally obtained once, when the facility
+* using it is initialized, and kept in a global variable.
+*
+* RETURNS: The key of the new slot, or ERROR if all TASK_TLS_MAX slots are
+* in use or the facility could not be initialized.
+*
+* ERRNO: S_taskLib_TLS_KEYS_EXHAUSTED
+*
+* SEE ALSO: taskTlsGet(), taskTlsSet()
+*/
+
+int taskTlsKeyCreate (void)
+    {
+    int key;
+
+    if (taskTlsLibInit () != OK)
+	return (ERROR);
+
+    taskLock ();				/* LOCK PREEMPTION */
+
+    if (taskTlsNextKey < TASK_TLS_MAX)
+	key = taskTlsNextKey++;
+    else
+	key = ERROR;
+
+    taskUnlock ();				/* UNLOCK PREEMPTION */
+
+    if (key == ERROR)
+	errnoSet (S_taskLib_TLS_KEYS_EXHAUSTED);
+
+    return (key);
+    }
+
+/*******************************************************************************
+*
+* taskTlsGet - get the calling task's value of a slot
+*
+* This routine returns the value stored in slot <key> by the calling task.
+* The TASK_TLS_GET() macro is an in-line equivalent that does not check
+* <key>.
+*
+* RETURNS: The value of the slot, or NULL if the calling task has not stored
+* a value in any slot, or <key> is invalid.
+*
+* SEE ALSO: taskTlsSet(), taskTlsTaskGet()
+*/
+
+void * taskTlsGet
+    (
+    int key		/* key from taskTlsKeyCreate() */
+    )
+    {
+    if ((key < 0) || (key >= taskTlsNextKey))
+	return (NULL);
+
+    return (TASK_TLS_GET (key));
+    }
+
+/*******************************************************************************
+*
+* taskTlsSet - set the calling task's value of a slot
+*
+* This routine stores <value> in slot <key> of the calling task.  The first
+* time a task stores a value, its slot table is allocated and <taskTlsTable>
+* is made a task variable of the task.  This routine may not be called from
+* interrupt level.
+*
+* RETURNS: OK, or ERROR if <key> is invalid or memory is insufficient for
+* the slot table.
+*
+* ERRNO: S_taskLib_TLS_KEY_INVALID
+*
+* SEE ALSO: taskTlsGet()
+*/
+
+STATUS taskTlsSet
+    (
+    int		key,	/* key from taskTlsKeyCreate() */
+    void *	value	/* value to store */
+    )
+    {
+    void **	pTable;
+
+    if ((key < 0) || (key >= taskTlsNextKey))
+	{
+	errnoSet (S_taskLib_TLS_KEY_INVALID);
+	return (ERROR);
+	}
+
+    if (taskTlsTable == NULL)
+	{
+	/* first slot used by this task: give it its own slot table */
+
+	if ((pTable = (void **) calloc (TASK_TLS_MAX, sizeof (void *))) == NULL)
+	    return (ERROR);
+
+	if (taskVarAdd (0, (int *) &taskTlsTable) != OK)
+	    {
+	    free ((char *) pTable);
+	    return (ERROR);
+	    }
+
+	taskTlsTable = pTable;
+	}
+
+    taskTlsTable [key] = value;
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* taskTlsTaskGet - get a task's value of a slot
+*
+* This routine returns the value stored in slot <key> by the task <tid>.
+* It is provided primarily for debugging; a task gets its own values with
+* taskTlsGet().
+*
+* RETURNS: The value of the slot, or NULL if the task has not stored a value
+* in any slot, or the task or <key> is invalid.
+*
+* SEE ALSO: taskTlsGet()
+*/
+
+void * taskTlsTaskGet
+    (
+    int tid,		/* ID of task whose slot is read */
+    int key		/* key from taskTlsKeyCreate() */
+    )
+    {
+    void **	pTable;
+
+    if ((key < 0) || (key >= taskTlsNextKey))
+	return (NULL);
+
+    pTable = (void **) taskVarGet (tid, (int *) &taskTlsTable);
+
+    if ((pTable == NULL) || (pTable == (void **) ERROR))
+	return (NULL);
+
+    return (pTable [key]);
+    }
@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+02a,17oct26,agt  doc: pointed to taskTlsLib for per-task data off the switch path.
 01z,21jan93,jdi  documentation cleanup for 5.1.
 01y,02oct92,jcf  added task validity check to switch hook.
 01x,18jul92,smb  changed errno.h to errnoLib.h.
@@ -58,6 +59,11 @@ The routines taskVarAdd() and taskVarDelete() are used to add or delete
 a task variable.  The routines taskVarGet() and taskVarSet() are used to get
 or set the value of a task variable.
 
+Every task variable is saved and restored at each switch from or to its
+task, so task switch time grows with the number of task variables.  New
+code needing several private values per task should use taskTlsLib, whose
+slot tables cost a single task variable per task.
+
 NOTE
 If you are using task variables in a task delete hook
 (see taskHookLib), refer to the manual entry for taskVarInit()
@@ -65,7 +71,7 @@ for warnings on proper usage.
 
 INCLUDE FILES: taskVarLib.h
 
-SEE ALSO: taskHookLib,
+SEE ALSO: taskHookLib, taskTlsLib,
 .pG "Basic OS"
 */
 
@@ -238,7 +244,8 @@ LOCAL void taskVarSwitchHook
 * tasks that own them.  Therefore, it is desirable to limit the number of
 * task variables that a task uses.  One efficient way to use task variables 
 * is to have a single task variable that is a pointer to a dynamically 
-* allocated structure containing the task's private data.
+* allocated structure containing the task's private data, or to use the
+* slots of taskTlsLib, which are reached through such a single pointer.
 *
 * EXAMPLE:
 * Assume that three identical tasks were spawned with a routine called
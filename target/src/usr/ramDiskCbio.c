@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01k,17oct26,agt  CBIO_CACHE_META is a no-op
 01j,12dec01,jkf  fixing diab build warnings
 01i,09dec01,jkf  SPR#71637, fix for SPR#68387 caused ready changed bugs.
 01h,30jul01,jkf  SPR#69031, common code for both AE & 5.x.
@@ -340,6 +341,7 @@ LOCAL STATUS ramDiskBlkCopy
 * CBIO_CACHE_FLUSH - Flush any dirty cached data
 * CBIO_CACHE_INVAL - Flush & Invalidate all cached data
 * CBIO_CACHE_NEWBLK - Allocate scratch block
+* CBIO_CACHE_META - Block holds file system metadata
 *
 * dev - the CBIO handle of the device being accessed (from creation routine)
 * 
@@ -368,6 +370,7 @@ LOCAL STATUS ramDiskIoctl
 	case CBIO_DEVICE_EJECT :
 	case CBIO_CACHE_FLUSH :
 	case CBIO_CACHE_INVAL :
+	case CBIO_CACHE_META :
 	    if( TRUE == CBIO_READYCHANGED (dev) )
 		{
 		errno = S_ioLib_DISK_NOT_PRESENT ;
@@ -0,0 +1,617 @@
+/* qPriWheelLib.c - timing wheel priority queue library */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+#include "copyright_wrs.h"
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  written.
+*/
+
+/*
+DESCRIPTION
+This library contains routines to manage a timer queue as a hierarchical
+timing wheel.  The wheel has WHEEL_LEVELS levels of WHEEL_SLOTS slots each;
+a node is kept in the slot selected by the highest group of WHEEL_SHIFT bits
+in which its expiry time differs from the wheel's notion of the current time.
+qPriWheelPut() and qPriWheelRemove() are therefore constant time regardless
+of the number of nodes queued, and qPriWheelAdvance() is constant time
+except when a lower level wraps, at which point the slot of the next level
+up is redistributed ("cascaded") one level down.  Each node is cascaded at
+most WHEEL_LEVELS - 1 times over its life, so advancing is amortized
+constant time as well.  This compares with qPriDeltaLib, whose
+qPriDeltaPut() is proportional to the number of nodes in the queue.
+
+The wheel keeps its own time, counted by qPriWheelAdvance(), so that the
+placement of nodes does not depend on vxTicks; qPriWheelCalibrate() only
+adjusts the node keys reported by qPriWheelKey().
+
+Slot lists are circular and doubly linked so a node may be removed
+without knowing which slot currently holds it.
+
+The slot lists live in a WHEEL_ARRAY supplied to qPriWheelInit().  The
+structure is about eight kilobytes, and since the tick queue is
+initialized before the memory pool exists it is normally carved out of
+memory by the kernel rather than allocated with qPriWheelArrayCreate().
+
+This queue complies with the multi-way queue data structures and thus may be
+utilized by any multi-way queue.  The timing wheel multi-way queue class is
+accessed by the global id qPriWheelClassId.
+
+SEE ALSO: qLib, qPriDeltaLib, kernelLib.
+*/
+
+#include "vxWorks.h"
+#include "qClass.h"
+#include "qPriWheelLib.h"
+#include "stdlib.h"
+
+IMPORT ULONG vxTicks;		/* current time in ticks */
+
+/* circular slot list manipulation */
+
+#define WHEEL_EMPTY(pHead)	((pHead)->next == (pHead))
+
+#define WHEEL_INSERT(pHead, pLink)				\
+    do {							\
+    (pLink)->next = (pHead)->next;				\
+    (pLink)->prev = (pHead);					\
+    (pHead)->next->prev = (pLink);				\
+    (pHead)->next = (pLink);					\
+    } while (0)
+
+#define WHEEL_UNLINK(pLink)					\
+    do {							\
+    (pLink)->prev->next = (pLink)->next;			\
+    (pLink)->next->prev = (pLink)->prev;			\
+    } while (0)
+
+
+/* forward static functions */
+
+static void qPriWheelPlace (WHEEL_ARRAY *pWheel, Q_PRI_WHEEL_NODE *pQNode);
+static void qPriWheelCascade (WHEEL_ARRAY *pWheel, WHEEL_LINK *pHead);
+
+
+/* locals */
+
+LOCAL Q_CLASS qPriWheelClass =
+    {
+    (FUNCPTR)qPriWheelCreate,
+    (FUNCPTR)qPriWheelInit,
+    (FUNCPTR)qPriWheelDelete,
+    (FUNCPTR)qPriWheelTerminate,
+    (FUNCPTR)qPriWheelPut,
+    (FUNCPTR)qPriWheelGet,
+    (FUNCPTR)qPriWheelRemove,
+    (FUNCPTR)qPriWheelResort,
+    (FUNCPTR)qPriWheelAdvance,
+    (FUNCPTR)qPriWheelGetExpired,
+    (FUNCPTR)qPriWheelKey,
+    (FUNCPTR)qPriWheelCalibrate,
+    (FUNCPTR)qPriWheelInfo,
+    (FUNCPTR)qPriWheelEach,
+    &qPriWheelClass
+    };
+
+/* globals */
+
+Q_CLASS_ID qPriWheelClassId = &qPriWheelClass;
+
+
+/******************************************************************************
+*
+* qPriWheelArrayCreate - allocate a timing wheel slot array
+*
+* This routine allocates a WHEEL_ARRAY from the free memory pool for use
+* with qPriWheelInit().
+*
+* RETURNS:
+*  Pointer to a WHEEL_ARRAY, or
+*  NULL if out of memory.
+*/
+
+WHEEL_ARRAY *qPriWheelArrayCreate (void)
+    {
+    return ((WHEEL_ARRAY *) malloc (sizeof (WHEEL_ARRAY)));
+    }
+
+/******************************************************************************
+*
+* qPriWheelArrayDelete - deallocate a timing wheel slot array
+*
+* This routine returns an allocated WHEEL_ARRAY structure to the free memory
+* pool.
+*
+* RETURNS:
+*  OK, or
+*  ERROR if could not deallocate the array.
+*/
+
+STATUS qPriWheelArrayDelete
+    (
+    WHEEL_ARRAY *pWheel
+    )
+    {
+    free ((char *) pWheel);
+    return (OK);
+    }
+
+/******************************************************************************
+*
+* qPriWheelCreate - allocate and initialize a timing wheel queue
+*
+* This routine allocates and initializes a timing wheel queue by allocating
+* a Q_PRI_WHEEL_HEAD structure from the free memory pool.  The slot lists
+* are kept in the specified WHEEL_ARRAY.
+*
+* RETURNS:
+*  Pointer to a Q_PRI_WHEEL_HEAD, or
+*  NULL if out of memory.
+*/
+
+Q_PRI_WHEEL_HEAD *qPriWheelCreate
+    (
+    WHEEL_ARRAY *pWheel
+    )
+    {
+    Q_PRI_WHEEL_HEAD *pQHead = (Q_PRI_WHEEL_HEAD *)
+				malloc (sizeof (Q_PRI_WHEEL_HEAD));
+
+    if (pQHead == NULL)
+	return (NULL);
+
+    qPriWheelInit (pQHead, pWheel);
+
+    return (pQHead);
+    }
+
+/******************************************************************************
+*
+* qPriWheelInit - initialize a timing wheel queue
+*
+* This routine initializes the specified timing wheel queue.  Every slot
+* list of the WHEEL_ARRAY is emptied and the wheel time is reset.
+*
+* RETURNS: OK.
+*/
+
+STATUS qPriWheelInit
+    (
+    Q_PRI_WHEEL_HEAD *pQHead,
+    WHEEL_ARRAY      *pWheel
+    )
+    {
+    FAST WHEEL_LINK *pHead = &pWheel->slot [0][0];
+    FAST int ix;
+
+    for (ix = 0; ix < WHEEL_LEVELS * WHEEL_SLOTS; ix++, pHead++)
+	pHead->next = pHead->prev = pHead;
+
+    pWheel->now		= 0;
+    pQHead->pFirstNode	= NULL;
+    pQHead->pWheel	= pWheel;
+    pQHead->nNodes	= 0;
+
+    return (OK);
+    }
+
+/******************************************************************************
+*
+* qPriWheelDelete - delete a timing wheel queue
+*
+* This routine deallocates memory associated with the queue head.  All
+* queued nodes are lost.  The WHEEL_ARRAY belongs to the caller and is not
+* freed.
+*
+* RETURNS:
+*  OK, or
+*  ERROR if memory cannot be deallocated.
+*/
+
+STATUS qPriWheelDelete
+    (
+    Q_PRI_WHEEL_HEAD *pQHead
+    )
+    {
+    free ((char *) pQHead);
+    return (OK);
+    }
+
+/******************************************************************************
+*
+* qPriWheelTerminate - terminate a timing wheel queue
+*
+* This routine terminates a timing wheel queue.  All queued nodes are lost.
+*
+* ARGSUSED
+*/
+
+STATUS qPriWheelTerminate
+    (
+    Q_PRI_WHEEL_HEAD *pQHead
+    )
+    {
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* qPriWheelPut - insert a node into a timing wheel queue
+*
+* This routine inserts a node into a timing wheel queue.  The key is the
+* absolute tick count at which the node expires; like qPriDeltaPut(), the
+* time-to-fire is taken relative to vxTicks.  A key equal to vxTicks
+* expires on the next qPriWheelAdvance().
+*/
+
+void qPriWheelPut
+    (
+    Q_PRI_WHEEL_HEAD *pQHead,
+    Q_PRI_WHEEL_NODE *pQNode,
+    ULONG             key
+    )
+    {
+    FAST WHEEL_ARRAY *pWheel = pQHead->pWheel;
+    FAST ULONG        delay  = key - vxTicks;
+
+    if (delay == 0)
+	delay = 1;			/* no expiring in the past */
+
+    pQNode->key	   = vxTicks + delay;
+    pQNode->expire = pWheel->now + delay;
+
+    qPriWheelPlace (pWheel, pQNode);
+    pQHead->nNodes++;
+    }
+
+/*******************************************************************************
+*
+* qPriWheelGet - remove and return first node in timing wheel queue
+*
+* This routine removes and returns the node that expires soonest in a timing
+* wheel queue.  If the queue is empty, NULL is returned.  Unlike the other
+* operations this one searches every slot; timer queues only ever take
+* expired nodes with qPriWheelGetExpired().
+*
+* RETURNS
+*  Pointer to first queue node in queue head, or
+*  NULL if queue is empty.
+*/
+
+Q_PRI_WHEEL_NODE *qPriWheelGet
+    (
+    Q_PRI_WHEEL_HEAD *pQHead
+    )
+    {
+    FAST WHEEL_ARRAY      *pWheel = pQHead->pWheel;
+    FAST WHEEL_LINK       *pHead  = &pWheel->slot [0][0];
+    FAST WHEEL_LINK       *pLink;
+    FAST Q_PRI_WHEEL_NODE *pFirst = NULL;
+    FAST int ix;
+
+    if (pQHead->nNodes == 0)
+	return (NULL);
+
+    for (ix = 0; ix < WHEEL_LEVELS * WHEEL_SLOTS; ix++, pHead++)
+	{
+	for (pLink = pHead->next; pLink != pHead; pLink = pLink->next)
+	    {
+	    if ((pFirst == NULL) ||
+		(((Q_PRI_WHEEL_NODE *) pLink)->expire - pWheel->now <
+		 pFirst->expire - pWheel->now))
+		pFirst = (Q_PRI_WHEEL_NODE *) pLink;
+	    }
+	}
+
+    qPriWheelRemove (pQHead, pFirst);
+
+    return (pFirst);
+    }
+
+/*******************************************************************************
+*
+* qPriWheelRemove - remove a node from a timing wheel queue
+*
+* This routine removes a node from the specified timing wheel queue.
+*
+* RETURNS: OK.
+*/
+
+STATUS qPriWheelRemove
+    (
+    Q_PRI_WHEEL_HEAD *pQHead,
+    Q_PRI_WHEEL_NODE *pQNode
+    )
+    {
+    WHEEL_UNLINK (&pQNode->link);
+    pQHead->nNodes--;
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* qPriWheelResort - resort a node to a new position based on a new key
+*
+* This routine resorts a node to a new position based on a new priority key.
+*/
+
+void qPriWheelResort
+    (
+    Q_PRI_WHEEL_HEAD *pQHead,
+    Q_PRI_WHEEL_NODE *pQNode,
+    ULONG             newKey
+    )
+    {
+    qPriWheelRemove (pQHead, pQNode);
+    qPriWheelPut (pQHead, pQNode, newKey);
+    }
+
+/*******************************************************************************
+*
+* qPriWheelAdvance - advance a queues concept of time
+*
+* This routine advances the wheel time by one tick.  It is usually called
+* from within a clock-tick interrupt service routine.  Whenever the low
+* bits of the wheel time wrap, the matching slot of each higher level is
+* cascaded, highest level first, so that nodes due in the coming period
+* are redistributed to the lower levels.  The nodes due now are then found
+* in a single level zero slot by qPriWheelGetExpired().
+*/
+
+void qPriWheelAdvance
+    (
+    Q_PRI_WHEEL_HEAD *pQHead
+    )
+    {
+    FAST WHEEL_ARRAY *pWheel = pQHead->pWheel;
+    FAST ULONG        now    = ++pWheel->now;
+    FAST int          level;
+
+    if ((now & WHEEL_MASK) != 0)
+	return;				/* nothing to cascade */
+
+    for (level = WHEEL_LEVELS - 1; level > 0; level--)
+	{
+	if ((now & ((1UL << (level * WHEEL_SHIFT)) - 1)) == 0)
+	    qPriWheelCascade (pWheel, &pWheel->slot [level]
+				[(now >> (level * WHEEL_SHIFT)) & WHEEL_MASK]);
+	}
+    }
+
+/*******************************************************************************
+*
+* qPriWheelGetExpired - return a time-to-fire expired node
+*
+* This routine returns a time-to-fire expired node in a timing wheel queue.
+* Expired nodes result from a qPriWheelAdvance(2) advancing a node beyond its
+* delay.  As many nodes may expire on a single qPriWheelAdvance(2), this
+* routine should be called within a while loop until NULL is returned.
+* NULL is returned when there are no expired nodes.
+*
+* RETURNS
+*  Pointer to an expired queue node, or
+*  NULL if no node has expired.
+*/
+
+Q_PRI_WHEEL_NODE *qPriWheelGetExpired
+    (
+    Q_PRI_WHEEL_HEAD *pQHead
+    )
+    {
+    FAST WHEEL_ARRAY      *pWheel = pQHead->pWheel;
+    FAST WHEEL_LINK       *pHead  = &pWheel->slot [0][pWheel->now & WHEEL_MASK];
+    FAST Q_PRI_WHEEL_NODE *pQNode;
+
+    while (!WHEEL_EMPTY (pHead))
+	{
+	pQNode = (Q_PRI_WHEEL_NODE *) pHead->next;
+	WHEEL_UNLINK (&pQNode->link);
+
+	if (pQNode->expire == pWheel->now)
+	    {
+	    pQHead->nNodes--;
+	    return (pQNode);
+	    }
+
+	/*
+	 * A delay within one slot of wrapping the wheel time lands behind
+	 * the current slot; move it up to the level it belongs at now.
+	 */
+
+	qPriWheelPlace (pWheel, pQNode);
+	}
+
+    return (NULL);
+    }
+
+/*******************************************************************************
+*
+* qPriWheelKey - return the key of a node
+*
+* This routine returns the key of a node currently in a timing wheel queue.
+* The keyType determines key style.  A normal key style returns the nodes
+* expiry in ticks.  A timer queue key type style returns the key as the
+* time-to-fire.
+*
+* RETURNS
+*  Node's key, or
+*  node's time-to-fire.
+*/
+
+ULONG qPriWheelKey
+    (
+    Q_PRI_WHEEL_NODE *pQNode,
+    int               keyType		/* 0 = normal; 1 = time queue */
+    )
+    {
+    if (keyType == 0)
+	return (pQNode->key);
+    else
+	return (pQNode->key - vxTicks);
+    }
+
+/*******************************************************************************
+*
+* qPriWheelCalibrate - offset every node in a queue by some delta
+*
+* This routine offsets the key of every node in a timing wheel queue by some
+* delta, as the kernel does when vxTicks rolls over.  Slot placement uses
+* the wheel's own time and is unaffected.
+*/
+
+void qPriWheelCalibrate
+    (
+    Q_PRI_WHEEL_HEAD *pQHead,
+    ULONG             keyDelta		/* offset to add to each node's key */
+    )
+    {
+    FAST WHEEL_LINK *pHead = &pQHead->pWheel->slot [0][0];
+    FAST WHEEL_LINK *pLink;
+    FAST int ix;
+
+    if (pQHead->nNodes == 0)
+	return;
+
+    for (ix = 0; ix < WHEEL_LEVELS * WHEEL_SLOTS; ix++, pHead++)
+	for (pLink = pHead->next; pLink != pHead; pLink = pLink->next)
+	    ((Q_PRI_WHEEL_NODE *) pLink)->key += keyDelta;
+    }
+
+/*******************************************************************************
+*
+* qPriWheelInfo - gather information on a timing wheel queue
+*
+* This routine fills up to maxNodes elements of a nodeArray with nodes
+* currently in a multi-way queue.  The actual number of nodes copied to the
+* array is returned.  If the nodeArray is NULL, then the number of nodes in
+* the timing wheel queue is returned.  Nodes are reported in slot order,
+* not in order of expiry.
+*
+* RETURNS
+*  Number of node pointers copied into the nodeArray, or
+*  Number of nodes in multi-way queue if nodeArray is NULL
+*/
+
+int qPriWheelInfo
+    (
+    Q_PRI_WHEEL_HEAD *pQHead,		/* queue to gather list for */
+    FAST int nodeArray[],		/* array of node pointers to be filled in */
+    FAST int maxNodes			/* max node pointers nodeArray can accomodate */
+    )
+    {
+    FAST WHEEL_LINK *pHead    = &pQHead->pWheel->slot [0][0];
+    FAST WHEEL_LINK *pLink;
+    FAST int        *pElement = nodeArray;
+    FAST int ix;
+
+    if (nodeArray == NULL)		/* NULL node array means return count */
+	return (pQHead->nNodes);
+
+    for (ix = 0; ix < WHEEL_LEVELS * WHEEL_SLOTS; ix++, pHead++)
+	{
+	for (pLink = pHead->next; pLink != pHead; pLink = pLink->next)
+	    {
+	    if (--maxNodes < 0)
+		return (pElement - nodeArray);
+
+	    *(pElement++) = (int) pLink;		/* fill in table */
+	    }
+	}
+
+    return (pElement - nodeArray);	/* return count of active tasks */
+    }
+
+/*******************************************************************************
+*
+* qPriWheelEach - call a routine for each node in a queue
+*
+* This routine calls a user-supplied routine once for each node in the
+* queue.  The routine should be declared as follows:
+* .CS
+*  BOOL routine (pQNode, arg)
+*      Q_PRI_WHEEL_NODE *pQNode;	/@ pointer to a queue node          @/
+*      int		arg;		/@ arbitrary user-supplied argument @/
+* .CE
+* The user-supplied routine should return TRUE if qPriWheelEach (2) is to
+* continue calling it for each entry, or FALSE if it is done and
+* qPriWheelEach can exit.
+*
+* RETURNS: NULL if traversed whole queue, or pointer to Q_PRI_WHEEL_NODE that
+*          qPriWheelEach stopped on.
+*/
+
+Q_PRI_WHEEL_NODE *qPriWheelEach
+    (
+    Q_PRI_WHEEL_HEAD *pQHead,		/* queue head of queue to call routine for */
+    FUNCPTR           routine,		/* the routine to call for each table entry */
+    int               routineArg	/* arbitrary user-supplied argument */
+    )
+    {
+    FAST WHEEL_LINK *pHead = &pQHead->pWheel->slot [0][0];
+    FAST WHEEL_LINK *pLink;
+    FAST int ix;
+
+    for (ix = 0; ix < WHEEL_LEVELS * WHEEL_SLOTS; ix++, pHead++)
+	{
+	for (pLink = pHead->next; pLink != pHead; pLink = pLink->next)
+	    {
+	    if (!(* routine) (pLink, routineArg))
+		return ((Q_PRI_WHEEL_NODE *) pLink);	/* node we ended with */
+	    }
+	}
+
+    return (NULL);
+    }
+
+/*******************************************************************************
+*
+* qPriWheelPlace - link a node into the slot for its expiry
+*
+* The level is the highest group of WHEEL_SHIFT bits in which the node's
+* expiry differs from the wheel time; the slot is the expiry's bits in that
+* group.
+*/
+
+LOCAL void qPriWheelPlace
+    (
+    WHEEL_ARRAY      *pWheel,
+    Q_PRI_WHEEL_NODE *pQNode
+    )
+    {
+    FAST ULONG diff  = pQNode->expire ^ pWheel->now;
+    FAST int   level = 0;
+
+    while ((diff >>= WHEEL_SHIFT) != 0)
+	level++;
+
+    WHEEL_INSERT (&pWheel->slot [level]
+			[(pQNode->expire >> (level * WHEEL_SHIFT)) & WHEEL_MASK],
+		  &pQNode->link);
+    }
+
+/*******************************************************************************
+*
+* qPriWheelCascade - redistribute the nodes of a slot
+*
+* Every node of the slot is placed again relative to the current wheel time,
+* which moves it to a lower level.
+*/
+
+LOCAL void qPriWheelCascade
+    (
+    WHEEL_ARRAY *pWheel,
+    WHEEL_LINK  *pHead
+    )
+    {
+    FAST WHEEL_LINK *pLink;
+
+    while (!WHEEL_EMPTY (pHead))
+	{
+	pLink = pHead->next;
+	WHEEL_UNLINK (pLink);
+	qPriWheelPlace (pWheel, (Q_PRI_WHEEL_NODE *) pLink);
+	}
+    }
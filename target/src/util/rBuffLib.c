@@ -6,6 +6,8 @@
 /*
 modification history
 --------------------
+02a,17oct26,agt  portWorkQAdd1() calls workQAdd1(), which is no longer in
+                 assembler on the I80X86.
 01z,20apr00,max  Change tid == NULL to tid == 0 (like in es.coretools)
 01y,28aug98,dgp  FCS man page edit
 01x,27aug98,dgp  add lib description, edit wvRBuffMgrPrioritySet() for manpgs
@@ -3441,20 +3443,11 @@ printf("%s\n",buffer);
 *
 * portWorkQAdd1 - add work with one parameter to the wind work queue
 *
-* When the kernel is interrupted, new kernel work must be queued to an internal
-* work queue.  The work queue is emptied by whatever task or interrupt service
-* routine that entered the kernel first.  The work is emptied as the last
-* code of reschedule().
+* This routine is kept for the trigger and ring buffer code, which call it
+* on the I80X86.  The work queue is now implemented in C on all
+* architectures, so it simply calls workQAdd1().
 *
-* INTERNAL
-* The work queue is single reader, multiple writer, so we should have to lock
-* out interrupts while the writer is copying into the ring, but because the
-* reader can never interrupt a writer, interrupts need only be locked while
-* we advance the write queue pointer.
-*
-* RETURNS: OK
-*
-* SEE ALSO: reschedule()
+* SEE ALSO: workQAdd1()
 *
 * NOMANUAL
 */
@@ -3465,20 +3458,7 @@ void portWorkQAdd1
     int arg1            /* parameter one to function */
     )
     {
-    int level = intLock ();             /* LOCK INTERRUPTS */
-    FAST JOB *pJob = (JOB *) &pJobPool [workQWriteIx];
-
-    workQWriteIx += 4;                  /* advance write index */
-
-    if (workQWriteIx == workQReadIx)
-        workQPanic ();                  /* leave interrupts locked */
-
-    intUnlock (level);                  /* UNLOCK INTERRUPTS */
-
-    workQIsEmpty = FALSE;               /* we put something in it */
-
-    pJob->function = func;              /* fill in function */
-    pJob->arg1 = arg1;                  /* fill in argument */
+    workQAdd1 (func, arg1);
     }
 
 #endif /* CPU_FAMILY == I80X86 */
@@ -6,6 +6,8 @@
 
 modification history
 --------------------
+01g,17oct26,agt  VxMutex is a fast mutex
+01f,17oct26,agt  add VxRWLock methods
 01e,17dec01,nel  Add include symbol for diab build.
 01d,16jul01,dbs  add VxCondVar methods
 01c,28jun01,dbs  move g_defaultServerPriority to comCoreLib
@@ -16,6 +18,7 @@ modification history
 #include <stdio.h>
 #include "vxWorks.h"
 #include "semLib.h"
+#include "semFmLib.h"
 #include "taskLib.h"
 #include "private/comMisc.h"
 
@@ -28,7 +31,11 @@ extern "C" int include_vxcom_comMisc (void)
 
 VxMutex::VxMutex ()
     {
-    m_mutex = semMCreate (SEM_Q_FIFO);
+    // Most of these guard a few lines of bookkeeping and are rarely
+    // contended, so take the fast mutex: semTake()/semGive() on it
+    // only enter the kernel when another task holds it.
+
+    m_mutex = semFmCreate (SEM_Q_FIFO);
     COM_ASSERT (m_mutex);
     }
 
@@ -73,6 +80,48 @@ void VxCondVar::signal () const
     semGive (m_condvar);
     }
 
+VxRWLock::VxRWLock ()
+  : m_mutex (),
+    m_noReaders (),
+    m_readers (0)
+    {
+    }
+
+VxRWLock::~VxRWLock ()
+    {
+    }
+
+void VxRWLock::readLock () const
+    {
+    m_mutex.lock ();
+    ++m_readers;
+    m_mutex.unlock ();
+    }
+
+void VxRWLock::readUnlock () const
+    {
+    m_mutex.lock ();
+    if (--m_readers == 0)
+	m_noReaders.signal ();
+    m_mutex.unlock ();
+    }
+
+void VxRWLock::writeLock () const
+    {
+    // Holding the mutex keeps new readers out; then wait for the
+    // current ones to drain. The condvar is a binary semaphore, so a
+    // stale signal just causes one more trip round the loop.
+    
+    m_mutex.lock ();
+    while (m_readers > 0)
+	m_noReaders.wait (m_mutex);
+    }
+
+void VxRWLock::writeUnlock () const
+    {
+    m_mutex.unlock ();
+    }
+
 void comAssertFailed
     (
     const char* expr,
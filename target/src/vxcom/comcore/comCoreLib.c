@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01o,17oct26,agt  add comSafeCas()
 01n,10dec01,dbs  diab build
 01m,06dec01,nel  Correct man pages.
 01l,02nov01,nel  SPR#71427. Correct error in comAddRegistry when null
@@ -557,3 +558,35 @@ long comSafeDec
     TASK_UNLOCK ();
     return n;
     }
+
+
+/**************************************************************************
+*
+* comSafeCas - compare and swap a variable in a task-safe way
+*
+* This function stores <newValue> in the variable only if it still
+* holds <oldValue>, guaranteeing that no other task can modify it
+* between the comparison and the store. It is the building block for
+* the non-blocking queues used by VxDCOM.
+*
+* RETURNS: TRUE if the value was stored, FALSE otherwise
+*/
+
+BOOL comSafeCas
+    (
+    long *      pVar,
+    long        oldValue,
+    long        newValue
+    )
+    {
+    BOOL swapped = FALSE;
+    
+    TASK_LOCK ();
+    if (*pVar == oldValue)
+        {
+        *pVar = newValue;
+        swapped = TRUE;
+        }
+    TASK_UNLOCK ();
+    return swapped;
+    }
@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01g,17oct26,agt  add interlocked compare-and-swap func
 01f,07aug01,dbs  return multiple interfaces during creation
 01e,06aug01,dbs  add registry-show capability
 01d,28jun01,dbs  add interlocked inc/dec funcs
@@ -122,6 +123,13 @@ long comSafeDec
     (
     long *              pVar            /* variable to decrement */
     );
+
+BOOL comSafeCas
+    (
+    long *              pVar,           /* variable to update */
+    long                oldValue,       /* value it must still hold */
+    long                newValue        /* value to store */
+    );
     
 #ifdef __cplusplus
 }
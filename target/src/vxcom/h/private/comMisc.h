@@ -6,6 +6,7 @@
 
 modification history
 --------------------
+01r,17oct26,agt  add VxRWLock and its scoped-lock helpers
 01q,08nov01,nel  SPR#71582. Type case error return in vxcom_mbstowcs to
                  size_t.
 01p,30oct01,nel  Correct problem with buffer restricted strings in
@@ -230,6 +231,83 @@ class VxCritSec
     };
 
 
+//////////////////////////////////////////////////////////////////////////
+//
+// VxRWLock -- a simple readers/writer lock. Any number of readers may
+// hold the lock at once; a writer excludes readers and other
+// writers. The internal mutex is only held for the duration of
+// readLock() and readUnlock() by readers, but for the whole critical
+// section by a writer, so a writer may nest calls to writeLock() and
+// readLock() while it holds the lock.
+//
+//////////////////////////////////////////////////////////////////////////
+
+class VxRWLock
+    {
+  public:
+
+    VxRWLock ();
+    ~VxRWLock ();
+
+    void readLock () const;
+    void readUnlock () const;
+    void writeLock () const;
+    void writeUnlock () const;
+
+  private:
+
+    // copy/assignment -- not allowed
+    VxRWLock (const VxRWLock&);
+    VxRWLock& operator= (const VxRWLock&);
+
+    VxMutex		m_mutex;
+    mutable VxCondVar	m_noReaders;
+    mutable long	m_readers;
+    };
+
+//////////////////////////////////////////////////////////////////////////
+//
+// VxReadCritSec / VxWriteCritSec -- scoped use of a VxRWLock
+//
+//////////////////////////////////////////////////////////////////////////
+
+class VxReadCritSec
+    {
+  public:
+    VxReadCritSec (const VxRWLock& lck) : m_lock (lck)
+	{ m_lock.readLock (); }
+
+    ~VxReadCritSec ()
+	{ m_lock.readUnlock (); }
+
+  private:
+
+    // copy/assignment -- not allowed
+    VxReadCritSec (const VxReadCritSec&);
+    VxReadCritSec& operator= (const VxReadCritSec&);
+    
+    const VxRWLock&	m_lock;
+    };
+
+class VxWriteCritSec
+    {
+  public:
+    VxWriteCritSec (const VxRWLock& lck) : m_lock (lck)
+	{ m_lock.writeLock (); }
+
+    ~VxWriteCritSec ()
+	{ m_lock.writeUnlock (); }
+
+  private:
+
+    // copy/assignment -- not allowed
+    VxWriteCritSec (const VxWriteCritSec&);
+    VxWriteCritSec& operator= (const VxWriteCritSec&);
+    
+    const VxRWLock&	m_lock;
+    };
+
+
 //////////////////////////////////////////////////////////////////////////
 //
 // VxGenericListElement - Template class for a generic list element in a
@@ -0,0 +1,299 @@
+/* NdrBuffer.cpp - pooled NDR marshaling buffers and stub arenas */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created
+
+*/
+
+/*
+  DESCRIPTION:
+
+  Memory management for the NDR marshaling streams and RPC PDUs. The
+  NdrBufPool keeps freed blocks on per-size-class lists so that
+  marshaling a reply, or receiving a request, recycles the previous
+  call's memory instead of making a fresh trip to the heap. NdrBuffer
+  is a growable contiguous buffer on top of the pool, and NdrArena is
+  a per-call bump allocator for stub-side unmarshaled data.
+*/
+
+#include <string.h>
+#include "NdrBuffer.h"
+#include "private/comMisc.h"
+#include "private/vxdcomGlobals.h"
+
+/* Include symbol for diab */
+extern "C" int include_vxdcom_NdrBuffer (void)
+    {
+    return 0;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Size classes -- class 'n' holds blocks of (256 << n) bytes...
+//
+
+const int    NDR_BUF_MIN_SHIFT = 8;
+const int    NDR_BUF_CLASSES = 9;
+const size_t NDR_BUF_MIN = (1 << NDR_BUF_MIN_SHIFT);
+const size_t NDR_BUF_MAX = (NDR_BUF_MIN << (NDR_BUF_CLASSES - 1));
+
+struct NdrFreeBlock
+    {
+    NdrFreeBlock*	pNext;
+    };
+
+static VxMutex		s_poolMutex;
+static NdrFreeBlock*	s_freeList [NDR_BUF_CLASSES];
+static int		s_freeCount [NDR_BUF_CLASSES];
+
+//////////////////////////////////////////////////////////////////////////
+//
+// ndrBufClass -- find the size class for a block of 'nb' bytes, or -1
+// if it is too big to be pooled...
+//
+
+static int ndrBufClass (size_t nb)
+    {
+    if (nb > NDR_BUF_MAX)
+	return -1;
+
+    int    n = 0;
+    size_t sz = NDR_BUF_MIN;
+    while (sz < nb)
+	{
+	sz <<= 1;
+	++n;
+	}
+    return n;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrBufPool::alloc -- get a block of at least 'nb' bytes, from the
+// appropriate free list if possible, and return its real size in
+// 'nb'...
+//
+
+byte* NdrBufPool::alloc (size_t& nb)
+    {
+    int n = ndrBufClass (nb);
+
+    if (n < 0)
+	return new byte [nb];
+
+    nb = (NDR_BUF_MIN << n);
+
+    s_poolMutex.lock ();
+    NdrFreeBlock* pBlk = s_freeList [n];
+    if (pBlk)
+	{
+	s_freeList [n] = pBlk->pNext;
+	--s_freeCount [n];
+	}
+    s_poolMutex.unlock ();
+
+    if (pBlk)
+	return reinterpret_cast<byte*> (pBlk);
+
+    return new byte [nb];
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrBufPool::release -- give back a block obtained from alloc(). If its
+// free list is already full, the block goes back to the heap...
+//
+
+void NdrBufPool::release (byte* pb, size_t nb)
+    {
+    if (pb == 0)
+	return;
+
+    int n = ndrBufClass (nb);
+
+    if ((n >= 0) && ((NDR_BUF_MIN << n) == nb))
+	{
+	VxCritSec cs (s_poolMutex);
+
+	if (s_freeCount [n] < g_vxdcomNdrBufCacheMax)
+	    {
+	    NdrFreeBlock* pBlk = reinterpret_cast<NdrFreeBlock*> (pb);
+	    pBlk->pNext = s_freeList [n];
+	    s_freeList [n] = pBlk;
+	    ++s_freeCount [n];
+	    return;
+	    }
+	}
+
+    delete [] pb;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+
+NdrBuffer::NdrBuffer ()
+  : m_base (0),
+    m_len (0),
+    m_cap (0)
+    {
+    }
+
+NdrBuffer::~NdrBuffer ()
+    {
+    clear ();
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrBuffer::reserve -- make sure there is room for 'nb' more bytes.
+// The buffer at least doubles each time it grows, so a large reply
+// is only copied a logarithmic number of times while it is being
+// marshaled...
+//
+
+HRESULT NdrBuffer::reserve (size_t nb)
+    {
+    if ((m_cap - m_len) >= nb)
+	return S_OK;
+
+    size_t len = 2 * m_cap;
+    if (len < (m_len + nb))
+	len = m_len + nb;
+
+    byte* ptmp = NdrBufPool::alloc (len);
+    if (! ptmp)
+	return E_OUTOFMEMORY;
+
+    if (m_len)
+	memcpy (ptmp, m_base, m_len);
+
+    NdrBufPool::release (m_base, m_cap);
+
+    m_base = ptmp;
+    m_cap = len;
+    return S_OK;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+
+HRESULT NdrBuffer::append (const void* pv, size_t nb)
+    {
+    HRESULT hr = reserve (nb);
+    if (FAILED (hr))
+	return hr;
+
+    if (pv)
+	memcpy (m_base + m_len, pv, nb);
+    else
+	memset (m_base + m_len, 0, nb);
+    m_len += nb;
+
+    return S_OK;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+
+void NdrBuffer::swap (NdrBuffer& other)
+    {
+    byte*  base = m_base;
+    size_t len = m_len;
+    size_t cap = m_cap;
+
+    m_base = other.m_base;
+    m_len = other.m_len;
+    m_cap = other.m_cap;
+
+    other.m_base = base;
+    other.m_len = len;
+    other.m_cap = cap;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+
+void NdrBuffer::clear ()
+    {
+    NdrBufPool::release (m_base, m_cap);
+    m_base = 0;
+    m_len = 0;
+    m_cap = 0;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrArena -- chunks are normally 1K, bigger if one allocation needs
+// more than that...
+//
+
+const size_t NDR_ARENA_CHUNK = 1024;
+
+NdrArena::NdrArena ()
+  : m_chunks (0),
+    m_next (0),
+    m_end (0)
+    {
+    }
+
+NdrArena::~NdrArena ()
+    {
+    reset ();
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrArena::alloc -- carve 'nb' bytes out of the current chunk,
+// starting a new one if it doesn't fit. The chunk header is rounded
+// up to 8 bytes so that the first allocation in each chunk is
+// suitably aligned for any NDR type...
+//
+
+byte* NdrArena::alloc (size_t nb)
+    {
+    const size_t hdrLen = (sizeof (Chunk) + 7) & ~7;
+
+    nb = (nb + 7) & ~7;
+
+    if ((m_next == 0) || ((size_t) (m_end - m_next) < nb))
+	{
+	size_t len = hdrLen + nb;
+	if (len < NDR_ARENA_CHUNK)
+	    len = NDR_ARENA_CHUNK;
+
+	byte* pb = NdrBufPool::alloc (len);
+	if (! pb)
+	    return 0;
+
+	Chunk* pChunk = reinterpret_cast<Chunk*> (pb);
+	pChunk->pNext = m_chunks;
+	pChunk->size = len;
+	m_chunks = pChunk;
+
+	m_next = pb + hdrLen;
+	m_end = pb + len;
+	}
+
+    byte* p = m_next;
+    m_next += nb;
+    return p;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+
+void NdrArena::reset ()
+    {
+    while (m_chunks)
+	{
+	Chunk* pChunk = m_chunks;
+	m_chunks = pChunk->pNext;
+	NdrBufPool::release (reinterpret_cast<byte*> (pChunk), pChunk->size);
+	}
+    m_next = 0;
+    m_end = 0;
+    }
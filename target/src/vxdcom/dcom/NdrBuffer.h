@@ -0,0 +1,125 @@
+/* NdrBuffer.h - pooled NDR marshaling buffers and stub arenas */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+
+modification history
+--------------------
+01a,17oct26,agt  created
+
+*/
+
+#ifndef __INCNdrBuffer_h
+#define __INCNdrBuffer_h
+
+#include "dcomLib.h"
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrBufPool -- a cache of raw memory blocks used by NDR buffers and
+// stub arenas. Blocks are kept on power-of-two size-class free
+// lists, from 256 bytes up to 64K, so that the marshaling buffers
+// for successive calls are recycled rather than going back to the
+// heap every time. Requests larger than the biggest class go
+// straight to the heap. Each free list holds at most
+// g_vxdcomNdrBufCacheMax blocks.
+//
+
+class NdrBufPool
+    {
+  public:
+
+    // allocate at least 'nb' bytes -- 'nb' is updated to the size
+    // of the block actually returned
+    static byte* alloc (size_t& nb);
+
+    // return a block obtained from alloc(), with the size it returned
+    static void  release (byte* pb, size_t nb);
+    };
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrBuffer -- a contiguous, growable byte buffer whose memory comes
+// from the NdrBufPool. Ownership of the memory can be passed from one
+// NdrBuffer to another with swap(), so a marshaled reply can move
+// from the NDR stream into the outgoing PDU without being copied.
+//
+
+class NdrBuffer
+    {
+  public:
+
+    NdrBuffer ();
+    ~NdrBuffer ();
+
+    byte*   begin () const { return m_base; }
+    byte*   end () const { return m_base + m_len; }
+    size_t  size () const { return m_len; }
+    size_t  capacity () const { return m_cap; }
+
+    // make room for 'nb' more bytes after end()
+    HRESULT reserve (size_t nb);
+
+    // copy 'nb' bytes onto the end of the buffer
+    HRESULT append (const void* pv, size_t nb);
+
+    // set the length, which must not exceed capacity()
+    void    sizeSet (size_t nb) { m_len = nb; }
+
+    // exchange contents with another buffer
+    void    swap (NdrBuffer& other);
+
+    // release the memory back to the pool
+    void    clear ();
+
+  private:
+
+    byte*		m_base;		// base of buffer
+    size_t		m_len;		// bytes in use
+    size_t		m_cap;		// bytes allocated
+
+    // unsupported
+    NdrBuffer (const NdrBuffer&);
+    NdrBuffer& operator= (const NdrBuffer&);
+    };
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrArena -- a bump-pointer allocator for stub-side unmarshaled
+// data (arrays, strings, referents). Memory is drawn from the
+// NdrBufPool in chunks and is only ever given back all at once, by
+// reset() or the destructor, at the end of the call.
+//
+
+class NdrArena
+    {
+  public:
+
+    NdrArena ();
+    ~NdrArena ();
+
+    // allocate 'nb' bytes, 8-byte aligned
+    byte*   alloc (size_t nb);
+
+    // free everything allocated since the last reset
+    void    reset ();
+
+  private:
+
+    struct Chunk
+	{
+	Chunk*		pNext;		// next chunk in arena
+	size_t		size;		// total size of this chunk
+	};
+
+    Chunk*		m_chunks;	// list of chunks, newest first
+    byte*		m_next;		// next free byte in newest chunk
+    byte*		m_end;		// end of newest chunk
+
+    // unsupported
+    NdrArena (const NdrArena&);
+    NdrArena& operator= (const NdrArena&);
+    };
+
+#endif
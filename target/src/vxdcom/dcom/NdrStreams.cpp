@@ -5,6 +5,8 @@
 /*
 modification history
 --------------------
+01t,17oct26,agt  grow marshal buffers from NdrBufPool, allocate stub memory
+                 from a per-call NdrArena, add detach()
 01s,17dec01,nel  Add include symbol for diab build.
 01r,01oct01,nel  SPR#69557. Add extra padding bytes to make VT_BOOL type work.
 01q,13jul01,dbs  fix up includes
@@ -117,8 +119,6 @@ NdrMarshalStream::NdrMarshalStream
 
 NdrMarshalStream::~NdrMarshalStream ()
     {
-    if (m_bOwnMemory && m_buffer)
-        delete [] m_buffer;
     }
 
 //////////////////////////////////////////////////////////////////////////
@@ -191,28 +191,20 @@ HRESULT NdrMarshalStream::reserve (size_t nb)
             return E_UNEXPECTED;
         
         // Need to expand - make it worthwhile for small values of
-        // 'nb' by having a minimum expansion size of MINEXPAND...
+        // 'nb' by having a minimum expansion size of MINEXPAND. The
+        // buffer itself at least doubles each time it grows...
         const size_t MINEXPAND = 512;
         size_t expansion = (nb < MINEXPAND) ? MINEXPAND : nb;
 
-        // New total length 'len' is old total plus expansion...
-        size_t len = (m_end - m_buffer) + expansion;
+        m_mem.sizeSet (m_iptr - m_buffer);
+        HRESULT hr = m_mem.reserve (expansion);
+        if (FAILED (hr))
+            return hr;
 
-        // Allocate new memory...
-        byte* ptmp = new byte [len];
-        if (! ptmp)
-            return E_OUTOFMEMORY;
-
-        // Copy in previous contents, if there were any...
-        if (m_buffer)
-            memcpy (ptmp, m_buffer, m_iptr - m_buffer);
-
-        // update members and free previous buffer
-        m_end = ptmp + len;
-        m_iptr = ptmp + (m_iptr - m_buffer);
-        if (m_buffer)
-            delete [] m_buffer;
-        m_buffer = ptmp;
+        // update members to point into the (possibly new) memory
+        m_buffer = m_mem.begin ();
+        m_iptr = m_mem.end ();
+        m_end = m_buffer + m_mem.capacity ();
         }
     return S_OK;
     }
@@ -246,8 +238,37 @@ HRESULT NdrMarshalStream::insert
 
 //////////////////////////////////////////////////////////////////////////
 //
-// NdrUnmarshalStream ctor -- allocate stub-buffer (if in stub
-// unmarshal phase) of same size as supplied buffer...
+// NdrMarshalStream::detach -- hand the marshaled data over to
+// 'buf'. If the stream owns its memory, the memory itself changes
+// hands and nothing is copied, otherwise the data is copied out of
+// the user-supplied buffer. Either way the stream is left empty...
+//
+
+HRESULT NdrMarshalStream::detach (NdrBuffer& buf)
+    {
+    HRESULT hr = S_OK;
+
+    buf.clear ();
+
+    if (m_bOwnMemory)
+        {
+        m_mem.sizeSet (m_iptr - m_buffer);
+        buf.swap (m_mem);
+        m_buffer = m_iptr = m_end = 0;
+        }
+    else
+        {
+        hr = buf.append (m_buffer, m_iptr - m_buffer);
+        m_iptr = m_buffer;
+        }
+
+    return hr;
+    }
+
+//////////////////////////////////////////////////////////////////////////
+//
+// NdrUnmarshalStream ctor -- stub-side memory is allocated on demand
+// from the stream's arena, see stubAlloc()...
 //
 
 NdrUnmarshalStream::NdrUnmarshalStream
@@ -262,18 +283,8 @@ NdrUnmarshalStream::NdrUnmarshalStream
         m_optr (pb),
         m_end (pb + nb),
         m_phase (ph),
-        m_stubBuffer (0),
-        m_stubNext (0)
+        m_stubArena ()
     {
-    // If we are in the stub-unmarshaling pahse, its safe to allocate
-    // memory for stub variables (arrays, etc) from a private heap,
-    // which will automatically be reclaimed in the stream's dtor. We
-    // allocate twice the stream's stub-data size, just to be safe...
-    if (m_phase == NdrPhase::STUB_UNMSHL)
-        {
-        m_stubBuffer = new byte [2 * nb];
-        m_stubNext = m_stubBuffer;
-        }
     }
 
 //////////////////////////////////////////////////////////////////////////
@@ -281,15 +292,15 @@ NdrUnmarshalStream::NdrUnmarshalStream
 
 NdrUnmarshalStream::~NdrUnmarshalStream ()
     {
-    if (m_stubBuffer)
-        delete [] m_stubBuffer;
     }
 
 //////////////////////////////////////////////////////////////////////////
 //
 // NdrUnmarshalStream::stubAlloc -- allocate 'nb' bytes from the safe
-// stub memory. Since the stub-buffer is always as big as the original
-// packet stub-data, then it should never run out...
+// stub memory. If we are in the stub-unmarshaling phase, its safe to
+// allocate memory for stub variables (arrays, etc) from the stream's
+// private arena, which is reclaimed all at once when the stream is
+// destroyed at the end of the call...
 //
 
 byte* NdrUnmarshalStream::stubAlloc (size_t nb)
@@ -297,14 +308,7 @@ byte* NdrUnmarshalStream::stubAlloc (size_t nb)
     if (m_phase != NdrPhase::STUB_UNMSHL)
         return 0;
     
-    if (m_stubBuffer == 0)
-        return 0;
-
-    // Round up m_stubNext to multiple of 4...
-    m_stubNext = (byte*) (((ULONG)(m_stubNext + 3)) & ~3);
-    byte* p = m_stubNext;
-    m_stubNext += nb;
-    return p;
+    return m_stubArena.alloc (nb);
     }
 
 //////////////////////////////////////////////////////////////////////////
@@ -317,8 +321,7 @@ NdrUnmarshalStream::NdrUnmarshalStream ()
     m_optr (0),
     m_end (0),
     m_phase (NdrPhase::NOPHASE),
-    m_stubBuffer (0),
-        m_stubNext (0)
+    m_stubArena ()
     {
     }
 
@@ -338,9 +341,8 @@ NdrUnmarshalStream& NdrUnmarshalStream::operator=
     m_end = rhs.m_end;
     m_phase = rhs.m_phase;
 
-    // set stub-buffer ptrs to NULL...
-    m_stubBuffer = 0;
-    m_stubNext = 0;
+    // stub memory is never shared, just drop our own...
+    m_stubArena.reset ();
 
     return *this;
     }
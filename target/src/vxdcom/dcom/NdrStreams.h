@@ -6,6 +6,7 @@
 
 modification history
 --------------------
+01h,17oct26,agt  use pooled NdrBuffer and NdrArena memory, add detach()
 01g,01oct01,nel  SPR#69557. Add extra padding bytes to make VT_BOOL type work.
 01f,18sep00,nel  SPR#33730. Merge T2 OPC fixes into T3 branch.
 01e,25may99,dbs  make sure stream dtors free buffer memory
@@ -20,6 +21,7 @@ modification history
 #define __INCNdrStreams_h
 
 #include "dcomProxy.h"
+#include "NdrBuffer.h"
 
 //////////////////////////////////////////////////////////////////////////
 //
@@ -47,7 +49,9 @@ struct NdrPhase
 // marshaled into that buffer, until it is full. The second
 // constructor takes only the data-representation argument, and causes
 // the stream to internally allocate memory as required, so it can
-// cope with variable-sized marshaling easily.
+// cope with variable-sized marshaling easily. Internally-allocated
+// memory comes from the NdrBufPool, and can be handed on to an
+// NdrBuffer with detach() rather than being copied out.
 //
 
 class NdrMarshalStream
@@ -76,6 +80,9 @@ class NdrMarshalStream
 
     void addEndPadding (DWORD amount) { m_endPadding += amount; };
     DWORD getEndPadding () const { return m_endPadding; };
+
+    // move the marshaled data into 'buf', leaving the stream empty
+    HRESULT detach (NdrBuffer& buf);
     
   private:
     DREP		m_drep;		// data representation
@@ -83,6 +90,7 @@ class NdrMarshalStream
     byte*		m_iptr;		// insert pointer
     byte*		m_end;		// end of buffer
     bool		m_bOwnMemory;	// does it own the buffer mem?
+    NdrBuffer		m_mem;		// memory, if we own it
     NdrPhase::Phase_t	m_phase;	// marshaling phase
     DWORD		m_endPadding;	// extra padding to be added to 
     					// end of stream.
@@ -130,8 +138,7 @@ class NdrUnmarshalStream
     byte*		m_optr;		// extract pointer
     byte*		m_end;		// end of buffer
     NdrPhase::Phase_t	m_phase;	// marshaling phase
-    byte*		m_stubBuffer;	// stub-only buffer
-    byte*		m_stubNext;	// ptr into that buffer
+    NdrArena		m_stubArena;	// stub-only memory
     };
 
 
@@ -3,6 +3,8 @@
 /*
 modification history
 --------------------
+02y,17oct26,agt  add objectTokenSet() and objectAdopt(), lock table
+                 while iterating over it
 02x,17dec01,nel  Add include symbol for diab.
 02w,03aug01,dbs  re-instate ref-counting methods
 02v,30jul01,dbs  import T2 changes for RemAddRef and object ID
@@ -459,6 +461,34 @@ ObjectTableEntry* ObjectExporter::objectFindByIUnknown
 ////////////////////////////////////////////////////////////////////////////
 //
 
+void ObjectExporter::objectTokenSet
+    (
+    ObjectTableEntry*   pOTE,
+    DWORD               dwToken
+    )
+    {
+    TRACE_CALL;
+
+    m_objectTable.objectTokenSet (pOTE, dwToken);
+    }
+
+////////////////////////////////////////////////////////////////////////////
+//
+
+void ObjectExporter::objectAdopt
+    (
+    ObjectTableEntry*   pOTE,
+    IUnknown*           pUnk
+    )
+    {
+    TRACE_CALL;
+
+    m_objectTable.objectAdopt (pOTE, pUnk);
+    }
+
+////////////////////////////////////////////////////////////////////////////
+//
+
 bool ObjectExporter::objectUnregister (OID oid)
     {
     TRACE_CALL;
@@ -477,6 +507,7 @@ void ObjectExporter::objectUnregisterAll ()
     AddRef ();
 
     // Iterate over the table, releasing each object-table entry
+    m_objectTable.lock ();
     VxObjectTable::iterator i = m_objectTable.begin ();
     while (i != m_objectTable.end ())
         {
@@ -484,6 +515,7 @@ void ObjectExporter::objectUnregisterAll ()
         ++i;
         m_objectTable.objectUnregister (oid);
         }
+    m_objectTable.unlock ();
 
     // Remove the safeguard...
     Release ();
@@ -554,6 +586,7 @@ HRESULT ObjectExporter::tick (size_t nSecs)
     STL_VECTOR(OID) oidsToDelete;
     
     VxCritSec cs (m_mutex);
+    m_objectTable.lock ();
     VxObjectTable::iterator i = m_objectTable.begin ();
     while (i != m_objectTable.end ())
         {
@@ -577,6 +610,7 @@ HRESULT ObjectExporter::tick (size_t nSecs)
         S_DEBUG (LOG_OBJ_EXPORTER, "Deleting object OID=" << oidsToDelete [n] << endl);
         m_objectTable.objectUnregister (oidsToDelete [n]);
         }
+    m_objectTable.unlock ();
 
     return S_OK;
     }
@@ -6,6 +6,7 @@
 
 modification history
 --------------------
+02b,17oct26,agt  add objectTokenSet() and objectAdopt()
 02a,03aug01,dbs  re-instate ref-counting methods
 01z,30jul01,dbs  import later T2 changes
 01y,19jul01,dbs  fix include-path of Remoting.h
@@ -150,6 +151,10 @@ class ObjectExporter : public RpcIfServer, public IRemUnknown
     ObjectTableEntry* objectFindByToken (DWORD dwToken);
     ObjectTableEntry* objectFindByIUnknown (IUnknown*);
 
+    // methods to update indexed fields of a remoted object
+    void objectTokenSet (ObjectTableEntry*, DWORD dwToken);
+    void objectAdopt (ObjectTableEntry*, IUnknown* punk);
+
     // method to unregister a remoted object
     bool              objectUnregister (OID o);
 
@@ -6,6 +6,7 @@
 
 modification history
 --------------------
+01u,17oct26,agt  index by stream, token and IUnknown; use VxRWLock
 01t,17dec01,nel  Add include symbol for diab build.
 01s,30jul01,dbs  fix stupid bug in findByIUnknown as in T2 original
 01r,13jul01,dbs  fix up includes
@@ -110,7 +111,7 @@ ObjectTableEntry* VxObjectTable::objectRegister
     {
     TRACE_CALL;
 
-    VxCritSec cs (m_mutex);
+    VxWriteCritSec cs (m_rwlock);
 
     OID oidNew = SCM::theSCM()->nextOid ();
 
@@ -123,9 +124,29 @@ ObjectTableEntry* VxObjectTable::objectRegister
 
     m_objectTable [oidNew] = pOTE;
 
+    if (pstmItfPtr)
+	m_streamIndex [pstmItfPtr] = pOTE;
+
     return pOTE;
     }
 
+////////////////////////////////////////////////////////////////////////////
+//
+// VxObjectTable::oidFind -- look up an OID, caller must hold the lock
+//
+
+ObjectTableEntry* VxObjectTable::oidFind
+    (
+    OID            oid
+    ) const
+    {
+    OBJECTMAP::const_iterator i = m_objectTable.find (oid);
+    if (i == m_objectTable.end ())
+	return 0;
+    
+    return (*i).second;
+    }
+
 ////////////////////////////////////////////////////////////////////////////
 //
 
@@ -137,13 +158,9 @@ ObjectTableEntry* VxObjectTable::objectFindByOid
     TRACE_CALL;
 
     // Look for entry...
-    VxCritSec cs (m_mutex);
+    VxReadCritSec cs (m_rwlock);
 
-    OBJECTMAP::const_iterator i = m_objectTable.find (oid);
-    if (i == m_objectTable.end ())
-    return 0;
-    
-    return (*i).second;
+    return oidFind (oid);
     }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -156,21 +173,13 @@ ObjectTableEntry* VxObjectTable::objectFindByStream
     {
     TRACE_CALL;
 
+    VxReadCritSec cs (m_rwlock);
 
-    VxCritSec cs (m_mutex);
-
-    // Must do linear search, as the table key is OID...
-    OBJECTMAP::const_iterator i = m_objectTable.begin ();
-    while (i != m_objectTable.end ())
-    {
-    ObjectTableEntry*    pOTE = (*i).second;
-    
-    if (pOTE->pstmMarshaledItfPtr == pStm)
-        return pOTE;
-    ++i;
-    }
+    STREAMMAP::const_iterator i = m_streamIndex.find (pStm);
+    if (i == m_streamIndex.end ())
+	return 0;
     
-    return 0;
+    return (*i).second;
     }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -183,50 +192,106 @@ ObjectTableEntry* VxObjectTable::objectFindByToken
     {
     TRACE_CALL;
 
+    VxReadCritSec cs (m_rwlock);
 
-    VxCritSec cs (m_mutex);
+    TOKENMAP::const_iterator i = m_tokenIndex.find (dwToken);
+    if (i == m_tokenIndex.end ())
+	return 0;
+    
+    return (*i).second;
+    }
 
-    // Must do linear search, as table key is OID...
-    OBJECTMAP::const_iterator i = m_objectTable.begin ();
-    while (i != m_objectTable.end ())
+////////////////////////////////////////////////////////////////////////////
+//
+
+ObjectTableEntry* VxObjectTable::objectFindByIUnknown
+    (
+    IUnknown*	punk
+    )
     {
-    ObjectTableEntry*    pOTE  = (*i).second;
+    TRACE_CALL;
 
-    if (pOTE->dwRegToken == dwToken)
-        return pOTE;
-    ++i;
-    }
+    VxReadCritSec cs (m_rwlock);
+
+    PUNKMAP::const_iterator i = m_punkIndex.find (punk);
+    if (i == m_punkIndex.end ())
+	return 0;
     
-    // Not found, if we get here...
-    return 0;
+    return (*i).second;
     }
 
 ////////////////////////////////////////////////////////////////////////////
 //
+// VxObjectTable::objectTokenSet -- record the class-factory
+// registration token of an entry, and index it...
+//
 
-ObjectTableEntry* VxObjectTable::objectFindByIUnknown
+void VxObjectTable::objectTokenSet
     (
-    IUnknown*	punk
+    ObjectTableEntry*	pOTE,
+    DWORD		dwToken
     )
     {
     TRACE_CALL;
 
-    ObjectTableEntry*	pOTE = 0;
+    VxWriteCritSec cs (m_rwlock);
 
-    VxCritSec cs (m_mutex);
+    TOKENMAP::iterator i = m_tokenIndex.find (pOTE->dwRegToken);
+    if ((i != m_tokenIndex.end ()) && ((*i).second == pOTE))
+	m_tokenIndex.erase (i);
 
-    // Must do linear search, as table key is OID...
-    OBJECTMAP::const_iterator i = m_objectTable.begin ();
-    while (i != m_objectTable.end ())
-	{
-	pOTE = (*i).second;
+    pOTE->dwRegToken = dwToken;
+    if (dwToken)
+	m_tokenIndex [dwToken] = pOTE;
+    }
 
-	if (pOTE->stdStub.getIUnknown () == punk)
-            return pOTE;
-	++i;
-	}
-    
-    return 0;
+////////////////////////////////////////////////////////////////////////////
+//
+// VxObjectTable::objectAdopt -- make the entry's stub adopt the given
+// server object, and index the entry by the object's identity
+// IUnknown. The stub only adopts the first object it is given, so
+// this is a no-op for an entry which already has one...
+//
+
+void VxObjectTable::objectAdopt
+    (
+    ObjectTableEntry*	pOTE,
+    IUnknown*		punk
+    )
+    {
+    TRACE_CALL;
+
+    VxWriteCritSec cs (m_rwlock);
+
+    if (pOTE->stdStub.getIUnknown ())
+	return;
+
+    pOTE->stdStub.adopt (punk, pOTE->oid);
+
+    IUnknown* punkServer = pOTE->stdStub.getIUnknown ();
+    if (punkServer)
+	m_punkIndex [punkServer] = pOTE;
+    }
+
+////////////////////////////////////////////////////////////////////////////
+//
+// VxObjectTable::indexRemove -- remove all secondary-index references
+// to an entry, caller must hold the lock exclusively...
+//
+
+void VxObjectTable::indexRemove (ObjectTableEntry* pOTE)
+    {
+    STREAMMAP::iterator s = m_streamIndex.find (pOTE->pstmMarshaledItfPtr);
+    if ((s != m_streamIndex.end ()) && ((*s).second == pOTE))
+	m_streamIndex.erase (s);
+
+    TOKENMAP::iterator t = m_tokenIndex.find (pOTE->dwRegToken);
+    if ((t != m_tokenIndex.end ()) && ((*t).second == pOTE))
+	m_tokenIndex.erase (t);
+
+    PUNKMAP::iterator u = m_punkIndex.find (pOTE->stdStub.getIUnknown ());
+    if ((u != m_punkIndex.end ()) && ((*u).second == pOTE))
+	m_punkIndex.erase (u);
     }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -236,17 +301,19 @@ bool VxObjectTable::objectUnregister (OID oid)
     {
     TRACE_CALL;
 
-    size_t nErased = 0;
+    VxWriteCritSec cs (m_rwlock);
 
-    VxCritSec cs (m_mutex);
+    OBJECTMAP::iterator i = m_objectTable.find (oid);
+    if (i == m_objectTable.end ())
+	return false;
 
-    ObjectTableEntry* pOTE = objectFindByOid (oid);
+    ObjectTableEntry* pOTE = (*i).second;
+    m_objectTable.erase (i);
 
+    indexRemove (pOTE);
     DELZERO (pOTE);
 
-    nErased = m_objectTable.erase (oid);
-
-    return (nErased != 0);
+    return true;
     }
 
 //////////////////////////////////////////////////////////////////////////
@@ -260,7 +327,7 @@ bool VxObjectTable::supportsInterface (REFIID riid)
     bool bSupports = false;
     
     // Must do linear search, as table key is OID...
-    VxCritSec cs (m_mutex);
+    VxReadCritSec cs (m_rwlock);
     
     OBJECTMAP::iterator i = m_objectTable.begin ();
     while (i != m_objectTable.end ())
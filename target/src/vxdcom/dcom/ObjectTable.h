@@ -6,6 +6,7 @@
 
 modification history
 --------------------
+01p,17oct26,agt  add secondary indexes and readers/writer lock
 01o,13jul01,dbs  fix up includes
 01n,05mar01,nel  SPR#62130 - implement CoDisconnectObject.
 01m,20sep00,nel  Add changes made in T2 since branch.
@@ -79,10 +80,22 @@ struct ObjectTableEntry
 // VxObjectTable -- this class implements a type of RpcDispatchTable
 // which records all exported objects owned by an Object Exporter.
 //
+// The primary key is the OID, but the table also keeps secondary
+// indexes by marshaled-stream, by factory registration token and by
+// server IUnknown so that none of the objectFindByXXX() methods has
+// to walk the whole table. To keep those indexes in step, the
+// registration token and the stub's server object must be set via
+// objectTokenSet() and objectAdopt(), not by writing the entry
+// directly. Look-ups take the table lock shared, so concurrent ORPC
+// dispatch does not serialise on it; changes take it exclusively.
+//
 
 class VxObjectTable : public RpcDispatchTable
     {
     typedef STL_MAP_LL(ObjectTableEntry*) OBJECTMAP;
+    typedef STL_MAP(IStream*, ObjectTableEntry*) STREAMMAP;
+    typedef STL_MAP(DWORD, ObjectTableEntry*) TOKENMAP;
+    typedef STL_MAP(IUnknown*, ObjectTableEntry*) PUNKMAP;
 
   public:
 
@@ -105,21 +118,33 @@ class VxObjectTable : public RpcDispatchTable
     ObjectTableEntry* objectFindByIUnknown (IUnknown* punk);
     bool              objectUnregister (OID o);
 
+    // methods to update indexed fields of an existing entry
+    void objectTokenSet (ObjectTableEntry*, DWORD dwToken);
+    void objectAdopt (ObjectTableEntry*, IUnknown* punk);
+
     iterator begin () { return m_objectTable.begin (); }
     iterator end () { return m_objectTable.end (); }
 
     const_iterator begin () const { return m_objectTable.begin (); }
     const_iterator end () const { return m_objectTable.end (); }
 
-    void lock () { m_mutex.lock (); }
-    void unlock () { m_mutex.unlock (); }
+    // exclusive lock, for iterating over the table while it may be
+    // modified -- the objectXXX() methods may still be called
+    void lock () { m_rwlock.writeLock (); }
+    void unlock () { m_rwlock.writeUnlock (); }
 
     void printOn (ostream&) const;
 
   private:
 
-    VxMutex		m_mutex;	// for task safety
+    ObjectTableEntry* oidFind (OID o) const;
+    void              indexRemove (ObjectTableEntry*);
+
+    VxRWLock		m_rwlock;	// for task safety
     OBJECTMAP		m_objectTable;	// OID -> ObjectTableEntry
+    STREAMMAP		m_streamIndex;	// IStream* -> ObjectTableEntry
+    TOKENMAP		m_tokenIndex;	// reg token -> ObjectTableEntry
+    PUNKMAP		m_punkIndex;	// IUnknown* -> ObjectTableEntry
 
     };
 
@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01z,17oct26,agt  adopt via exporter so object table stays indexed
 01y,17dec01,nel  Add include symbol for diab.
 01x,13jul01,dbs  fix up includes
 01w,16jul99,aim  replace resolverAddressGet => rpcAddressFormat
@@ -157,8 +158,7 @@ HRESULT VxStdMarshaler::MarshalInterface
     ObjectTableEntry* pOTE = px->objectFindByOid (m_oid);
     if (pOTE)
 	{
-	pOTE->stdStub.adopt (reinterpret_cast<IUnknown*> (pvInterface),
-			     m_oid);
+	px->objectAdopt (pOTE, reinterpret_cast<IUnknown*> (pvInterface));
 
 	hr = pOTE->stdStub.interfaceAdd (riid, cRefs, &ipidNew);
 	if (FAILED (hr))
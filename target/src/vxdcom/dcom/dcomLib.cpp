@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+04a,17oct26,agt  set CF registration token via object exporter
 03z,03jan02,nel  Remove OLE2T.
 03y,17dec01,nel  Add include sybmol for diab build.
 03x,02nov01,nel  Correct docs errors.
@@ -318,7 +319,7 @@ HRESULT CoRegisterClassObject
 	{
 	pOTE->punkCF = pUnkCF;
 	pOTE->clsid = rclsid;
-	pOTE->dwRegToken = dwRegister;
+	px->objectTokenSet (pOTE, dwRegister);
 	}
     *lpdwRegister = dwRegister;
     
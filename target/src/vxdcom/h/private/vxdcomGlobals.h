@@ -5,6 +5,8 @@
 /*
 modification history
 --------------------
+01g,17oct26,agt  add g_vxdcomNdrBufCacheMax
+01f,17oct26,agt  add g_vxdcomThreadPoolQueueSize
 01e,02aug01,dbs  add globals for SCM task stack and prio
 01d,18jul01,dbs  move g_defaultServerPriority to comCoreLib
 01c,17aug99,aim  added g_vxdcomExportAddress globals
@@ -33,6 +35,12 @@ __EC__ int g_vxdcomMaxThreads __I(5);
 
 __EC__ int g_vxdcomThreadPoolPriority __I(100);
 
+__EC__ int g_vxdcomThreadPoolQueueSize __I(64);
+// slots in the thread-pool ring queue, 0 == use the original list queue
+
+__EC__ int g_vxdcomNdrBufCacheMax __I(16);
+// free NDR buffers cached per size class, 0 == no caching
+
 __EC__ DWORD g_defaultAuthnLevel __I(RPC_C_AUTHN_LEVEL_NONE);
 
 __EC__ DWORD g_defaultImpLevel __I(RPC_C_IMP_LEVEL_ANONYMOUS);
@@ -0,0 +1,192 @@
+/* EpollDemux - epoll based EventDemux for the Linux debug build */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created
+*/
+
+#include "EpollDemux.h"
+#include "TraceCall.h"
+
+/* Include symbol for diab */
+extern "C" int include_vxdcom_EpollDemux (void)
+    {
+    return 0;
+    }
+
+#ifdef VXDCOM_PLATFORM_LINUX
+
+EpollDemux::EpollDemux (int maxEvents)
+  : m_epollFd (-1),
+    m_maxEvents (maxEvents),
+    m_events (0),
+    m_interest (),
+    m_mutex ()
+    {
+    TRACE_CALL;
+
+    m_events = new epoll_event [m_maxEvents];
+
+    if (m_events)
+	m_epollFd = ::epoll_create (m_maxEvents);
+
+    if (m_epollFd < 0)
+	S_ERR (LOG_REACTOR | LOG_ERRNO, "EpollDemux: epoll_create failed");
+    }
+
+EpollDemux::~EpollDemux ()
+    {
+    TRACE_CALL;
+
+    if (m_epollFd >= 0)
+	::close (m_epollFd);
+
+    delete [] m_events;
+    }
+
+bool EpollDemux::isOpen () const
+    {
+    return m_epollFd >= 0;
+    }
+
+const char* EpollDemux::name () const
+    {
+    return "epoll";
+    }
+
+int EpollDemux::interestSet
+    (
+    REACTOR_HANDLE	handle,
+    REACTOR_EVENT_MASK	oldMask,
+    REACTOR_EVENT_MASK	newMask
+    )
+    {
+    epoll_event ev;
+    int op;
+
+    ::memset (&ev, 0, sizeof (ev));
+
+    ev.data.fd = handle;
+
+    if (newMask & EventHandler::READ_MASK)
+	ev.events |= EPOLLIN;
+
+    if (newMask & EventHandler::WRITE_MASK)
+	ev.events |= EPOLLOUT;
+
+    if (oldMask == EventHandler::NULL_MASK)
+	op = EPOLL_CTL_ADD;
+    else if (newMask == EventHandler::NULL_MASK)
+	op = EPOLL_CTL_DEL;
+    else
+	op = EPOLL_CTL_MOD;
+
+    return ::epoll_ctl (m_epollFd, op, handle, &ev);
+    }
+
+int EpollDemux::handleBind
+    (
+    REACTOR_HANDLE	handle,
+    REACTOR_EVENT_MASK	mask
+    )
+    {
+    TRACE_CALL;
+
+    VxCritSec cs (m_mutex);
+
+    REACTOR_EVENT_MASK oldMask = m_interest [handle];
+    REACTOR_EVENT_MASK newMask = oldMask | mask;
+
+    if (newMask == oldMask)
+	return 0;
+
+    if (interestSet (handle, oldMask, newMask) < 0)
+	{
+	if (oldMask == EventHandler::NULL_MASK)
+	    m_interest.erase (handle);
+	return -1;
+	}
+
+    m_interest [handle] = newMask;
+
+    return 0;
+    }
+
+int EpollDemux::handleUnbind
+    (
+    REACTOR_HANDLE	handle,
+    REACTOR_EVENT_MASK	mask
+    )
+    {
+    TRACE_CALL;
+
+    VxCritSec cs (m_mutex);
+
+    InterestMap::iterator iter = m_interest.find (handle);
+
+    if (iter == m_interest.end ())
+	return 0;
+
+    REACTOR_EVENT_MASK oldMask = (*iter).second;
+    REACTOR_EVENT_MASK newMask = oldMask & ~mask;
+
+    if (newMask == oldMask)
+	return 0;
+
+    // The handle may already have been closed, in which case the
+    // kernel has dropped it from the epoll set itself.
+
+    interestSet (handle, oldMask, newMask);
+
+    if (newMask == EventHandler::NULL_MASK)
+	m_interest.erase (iter);
+    else
+	(*iter).second = newMask;
+
+    return 0;
+    }
+
+int EpollDemux::wait
+    (
+    EventList&	readyEvents,
+    TimeValue*	timeout
+    )
+    {
+    TRACE_CALL;
+
+    int msec = -1;
+
+    if (timeout)
+	msec = timeout->sec () * 1000 + (timeout->usec () + 999) / 1000;
+
+    int n = ::epoll_wait (m_epollFd, m_events, m_maxEvents, msec);
+
+    if (n < 0)
+	return (errno == EINTR) ? 0 : -1;
+
+    for (int i = 0; i < n; ++i)
+	{
+	Event event;
+
+	event.handle = m_events[i].data.fd;
+	event.mask = EventHandler::NULL_MASK;
+
+	// Errors and hangups are reported as readable so the handler
+	// gets to see the failing read and close itself down.
+
+	if (m_events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+	    event.mask |= EventHandler::READ_MASK;
+
+	if (m_events[i].events & EPOLLOUT)
+	    event.mask |= EventHandler::WRITE_MASK;
+
+	readyEvents.push_back (event);
+	}
+
+    return n;
+    }
+
+#endif // VXDCOM_PLATFORM_LINUX
@@ -0,0 +1,53 @@
+/* EpollDemux - epoll based EventDemux for the Linux debug build */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created
+*/
+
+#ifndef __INCEpollDemux_h
+#define __INCEpollDemux_h
+
+#include "EventDemux.h"
+
+#ifdef VXDCOM_PLATFORM_LINUX
+
+#include "sys/epoll.h"
+
+// Level-triggered epoll backend.  The kernel keeps the interest set,
+// so binding is one epoll_ctl() per change and wait() only touches
+// ready handles.
+
+class EpollDemux : public EventDemux
+    {
+  public:
+
+    EpollDemux (int maxEvents = 64);
+    virtual ~EpollDemux ();
+
+    bool isOpen () const;
+
+    virtual int handleBind (REACTOR_HANDLE, REACTOR_EVENT_MASK);
+    virtual int handleUnbind (REACTOR_HANDLE, REACTOR_EVENT_MASK);
+    virtual int wait (EventList&, TimeValue*);
+    virtual const char* name () const;
+
+  private:
+
+    typedef STL_MAP (REACTOR_HANDLE, REACTOR_EVENT_MASK) InterestMap;
+
+    int interestSet (REACTOR_HANDLE, REACTOR_EVENT_MASK, REACTOR_EVENT_MASK);
+
+    int			m_epollFd;
+    int			m_maxEvents;
+    epoll_event*	m_events;
+    InterestMap		m_interest;
+    VxMutex		m_mutex; // protect m_interest
+    };
+
+#endif // VXDCOM_PLATFORM_LINUX
+
+#endif // __INCEpollDemux_h
@@ -0,0 +1,72 @@
+/* EventDemux - Readiness demultiplexer interface used by Reactor */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created
+*/
+
+#include "EventDemux.h"
+#include "SelectDemux.h"
+#include "TraceCall.h"
+
+#if defined (VXDCOM_PLATFORM_LINUX)
+#include "EpollDemux.h"
+#elif defined (VXDCOM_PLATFORM_VXWORKS)
+#include "SelSetDemux.h"
+#endif
+
+/* Include symbol for diab */
+extern "C" int include_vxdcom_EventDemux (void)
+    {
+    return 0;
+    }
+
+EventDemux::EventDemux ()
+    {
+    TRACE_CALL;
+    }
+
+EventDemux::~EventDemux ()
+    {
+    TRACE_CALL;
+    }
+
+int EventDemux::rearm
+    (
+    REACTOR_HANDLE,
+    REACTOR_EVENT_MASK
+    )
+    {
+    return 0;
+    }
+
+EventDemux* EventDemux::create ()
+    {
+    TRACE_CALL;
+
+    EventDemux* demux = 0;
+
+#if defined (VXDCOM_PLATFORM_LINUX)
+    EpollDemux* epollDemux = new EpollDemux ();
+
+    if (epollDemux && epollDemux->isOpen ())
+	demux = epollDemux;
+    else
+	delete epollDemux;
+#elif defined (VXDCOM_PLATFORM_VXWORKS)
+    SelSetDemux* selSetDemux = new SelSetDemux ();
+
+    if (selSetDemux && selSetDemux->isOpen ())
+	demux = selSetDemux;
+    else
+	delete selSetDemux;
+#endif
+
+    if (demux == 0)
+	demux = new SelectDemux ();
+
+    return demux;
+    }
@@ -0,0 +1,91 @@
+/* EventDemux - Readiness demultiplexer interface used by Reactor */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created
+*/
+
+#ifndef __INCEventDemux_h
+#define __INCEventDemux_h
+
+#include "ReactorTypes.h"
+#include "EventHandler.h"
+#include "TimeValue.h"
+#include "private/comMisc.h"
+#include "private/comStl.h"
+
+// An EventDemux owns the interest set of a Reactor.  Handles are
+// bound and unbound incrementally as EventHandlers come and go, and
+// wait() returns only the handles that are ready, so the cost of an
+// event-loop iteration does not depend on the number of idle handles.
+//
+// Masks passed to and returned from an EventDemux only ever contain
+// EventHandler::READ_MASK and/or EventHandler::WRITE_MASK; Reactor
+// folds ACCEPT_MASK and CONNECT_MASK into READ_MASK before binding.
+
+class EventDemux
+    {
+  public:
+
+    struct Event
+	{
+	REACTOR_HANDLE		handle;
+	REACTOR_EVENT_MASK	mask;
+	};
+
+    typedef STL_VECTOR (Event) EventList;
+
+    virtual ~EventDemux ();
+
+    virtual int handleBind
+	(
+	REACTOR_HANDLE		handle,
+	REACTOR_EVENT_MASK	mask
+	) = 0;
+    // Add <mask> to the events of interest for <handle>.
+
+    virtual int handleUnbind
+	(
+	REACTOR_HANDLE		handle,
+	REACTOR_EVENT_MASK	mask
+	) = 0;
+    // Remove <mask> from the events of interest for <handle>.
+
+    virtual int wait
+	(
+	EventList&		readyEvents,
+	TimeValue*		timeout
+	) = 0;
+    // Append the ready handles to <readyEvents>, waiting at most
+    // <timeout> (forever if 0).  Returns the number of events
+    // appended, 0 on timeout or -1 on error.
+
+    virtual int rearm
+	(
+	REACTOR_HANDLE		handle,
+	REACTOR_EVENT_MASK	mask
+	);
+    // Called once a ready handle has been serviced.  Edge-reporting
+    // backends use this to pick up data left unread by the handler.
+
+    virtual const char* name () const = 0;
+
+    static EventDemux* create ();
+    // Create the preferred demultiplexer for this platform, falling
+    // back to select() if it cannot be initialised.
+
+  protected:
+
+    EventDemux ();
+
+  private:
+
+    // unsupported
+    EventDemux (const EventDemux&);
+    EventDemux& operator= (const EventDemux&);
+    };
+
+#endif // __INCEventDemux_h
@@ -5,6 +5,8 @@
 /*
 modification history
 --------------------
+01w,17oct26,agt  wait for events through an EventDemux instead of
+                 rebuilding select() masks on every pass
 01v,17dec01,nel  Add include symbol for diab build.
 01u,10dec01,dbs  diab build
 01t,20sep01,nel  Fix compilation for ARM.
@@ -47,10 +49,30 @@ extern "C" int include_vxdcom_Reactor (void)
 #include "selectLib.h"
 #endif
 
+// Reduce a Reactor event mask to the READ_MASK/WRITE_MASK form
+// understood by the EventDemux.
+
+static REACTOR_EVENT_MASK demuxMask (REACTOR_EVENT_MASK eventMask)
+    {
+    REACTOR_EVENT_MASK mask = EventHandler::NULL_MASK;
+
+    if (eventMask & (EventHandler::READ_MASK |
+		     EventHandler::ACCEPT_MASK |
+		     EventHandler::CONNECT_MASK))
+	mask |= EventHandler::READ_MASK;
+
+    if (eventMask & EventHandler::WRITE_MASK)
+	mask |= EventHandler::WRITE_MASK;
+
+    return mask;
+    }
+
 Reactor::Reactor ()
   : m_rdHandles (),
     m_wrHandles (),
     m_exHandles (),
+    m_demux (EventDemux::create ()),
+    m_readyEvents (),
     m_endEventLoop (false),
     m_wakeupHandler (this),
     m_handle2handlerMap (),
@@ -94,6 +116,8 @@ Reactor::~Reactor ()
 	if (eventHandler)
 	    eventHandler->handleClose (handle);
 	}
+
+    delete m_demux;
     }
 
 int Reactor::run ()
@@ -228,44 +252,11 @@ int Reactor::handlerFind
     return 0;
     }
 
-int Reactor::select
-    (
-    int		nHandles,
-    HandleSet*	rdSet,
-    HandleSet*	wrSet,
-    HandleSet*  exSet,
-    TimeValue*	timeout
-    )
-    {
-    timeval* t = 0;
-
-    if (timeout)
-	t = *timeout;
-
-    REACTOR_HANDLE_SET_TYPE* r = 
-		rdSet ? *rdSet : (REACTOR_HANDLE_SET_TYPE *)NULL;
-    REACTOR_HANDLE_SET_TYPE* w = 
-		wrSet ? *wrSet : (REACTOR_HANDLE_SET_TYPE *)NULL;
-    REACTOR_HANDLE_SET_TYPE* e = 
-		exSet ? *exSet : (REACTOR_HANDLE_SET_TYPE *)NULL;
-
-#ifdef VXDCOM_PLATFORM_VXWORKS
-    errno = 0;
-#endif
-    
-    return ::select (nHandles, r, w, e, t);
-    }
-
 int Reactor::handleEvents ()
     {
     TRACE_CALL;
 
-    HandleSet rdSet (m_rdHandles);
-    HandleSet wrSet (m_wrHandles);
-    HandleSet exSet; // (m_exHandles);
-
     int haveTimer = 0;
-    int maxHandle = max (rdSet.maxHandle (), wrSet.maxHandle ());
 
     TimeValue timeout;
 
@@ -279,16 +270,14 @@ int Reactor::handleEvents ()
 
     TimeValue startTime = TimeValue::now ();
 
-    int selectFds = select (maxHandle +1,
-			    (rdSet.count () > 0) ? &rdSet : 0,
-			    (wrSet.count () > 0) ? &wrSet : 0,
-			    (exSet.count () > 0) ? &exSet : 0,
-			    haveTimer ? &timeout : 0);
+    m_readyEvents.clear ();
+
+    int readyFds = m_demux->wait (m_readyEvents, haveTimer ? &timeout : 0);
 
     if (m_endEventLoop)
 	return 0;
 
-    if (selectFds < 0)
+    if (readyFds < 0)
 	return -1;
 
     if (haveTimer)
@@ -297,67 +286,39 @@ int Reactor::handleEvents ()
     if (haveTimer)
 	dispatchTimers ();
 
-    if (selectFds > 0)
-	{
-	rdSet.sync (maxHandle +1);
-	wrSet.sync (maxHandle +1);
-	exSet.sync (maxHandle +1);
-	dispatchFdEvents (rdSet, wrSet, exSet);
-	}
+    if (readyFds > 0)
+	dispatchFdEvents (m_readyEvents);
 
     return 0;
     }
 
 int Reactor::dispatchFdEvents
     (
-    HandleSet&	rdSet,
-    HandleSet&	wrSet,
-    HandleSet&	exSet
+    EventDemux::EventList&	readyEvents
     )
     {
-    // exceptions not supported on vxWorks
-    // dispatchFdEvents (exSet,
-    //	               m_exHandles,
-    //	               EventHandler::EXCEPT_MASK,
-    //	               &EventHandler::handleException);
-
-    if (rdSet.count () > 0)
-	{
-	dispatchFdEvents (rdSet,
-			  m_rdHandles,
-			  EventHandler::READ_MASK,
-			  &EventHandler::handleInput);
-	}
+    TRACE_CALL;
 
-#if 0
-    if (wrSet.count () > 0)
-	{
-	dispatchFdEvents (wrSet,
-			  m_wrHandles,
-			  EventHandler::WRITE_MASK,
-			  &EventHandler::handleOutput);
-	}
-#endif
+    // exceptions not supported on vxWorks, and write events are not
+    // dispatched (see handleOutput).
 
-    return 0;
-    }
-
-int Reactor::dispatchFdEvents
-    (
-    HandleSet&			selectHandles,
-    HandleSet&	       		reactorHandles,
-    REACTOR_EVENT_MASK		mask,
-    EventHandlerCallback	callback
-    )
-    {
-    TRACE_CALL;
+    EventDemux::EventList::iterator iter (readyEvents.begin ());
 
-    REACTOR_HANDLE handle;
+    for (; iter != readyEvents.end (); ++iter)
+	{
+	if (((*iter).mask & EventHandler::READ_MASK) == 0)
+	    continue;
 
-    HandleSetIterator hsIter (selectHandles);
+	REACTOR_HANDLE handle = (*iter).handle;
 
-    while ((handle = hsIter ()) != INVALID_REACTOR_HANDLE)
-	dispatchFdEvent (reactorHandles, handle, mask, callback);
+	if (dispatchFdEvent (m_rdHandles,
+			     handle,
+			     EventHandler::READ_MASK,
+			     &EventHandler::handleInput) >= 0)
+	    {
+	    m_demux->rearm (handle, EventHandler::READ_MASK);
+	    }
+	}
 
     return 0;
     }
@@ -424,7 +385,7 @@ int Reactor::handlerBind
     if (eventMask & EventHandler::EXCEPT_MASK)
 	m_exHandles.set (handle);
 
-    return 0;
+    return m_demux->handleBind (handle, demuxMask (eventMask));
     }
 
 int Reactor::handlerUnbind
@@ -456,6 +417,8 @@ int Reactor::handlerUnbind
     if (eventMask & EventHandler::EXCEPT_MASK)
 	m_exHandles.clr (handle);
 
+    m_demux->handleUnbind (handle, demuxMask (eventMask));
+
     if ((eventMask & EventHandler::DONT_CALL) == 0)
 	eventHandler->handleClose (handle, eventMask);
 
@@ -486,9 +449,16 @@ const HandleSet& Reactor::exHandles () const
     return m_exHandles;
     }
 
+const EventDemux& Reactor::demux () const
+    {
+    TRACE_CALL;
+    return *m_demux;
+    }
+
 ostream& operator<< (ostream& os, const Reactor& r)
     {
-    os << "read-mask ("
+    os << r.demux ().name ()
+       << " read-mask ("
        << r.rdHandles ()
        << ") ";
 #if 0
@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01l,17oct26,agt  delegate readiness tracking to an EventDemux
 01k,13jul01,dbs  fix up includes
 01j,16nov99,nel  Mod to get round compiler differences between T2 and T3 in
                  timerAdd
@@ -24,6 +25,7 @@ modification history
 
 #include "ReactorTypes.h"
 #include "EventHandler.h"
+#include "EventDemux.h"
 #include "HandleSet.h"
 #include "TimeValue.h"
 #include "private/comMisc.h"
@@ -105,6 +107,8 @@ class Reactor
     const HandleSet& wrHandles () const;
     const HandleSet& exHandles () const;
 
+    const EventDemux& demux () const;
+
     static Reactor* instance ();
 
     friend ostream& operator<< (ostream& os, const Reactor&);
@@ -141,17 +145,7 @@ class Reactor
 
     int dispatchFdEvents
 	(
-	HandleSet&		rdSet,
-	HandleSet&		wrSet,
-	HandleSet&		exSet
-	);
-
-    int dispatchFdEvents
-	(
-	HandleSet&		selectHandles,
-	HandleSet&		reactorHandles,
-	REACTOR_EVENT_MASK	mask,
-	EventHandlerCallback	callback
+	EventDemux::EventList&	readyEvents
 	);
 
     int dispatchFdEvent
@@ -180,20 +174,13 @@ class Reactor
 	TimeValue&		timeValue
 	);
 
-    int select
-	(
-	int			nHandles,
-	HandleSet*		rdSet,
-	HandleSet*		wrSet,
-	HandleSet*		exSet,
-	TimeValue*		timeout
-	);
-
     int wakeup ();
     
     HandleSet			m_rdHandles;
     HandleSet			m_wrHandles;
     HandleSet			m_exHandles;
+    EventDemux*			m_demux;
+    EventDemux::EventList	m_readyEvents; // reactor task only
     bool			m_endEventLoop;
     WakeupHandler		m_wakeupHandler;
     Handle2HandlerMap		m_handle2handlerMap;
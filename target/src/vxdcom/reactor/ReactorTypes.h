@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01b,17oct26,agt  include uio headers for struct iovec
 01a,13jul01,dbs  fix up includes, remove win32 refs
 */
 
@@ -31,6 +32,7 @@ modification history
 #ifdef VXDCOM_PLATFORM_VXWORKS
 #include "vxWorks.h"
 #include "sockLib.h"
+#include "net/uio.h"
 #include "hostLib.h"
 #include "inetLib.h"
 #include "selectLib.h"
@@ -43,6 +45,7 @@ modification history
 
 #ifdef VXDCOM_PLATFORM_SOLARIS
 #include "sys/socket.h"
+#include "sys/uio.h"
 #include "netinet/in.h"
 #include "arpa/inet.h"
 #include "netdb.h"
@@ -56,6 +59,7 @@ modification history
 
 #ifdef VXDCOM_PLATFORM_LINUX
 #include "sys/socket.h"
+#include "sys/uio.h"
 #include "netinet/in.h"
 #include "arpa/inet.h"
 #include "netdb.h"
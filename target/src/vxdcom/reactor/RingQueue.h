@@ -0,0 +1,78 @@
+/* RingQueue - bounded multi-producer/multi-consumer queue */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created
+*/
+
+#ifndef __INCRingQueue_h
+#define __INCRingQueue_h
+
+#include "comCoreLib.h"
+#include "private/comMisc.h"
+
+// A fixed-size ring of slots, each carrying a sequence number that
+// tells producers and consumers whether it is free or full for the
+// current lap.  Positions are claimed with comSafeCas() so the fast
+// path never takes a semaphore and never allocates; add() and
+// remove() only fall back to blocking on a condition variable when
+// the ring is full or empty respectively.
+
+template <class T>
+class RingQueue
+    {
+  public:
+
+    RingQueue (size_t capacity = 0);
+    ~RingQueue ();
+
+    bool open (size_t capacity);
+    // Allocate the ring; <capacity> is rounded up to a power of two.
+
+    bool tryAdd (const T& t);
+    // Non-blocking; returns false if the ring is full.
+
+    bool tryRemove (T& t);
+    // Non-blocking; returns false if the ring is empty.
+
+    void add (const T& t);
+    // Block while the ring is full.
+
+    void remove (T& t);
+    // Block while the ring is empty.
+
+    size_t size () const;
+    size_t capacity () const;
+
+  private:
+
+    struct Cell
+	{
+	long	seq;
+	T	data;
+	};
+
+    void wakeConsumer ();
+    void wakeProducer ();
+
+    Cell*		m_cells;
+    long		m_mask;
+    long		m_enqPos;
+    long		m_deqPos;
+    long		m_emptyWaiters;
+    long		m_fullWaiters;
+    VxMutex		m_waitLock;
+    VxCondVar		m_notEmpty;
+    VxCondVar		m_notFull;
+
+    // unsupported
+    RingQueue (const RingQueue&);
+    RingQueue& operator= (const RingQueue&);
+    };
+
+#include "RingQueue.tcc"
+
+#endif // __INCRingQueue_h
@@ -0,0 +1,191 @@
+/* RingQueue - bounded multi-producer/multi-consumer queue */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created
+*/
+
+#include "RingQueue.h"
+#include "TraceCall.h"
+
+template <class T> RingQueue<T>::RingQueue (size_t capacity)
+  : m_cells (0),
+    m_mask (0),
+    m_enqPos (0),
+    m_deqPos (0),
+    m_emptyWaiters (0),
+    m_fullWaiters (0),
+    m_waitLock (),
+    m_notEmpty (),
+    m_notFull ()
+    {
+    if (capacity)
+	open (capacity);
+    }
+
+template <class T> RingQueue<T>::~RingQueue ()
+    {
+    delete [] m_cells;
+    }
+
+template <class T>
+bool RingQueue<T>::open (size_t capacity)
+    {
+    size_t n = 2;
+
+    while (n < capacity)
+	n <<= 1;
+
+    delete [] m_cells;
+
+    if ((m_cells = new Cell [n]) == 0)
+	{
+	m_mask = 0;
+	return false;
+	}
+
+    for (size_t i = 0; i < n; ++i)
+	m_cells [i].seq = i;
+
+    m_mask = n - 1;
+    m_enqPos = 0;
+    m_deqPos = 0;
+
+    return true;
+    }
+
+template <class T>
+bool RingQueue<T>::tryAdd (const T& t)
+    {
+    if (m_cells == 0)
+	return false;
+
+    Cell* cell;
+    long pos = m_enqPos;
+
+    for (;;)
+	{
+	cell = &m_cells [pos & m_mask];
+
+	long dif = cell->seq - pos;
+
+	if (dif == 0)
+	    {
+	    if (::comSafeCas (&m_enqPos, pos, pos + 1))
+		break;
+	    }
+	else if (dif < 0)
+	    return false;		// full
+
+	pos = m_enqPos;
+	}
+
+    cell->data = t;
+    cell->seq = pos + 1;		// publish to consumers
+
+    if (m_emptyWaiters)
+	wakeConsumer ();
+
+    return true;
+    }
+
+template <class T>
+bool RingQueue<T>::tryRemove (T& t)
+    {
+    if (m_cells == 0)
+	return false;
+
+    Cell* cell;
+    long pos = m_deqPos;
+
+    for (;;)
+	{
+	cell = &m_cells [pos & m_mask];
+
+	long dif = cell->seq - (pos + 1);
+
+	if (dif == 0)
+	    {
+	    if (::comSafeCas (&m_deqPos, pos, pos + 1))
+		break;
+	    }
+	else if (dif < 0)
+	    return false;		// empty
+
+	pos = m_deqPos;
+	}
+
+    t = cell->data;
+    cell->seq = pos + m_mask + 1;	// hand back to producers
+
+    if (m_fullWaiters)
+	wakeProducer ();
+
+    return true;
+    }
+
+template <class T>
+void RingQueue<T>::add (const T& t)
+    {
+    if (tryAdd (t))
+	return;
+
+    // Slow path.  The waiter count is raised before the final retry,
+    // so a consumer that frees a slot after our failed attempt is
+    // guaranteed to see it and signal us.
+
+    VxCritSec cs (m_waitLock);
+
+    ::comSafeInc (&m_fullWaiters);
+
+    while (! tryAdd (t))
+	m_notFull.wait (m_waitLock);
+
+    ::comSafeDec (&m_fullWaiters);
+    }
+
+template <class T>
+void RingQueue<T>::remove (T& t)
+    {
+    if (tryRemove (t))
+	return;
+
+    VxCritSec cs (m_waitLock);
+
+    ::comSafeInc (&m_emptyWaiters);
+
+    while (! tryRemove (t))
+	m_notEmpty.wait (m_waitLock);
+
+    ::comSafeDec (&m_emptyWaiters);
+    }
+
+template <class T>
+void RingQueue<T>::wakeConsumer ()
+    {
+    VxCritSec cs (m_waitLock);
+    m_notEmpty.signal ();
+    }
+
+template <class T>
+void RingQueue<T>::wakeProducer ()
+    {
+    VxCritSec cs (m_waitLock);
+    m_notFull.signal ();
+    }
+
+template <class T>
+size_t RingQueue<T>::size () const
+    {
+    long n = m_enqPos - m_deqPos;
+    return (n > 0) ? n : 0;
+    }
+
+template <class T>
+size_t RingQueue<T>::capacity () const
+    {
+    return m_cells ? m_mask + 1 : 0;
+    }
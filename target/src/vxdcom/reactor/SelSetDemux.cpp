@@ -0,0 +1,199 @@
+/* SelSetDemux - selSetLib based EventDemux for VxWorks */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01b,17oct26,agt  wait() takes the ready queue instead of scanning masks
+01a,17oct26,agt  created
+*/
+
+#include "SelSetDemux.h"
+#include "TraceCall.h"
+
+/* Include symbol for diab */
+extern "C" int include_vxdcom_SelSetDemux (void)
+    {
+    return 0;
+    }
+
+#ifdef VXDCOM_PLATFORM_VXWORKS
+
+#include "taskLib.h"
+
+SelSetDemux::SelSetDemux (int maxEvents)
+  : SelectDemux (),
+    m_selSet (0),
+    m_ownerTask (0),
+    m_maxEvents (maxEvents),
+    m_events (0)
+    {
+    TRACE_CALL;
+
+    m_events = new SEL_SET_EVENT [m_maxEvents];
+    }
+
+SelSetDemux::~SelSetDemux ()
+    {
+    TRACE_CALL;
+
+    if (m_selSet)
+	::selSetDelete (m_selSet);
+
+    delete [] m_events;
+    }
+
+bool SelSetDemux::isOpen () const
+    {
+    return m_events != 0;
+    }
+
+const char* SelSetDemux::name () const
+    {
+    return m_selSet ? "selSet" : "select";
+    }
+
+int SelSetDemux::selSetOpen ()
+    {
+    TRACE_CALL;
+
+    VxCritSec cs (m_mutex);
+
+    if (m_selSet)
+	::selSetDelete (m_selSet);
+
+    m_ownerTask = ::taskIdSelf ();
+
+    if ((m_selSet = ::selSetCreate ()) == 0)
+	{
+	S_ERR (LOG_REACTOR | LOG_ERRNO,
+	       "SelSetDemux: selSetCreate failed, using select()");
+	return -1;
+	}
+
+    HandleSetIterator rdIter (m_rdHandles);
+    HandleSetIterator wrIter (m_wrHandles);
+    REACTOR_HANDLE handle;
+
+    while ((handle = rdIter ()) != INVALID_REACTOR_HANDLE)
+	::selSetAdd (m_selSet, handle, SELREAD);
+
+    while ((handle = wrIter ()) != INVALID_REACTOR_HANDLE)
+	::selSetAdd (m_selSet, handle, SELWRITE);
+
+    return 0;
+    }
+
+int SelSetDemux::handleBind
+    (
+    REACTOR_HANDLE	handle,
+    REACTOR_EVENT_MASK	mask
+    )
+    {
+    TRACE_CALL;
+
+    VxCritSec cs (m_mutex);
+
+    SelectDemux::handleBind (handle, mask);
+
+    if (m_selSet == 0)
+	return 0;
+
+    int result = 0;
+
+    if (mask & EventHandler::READ_MASK)
+	if (::selSetAdd (m_selSet, handle, SELREAD) != OK)
+	    result = -1;
+
+    if (mask & EventHandler::WRITE_MASK)
+	if (::selSetAdd (m_selSet, handle, SELWRITE) != OK)
+	    result = -1;
+
+    return result;
+    }
+
+int SelSetDemux::handleUnbind
+    (
+    REACTOR_HANDLE	handle,
+    REACTOR_EVENT_MASK	mask
+    )
+    {
+    TRACE_CALL;
+
+    VxCritSec cs (m_mutex);
+
+    SelectDemux::handleUnbind (handle, mask);
+
+    if (m_selSet == 0)
+	return 0;
+
+    if (mask & EventHandler::READ_MASK)
+	::selSetRemove (m_selSet, handle, SELREAD);
+
+    if (mask & EventHandler::WRITE_MASK)
+	::selSetRemove (m_selSet, handle, SELWRITE);
+
+    return 0;
+    }
+
+int SelSetDemux::rearm
+    (
+    REACTOR_HANDLE	handle,
+    REACTOR_EVENT_MASK	mask
+    )
+    {
+    if (m_selSet == 0)
+	return 0;
+
+    if (mask & EventHandler::READ_MASK)
+	::selSetRearm (m_selSet, handle, SELREAD);
+
+    if (mask & EventHandler::WRITE_MASK)
+	::selSetRearm (m_selSet, handle, SELWRITE);
+
+    return 0;
+    }
+
+int SelSetDemux::wait
+    (
+    EventList&	readyEvents,
+    TimeValue*	timeout
+    )
+    {
+    TRACE_CALL;
+
+    if (m_ownerTask != ::taskIdSelf ())
+	selSetOpen ();
+
+    if (m_selSet == 0)
+	return SelectDemux::wait (readyEvents, timeout);
+
+    timeval* t = 0;
+
+    if (timeout)
+	t = *timeout;
+
+    int n = ::selSetWait (m_selSet, m_events, m_maxEvents, t);
+
+    // A handle ready for both reading and writing comes back as two
+    // events, which Reactor dispatches independently.
+
+    for (int i = 0; i < n; ++i)
+	{
+	Event event;
+
+	event.handle = m_events[i].fd;
+
+	if (m_events[i].type == SELREAD)
+	    event.mask = EventHandler::READ_MASK;
+	else
+	    event.mask = EventHandler::WRITE_MASK;
+
+	readyEvents.push_back (event);
+	}
+
+    return n;
+    }
+
+#endif // VXDCOM_PLATFORM_VXWORKS
@@ -0,0 +1,57 @@
+/* SelSetDemux - selSetLib based EventDemux for VxWorks */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01b,17oct26,agt  wait() takes the ready queue instead of scanning masks
+01a,17oct26,agt  created
+*/
+
+#ifndef __INCSelSetDemux_h
+#define __INCSelSetDemux_h
+
+#include "SelectDemux.h"
+
+#ifdef VXDCOM_PLATFORM_VXWORKS
+
+#include "selSetLib.h"
+
+// Keeps the Reactor's wake-up nodes installed in the drivers' select
+// wake-up lists (see selSetLib) instead of re-registering every handle
+// on each pass round the event loop.  wait() only takes the handles
+// queued as ready by selWakeup(), and rearm() re-arms a serviced handle
+// without touching the driver's wake-up list where it can.  The select
+// set belongs to the task which waits on it, so it is created by the
+// first wait(); the inherited SelectDemux interest sets are used to
+// populate it and as a fallback if it cannot be created.
+
+class SelSetDemux : public SelectDemux
+    {
+  public:
+
+    SelSetDemux (int maxEvents = 64);
+    virtual ~SelSetDemux ();
+
+    bool isOpen () const;
+
+    virtual int handleBind (REACTOR_HANDLE, REACTOR_EVENT_MASK);
+    virtual int handleUnbind (REACTOR_HANDLE, REACTOR_EVENT_MASK);
+    virtual int wait (EventList&, TimeValue*);
+    virtual int rearm (REACTOR_HANDLE, REACTOR_EVENT_MASK);
+    virtual const char* name () const;
+
+  private:
+
+    int selSetOpen ();
+
+    SEL_SET_ID		m_selSet;
+    int			m_ownerTask;
+    int			m_maxEvents;
+    SEL_SET_EVENT*	m_events;
+    };
+
+#endif // VXDCOM_PLATFORM_VXWORKS
+
+#endif // __INCSelSetDemux_h
@@ -0,0 +1,169 @@
+/* SelectDemux - select() based EventDemux */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created from Reactor select code
+*/
+
+#include "SelectDemux.h"
+#include "TraceCall.h"
+
+#ifdef VXDCOM_PLATFORM_VXWORKS
+#include "selectLib.h"
+#endif
+
+/* Include symbol for diab */
+extern "C" int include_vxdcom_SelectDemux (void)
+    {
+    return 0;
+    }
+
+SelectDemux::SelectDemux ()
+  : m_rdHandles (),
+    m_wrHandles (),
+    m_mutex ()
+    {
+    TRACE_CALL;
+    }
+
+SelectDemux::~SelectDemux ()
+    {
+    TRACE_CALL;
+    }
+
+const char* SelectDemux::name () const
+    {
+    return "select";
+    }
+
+int SelectDemux::handleBind
+    (
+    REACTOR_HANDLE	handle,
+    REACTOR_EVENT_MASK	mask
+    )
+    {
+    TRACE_CALL;
+
+    VxCritSec cs (m_mutex);
+
+    if (mask & EventHandler::READ_MASK)
+	m_rdHandles.set (handle);
+
+    if (mask & EventHandler::WRITE_MASK)
+	m_wrHandles.set (handle);
+
+    return 0;
+    }
+
+int SelectDemux::handleUnbind
+    (
+    REACTOR_HANDLE	handle,
+    REACTOR_EVENT_MASK	mask
+    )
+    {
+    TRACE_CALL;
+
+    VxCritSec cs (m_mutex);
+
+    if (mask & EventHandler::READ_MASK)
+	m_rdHandles.clr (handle);
+
+    if (mask & EventHandler::WRITE_MASK)
+	m_wrHandles.clr (handle);
+
+    return 0;
+    }
+
+int SelectDemux::wait
+    (
+    EventList&	readyEvents,
+    TimeValue*	timeout
+    )
+    {
+    TRACE_CALL;
+
+    HandleSet rdSet;
+    HandleSet wrSet;
+
+	{
+	VxCritSec cs (m_mutex);
+	rdSet = m_rdHandles;
+	wrSet = m_wrHandles;
+	}
+
+    int maxHandle = max (rdSet.maxHandle (), wrSet.maxHandle ());
+
+    timeval* t = 0;
+
+    if (timeout)
+	t = *timeout;
+
+#ifdef VXDCOM_PLATFORM_VXWORKS
+    errno = 0;
+#endif
+
+    int selectFds = ::select (maxHandle + 1,
+			      (rdSet.count () > 0) ? (fd_set*) rdSet : 0,
+			      (wrSet.count () > 0) ? (fd_set*) wrSet : 0,
+			      0,
+			      t);
+
+    if (selectFds <= 0)
+	return selectFds;
+
+    return collect (readyEvents,
+		    (rdSet.count () > 0) ? (fd_set*) rdSet : 0,
+		    (wrSet.count () > 0) ? (fd_set*) wrSet : 0,
+		    maxHandle + 1);
+    }
+
+int SelectDemux::collect
+    (
+    EventList&			readyEvents,
+    REACTOR_HANDLE_SET_TYPE*	rdSet,
+    REACTOR_HANDLE_SET_TYPE*	wrSet,
+    int				nHandles
+    )
+    {
+    int nEvents = 0;
+    int nWords = (nHandles + NFDBITS - 1) / NFDBITS;
+
+    // Skip a word of the masks at a time so that the cost is bounded
+    // by the ready handles rather than by the highest handle.
+
+    for (int ix = 0; ix < nWords; ++ix)
+	{
+	fd_mask rdWord = rdSet ? rdSet->fds_bits [ix] : 0;
+	fd_mask wrWord = wrSet ? wrSet->fds_bits [ix] : 0;
+
+	if ((rdWord | wrWord) == 0)
+	    continue;
+
+	for (int bit = 0; bit < NFDBITS; ++bit)
+	    {
+	    fd_mask m = ((fd_mask) 1) << bit;
+
+	    if (((rdWord | wrWord) & m) == 0)
+		continue;
+
+	    Event event;
+
+	    event.handle = ix * NFDBITS + bit;
+	    event.mask = EventHandler::NULL_MASK;
+
+	    if (rdWord & m)
+		event.mask |= EventHandler::READ_MASK;
+
+	    if (wrWord & m)
+		event.mask |= EventHandler::WRITE_MASK;
+
+	    readyEvents.push_back (event);
+	    ++nEvents;
+	    }
+	}
+
+    return nEvents;
+    }
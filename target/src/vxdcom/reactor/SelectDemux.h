@@ -0,0 +1,48 @@
+/* SelectDemux - select() based EventDemux */
+
+/* Copyright (c) 1999 Wind River Systems, Inc. */
+
+/*
+modification history
+--------------------
+01a,17oct26,agt  created from Reactor select code
+*/
+
+#ifndef __INCSelectDemux_h
+#define __INCSelectDemux_h
+
+#include "EventDemux.h"
+#include "HandleSet.h"
+
+// The portable demultiplexer.  Every wait() copies the interest sets
+// and scans the result up to the highest handle, so it is only used
+// when no scalable backend is available.
+
+class SelectDemux : public EventDemux
+    {
+  public:
+
+    SelectDemux ();
+    virtual ~SelectDemux ();
+
+    virtual int handleBind (REACTOR_HANDLE, REACTOR_EVENT_MASK);
+    virtual int handleUnbind (REACTOR_HANDLE, REACTOR_EVENT_MASK);
+    virtual int wait (EventList&, TimeValue*);
+    virtual const char* name () const;
+
+  protected:
+
+    static int collect
+	(
+	EventList&		readyEvents,
+	REACTOR_HANDLE_SET_TYPE* rdSet,
+	REACTOR_HANDLE_SET_TYPE* wrSet,
+	int			nHandles
+	);
+
+    HandleSet		m_rdHandles;
+    HandleSet		m_wrHandles;
+    VxMutex		m_mutex; // protect the interest sets
+    };
+
+#endif // __INCSelectDemux_h
@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01f,17oct26,agt  add sendv()
 01e,17dec01,nel  Add include symbol for diab build.
 01d,17nov99,nel  Cast const char* explicitly to char*
 01c,03jun99,aim  fix preprocessor directive
@@ -73,3 +74,66 @@ SockIO::recv (void *buf, size_t n) const
 #endif
     }
 
+
+size_t  
+SockIO::sendv (const struct iovec iov [], int n) const
+    {
+    TRACE_CALL;
+
+    // Keep a private copy of the vector, so it can be adjusted to
+    // resume after a partial send...
+    const int MAXIOV = 16;
+    struct iovec v [MAXIOV];
+    size_t total = 0;
+    size_t remaining = 0;
+    int i;
+
+    if ((n <= 0) || (n > MAXIOV))
+	return (size_t) -1;
+    
+    for (i = 0; i < n; ++i)
+	{
+	v [i] = iov [i];
+	remaining += iov [i].iov_len;
+	}
+
+    struct iovec* pv = v;
+    
+    while (remaining > 0)
+	{
+#ifdef VXDCOM_PLATFORM_WIN32
+	int sent = ::send (handleGet (),
+			   static_cast<const char*> (pv->iov_base),
+			   pv->iov_len,
+			   0);
+#else
+	struct msghdr msg;
+	::memset (&msg, 0, sizeof (msg));
+	msg.msg_iov = pv;
+	msg.msg_iovlen = n;
+
+	int sent = ::sendmsg (handleGet (), &msg, 0);
+#endif
+	if (sent <= 0)
+	    return (size_t) -1;
+
+	total += sent;
+	remaining -= sent;
+
+	// Skip the buffers that have been completely sent, and
+	// advance into the first one that hasn't...
+	while ((n > 0) && ((size_t) sent >= pv->iov_len))
+	    {
+	    sent -= pv->iov_len;
+	    ++pv;
+	    --n;
+	    }
+	if (sent > 0)
+	    {
+	    pv->iov_base = static_cast<char*> (pv->iov_base) + sent;
+	    pv->iov_len -= sent;
+	    }
+	}
+
+    return total;
+    }
@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01b,17oct26,agt  add sendv()
 01a,10may99,aim  created
 */
 
@@ -42,6 +43,12 @@ class SockIO : public SockEP
 			 size_t n) const;
     // Recv an <n> byte buffer from the connected socket (uses
     // <read(2)>).
+
+    virtual size_t sendv (const struct iovec iov [],
+			  int n) const;
+    // Send the <n> buffers described by <iov> to the connected
+    // socket, as one gathered write where possible (uses
+    // <sendmsg(2)>). Returns the total sent, or -1 on error.
     };
 
 #endif // __INCSockIO_h
@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01c,17oct26,agt  add processDebugOutput() for I/O vectors
 01b,02oct01,nel  Add debug hooks for dcomShow.
 01a,11may99,aim  created
 */
@@ -61,6 +62,38 @@ class SockStream : public SockIO
 	    }
         }
 
+    void processDebugOutput
+        (
+	void (*pHook)(const BYTE *, DWORD, const char *, int, int),
+	const struct iovec iov [],
+	int n
+	)
+	{
+	// The hooks expect to see whole packets, so gather the
+	// vector into one buffer -- only done if a hook is set
+	if (CHECKHOOK(pHook))
+	    {
+	    DWORD length = 0;
+	    int   i;
+
+	    for (i = 0; i < n; ++i)
+		length += iov [i].iov_len;
+
+	    BYTE* pBuf = new BYTE [length];
+	    if (pBuf)
+		{
+		BYTE* p = pBuf;
+		for (i = 0; i < n; ++i)
+		    {
+		    memcpy (p, iov [i].iov_base, iov [i].iov_len);
+		    p += iov [i].iov_len;
+		    }
+		processDebugOutput (pHook, pBuf, length);
+		delete [] pBuf;
+		}
+	    }
+	}
+
     // Meta-type info
     typedef INETSockAddr PEER_ADDR;
     };
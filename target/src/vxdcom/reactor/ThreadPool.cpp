@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01n,17oct26,agt  add ring-buffer queues with per-worker work stealing
 01m,22apr02,nel  SPR#76056. Correct test on task creation to test for -1
                  rather than < 0.
 01l,17dec01,nel  Add include symbol for diab.
@@ -37,7 +38,8 @@ extern "C" int include_vxdcom_ThreadPool (void)
 ThreadPool::ThreadPool
     (
     size_t	thrStackSize,
-    long	thrPriority
+    long	thrPriority,
+    size_t	ringSize
     )
   : m_minThreads (0),
     m_maxThreads (0),
@@ -46,7 +48,17 @@ ThreadPool::ThreadPool
     m_thrStackSize (thrStackSize),
     m_thrPriority (thrPriority),
     m_thrScavenger (0),
-    m_thrName (0)
+    m_thrName (0),
+    m_ringSize (ringSize),
+    m_globalQ (ringSize),
+    m_workers (0),
+    m_nWorkers (0),
+    m_pending (0),
+    m_idle (0),
+    m_fullWaiters (0),
+    m_workLock (),
+    m_workReady (),
+    m_workTaken ()
     {
     TRACE_CALL;
     }
@@ -59,6 +71,7 @@ ThreadPool::~ThreadPool ()
 
     threadNameDelete ();
 
+    delete [] m_workers;
     }
 
 int ThreadPool::open
@@ -71,6 +84,9 @@ int ThreadPool::open
 
     threadNameSet (threadName);
 
+    if (workersCreate (maxThreads) < 0)
+	return -1;
+
     for (int i = 0; i < maxThreads; ++i)
 	{
 	    if (threadAdd () < 0)
@@ -99,6 +115,9 @@ int ThreadPool::open
 
     threadNameSet (threadName);
 
+    if (workersCreate (maxThreads) < 0)
+	return -1;
+
     for (int i = 0; i < minThreads; ++i)
 	if (threadAdd () < 0) 
 	    {
@@ -155,6 +174,7 @@ void* ThreadPool::serviceHandler ()
     TRACE_CALL;
 
     EventHandler* pEventHandler;
+    Worker* self = ringMode () ? workerAttach () : 0;
 
     while (1)
 	{
@@ -164,7 +184,12 @@ void* ThreadPool::serviceHandler ()
 
 	// remove() will block until a job is inserted into the Q.
 
-	if (remove (pEventHandler) < 0)
+	if (ringMode ())
+	    {
+	    if (workRemove (self, pEventHandler) < 0)
+		break;
+	    }
+	else if (remove (pEventHandler) < 0)
 	    break;
 
 	if (pEventHandler == 0)
@@ -176,6 +201,9 @@ void* ThreadPool::serviceHandler ()
 	    pEventHandler->handleClose (handle);
 	}
 
+    if (self)
+	workerDetach (self);
+
     VxCritSec cs (m_threadCountLock);
 
     queueSizeSet (--m_threadCount);
@@ -207,6 +235,219 @@ int ThreadPool::enqueue (EventHandler* pEventHandler)
     return add (pEventHandler);
     }
 
+int ThreadPool::add (EventHandler* pEventHandler)
+    {
+    TRACE_CALL;
+
+    if (! ringMode ())
+	return TaskQueue<EventHandler*>::add (pEventHandler);
+
+    // Steer all work for one handler to the same worker so that a
+    // burst from one connection stays on one thread's local queue.
+    // Any idle worker will steal it if that thread is busy.
+
+    bool queued = false;
+
+    if (m_nWorkers > 0)
+	{
+	Worker& w = m_workers [(reinterpret_cast<unsigned long> (pEventHandler)
+				>> 4) % m_nWorkers];
+
+	if (w.taskId != 0)
+	    queued = w.localQ.tryAdd (pEventHandler);
+	}
+
+    if (! queued)
+	m_globalQ.add (pEventHandler);
+
+    // The job is counted only once it is visible, so a worker which
+    // finds m_pending > 0 can always find the job.
+
+    ::comSafeInc (&m_pending);
+
+    if (m_idle > 0)
+	{
+	VxCritSec cs (m_workLock);
+	m_workReady.signal ();
+	}
+
+    if (queueIsFull ())
+	{
+	queueFullHandler ();
+
+	VxCritSec cs (m_workLock);
+
+	::comSafeInc (&m_fullWaiters);
+
+	while (queueIsFull ())
+	    m_workTaken.wait (m_workLock);
+
+	::comSafeDec (&m_fullWaiters);
+	}
+
+    return 0;
+    }
+
+int ThreadPool::remove (EventHandler*& pEventHandler)
+    {
+    TRACE_CALL;
+
+    if (! ringMode ())
+	return TaskQueue<EventHandler*>::remove (pEventHandler);
+
+    return workRemove (0, pEventHandler);
+    }
+
+size_t ThreadPool::queueSize () const
+    {
+    if (! ringMode ())
+	return TaskQueue<EventHandler*>::queueSize ();
+
+    return (m_pending > 0) ? m_pending : 0;
+    }
+
+int ThreadPool::removeAll ()
+    {
+    TRACE_CALL;
+
+    if (! ringMode ())
+	return TaskQueue<EventHandler*>::removeAll ();
+
+    EventHandler* pEventHandler;
+
+    while (m_globalQ.tryRemove (pEventHandler))
+	workTaken ();
+
+    for (int i = 0; i < m_nWorkers; ++i)
+	while (m_workers [i].localQ.tryRemove (pEventHandler))
+	    workTaken ();
+
+    return 0;
+    }
+
+int ThreadPool::workersCreate (int maxThreads)
+    {
+    if (! ringMode () || m_workers != 0)
+	return 0;
+
+    if (maxThreads <= 0)
+	maxThreads = 1;
+
+    if ((m_workers = new Worker [maxThreads]) == 0)
+	return -1;
+
+    // Local queues share the configured ring size between them, but
+    // never drop below a useful burst size.
+
+    size_t localSize = max (m_ringSize / maxThreads, (size_t) 16);
+
+    for (int i = 0; i < maxThreads; ++i)
+	{
+	m_workers [i].taskId = 0;
+
+	if (! m_workers [i].localQ.open (localSize))
+	    return -1;
+	}
+
+    m_nWorkers = maxThreads;
+
+    return 0;
+    }
+
+ThreadPool::Worker* ThreadPool::workerAttach ()
+    {
+    long self = ::taskIdSelf ();
+
+    for (int i = 0; i < m_nWorkers; ++i)
+	if (::comSafeCas (&m_workers [i].taskId, 0, self))
+	    return &m_workers [i];
+
+    // More threads than slots; this one serves the global queue only.
+
+    return 0;
+    }
+
+void ThreadPool::workerDetach (Worker* self)
+    {
+    // Stop add() steering work here.  Anything already in our local
+    // queue stays there; the other workers steal from every slot,
+    // owned or not, and removeAll() drains them all.
+
+    self->taskId = 0;
+    }
+
+int ThreadPool::workRemove
+    (
+    Worker*		self,
+    EventHandler*&	pEventHandler
+    )
+    {
+    TRACE_CALL;
+
+    int start = self ? (self - m_workers) : 0;
+
+    while (1)
+	{
+	// Own queue first, then the global queue, then steal from the
+	// other workers, starting with our neighbour.
+
+	if (self && self->localQ.tryRemove (pEventHandler))
+	    break;
+
+	if (m_globalQ.tryRemove (pEventHandler))
+	    break;
+
+	bool stolen = false;
+
+	for (int i = 1; i <= m_nWorkers && ! stolen; ++i)
+	    {
+	    Worker& victim = m_workers [(start + i) % m_nWorkers];
+
+	    if (&victim != self)
+		stolen = victim.localQ.tryRemove (pEventHandler);
+	    }
+
+	if (stolen)
+	    break;
+
+	// Nothing anywhere: block.  m_idle is raised before m_pending
+	// is re-checked so that add() cannot miss us.
+
+	VxCritSec cs (m_workLock);
+
+	::comSafeInc (&m_idle);
+
+	if (m_pending <= 0)
+	    m_workReady.wait (m_workLock);
+
+	::comSafeDec (&m_idle);
+	}
+
+    workTaken ();
+
+    // The condition variable only remembers one signal, so pass a
+    // wakeup on if there is still work and someone else is waiting.
+
+    if (m_pending > 0 && m_idle > 0)
+	{
+	VxCritSec cs (m_workLock);
+	m_workReady.signal ();
+	}
+
+    return 0;
+    }
+
+void ThreadPool::workTaken ()
+    {
+    ::comSafeDec (&m_pending);
+
+    if (m_fullWaiters > 0)
+	{
+	VxCritSec cs (m_workLock);
+	m_workTaken.signal ();
+	}
+    }
+
 int ThreadPool::threadAdd ()
     {
     TRACE_CALL;
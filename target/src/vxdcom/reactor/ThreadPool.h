@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01h,17oct26,agt  add ring-buffer queues with per-worker work stealing
 01g,03aug01,dbs  remove usage of Thread class
 01f,21sep99,aim  changed API for activate
 01e,20sep99,aim  added Thread name parameter
@@ -18,6 +19,7 @@ modification history
 #define __INCThreadPool_h
 
 #include "TaskQueue.h"
+#include "RingQueue.h"
 #include "Reactor.h"
 #include "TimeValue.h"
 
@@ -30,8 +32,12 @@ class ThreadPool : public TaskQueue<EventHandler*>
     ThreadPool
 	(
 	size_t		thrStackSize = 0,
-	long		thrPriority  = 150
+	long		thrPriority  = 150,
+	size_t		ringSize     = 0
 	);
+    // A non-zero <ringSize> replaces the inherited list queue with a
+    // RingQueue of that many slots plus a local RingQueue per worker
+    // thread, from which idle workers steal.
 
     virtual ~ThreadPool ();
 
@@ -54,6 +60,10 @@ class ThreadPool : public TaskQueue<EventHandler*>
     // from TaskQueue
     virtual void* serviceHandler ();
     virtual int queueFullHandler ();
+    virtual int add (EventHandler*);
+    virtual int remove (EventHandler*&);
+    virtual size_t queueSize () const;
+    virtual int removeAll ();
 
     int minThreads () const;
     int maxThreads () const;
@@ -66,6 +76,14 @@ class ThreadPool : public TaskQueue<EventHandler*>
     
   private:
 
+    typedef RingQueue<EventHandler*> WorkQueue;
+
+    struct Worker
+	{
+	long		taskId;		// 0 if the slot is free
+	WorkQueue	localQ;
+	};
+
     int		m_minThreads;
     int		m_maxThreads;
     int		m_threadCount;
@@ -74,6 +92,24 @@ class ThreadPool : public TaskQueue<EventHandler*>
     long	m_thrPriority;
     Scavenger*	m_thrScavenger;
     char*	m_thrName;
+
+    size_t	m_ringSize;
+    WorkQueue	m_globalQ;
+    Worker*	m_workers;
+    int		m_nWorkers;
+    long	m_pending;	// jobs queued in m_globalQ and all localQs
+    long	m_idle;		// workers blocked in workRemove()
+    long	m_fullWaiters;	// producers blocked in add()
+    VxMutex	m_workLock;
+    VxCondVar	m_workReady;
+    VxCondVar	m_workTaken;
+
+    bool	ringMode () const { return m_ringSize != 0; }
+    int		workersCreate (int maxThreads);
+    Worker*	workerAttach ();
+    void	workerDetach (Worker*);
+    int		workRemove (Worker*, EventHandler*&);
+    void	workTaken ();
 	
     int 	threadAdd ();
     int 	threadRemove ();
@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01s,17oct26,agt  move marshaled reply into the PDU without copying
 01r,17dec01,nel  Add include symbol for diab.
 01q,13jul01,dbs  fix up includes, exclude priority propagation for now
 01p,13jul00,nel  Win2K fix.
@@ -246,8 +247,14 @@ RpcDispatcher::dispatch (const RpcPdu& request, RpcPdu& reply, int channelId, RE
 	    {
 	    RpcPduFactory::formatResponsePdu (request, reply);
 
+	    // Hand the marshaled reply over to the PDU without
+	    // copying it...
 	    if (ms.size() > 0)
-		reply.stubDataAppend (ms.begin (), ms.size ());
+		{
+		NdrBuffer buf;
+		if (SUCCEEDED (ms.detach (buf)))
+		    reply.stubDataAdopt (buf);
+		}
 	    }
 	else
 	    {
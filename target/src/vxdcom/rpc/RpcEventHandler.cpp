@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01y,17oct26,agt  send PDUs as an I/O vector instead of a flat copy
 01x,17dec01,nel  Add include symbol for diab.
 01w,02oct01,nel  Move debug hooks into SockStream class.
 01v,25sep01,nel  Correct prototype error under test harness build.
@@ -327,22 +328,22 @@ int RpcEventHandler::sendPdu (RpcPdu& pdu)
     {
     TRACE_CALL;
 
+    struct iovec iov [2];
     size_t len;
-    char *buf = 0;
     int status = -1;
 
     S_DEBUG (LOG_RPC, "sendPdu: " << pdu);
 
-    if (pdu.makeReplyBuffer (buf, len) < 0)
+    int nIov = pdu.makeReplyVector (iov, len);
+
+    if (nIov <= 0)
 	stream().close ();
-    else if (stream().send (buf, len) == len)
+    else if (stream().sendv (iov, nIov) == len)
 	{
-	stream ().processDebugOutput (pRpcServerOutput, (BYTE *)buf, len);
+	stream ().processDebugOutput (pRpcServerOutput, iov, nIov);
 	status = 0;
 	}
 
-    delete [] buf;
-
     return status;
     }
 
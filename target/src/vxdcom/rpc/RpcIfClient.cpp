@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01u,17oct26,agt  send PDUs as an I/O vector instead of a flat copy
 01t,17dec01,nel  Add include symbol for diab.
 01s,10oct01,dbs  add AddKnownInterface() method to IOrpcClientChannel
 01r,02oct01,nel  Move debug hooks into SockStream class.
@@ -147,27 +148,24 @@ bool RpcIfClient::connected () const
 
 int RpcIfClient::sendPdu (RpcPdu& pdu)
     {
+    struct iovec iov [2];
     size_t len;
-    char *buf = 0;
     int result = -1;
 
-    if (pdu.makeReplyBuffer (buf, len) < 0)
+    int nIov = pdu.makeReplyVector (iov, len);
+
+    if (nIov <= 0)
         stream().close ();
     else 
 	{
-	stream ().processDebugOutput (pRpcClientOutput, (BYTE *)buf, (DWORD)len);
-	if (stream().send (buf, len) == len)
+	stream ().processDebugOutput (pRpcClientOutput, iov, nIov);
+	if (stream().sendv (iov, nIov) == len)
 	    {
 	    result = 0;
 	    S_DEBUG (LOG_RPC, "sendPdu: " << pdu);
 	    }
 	}
 
-    if (buf != NULL)
-	{
-	delete [] buf;
-	}
-
     return result;
     }
 
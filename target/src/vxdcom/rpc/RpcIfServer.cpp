@@ -5,6 +5,7 @@
 /*
 modification history
 --------------------
+01m,17oct26,agt  pass g_vxdcomThreadPoolQueueSize to ThreadPool
 01l,17dec01,nel  Add include symbol for diab.
 01k,13jul01,dbs  fix up includes
 01j,24feb00,dbs  call close() from dtor
@@ -43,7 +44,9 @@ RpcIfServer::RpcIfServer
     m_dispatcher (dispatcher),
     m_addressBinding (),
     m_concurrency (concurrency),
-    m_threadPool (g_vxdcomDefaultStackSize, g_vxdcomThreadPoolPriority)
+    m_threadPool (g_vxdcomDefaultStackSize,
+		  g_vxdcomThreadPoolPriority,
+		  g_vxdcomThreadPoolQueueSize)
     {
     COM_ASSERT (m_dispatcher);
     TRACE_CALL;
@@ -3,6 +3,8 @@
 /*
 modification history
 --------------------
+02a,17oct26,agt  hold stub-data in pooled NdrBuffer, add stubDataAdopt(),
+                 send header and stub-data as an I/O vector
 01z,17dec01,nel  Add include symbol for diab build.
 01y,10dec01,dbs  diab build
 01x,08oct01,nel  SPR#70120. reformat ALTER_CONTEXT_RESP separately from
@@ -198,12 +200,8 @@ RpcPdu::authTrailer () const
     if (alen == 0)
         return 0;
 
-#ifdef __DCC__
-    const char* stubDataOffset = &(*(m_stubData.begin ()));
-#else
     const char* stubDataOffset = reinterpret_cast<const char*>
                                  (m_stubData.begin ());
-#endif
     
     if (stubDataOffset == 0)
         return 0;
@@ -331,11 +329,29 @@ size_t
 RpcPdu::stubDataAppend (const void* pv, size_t n)
     {
     TRACE_CALL;
-    const char* p = reinterpret_cast<const char*> (pv);
-    m_stubData.insert (m_stubData.end (), p, p +n);
+    if (FAILED (m_stubData.append (pv, n)))
+        return 0;
     return n;
     }
 
+//////////////////////////////////////////////////////////////////////////
+//
+// RpcPdu::stubDataAdopt -- take over the contents of 'buf' as this
+// PDU's stub-data. If we have no stub-data yet, its memory is simply
+// exchanged with ours, so nothing is copied. 'buf' is left empty...
+//
+
+void
+RpcPdu::stubDataAdopt (NdrBuffer& buf)
+    {
+    TRACE_CALL;
+    if (m_stubData.size () == 0)
+        m_stubData.swap (buf);
+    else
+        m_stubData.append (buf.begin (), buf.size ());
+    buf.clear ();
+    }
+
 const GUID& RpcPdu::objectId () const
     {
     TRACE_CALL;
@@ -421,7 +437,7 @@ RpcPdu::appendStubData (const char* buf, size_t len)
     {
     size_t n = min(len, m_requiredOctets); // octets to copy
 
-    m_stubData.insert (m_stubData.end (), buf, buf + n);
+    m_stubData.append (buf, n);
 
     if ((m_requiredOctets -= n) == 0)
         m_pduState = HAVE_STUB;
@@ -603,21 +619,13 @@ RpcPdu::authLen () const
 const void*
 RpcPdu::stubData () const
     {
-#ifdef __DCC__
-    return &(*(m_stubData.begin ()));
-#else
     return m_stubData.begin ();
-#endif
     }
 
 void*
 RpcPdu::stubData ()
     {
-#ifdef __DCC__
-    return &(*(m_stubData.begin ()));
-#else
     return m_stubData.begin ();
-#endif
     }
 
 bool
@@ -669,35 +677,44 @@ RpcPdu::isAlterContextResp () const
     return (packetType () == RPC_CN_PKT_ALTER_CONTEXT_RESP);
     }
 
+//////////////////////////////////////////////////////////////////////////
+//
+// RpcPdu::makeReplyVector -- format the header ready for sending, and
+// describe the packet in 'iov' as the header followed (if there is
+// any) by the stub-data. Returns the number of entries used, and the
+// total packet length in 'buflen'. The vector points into the PDU, so
+// is only valid while the PDU is unchanged...
+//
+
 int
-RpcPdu::makeReplyBuffer (char*& buf, size_t& buflen)
+RpcPdu::makeReplyVector (struct iovec iov [2], size_t& buflen)
     {
     int hdrLength = hdrLen ();
     int payloadLength = payloadLen ();
+    int nIov = 0;
 
     buflen = hdrLength + payloadLength;
 
-    buf = new char[buflen];
-
-    if (buf)
-        {
-        // Set the fragment-length field, and the DREP...
-        fragLenSet ();
-        drepSet ();
+    // Set the fragment-length field, and the DREP...
+    fragLenSet ();
+    drepSet ();
 
-        // Format the packet into the correct NDR mode...
-        commonHdrReformat (drep ());
-        extHdrReformat (drep ());
+    // Format the packet into the correct NDR mode...
+    commonHdrReformat (drep ());
+    extHdrReformat (drep ());
 
-        char* header = reinterpret_cast<char*> (&m_header);
+    iov [nIov].iov_base = reinterpret_cast<char*> (&m_header);
+    iov [nIov].iov_len = hdrLength;
+    ++nIov;
 
-        ::memcpy (buf, header, hdrLength);
-
-        if (payloadLength > 0)
-            ::memcpy (buf + hdrLength, stubData (), payloadLength);
+    if (payloadLength > 0)
+        {
+        iov [nIov].iov_base = reinterpret_cast<char*> (stubData ());
+        iov [nIov].iov_len = payloadLength;
+        ++nIov;
         }
 
-    return buf ? 0 : -1;
+    return nIov;
     }
 
 GUID
@@ -845,8 +862,9 @@ operator<< (ostream& os, const RpcPdu& pdu)
 void
 RpcPdu::stubDataAlign (size_t n)
     {
-    while ((m_stubData.size () % n) != 0)
-        m_stubData.push_back (0);
+    size_t pad = (n - (m_stubData.size () % n)) % n;
+    if (pad)
+        m_stubData.append (0, pad);
     }
 
 //////////////////////////////////////////////////////////////////////////
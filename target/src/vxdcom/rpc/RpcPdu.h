@@ -5,6 +5,8 @@
 /*
 modification history
 --------------------
+01h,17oct26,agt  hold stub-data in pooled NdrBuffer, add stubDataAdopt(),
+                 replace makeReplyBuffer() with makeReplyVector()
 01g,13jul01,dbs  fix up includes
 01f,22jun00,dbs  add accessors for alter_context_resp
 01e,06jul99,aim  added isBindNak
@@ -20,6 +22,8 @@ modification history
 #include <iostream>
 #include "rpcDceProto.h"
 #include "private/comStl.h"
+#include "ReactorTypes.h"
+#include "NdrBuffer.h"
 
 //////////////////////////////////////////////////////////////////////////
 //
@@ -29,8 +33,10 @@ modification history
 // procedure, to the point of being processed, and back to the transmit
 // procedure, without having to do memcpy().
 //
-// The member 'm_bufptr' always points to the next free location in the
-// buffer, so we can always insert extra bytes there.
+// The stub-data is held in a pooled NdrBuffer, which can take over the
+// memory of a marshaling stream via stubDataAdopt(). For sending, the
+// header and stub-data are described by an I/O vector, so they go to
+// the socket as they are without first being copied into one buffer.
 //
 
 class RpcPdu
@@ -93,6 +99,7 @@ class RpcPdu
     void*  stubData ();
     size_t stubDataLen () const;
     size_t stubDataAppend (const void* pv, size_t n);
+    void   stubDataAdopt (NdrBuffer& buf);
     void   stubDataAlign (size_t n);
 
     // size of stub-data + auth-trailer
@@ -129,18 +136,15 @@ class RpcPdu
     bool isFault () const;
     bool isAlterContextResp () const;
     
-    int makeReplyBuffer (char*& buf, size_t& buflen);
+    int makeReplyVector (struct iovec iov [2], size_t& buflen);
 
     friend ostream& operator<< (ostream& os, const RpcPdu&);
 
   private:
 
-    typedef STL_VECTOR(char) Stub;
-    typedef STL_VECTOR(char)::iterator StubIter;
-
     rpc_cn_packet_t	m_header;
     char*		m_headerOffset;
-    Stub                m_stubData;
+    NdrBuffer           m_stubData;
     size_t		m_requiredOctets;
     unsigned long	m_pduState;
 
@@ -6,6 +6,8 @@
 /*
 modification history
 --------------------
+02p,17oct26,agt  carve a larger kernel work queue when workQSize is raised.
+02o,17oct26,agt  added kernelTickWheel to select the qPriWheelLib tick queue.
 02n,13may02,cyr  update round-robin scheduling documentation section
 02m,09nov01,jhw  Revert WDB_INFO to be inside WIND_TCB.
 02l,27oct01,jhw  Set pTcb->pWdbInfo to NULL for the root task.
@@ -101,6 +103,20 @@ service routines handling interrupts of priority greater than the
 interrupt lock-out level may not call any VxWorks routine.
 .LP
 
+The tick queue, which holds delayed tasks and watchdogs, is normally a
+sorted list (qPriDeltaLib) whose insertion time grows with the number of pending
+timeouts.  Setting the global <kernelTickWheel> to TRUE before calling
+kernelInit() replaces it with a hierarchical timing wheel (see
+qPriWheelLib) whose insertion, removal, and per-tick cost do not depend on
+the number of timeouts.  The wheel's slot array, about eight kilobytes, is
+taken from the start of the memory pool.
+
+Work that interrupt service routines defer while the kernel is busy is held
+in the kernel work queue (see workQLib), a ring of WIND_JOBS_MAX jobs by
+default.  Setting the global <workQSize> to a larger number of jobs before
+calling kernelInit() takes a ring of that size, rounded down to a power of
+two, from the start of the memory pool, at 16 bytes per job.
+
 Once the kernel initialization is complete, a root task is spawned with
 the specified entry point and stack size.  The root entry point is normally
 usrRoot() of the usrConfig.c module.  The remaining VxWorks initialization
@@ -157,6 +173,7 @@ SEE ALSO: taskLib, intLib,
 #include "string.h"
 #include "intLib.h"
 #include "qPriBMapLib.h"
+#include "qPriWheelLib.h"
 #include "classLib.h"
 #include "semLib.h"
 #include "wdLib.h"
@@ -181,6 +198,12 @@ SEE ALSO: taskLib, intLib,
 #define MEM_TOT_BLOCK_SIZE	((2 * MEM_BLOCK_HDR_SIZE) + MEM_FREE_BLOCK_SIZE)
 
 
+/* externs */
+
+extern UINT	workQSize;		/* jobs in the kernel work queue */
+extern int	workQPoolInit (char *pPool, UINT nJobs);
+
+
 /* global variables */
 
 char *    vxIntStackEnd;		/* end of interrupt stack */
@@ -193,6 +216,7 @@ ULONG	  roundRobinSlice;		/* round robin slice in ticks */
 Q_HEAD	  activeQHead = {NULL,0,0,NULL};/* multi-way active queue head */
 Q_HEAD	  tickQHead;			/* multi-way tick queue head */
 Q_HEAD	  readyQHead;			/* multi-way ready queue head */
+BOOL	  kernelTickWheel = FALSE;	/* timing wheel tick queue */
 
 #if     (CPU_FAMILY == ARM)
 char *    vxSvcIntStackBase;            /* base of SVC-mode interrupt stack */
@@ -413,6 +437,26 @@ void kernelInit
 #endif	/* CPU_FAMILY != I960 */
 #endif 	/* (_STACK_DIR == _STACK_GROWS_UP) */
 
+    /* If a timing wheel tick queue was selected, carve its slot array from
+     * the beginning of the memory pool.  Nothing has been queued on the
+     * tick queue yet, so it may simply be initialized again.
+     */
+
+    if (kernelTickWheel)
+	{
+	qInit (&tickQHead, qPriWheelClassId, (int) pMemPoolStart,
+	       0, 0, 0, 0, 0, 0, 0, 0, 0);
+	pMemPoolStart += STACK_ROUND_UP (sizeof (WHEEL_ARRAY));
+	}
+
+    /* Likewise carve a larger kernel work queue if one was asked for.
+     * Interrupts are still locked, so no work has been queued yet.
+     */
+
+    if (workQSize > WIND_JOBS_MAX)
+	pMemPoolStart += STACK_ROUND_UP (workQPoolInit (pMemPoolStart,
+							workQSize));
+
     /* Carve the root stack and tcb from the end of the memory pool.  We have
      * to leave room at the very top and bottom of the root task memory for
      * the memory block headers that are put at the end and beginning of a
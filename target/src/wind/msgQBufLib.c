@@ -0,0 +1,609 @@
+/* msgQBufLib.c - message queue buffer loan library */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+#include "copyright_wrs.h"
+
+/*
+modification history
+--------------------
+01c,17oct26,agt  find the pool of a queue through its pMsgPool, so queues
+		 set up by msgQInit() work too; verify the id up front.
+01b,17oct26,agt  msgQBufFree() and msgQBufSend() check that each buffer is
+		 one of the queue's and is on loan.
+01a,17oct26,agt  written.
+*/
+
+/*
+DESCRIPTION
+This library lets tasks pass messages through a local message queue
+without copying them.  msgQSend() copies a message into one of the
+queue's message buffers and msgQReceive() copies it out again; for large
+messages these two copies dominate the cost of the transfer.  The routines
+here instead loan the queue's message buffers to the caller.
+
+A sender obtains an empty buffer with msgQBufAlloc(), builds the message
+in place, and posts it with msgQBufSend().  A receiver obtains posted
+buffers with msgQBufReceive(), uses the data in place, and hands each
+buffer back with msgQBufFree() when it is done.  The buffers are the
+queue's own, so a queue created by msgQCreate() with <maxMsgs> messages of
+<maxMsgLength> bytes holds at most <maxMsgs> buffers in all, whether empty,
+queued, or on loan; msgQBufAlloc() pends like msgQSend() when none is free.
+
+msgQBufSend() and msgQBufReceive() take arrays of buffers, so several
+messages may be passed in one call.  A batch sent by msgQBufSend() is
+queued with preemption locked: a receiver woken by the first message does
+not run until the whole batch has been queued.
+
+Loaned buffers and copied messages may be mixed on one queue.  A message
+posted by msgQBufSend() may be read by msgQReceive(), and a message sent
+by msgQSend() may be taken by msgQBufReceive().
+
+A buffer on loan belongs to the caller until it is posted or freed.  It
+must be passed back to the queue it came from, and only once.
+msgQBufFree() and msgQBufSend() refuse a pointer that is not the start of
+one of the queue's buffers, or a buffer that is not on loan, such as one
+already passed back.  A buffer that is still on loan when its queue is
+deleted is reclaimed with the queue and must not be used afterwards;
+msgQDelete() does not wait for outstanding loans.  msgQBufNumLoaned()
+reports how many buffers are on loan.
+
+These routines apply to local message queues, created by msgQCreate() or
+initialized by msgQInit(); shared and distributed message queues are
+refused.
+
+INTERRUPT LEVEL
+msgQBufAlloc(), msgQBufFree(), msgQBufSend() and msgQBufNumLoaned() may
+be called from interrupt service routines; msgQBufAlloc() must then be
+called with a timeout of NO_WAIT.  msgQBufReceive() may not be called
+from interrupt level.
+
+INCLUDE FILES: msgQBufLib.h
+
+SEE ALSO: msgQLib, msgQShow,
+.pG "Basic OS"
+*/
+
+#include "vxWorks.h"
+#include "taskLib.h"
+#include "intLib.h"
+#include "errnoLib.h"
+#include "msgQBufLib.h"
+#include "private/objLibP.h"
+#include "private/msgQLibP.h"
+#include "private/sigLibP.h"
+#include "private/windLibP.h"
+#include "private/kernelLibP.h"
+
+/* externs */
+
+extern CLASS_ID msgQClassId;
+
+/* macros */
+
+/* the message node that holds the data buffer pBuf */
+
+#define MSG_BUF_TO_NODE(pBuf)						\
+    ((MSG_NODE *) ((char *) (pBuf) - (int) MSG_NODE_DATA ((MSG_NODE *) NULL)))
+
+/* the link of a message node while its buffer is on loan */
+
+#define MSG_BUF_LOAN_TAG(msgQId)	((Q_JOB_NODE *) (msgQId))
+
+/* local message queue id check, sets errno for shared, distributed and
+ * invalid ids
+ */
+
+#define MSG_Q_BUF_ID_CHECK(msgQId)					\
+    (ID_IS_SHARED (msgQId) ? (errnoSet (S_objLib_OBJ_ID_ERROR), ERROR) :	\
+			     OBJ_VERIFY (msgQId, msgQClassId))
+
+/* forward static functions */
+
+static MSG_NODE * msgQBufClaim (MSG_Q_ID msgQId, char *pBuf);
+
+
+/*******************************************************************************
+*
+* msgQBufAlloc - borrow an empty message buffer from a message queue
+*
+* This routine takes an empty message buffer from the local message queue
+* <msgQId> and loans it to the caller.  The buffer is <maxMsgLength> bytes
+* long, as given to msgQCreate().  The caller builds a message in place and
+* then posts it with msgQBufSend(), or returns the buffer unused with
+* msgQBufFree().
+*
+* If all the buffers of the queue are queued or on loan, the caller pends
+* as msgQSend() does, for at most <timeout> ticks.  The <timeout> parameter
+* can also have the values NO_WAIT and WAIT_FOREVER.
+*
+* WARNING
+* This routine may be called from an interrupt service routine only with a
+* <timeout> of NO_WAIT.
+*
+* RETURNS: A pointer to the message buffer, or NULL if the message queue
+* ID is invalid, or no buffer became free within <timeout> ticks.
+*
+* ERRNO:
+* .iP "S_objLib_OBJ_ID_ERROR"
+* Message queue ID is invalid or not local.
+* .iP "S_objLib_OBJ_DELETED"
+* Message queue deleted while calling task was pended.
+* .iP "S_objLib_OBJ_UNAVAILABLE"
+* No buffer is free and <timeout> is NO_WAIT.
+* .iP "S_objLib_OBJ_TIMEOUT"
+* Timeout occurred while waiting for a free buffer.
+* .iP "S_msgQLib_NON_ZERO_TIMEOUT_AT_INT_LEVEL"
+* Called from an ISR with <timeout> other than NO_WAIT.
+* .LP
+*
+* SEE ALSO: msgQBufSend(), msgQBufFree()
+*/
+
+char * msgQBufAlloc
+    (
+    FAST MSG_Q_ID	msgQId,		/* message queue to borrow from */
+    int			timeout		/* ticks to wait */
+    )
+    {
+    FAST MSG_NODE *	pMsg;
+
+    if (MSG_Q_BUF_ID_CHECK (msgQId) != OK)
+	return (NULL);
+
+    if (!INT_CONTEXT ())
+	TASK_LOCK ();
+    else
+	{
+	if (timeout != 0)
+	    {
+	    errnoSet (S_msgQLib_NON_ZERO_TIMEOUT_AT_INT_LEVEL);
+	    return (NULL);
+	    }
+	}
+
+restart:
+    if (OBJ_VERIFY (msgQId, msgQClassId) != OK)
+	{
+	if (!INT_CONTEXT ())
+	    TASK_UNLOCK ();
+	return (NULL);
+	}
+
+    pMsg = (MSG_NODE *) qJobGet (msgQId, &msgQId->freeQ, timeout);
+
+    if (pMsg == (MSG_NODE *) NONE)
+	{
+	timeout = SIG_TIMEOUT_RECALC(timeout);
+	goto restart;
+	}
+
+    if (pMsg == NULL)
+	{
+	/* as in msgQSend(), count only real timeouts on a live queue */
+
+	if (errnoGet () == S_objLib_OBJ_TIMEOUT)
+	    {
+	    if (OBJ_VERIFY (msgQId, msgQClassId) == OK)
+		msgQId->sendTimeouts++;
+	    else
+		errnoSet (S_objLib_OBJ_DELETED);
+	    }
+
+	if (!INT_CONTEXT ())
+	    TASK_UNLOCK ();
+	return (NULL);
+	}
+
+    pMsg->msgLength = 0;
+    pMsg->node.next = MSG_BUF_LOAN_TAG (msgQId);
+
+    if (!INT_CONTEXT ())
+	TASK_UNLOCK ();
+
+    return (MSG_NODE_DATA (pMsg));
+    }
+
+/*******************************************************************************
+*
+* msgQBufFree - return a loaned message buffer to a message queue
+*
+* This routine gives the message buffer <pBuf> back to the message queue
+* <msgQId> as an empty buffer.  <pBuf> must have been obtained from the
+* same queue with msgQBufAlloc() or msgQBufReceive(), and must not be used
+* by the caller afterwards.  A task pended in msgQSend() or msgQBufAlloc()
+* for a free buffer is unblocked.
+*
+* RETURNS: OK, or ERROR if the message queue ID or the buffer is invalid.
+*
+* ERRNO:
+* .iP "S_objLib_OBJ_ID_ERROR"
+* Message queue ID is invalid or not local.
+* .iP "S_msgQLib_INVALID_MSG_LENGTH"
+* <pBuf> is not the address of one of the buffers of the queue.
+* .iP "S_objLib_OBJ_UNAVAILABLE"
+* <pBuf> is not on loan; it is free, queued, or was already passed back.
+* .LP
+*
+* SEE ALSO: msgQBufAlloc(), msgQBufReceive()
+*/
+
+STATUS msgQBufFree
+    (
+    FAST MSG_Q_ID	msgQId,		/* message queue the buffer came from */
+    char *		pBuf		/* loaned buffer to return */
+    )
+    {
+    FAST MSG_NODE *	pMsg;
+
+    if (MSG_Q_BUF_ID_CHECK (msgQId) != OK)
+	return (ERROR);
+
+    if (!INT_CONTEXT ())
+	TASK_LOCK ();
+
+    if ((OBJ_VERIFY (msgQId, msgQClassId) != OK) ||
+	((pMsg = msgQBufClaim (msgQId, pBuf)) == NULL))
+	{
+	if (!INT_CONTEXT ())
+	    TASK_UNLOCK ();
+	return (ERROR);
+	}
+
+    qJobPut (msgQId, &msgQId->freeQ, &pMsg->node, Q_JOB_PRI_DONT_CARE);
+
+    if (!INT_CONTEXT ())
+	TASK_UNLOCK ();
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* msgQBufSend - post loaned message buffers to a message queue
+*
+* This routine queues <nBufs> message buffers on the message queue
+* <msgQId>.  Each entry of <bufList> must be a buffer loaned by
+* msgQBufAlloc() or msgQBufReceive() from the same queue, and the matching
+* entry of <lenList> gives the length of the message it holds.  Ownership
+* of the buffers passes back to the queue; the caller must not use them
+* afterwards.
+*
+* The messages are queued in array order.  The <priority> parameter
+* applies to all of them, as for msgQSend(): MSG_PRI_NORMAL queues them at
+* the tail, in order; MSG_PRI_URGENT queues each at the head, so that the
+* last buffer of the array is received first.
+*
+* The lengths and buffers are checked before any buffer is queued, so a
+* batch is either refused whole or queued whole; a refused batch leaves
+* all its buffers on loan.  The batch is queued with
+* preemption locked, so a task pended in msgQReceive() or msgQBufReceive()
+* runs only once all <nBufs> messages are on the queue.  As no buffer has
+* to be claimed, this routine never pends.
+*
+* RETURNS: OK, or ERROR if the message queue ID, a length or a buffer is
+* invalid, or a VxWorks event could not be sent.
+*
+* ERRNO:
+* .iP "S_objLib_OBJ_ID_ERROR"
+* Message queue ID is invalid or not local.
+* .iP "S_msgQLib_INVALID_MSG_LENGTH"
+* A length exceeds the maximum length of the queue, <nBufs> is negative,
+* or an entry of <bufList> is not the address of one of the buffers of
+* the queue.
+* .iP "S_objLib_OBJ_UNAVAILABLE"
+* A buffer is not on loan, or appears twice in <bufList>.
+* .iP "S_eventLib_EVENTSEND_FAILED"
+* The message queue failed to send events to the registered task.  The
+* messages were queued nonetheless.  This errno value can only exist if
+* the message queue was created with the MSG_Q_EVENTSEND_ERR_NOTIFY option.
+* .LP
+*
+* SEE ALSO: msgQBufAlloc(), msgQBufReceive(), msgQSend()
+*/
+
+STATUS msgQBufSend
+    (
+    FAST MSG_Q_ID	msgQId,		/* message queue on which to send */
+    char *		bufList[],	/* loaned buffers holding messages */
+    UINT		lenList[],	/* length of each message */
+    int			nBufs,		/* number of buffers in the arrays */
+    int			priority	/* MSG_PRI_NORMAL or MSG_PRI_URGENT */
+    )
+    {
+    FAST MSG_NODE *	pMsg;
+    FAST int		ix;
+    STATUS		status = OK;
+
+    if (MSG_Q_BUF_ID_CHECK (msgQId) != OK)
+	return (ERROR);
+
+    if (!INT_CONTEXT ())
+	TASK_LOCK ();
+
+    if (OBJ_VERIFY (msgQId, msgQClassId) != OK)
+	{
+	if (!INT_CONTEXT ())
+	    TASK_UNLOCK ();
+	return (ERROR);
+	}
+
+    if (nBufs < 0)
+	{
+	if (!INT_CONTEXT ())
+	    TASK_UNLOCK ();
+	errnoSet (S_msgQLib_INVALID_MSG_LENGTH);
+	return (ERROR);
+	}
+
+    /* claim every buffer first, a buffer listed twice is claimed once */
+
+    for (ix = 0; ix < nBufs; ix++)
+	{
+	if (lenList [ix] > msgQId->maxMsgLength)
+	    {
+	    errnoSet (S_msgQLib_INVALID_MSG_LENGTH);
+	    break;
+	    }
+
+	if (msgQBufClaim (msgQId, bufList [ix]) == NULL)
+	    break;				/* errno set by msgQBufClaim() */
+	}
+
+    if (ix < nBufs)
+	{
+	/* put the buffers claimed so far back on loan */
+
+	while (--ix >= 0)
+	    MSG_BUF_TO_NODE (bufList [ix])->node.next =
+						MSG_BUF_LOAN_TAG (msgQId);
+
+	if (!INT_CONTEXT ())
+	    TASK_UNLOCK ();
+	return (ERROR);
+	}
+
+    for (ix = 0; ix < nBufs; ix++)
+	{
+	pMsg = MSG_BUF_TO_NODE (bufList [ix]);
+	pMsg->msgLength = lenList [ix];
+
+	/* the message is queued even when the event cannot be sent */
+
+	if (qJobPut (msgQId, &msgQId->msgQ, &pMsg->node, priority) != OK)
+	    status = ERROR;			/* errno set by qJobPut() */
+	}
+
+    if (!INT_CONTEXT ())
+	TASK_UNLOCK ();
+
+    return (status);
+    }
+
+/*******************************************************************************
+*
+* msgQBufReceive - borrow queued messages from a message queue
+*
+* This routine takes up to <maxBufs> messages from the message queue
+* <msgQId> and loans their buffers to the caller, without copying them.
+* The buffer addresses are stored in <bufList> and the message lengths in
+* <lenList>, oldest message first.  Each buffer must later be returned
+* with msgQBufFree(), or posted again with msgQBufSend().
+*
+* If no message is queued, the caller pends for at most <timeout> ticks
+* for the first one, as msgQReceive() does.  The <timeout> parameter can
+* also have the values NO_WAIT and WAIT_FOREVER.  Once a message has been
+* received, the routine takes whatever further messages are already queued,
+* up to <maxBufs>, and returns without pending again.
+*
+* WARNING
+* This routine must not be called by interrupt service routines.
+*
+* RETURNS: The number of buffers received, at least one, or ERROR.
+*
+* ERRNO:
+* .iP "S_objLib_OBJ_ID_ERROR"
+* Message queue ID is invalid or not local.
+* .iP "S_objLib_OBJ_DELETED"
+* Message queue deleted while calling task was pended.
+* .iP "S_objLib_OBJ_UNAVAILABLE"
+* No messages are queued and <timeout> is NO_WAIT.
+* .iP "S_objLib_OBJ_TIMEOUT"
+* Timeout occurred while waiting for a message.
+* .iP "S_msgQLib_INVALID_MSG_LENGTH"
+* <maxBufs> is less than 1.
+* .iP "S_intLib_NOT_ISR_CALLABLE"
+* Called from an ISR.
+* .LP
+*
+* SEE ALSO: msgQBufFree(), msgQBufSend(), msgQReceive()
+*/
+
+int msgQBufReceive
+    (
+    FAST MSG_Q_ID	msgQId,		/* message queue from which to receive */
+    char *		bufList[],	/* where to store the loaned buffers */
+    UINT		lenList[],	/* where to store the message lengths */
+    int			maxBufs,	/* number of entries in the arrays */
+    int			timeout		/* ticks to wait for the first message */
+    )
+    {
+    FAST MSG_NODE *	pMsg;
+    FAST int		nBufs;
+    int			errnoCopy;
+
+    if (INT_RESTRICT () != OK)		/* errno set by INT_RESTRICT() */
+	return (ERROR);
+
+    if (MSG_Q_BUF_ID_CHECK (msgQId) != OK)
+	return (ERROR);
+
+    if (maxBufs < 1)
+	{
+	errnoSet (S_msgQLib_INVALID_MSG_LENGTH);
+	return (ERROR);
+	}
+
+    TASK_LOCK ();
+
+restart:
+    if (OBJ_VERIFY (msgQId, msgQClassId) != OK)
+	{
+	TASK_UNLOCK ();
+	return (ERROR);
+	}
+
+    pMsg = (MSG_NODE *) qJobGet (msgQId, &msgQId->msgQ, timeout);
+
+    if (pMsg == (MSG_NODE *) NONE)
+	{
+	timeout = SIG_TIMEOUT_RECALC(timeout);
+	goto restart;
+	}
+
+    if (pMsg == NULL)
+	{
+	/* as in msgQReceive(), count only real timeouts on a live queue */
+
+	if (errnoGet () == S_objLib_OBJ_TIMEOUT)
+	    {
+	    if (OBJ_VERIFY (msgQId, msgQClassId) == OK)
+		msgQId->recvTimeouts++;
+	    else
+		errnoSet (S_objLib_OBJ_DELETED);
+	    }
+
+	TASK_UNLOCK ();
+	return (ERROR);
+	}
+
+    /* take what else is already queued, leaving errno untouched */
+
+    errnoCopy = errnoGet ();
+    nBufs = 0;
+
+    do
+	{
+	pMsg->node.next = MSG_BUF_LOAN_TAG (msgQId);
+	bufList [nBufs] = MSG_NODE_DATA (pMsg);
+	lenList [nBufs] = pMsg->msgLength;
+	nBufs++;
+	}
+    while ((nBufs < maxBufs) &&
+	   ((pMsg = (MSG_NODE *) qJobGet (msgQId, &msgQId->msgQ, NO_WAIT))
+	    != NULL) && (pMsg != (MSG_NODE *) NONE));
+
+    errnoSet (errnoCopy);
+
+    TASK_UNLOCK ();
+
+    return (nBufs);
+    }
+
+/*******************************************************************************
+*
+* msgQBufNumLoaned - get the number of message buffers on loan
+*
+* This routine returns the number of buffers of the message queue <msgQId>
+* that have been loaned out by msgQBufAlloc() or msgQBufReceive() and not
+* yet returned with msgQBufSend() or msgQBufFree().  The value is a
+* snapshot and may have changed by the time it is used.
+*
+* RETURNS: The number of buffers on loan, or ERROR if the message queue ID
+* is invalid.
+*
+* ERRNO:
+* .iP "S_objLib_OBJ_ID_ERROR"
+* Message queue ID is invalid or not local.
+* .LP
+*
+* SEE ALSO: msgQNumMsgs()
+*/
+
+int msgQBufNumLoaned
+    (
+    FAST MSG_Q_ID	msgQId		/* message queue to examine */
+    )
+    {
+    FAST int		nLoaned;
+    FAST int		level;
+
+    if (MSG_Q_BUF_ID_CHECK (msgQId) != OK)
+	return (ERROR);
+
+    level = intLock ();				/* LOCK INTERRUPTS */
+
+    if (OBJ_VERIFY (msgQId, msgQClassId) != OK)
+	{
+	intUnlock (level);			/* UNLOCK INTERRUPTS */
+	return (ERROR);
+	}
+
+    nLoaned = msgQId->maxMsgs - msgQId->msgQ.count - msgQId->freeQ.count;
+
+    intUnlock (level);				/* UNLOCK INTERRUPTS */
+
+    return (nLoaned);
+    }
+
+/*******************************************************************************
+*
+* msgQBufClaim - take back a loaned buffer
+*
+* This routine finds the message node of <pBuf>, checking that it is one of
+* the buffers of <msgQId> and that it is on loan.  The loan tag of the node
+* is cleared, so the same buffer cannot be passed back twice.  The pool of a
+* queue created by msgQCreate() follows its MSG_Q structure.  The caller
+* must have verified <msgQId>.
+*
+* RETURNS: The message node, or NULL if <pBuf> is not a loaned buffer of
+* the queue.
+*
+* ERRNO: S_msgQLib_INVALID_MSG_LENGTH, S_objLib_OBJ_UNAVAILABLE
+*/
+
+LOCAL MSG_NODE * msgQBufClaim
+    (
+    FAST MSG_Q_ID	msgQId,		/* message queue the buffer came from */
+    char *		pBuf		/* loaned buffer */
+    )
+    {
+    char *		pPool = msgQId->pMsgPool;
+    UINT		nodeSize = MSG_NODE_SIZE (msgQId->maxMsgLength);
+    UINT		offset;
+    FAST MSG_NODE *	pMsg;
+    FAST int		level;
+
+    if (pBuf == NULL)
+	{
+	errnoSet (S_msgQLib_INVALID_MSG_LENGTH);
+	return (NULL);
+	}
+
+    /* a pointer below the pool wraps around to a large offset */
+
+    offset = (UINT) ((char *) MSG_BUF_TO_NODE (pBuf) - pPool);
+
+    if ((offset >= (UINT) msgQId->maxMsgs * nodeSize) ||
+	((offset % nodeSize) != 0))
+	{
+	errnoSet (S_msgQLib_INVALID_MSG_LENGTH);
+	return (NULL);
+	}
+
+    pMsg = (MSG_NODE *) (pPool + offset);
+
+    level = intLock ();				/* LOCK INTERRUPTS */
+
+    if (pMsg->node.next != MSG_BUF_LOAN_TAG (msgQId))
+	{
+	intUnlock (level);			/* UNLOCK INTERRUPTS */
+	errnoSet (S_objLib_OBJ_UNAVAILABLE);
+	return (NULL);
+	}
+
+    pMsg->node.next = NULL;
+
+    intUnlock (level);				/* UNLOCK INTERRUPTS */
+
+    return (pMsg);
+    }
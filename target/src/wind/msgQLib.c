@@ -6,6 +6,9 @@
 /*
 modification history
 --------------------
+02p,17oct26,agt  msgQInit() records the message pool in the queue.
+02o,17oct26,agt  msgQDestroy() no longer waits for buffers loaned out by
+                 msgQBufLib.
 02n,10dec01,bwa  Added comment about MSG_Q_EVENTSEND_ERR_NOTIFY msgQCreate
                  option (SPR 72058).
 02m,26oct01,bwa  Added msgQEvLib and eventLib to the list of 'SEE ALSO'
@@ -376,7 +379,9 @@ STATUS msgQInit
 	return (ERROR);
 
 
-    /* put msg nodes on free list */
+    /* put msg nodes on free list, remembering where the pool starts */
+
+    pMsgQ->pMsgPool = (char *) pMsgPool;
 
     for (ix = 0; ix < maxMsgs; ix++)
 	{
@@ -435,7 +440,8 @@ STATUS msgQTerminate
 * msgQSend(), msgQReceive() or pending for the reception of events
 * meant to be sent from the message queue will unblock and return
 * ERROR.  When this function returns, <msgQId> is no longer a valid 
-* message queue ID.
+* message queue ID.  Message buffers still on loan from msgQBufAlloc() or
+* msgQBufReceive() are freed with the queue and must no longer be used.
 *
 * RETURNS: OK on success or ERROR otherwise.
 *
@@ -478,6 +484,7 @@ LOCAL STATUS msgQDestroy
     Q_JOB_NODE *pNode;
     FAST int	timeout;
     FAST int	nMsgs;
+    FAST int	nNodes;
 
     int errnoCopy;
 
@@ -516,6 +523,13 @@ LOCAL STATUS msgQDestroy
 
     objCoreTerminate (&msgQId->objCore);	/* INVALIDATE */
 
+    /*
+     * Buffers loaned out by msgQBufLib never come back to an invalid
+     * queue, so only wait for the nodes that are queued right now.
+     */
+
+    nNodes = msgQId->msgQ.count + msgQId->freeQ.count;
+
 #ifdef WV_INSTRUMENTATION
 
     /*  Indicate that the msgQDelete has succeeded (before TASK_UNLOCK, as
@@ -539,7 +553,7 @@ LOCAL STATUS msgQDestroy
 
     errnoCopy = errnoGet ();
 
-    while (nMsgs < msgQId->maxMsgs)
+    while (nMsgs < nNodes)
 	{
 	while (((pNode = qJobGet (msgQId, &msgQId->freeQ, timeout)) != NULL) &&
 	       (pNode != (Q_JOB_NODE *) NONE))
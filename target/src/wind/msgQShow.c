@@ -6,6 +6,8 @@
 /*
 modification history
 --------------------
+01x,17oct26,agt  take the pended side from the pend queues, not the counts.
+01w,17oct26,agt  msgQShow() displays buffers loaned out by msgQBufLib.
 01v,06nov01,aeg  added display of VxWorks event information.
 01u,26sep01,jws  move vxMP and vxFusion show & info rtn ptrs
                  to funcBind.c (SPR36055)
@@ -176,6 +178,11 @@ LOCAL BOOL msgQInfoEach
 * will be 0.
 * .LP
 *
+* While message buffers are on loan from msgQBufAlloc() or msgQBufReceive(),
+* fewer than <maxMsgs> messages fill the queue, and <numTasks> may count
+* blocked senders although <numMsgs> is less than <maxMsgs>, or even 0;
+* the number of buffers on loan is given by msgQBufNumLoaned().
+*
 * A list of pointers to the messages queued and their lengths can be
 * obtained by setting <msgPtrList> and <msgLenList> to the addresses of
 * arrays to receive the respective lists, and setting <msgListMax> to
@@ -276,16 +283,16 @@ STATUS msgQInfoGet
 	}
 
     /* tasks can be blocked on either the msg queue (receivers) or
-     * on the free queue (receivers), but not both.  Here we determine
-     * which queue to get task info from: if there are no msgs queued
-     * then there might be receivers pended, otherwise there might be
-     * senders pended.
+     * on the free queue (senders), but not both.  Here we determine
+     * which queue to get task info from: the message count does not
+     * tell, since with buffers on loan senders can block while no
+     * messages are queued, so look at the pend queues themselves.
      */
 
-    if (msgQId->msgQ.count == 0)
-	pendQ = &msgQId->msgQ.pendQ;	/* might be receivers pended */
+    if (Q_FIRST (&msgQId->msgQ.pendQ) != NULL)
+	pendQ = &msgQId->msgQ.pendQ;	/* receivers pended */
     else
-	pendQ = &msgQId->freeQ.pendQ;	/* might be senders pended */
+	pendQ = &msgQId->freeQ.pendQ;	/* senders pended, if any */
 
     if (pInfo->taskIdList != NULL)
 	{
@@ -343,7 +350,16 @@ STATUS msgQInfoGet
 *     Send timeouts       : 0
 *     Receive timeouts    : 0
 *     Options             : 0x1       MSG_Q_FIFO
+* .CE
+*
+* If message buffers are on loan from msgQBufAlloc() or msgQBufReceive(),
+* their number is displayed after the number of messages queued:
+* .CS
+*     Buffers On Loan     : 2
+* .CE
 *
+* Information about VxWorks events is displayed as follows:
+* .CS
 *     VxWorks Events
 *     --------------
 *     Registered Task     : 0x3f5c70 (t1)
@@ -398,6 +414,8 @@ STATUS msgQShow
     int	        ix2;
     char *	pMsg;
     int	        len;
+    int		nLoaned;
+    BOOL	sendersBlocked;
     EVENTS_RSRC msgQEvResource;
 
 
@@ -461,6 +479,11 @@ STATUS msgQShow
 
     msgQEvResource = msgQId->events;		/* record event info */ 
 
+    nLoaned = info.maxMsgs - info.numMsgs -	/* record buffer loans */
+	      msgQId->freeQ.count;
+
+    sendersBlocked = (Q_FIRST (&msgQId->freeQ.pendQ) != NULL);
+
     intUnlock (lock);				/* UNLOCK INTERRUPTS */
 
     /* show summary information */
@@ -477,7 +500,10 @@ STATUS msgQShow
     printf ("%-20s: %-10d\n", "Messages Max", info.maxMsgs);
     printf ("%-20s: %-10d\n", "Messages Queued", info.numMsgs);
 
-    if (info.numMsgs == info.maxMsgs) 
+    if (nLoaned > 0)
+	printf ("%-20s: %-10d\n", "Buffers On Loan", nLoaned);
+
+    if (sendersBlocked)
 	printf ("%-20s: %-10d\n", "Senders Blocked", info.numTasks);
     else
 	printf ("%-20s: %-10d\n", "Receivers Blocked", info.numTasks);
@@ -503,7 +529,7 @@ STATUS msgQShow
 	if (info.numTasks > 0)
 	    {
 	    printf ("\n%s Blocked:\n",
-		    (info.numMsgs == info.maxMsgs) ? "Senders" : "Receivers");
+		    sendersBlocked ? "Senders" : "Receivers");
 
 	    printf ("\n");
 	    printf ("   NAME      TID    PRI TIMEOUT\n");
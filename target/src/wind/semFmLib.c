@@ -0,0 +1,555 @@
+/* semFmLib.c - fast mutual-exclusion semaphore library */
+
+/* Copyright 1984-2002 Wind River Systems, Inc. */
+#include "copyright_wrs.h"
+
+/*
+modification history
+--------------------
+01c,17oct26,agt  uncontended take and give use only vxTas() and a store again;
+		 the owner counts are raised before the claim instead.
+01b,17oct26,agt  claim and release the lock with interrupts locked, so an
+		 owner cannot be deleted between the claim and its counts.
+01a,17oct26,agt  written.
+*/
+
+/*
+DESCRIPTION
+This library provides fast mutual-exclusion semaphores.  A fast mutex
+behaves like a mutual-exclusion semaphore created with semMCreate(): it
+may be taken recursively, may only be given by its owner, may not be used
+from interrupt level, and accepts the SEM_Q_PRIORITY, SEM_Q_FIFO,
+SEM_DELETE_SAFE, SEM_INVERSION_SAFE and SEM_EVENTSEND_ERR_NOTIFY options
+with the same meaning.  See semMLib for a full discussion.
+
+The difference is in how an uncontended semTake() or semGive() is carried
+out.  A fast mutex carries a lock byte next to the semaphore.  semTake()
+claims it with a single vxTas() and records the caller as owner, and
+semGive() clears it again, without locking interrupts or entering the
+kernel.  Only when the lock is already held, or when tasks are pended,
+priorities must be restored, deleters released, or events sent, is the
+work done in kernel state through the same pend queue, priority
+inheritance and task safety code as semMLib.
+
+Neither path locks interrupts, so the order of the steps matters:
+.IP
+semTake() raises the caller's safety and inheritance counts before it
+claims the lock, the way taskSafe() does, so a task holding the lock of a
+SEM_DELETE_SAFE mutex is always protected from deletion.
+.IP
+A task that finds the lock held pends even if the owner has not yet been
+recorded.  The new owner looks at the pend queue once it has recorded
+itself, and raises its priority to that of the first pended task.
+.IP
+semGive() clears the owner and the lock, then looks at the pend queue and
+the event registration again.  A task that pended, or registered for
+events, while the lock was being released is then given the semaphore,
+or sent its events, in kernel state.
+.LP
+
+Fast mutexes are created with semFmCreate(); they cannot be initialized in
+place with semMInit(), as the lock byte is allocated with the semaphore.
+semMGiveForce() may be used on them.
+
+INCLUDE FILES: semFmLib.h
+
+SEE ALSO: semLib, semMLib, vxTas(),
+.pG "Basic OS"
+*/
+
+#include "vxWorks.h"
+#include "errnoLib.h"
+#include "taskLib.h"
+#include "intLib.h"
+#include "vxLib.h"
+#include "semFmLib.h"
+#include "eventLib.h"
+#include "private/eventLibP.h"
+#include "private/sigLibP.h"
+#include "private/objLibP.h"
+#include "private/semLibP.h"
+#include "private/windLibP.h"
+
+
+/* macros */
+
+/* giving semId leaves pTcb with an inherited priority to drop */
+
+#define SEM_FM_PRI_RESORT(semId, pTcb)					\
+    (((semId)->options & SEM_INVERSION_SAFE) &&				\
+     ((pTcb)->priMutexCnt == 0) && ((pTcb)->priority != (pTcb)->priNormal))
+
+/* giving semId leaves pTcb deletable with deleters pended */
+
+#define SEM_FM_SAFE_Q_FLUSH(semId, pTcb)				\
+    (((semId)->options & SEM_DELETE_SAFE) &&				\
+     ((pTcb)->safeCnt == 0) && (Q_FIRST (&(pTcb)->safetyQHead) != NULL))
+
+
+/* forward static functions */
+
+static STATUS semFmGiveKern (SEM_ID semId, BOOL held);
+static STATUS semFmHandOff (SEM_ID semId);
+static void   semFmInherit (SEM_ID semId);
+static STATUS semFmPendQPut (SEM_ID semId, int timeout);
+
+/* locals */
+
+LOCAL BOOL	semFmLibInstalled;	/* protect from muliple inits */
+
+
+/*******************************************************************************
+*
+* semFmLibInit - initialize the fast mutex semaphore management package
+*
+* SEE ALSO: semLibInit(1).
+* NOMANUAL
+*/
+
+STATUS semFmLibInit (void)
+
+    {
+    if (!semFmLibInstalled)
+	{
+	semGiveTbl [SEM_TYPE_FMUTEX]		= (FUNCPTR) semFmGive;
+	semTakeTbl [SEM_TYPE_FMUTEX]		= (FUNCPTR) semFmTake;
+
+	if (semLibInit () == OK)
+	    semFmLibInstalled = TRUE;
+	}
+
+    return ((semFmLibInstalled) ? OK : ERROR);
+    }
+
+/*******************************************************************************
+*
+* semFmCreate - create and initialize a fast mutual-exclusion semaphore
+*
+* This routine allocates and initializes a fast mutual-exclusion semaphore.
+* The semaphore state is initialized to full.
+*
+* Semaphore options are those of semMCreate():
+* .iP "SEM_Q_PRIORITY  (0x1)" 8
+* Queue pended tasks on the basis of their priority.
+* .iP "SEM_Q_FIFO  (0x0)"
+* Queue pended tasks on a first-in-first-out basis.
+* .iP "SEM_DELETE_SAFE  (0x4)"
+* Protect a task that owns the semaphore from unexpected deletion.
+* .iP "SEM_INVERSION_SAFE  (0x8)"
+* Protect the system from priority inversion.  This option must be
+* accompanied by the SEM_Q_PRIORITY queuing mode.
+* .iP "SEM_EVENTSEND_ERR_NOTIFY (0x10)"
+* When the semaphore is given, if a task is registered for events and the
+* actual sending of events fails, a value of ERROR is returned and the errno
+* is set accordingly.
+* .LP
+*
+* RETURNS: The semaphore ID, or NULL if the semaphore cannot be created.
+*
+* ERRNO
+* .iP "S_semLib_INVALID_OPTION"
+* Invalid option was passed to semFmCreate.
+* .iP "S_memLib_NOT_ENOUGH_MEMORY"
+* Not enough memory available to create the semaphore.
+* .LP
+*
+* SEE ALSO: semMCreate()
+*/
+
+SEM_ID semFmCreate
+    (
+    int options                 /* mutex semaphore options */
+    )
+    {
+    SEM_ID semId;
+    char * pLock;			/* lock byte, see SEM_FM_LOCK */
+
+    if ((!semFmLibInstalled) && (semFmLibInit () != OK))
+        return (NULL);
+
+    if ((options & SEM_INVERSION_SAFE) && ((options & SEM_Q_MASK)==SEM_Q_FIFO))
+	{
+	errno = S_semLib_INVALID_OPTION;
+	return (NULL);
+	}
+
+    if ((semId = (SEM_ID) objAllocExtra (semClassId, sizeof (char),
+					 (void **) &pLock)) == NULL)
+	return (NULL);
+
+    /* initialize allocated semaphore as a mutex, then retype it */
+
+    if ((semQInit (semId, options) != OK) ||
+	(semMCoreInit (semId, options) != OK))
+	{
+	objFree (semClassId, (char *) semId);
+	return (NULL);
+	}
+
+    *pLock          = 0;			/* lock is free */
+    semId->semType  = SEM_TYPE_FMUTEX;		/* type is fast mutex */
+
+    return (semId);
+    }
+
+/*******************************************************************************
+*
+* semFmGive - give a fast mutex semaphore
+*
+* Gives the semaphore.  If no task is pended and no task is registered for
+* events, the owner and the lock are simply cleared.  Otherwise the
+* semaphore is handed over in kernel state by semFmGiveKern().  The kernel
+* is also entered if a task pended or registered while the lock was being
+* released, or if the caller's priority must be restored or deleters
+* released.
+*
+* WARNING
+* This routine may not be used from interrupt level.
+*
+* ERRNO: S_semLib_INVALID_OPERATION
+*
+* NOMANUAL
+*/
+
+STATUS semFmGive
+    (
+    FAST SEM_ID semId   /* semaphore ID to give */
+    )
+    {
+    FAST WIND_TCB *pTcb = taskIdCurrent;
+
+    if (INT_RESTRICT () != OK)			/* restrict isr use */
+	return (ERROR);
+
+    if (OBJ_VERIFY (semId, semClassId) != OK)	/* check validity */
+	return (ERROR);
+
+    if (pTcb != semId->semOwner)		/* check for ownership */
+	{
+	errnoSet (S_semLib_INVALID_OPERATION);
+	return (ERROR);
+	}
+
+    if (semId->recurse > 0)			/* check recurse count */
+	{
+	semId->recurse --;			/* decrement recurse count */
+	return (OK);
+	}
+
+    if ((Q_FIRST (&semId->qHead) != NULL) ||
+	(semId->events.taskId != (int)NULL))
+	{
+	kernelState = TRUE;			/* KERNEL ENTER */
+	return (semFmGiveKern (semId, TRUE));	/* hand over */
+	}
+
+    semId->semOwner = NULL;			/* clear owner ... */
+    *SEM_FM_LOCK (semId) = 0;			/* ... and release lock */
+
+    /* counts drop after the release, so the owner stays safe until then */
+
+    if (semId->options & SEM_INVERSION_SAFE)
+	pTcb->priMutexCnt --;
+
+    if (semId->options & SEM_DELETE_SAFE)
+	pTcb->safeCnt --;
+
+    if ((Q_FIRST (&semId->qHead) != NULL) ||	/* pended meanwhile? */
+	(semId->events.taskId != (int)NULL) ||
+	SEM_FM_PRI_RESORT (semId, pTcb) ||
+	SEM_FM_SAFE_Q_FLUSH (semId, pTcb))
+	{
+	kernelState = TRUE;			/* KERNEL ENTER */
+	return (semFmGiveKern (semId, FALSE));	/* do the work */
+	}
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* semFmTake - take a fast mutex semaphore
+*
+* Takes the semaphore.  If the lock is free it is claimed with vxTas() and
+* the caller becomes owner.  A task that already owns the semaphore takes it
+* recursively.  Otherwise the caller pends in kernel state, and ownership is
+* handed to it by the giving task.
+*
+* WARNING
+* This routine may not be used from interrupt level.
+*
+* NOMANUAL
+*/
+
+STATUS semFmTake
+    (
+    FAST SEM_ID semId,  /* semaphore ID to take */
+    int timeout         /* timeout in ticks */
+    )
+    {
+    FAST WIND_TCB *pTcb = taskIdCurrent;
+    int status;
+
+    if (INT_RESTRICT () != OK)
+	return (ERROR);
+
+again:
+    if (OBJ_VERIFY (semId, semClassId) != OK)
+	return (ERROR);
+
+    if (semId->semOwner == pTcb)		/* check for recursion */
+	{
+	semId->recurse ++;			/* keep recursion count */
+	return (OK);
+	}
+
+    /* counts rise before the claim, so the lock is never held unsafe */
+
+    if (semId->options & SEM_DELETE_SAFE)
+	pTcb->safeCnt ++;			/* update safety count */
+
+    if (semId->options & SEM_INVERSION_SAFE)
+	pTcb->priMutexCnt ++;			/* update inherit count */
+
+    if (vxTas ((void *) SEM_FM_LOCK (semId)))	/* uncontended */
+	{
+	semId->semOwner = pTcb;			/* update semaphore state */
+
+	if ((semId->options & SEM_INVERSION_SAFE) &&
+	    (Q_FIRST (&semId->qHead) != NULL))	/* pended before we owned */
+	    {
+	    kernelState = TRUE;			/* KERNEL ENTER */
+	    semFmInherit (semId);
+	    windExit ();			/* KERNEL EXIT */
+	    }
+
+	return (OK);
+	}
+
+    kernelState = TRUE;				/* KERNEL ENTER */
+
+    if (vxTas ((void *) SEM_FM_LOCK (semId)))	/* released meanwhile */
+	{
+	semId->semOwner = pTcb;
+	semFmInherit (semId);
+	windExit ();				/* KERNEL EXIT */
+	return (OK);
+	}
+
+    /* the counts are raised again by the task that hands the mutex over */
+
+    if (semId->options & SEM_INVERSION_SAFE)
+	pTcb->priMutexCnt --;
+
+    if (semId->options & SEM_DELETE_SAFE)
+	pTcb->safeCnt --;
+
+    if (SEM_FM_PRI_RESORT (semId, pTcb))
+	windPrioritySet (pTcb, pTcb->priNormal);
+
+    if (SEM_FM_SAFE_Q_FLUSH (semId, pTcb))
+	windPendQFlush (&pTcb->safetyQHead);
+
+    if (semFmPendQPut (semId, timeout) != OK)
+	{
+	windExit ();				/* windPendQPut failed */
+	return (ERROR);
+	}
+
+    if ((status = windExit ()) == RESTART)	/* KERNEL EXIT */
+	{
+	timeout = SIG_TIMEOUT_RECALC(timeout);
+	goto again;				/* we got signalled */
+	}
+
+    return (status);
+    }
+
+/*******************************************************************************
+*
+* semFmGiveKern - finish giving a fast mutex in kernel state
+*
+* This routine is called with kernelState == TRUE.  If <held> is TRUE the
+* caller still holds the lock and its counts, because tasks are pended or
+* registered for events: the counts are dropped and the semaphore is handed
+* over by semFmHandOff().  Otherwise the caller has released the lock on
+* the fast path, and the lock is claimed back to hand it over only if tasks
+* pended or registered meanwhile and no other task has claimed it since.
+* The caller's normal priority is then restored and deleters waiting on its
+* safety queue are released.
+*
+* RETURNS: OK, or ERROR if events could not be sent.
+*
+* NOMANUAL
+*/
+
+LOCAL STATUS semFmGiveKern
+    (
+    FAST SEM_ID semId,  /* semaphore ID to give */
+    BOOL	held	/* TRUE if the caller still holds the lock */
+    )
+    {
+    FAST WIND_TCB *pTcb    = taskIdCurrent;
+    STATUS	   retStatus = OK;
+    int		   oldErrno = errno;
+
+    if (held)
+	{
+	if (semId->options & SEM_INVERSION_SAFE)
+	    pTcb->priMutexCnt --;
+
+	if (semId->options & SEM_DELETE_SAFE)
+	    pTcb->safeCnt --;
+
+	retStatus = semFmHandOff (semId);
+	}
+    else if (((Q_FIRST (&semId->qHead) != NULL) ||
+	      (semId->events.taskId != (int)NULL)) &&
+	     vxTas ((void *) SEM_FM_LOCK (semId)))
+	{
+	retStatus = semFmHandOff (semId);	/* nobody claimed it */
+	}
+
+    if (SEM_FM_PRI_RESORT (semId, pTcb))
+	windPrioritySet (pTcb, pTcb->priNormal);
+
+    if (SEM_FM_SAFE_Q_FLUSH (semId, pTcb))
+	windPendQFlush (&pTcb->safetyQHead);
+
+    if (retStatus == ERROR)
+	{
+	windExit ();
+	errnoSet (S_eventLib_EVENTSEND_FAILED);
+	}
+    else
+	{
+	errnoSet (oldErrno);
+	retStatus = windExit ();		/* KERNEL EXIT */
+	}
+
+    return (retStatus);
+    }
+
+/*******************************************************************************
+*
+* semFmHandOff - hand a held fast mutex to the first pended task
+*
+* This routine is called in kernel state with the lock held and no owner
+* counts held for it.  The semaphore is handed to the first pended task, or
+* released if there is none, in which case events are sent to a registered
+* task.
+*
+* RETURNS: OK, or ERROR if events could not be sent and the semaphore was
+* created with SEM_EVENTSEND_ERR_NOTIFY.
+*
+* NOMANUAL
+*/
+
+LOCAL STATUS semFmHandOff
+    (
+    FAST SEM_ID semId   /* semaphore ID to hand over */
+    )
+    {
+    STATUS retStatus = OK;
+
+    if ((semId->semOwner = (WIND_TCB *) Q_FIRST (&semId->qHead)) != NULL)
+	{
+	windPendQGet (&semId->qHead);		/* unblock receiver */
+
+	semId->semOwner->pPriMutex = NULL;	/* receiver no longer pended */
+
+	if (semId->options & SEM_DELETE_SAFE)
+	    semId->semOwner->safeCnt ++;	/* increment receiver safety */
+
+	if (semId->options & SEM_INVERSION_SAFE)
+	    semId->semOwner->priMutexCnt ++;	/* update inherit count */
+
+	return (OK);
+	}
+
+    *SEM_FM_LOCK (semId) = 0;			/* release */
+
+    if (semId->events.taskId != (int)NULL)	/* send events */
+	{
+	if (eventRsrcSend (semId->events.taskId,
+			   semId->events.registered) != OK)
+	    {
+	    if ((semId->options & SEM_EVENTSEND_ERR_NOTIFY) != 0x0)
+		retStatus = ERROR;
+
+	    semId->events.taskId = (int)NULL;
+	    }
+	else if ((semId->events.options & EVENTS_SEND_ONCE) != 0x0)
+	    semId->events.taskId = (int)NULL;
+	}
+
+    return (retStatus);
+    }
+
+/*******************************************************************************
+*
+* semFmInherit - raise the owner of a fast mutex to its pended tasks
+*
+* This routine is called in kernel state by a new owner of an inversion-safe
+* fast mutex.  Tasks that pended while the lock was held but no owner was
+* recorded could not raise the owner's priority themselves; the first of
+* them, the most important, is the one that matters.
+*
+* NOMANUAL
+*/
+
+LOCAL void semFmInherit
+    (
+    FAST SEM_ID semId   /* semaphore ID just claimed */
+    )
+    {
+    FAST WIND_TCB *pPended;
+
+    if (!(semId->options & SEM_INVERSION_SAFE))
+	return;
+
+    pPended = (WIND_TCB *) Q_FIRST (&semId->qHead);
+
+    if ((pPended != NULL) &&
+	(pPended->priority < semId->semOwner->priority))
+	{
+	windPrioritySet (semId->semOwner, pPended->priority);
+	}
+    }
+
+/*******************************************************************************
+*
+* semFmPendQPut - put current task on fast mutex pend queue
+*
+* This routine is called with kernelState == TRUE if the lock is held and
+* the caller must pend.  An inversion-safe mutex raises the owner's
+* priority here, as semMPendQPut() does.  The lock may be held by a task
+* that has not yet recorded itself as owner; that task raises its own
+* priority with semFmInherit() once it has.
+*
+* RETURNS: OK, or ERROR if windPendQPut failed.
+* NOMANUAL
+*/
+
+LOCAL STATUS semFmPendQPut
+    (
+    FAST SEM_ID semId,  /* semaphore ID to take */
+    int timeout         /* timeout in ticks */
+    )
+    {
+    if (windPendQPut (&semId->qHead, timeout) != OK)
+	return (ERROR);
+
+    if (semId->options & SEM_INVERSION_SAFE)
+	{
+	taskIdCurrent->pPriMutex = semId;	/* track mutex we pend on */
+
+	if ((semId->semOwner != NULL) &&
+	    (taskIdCurrent->priority < semId->semOwner->priority))
+	    {
+	    windPrioritySet (semId->semOwner, taskIdCurrent->priority);
+	    }
+	}
+
+    return (OK);
+    }
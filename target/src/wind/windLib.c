@@ -6,6 +6,9 @@
 /*
 modification history
 --------------------
+02d,17oct26,agt  note when an inheritance mutex has no owner yet.
+02c,17oct26,agt  doc: workQALib is gone, workQLib is used on all arches.
+02b,17oct26,agt  windPrioritySet() stops inheritance at a mutex with no owner.
 02a,22may02,jgn  updated tick counter to be 64 bit - SPR #70255
 01z,20mar02,bwa  windPendQRemove() now moves task out of the tick Q. (SPR
                  #74673).
@@ -61,7 +64,7 @@ no user callable routines.
 INTERNAL
 This is a description of the architecture of Wind version 2.0.  The information
 here applies to the following libraries: kernelLib, taskLib, semLib, tickLib,
-wdLib, schedLib, workQLib, windLib, windALib, semALib, and workQALib.
+wdLib, schedLib, workQLib, windLib, windALib, and semALib.
 
 STATE MACHINE
 The kernel is a small state machine.  Each task contains state information in
@@ -570,7 +573,13 @@ void windPrioritySet
 	    {
 	    Q_RESORT (pTcb->pPendQ, pTcb, priority);
 
-	    if (pTcb->pPriMutex != NULL)	/* chain up for inheritance */
+	    /* a fast mutex owner claims the lock before it records itself,
+	     * so a task may pend on a mutex whose semOwner is still NULL;
+	     * the owner inherits the priority itself once recorded.
+	     */
+
+	    if ((pTcb->pPriMutex != NULL) &&	/* chain up for inheritance */
+		(pTcb->pPriMutex->semOwner != NULL))
 		pTcb = pTcb->pPriMutex->semOwner;
 	    }
 	}
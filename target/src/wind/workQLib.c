@@ -6,6 +6,11 @@
 /*
 modification history
 --------------------
+01w,17oct26,agt  overflow reboots by default again; without the panic,
+                 overflows are reported through logMsg().
+01v,17oct26,agt  made the ring size configurable, counted overflows instead of
+                 rebooting, added workQMerge1/2() and a high-water mark;
+                 the portable version is now used by all architectures.
 01u,09nov01,dee  add CPU_FAMILY != COLDFIRE
 01t,03mar00,zl   merged SH support into T2
 01u,18dec00,pes  Correct compiler warnings
@@ -61,24 +66,38 @@ work queue writers are from interrupt service routines so the interrupts must
 be locked during work queue write manipulations, but need not be locked during
 read operations.
 
-The work queue is implemented is implemented as a 1K byte ring buffer.  Each
-ring entry, or JOB, is 16 bytes in size.  So the ring has 64 entries.  The
-selection of this size is based on the efficiency of indexing the work queue
-with a single byte index.  To advance the index, all we have to do is add four
-to the index, and if our arithmatic is 8 bit, the overflow will be discarded.
-The efficiency lies in the fact that we have no conditionals to test for ring
-wrap around.
-
-This library should be optimized whenever possible, because the work queue
-should scream.
+The work queue is implemented as a ring of 16 byte entries, or JOBs.  The
+ring holds <workQSize> jobs, a power of two, so that the free running read
+and write indexes are mapped onto the ring with a mask and the ring is full
+when they are <workQSize> apart.  By default the ring is the static pool of
+WIND_JOBS_MAX jobs.  Setting <workQSize> to a larger value before calling
+kernelInit() makes kernelInit() carve a ring of that many jobs from the
+start of the memory pool, with workQPoolInit().
+
+When a job is added to a full ring, the system is rebooted through
+workQPanic(), as the discarded work could leave the kernel inconsistent;
+a semaphore give or a task resume that is lost may block a task forever.
+<workQHighWater> records the most jobs ever queued at once and may be used
+to size the ring.  A system that would rather survive an overflow may set
+<workQOverflowPanic> to FALSE: the job is then discarded and
+<workQOverflows> is incremented.  The next time the ring is emptied at
+interrupt level, the jobs discarded since the last report are reported
+through logMsg(), if logLib is configured; logMsg() cannot be called from
+workQAdd() itself, as it would queue more work on the full ring.
+
+Work that has the same effect whether it is done once or twice in a row,
+such as resuming a task or flushing a semaphore, may be added with
+workQMerge1() or workQMerge2().  If the job most recently queued and not yet
+started is identical, no new job is queued and <workQMerged> is incremented.
+This keeps a burst of identical requests from one interrupt source from
+filling the ring.  Work whose effect accumulates, such as giving a
+semaphore, must not be merged.
 
 CAVEATS
-Two constraints make the future of this library somewhat cloudy.  The
-limits of 64 jobs and 16 byte jobs are pretty much hard coded in.  So its
-likely that this implementation will give way someday to meet future needs.
-It remains the most efficient mechanism for the work queue today.
+The ring is sized once, when the kernel is initialized; it cannot grow
+while jobs may be queued by interrupt service routines.
 
-SEE ALSO: workALib, windLib, and windALib.
+SEE ALSO: windLib, and windALib.
 
 NOMANUAL
 */
@@ -91,30 +110,29 @@ NOMANUAL
 #include "private/workQLibP.h"
 #include "private/funcBindP.h"
 
-/*
- * optimized version available for 680X0, I960, MIPS, I80X86, SH,
- * ARM (excluding Thumb)
- */
-
-#if (defined(PORTABLE) || \
-     ((CPU_FAMILY != MC680X0) && \
-      (CPU_FAMILY != I960) && \
-      (CPU_FAMILY != MIPS) && \
-      (CPU_FAMILY != I80X86) && \
-      (CPU_FAMILY != SH) && \
-      (CPU_FAMILY != COLDFIRE) && \
-      (CPU_FAMILY != ARM)) || \
-     ((CPU_FAMILY == ARM) && ARM_THUMB))
-#define workLib_PORTABLE
-#endif
-
 /* globals */
 
-volatile UINT8 workQReadIx;		/* circular work queue read index */
-volatile UINT8 workQWriteIx;		/* circular work queue read index */
+volatile UINT  workQReadCnt;		/* free running work queue read index */
+volatile UINT  workQWriteCnt;		/* free running work queue write index */
 volatile BOOL  workQIsEmpty;		/* TRUE if work queue is empty */
 int   pJobPool [WIND_JOBS_MAX * 4];	/* pool of memory for jobs */
 
+JOB * pWorkQJobs = (JOB *) pJobPool;	/* ring of jobs in use */
+UINT  workQSize  = WIND_JOBS_MAX;	/* jobs in the ring, a power of two */
+UINT  workQMask  = WIND_JOBS_MAX - 1;	/* maps an index onto the ring */
+UINT  workQHighWater;			/* most jobs ever queued at once */
+UINT  workQOverflows;			/* jobs discarded on a full ring */
+UINT  workQMerged;			/* jobs merged by workQMerge[12]() */
+BOOL  workQOverflowPanic = TRUE;	/* reboot on overflow */
+
+/* locals */
+
+LOCAL UINT workQOverflowsLogged;	/* workQOverflows last reported */
+
+/* forward static functions */
+
+static void workQAdd (FUNCPTR func, int arg1, int arg2, BOOL merge);
+
 
 /*******************************************************************************
 *
@@ -125,11 +143,112 @@ int   pJobPool [WIND_JOBS_MAX * 4];	/* pool of memory for jobs */
 
 void workQInit (void)
     {
-    workQReadIx  = workQWriteIx = 0;	/* initialize the indexes */
+    workQReadCnt = workQWriteCnt = 0;	/* initialize the indexes */
     workQIsEmpty = TRUE;		/* the work queue is empty */
     }
 
-#ifdef workLib_PORTABLE
+/*******************************************************************************
+*
+* workQPoolInit - use a larger ring for the wind work queue
+*
+* This routine makes the work queue use the <nJobs> jobs of memory at <pPool>
+* instead of the static pool.  <nJobs> is rounded down to a power of two.  It
+* is called by kernelInit() when <workQSize> exceeds WIND_JOBS_MAX, before
+* any work can have been queued.
+*
+* RETURNS: The number of bytes of <pPool> used.
+*
+* NOMANUAL
+*/
+
+int workQPoolInit
+    (
+    char *	pPool,		/* memory for the ring */
+    UINT	nJobs		/* jobs requested */
+    )
+    {
+    FAST UINT	size = 1;
+
+    while ((size << 1) <= nJobs && (size << 1) != 0)
+	size <<= 1;
+
+    pWorkQJobs = (JOB *) pPool;
+    workQSize  = size;
+    workQMask  = size - 1;
+
+    workQInit ();
+
+    return ((int) (size * sizeof (JOB)));
+    }
+
+/*******************************************************************************
+*
+* workQAdd - add work to the wind work queue
+*
+* This routine queues the job <func>(<arg1>, <arg2>).  If <merge> is TRUE and
+* the job most recently queued and not yet started is identical, it is not
+* queued again.  The job is filled in with interrupts locked, so a nested
+* interrupt comparing against it never sees a job half written.
+*
+* If the ring is full the system is rebooted by workQPanic(), or, if
+* <workQOverflowPanic> is FALSE, the job is discarded and counted for
+* workQDoWork() to report.
+*
+* NOMANUAL
+*/
+
+LOCAL void workQAdd
+    (
+    FUNCPTR	func,		/* function to invoke */
+    int		arg1,		/* parameter one to function */
+    int		arg2,		/* parameter two to function */
+    BOOL	merge		/* TRUE if job may merge with the last one */
+    )
+    {
+    FAST JOB *	pJob;
+    FAST UINT	nJobs;
+    int		level = intLock ();	/* LOCK INTERRUPTS */
+
+    nJobs = workQWriteCnt - workQReadCnt;
+
+    if (merge && (nJobs != 0))
+	{
+	pJob = &pWorkQJobs [(workQWriteCnt - 1) & workQMask];
+
+	if ((pJob->function == func) && (pJob->arg1 == arg1) &&
+	    (pJob->arg2 == arg2))
+	    {
+	    workQMerged++;
+	    intUnlock (level);		/* UNLOCK INTERRUPTS */
+	    return;
+	    }
+	}
+
+    if (nJobs >= workQSize)
+	{
+	if (workQOverflowPanic)
+	    workQPanic ();		/* leave interrupts locked */
+
+	workQOverflows++;
+	intUnlock (level);		/* UNLOCK INTERRUPTS */
+	return;
+	}
+
+    pJob = &pWorkQJobs [workQWriteCnt & workQMask];
+
+    pJob->function = func;		/* fill in function */
+    pJob->arg1	   = arg1;		/* fill in arguments */
+    pJob->arg2	   = arg2;
+
+    workQWriteCnt++;			/* advance write index */
+
+    if (++nJobs > workQHighWater)
+	workQHighWater = nJobs;
+
+    workQIsEmpty = FALSE;		/* we put something in it */
+
+    intUnlock (level);			/* UNLOCK INTERRUPTS */
+    }
 
 /*******************************************************************************
 *
@@ -140,12 +259,6 @@ void workQInit (void)
 * routine that entered the kernel first.  The work is emptied as the last
 * code of reschedule().
 *
-* INTERNAL
-* The work queue is single reader, multiple writer, so we should have to lock
-* out interrupts while the writer is copying into the ring, but because the
-* reader can never interrupt a writer, interrupts need only be locked while
-* we advance the write queue pointer.
-*
 * RETURNS: OK
 *
 * SEE ALSO: reschedule().
@@ -158,19 +271,7 @@ void workQAdd0
     FUNCPTR func        /* function to invoke */
     )
     {
-    int level = intLock ();		/* LOCK INTERRUPTS */
-    FAST JOB *pJob = (JOB *) &pJobPool [workQWriteIx];
-
-    workQWriteIx += 4;			/* advance write index */
-
-    if (workQWriteIx == workQReadIx)
-	workQPanic ();			/* leave interrupts locked */
-
-    intUnlock (level);			/* UNLOCK INTERRUPTS */
-
-    workQIsEmpty = FALSE;		/* we put something in it */
-
-    pJob->function = func;		/* fill in function */
+    workQAdd (func, 0, 0, FALSE);
     }
 
 /*******************************************************************************
@@ -182,12 +283,6 @@ void workQAdd0
 * routine that entered the kernel first.  The work is emptied as the last
 * code of reschedule().
 *
-* INTERNAL
-* The work queue is single reader, multiple writer, so we should have to lock
-* out interrupts while the writer is copying into the ring, but because the
-* reader can never interrupt a writer, interrupts need only be locked while
-* we advance the write queue pointer.
-*
 * RETURNS: OK
 *
 * SEE ALSO: reschedule()
@@ -201,20 +296,7 @@ void workQAdd1
     int arg1            /* parameter one to function */
     )
     {
-    int level = intLock ();		/* LOCK INTERRUPTS */
-    FAST JOB *pJob = (JOB *) &pJobPool [workQWriteIx];
-
-    workQWriteIx += 4;			/* advance write index */
-
-    if (workQWriteIx == workQReadIx)
-	workQPanic ();			/* leave interrupts locked */
-
-    intUnlock (level);			/* UNLOCK INTERRUPTS */
-
-    workQIsEmpty = FALSE;		/* we put something in it */
-
-    pJob->function = func;		/* fill in function */
-    pJob->arg1 = arg1;			/* fill in argument */
+    workQAdd (func, arg1, 0, FALSE);
     }
 
 /*******************************************************************************
@@ -226,12 +308,6 @@ void workQAdd1
 * routine that entered the kernel first.  The work is emptied as the last
 * code of reschedule().
 *
-* INTERNAL
-* The work queue is single reader, multiple writer, so we should have to lock
-* out interrupts while the writer is copying into the ring, but because the
-* reader can never interrupt a writer, interrupts need only be locked while
-* we advance the write queue pointer.
-*
 * RETURNS: OK
 *
 * SEE ALSO: reschedule().
@@ -246,21 +322,54 @@ void workQAdd2
     int arg2            /* parameter two to function */
     )
     {
-    int level = intLock ();		/* LOCK INTERRUPTS */
-    FAST JOB *pJob = (JOB *) &pJobPool [workQWriteIx];
-
-    workQWriteIx += 4;			/* advance write index */
+    workQAdd (func, arg1, arg2, FALSE);
+    }
 
-    if (workQWriteIx == workQReadIx)
-	workQPanic ();			/* leave interrupts locked */
+/*******************************************************************************
+*
+* workQMerge1 - add repeatable work with one parameter to the wind work queue
+*
+* This routine is workQAdd1() for work that has the same effect when done
+* twice in a row as when done once.  If the job most recently queued, and
+* not yet started, is the same function with the same parameter, nothing
+* is queued.
+*
+* SEE ALSO: workQAdd1()
+*
+* NOMANUAL
+*/
 
-    intUnlock (level);			/* UNLOCK INTERRUPTS */
+void workQMerge1
+    (
+    FUNCPTR func,       /* function to invoke */
+    int arg1            /* parameter one to function */
+    )
+    {
+    workQAdd (func, arg1, 0, TRUE);
+    }
 
-    workQIsEmpty = FALSE;		/* we put something in it */
+/*******************************************************************************
+*
+* workQMerge2 - add repeatable work with two parameters to the wind work queue
+*
+* This routine is workQAdd2() for work that has the same effect when done
+* twice in a row as when done once.  If the job most recently queued, and
+* not yet started, is the same function with the same parameters, nothing
+* is queued.
+*
+* SEE ALSO: workQAdd2()
+*
+* NOMANUAL
+*/
 
-    pJob->function = func;		/* fill in function */
-    pJob->arg1 = arg1;			/* fill in arguments */
-    pJob->arg2 = arg2;
+void workQMerge2
+    (
+    FUNCPTR func,       /* function to invoke */
+    int arg1,           /* parameter one to function */
+    int arg2            /* parameter two to function */
+    )
+    {
+    workQAdd (func, arg1, arg2, TRUE);
     }
 
 /*******************************************************************************
@@ -273,10 +382,14 @@ void workQAdd2
 * routine as the last code of reschedule().
 *
 * INTERNAL
-* The work queue is single reader, multiple writer, so we should have to lock
-* out interrupts while the writer is copying into the ring, but because the
-* reader can never interrupt a writer, interrupts need only be locked while
-* we advance the write queue pointer.
+* The work queue is single reader, multiple writer, so the reader need not
+* lock interrupts.  The job is copied out before the read index is advanced,
+* as the slot may be reused by a writer as soon as it is.
+*
+* Discarded jobs are reported once the ring is empty, and only at interrupt
+* level, where logMsg() sends with NO_WAIT and cannot pend in kernel state.
+* The job logMsg() queues to wake up tLogTask leaves <workQIsEmpty> FALSE,
+* so the caller runs this routine again.
 *
 * SEE ALSO: reschedule().
 *
@@ -286,35 +399,50 @@ void workQAdd2
 void workQDoWork (void)
     {
     FAST JOB *pJob;
+    FUNCPTR func;
+    int arg1;
+    int arg2;
+    UINT nLost;
     int oldErrno = errno;			/* save errno */
 
-    while (workQReadIx != workQWriteIx)
+    while (workQReadCnt != workQWriteCnt)
 	{
-        pJob = (JOB *) &pJobPool [workQReadIx];	/* get job */
+        pJob = &pWorkQJobs [workQReadCnt & workQMask];	/* get job */
+
+	func = pJob->function;
+	arg1 = pJob->arg1;
+	arg2 = pJob->arg2;
 
 	/* increment read index before calling function, because work function
 	 * could be windTickAnnounce () that calls this routine as well.
 	 */
 
-	workQReadIx += 4;
+	workQReadCnt++;
 
-        (FUNCPTR *)(pJob->function) (pJob->arg1, pJob->arg2);
+        (*func) (arg1, arg2);
 
 	workQIsEmpty = TRUE;			/* leave loop with empty TRUE */
 	}
 
+    if ((workQOverflows != workQOverflowsLogged) && intContext () &&
+	(_func_logMsg != NULL))
+	{
+	nLost = workQOverflows - workQOverflowsLogged;
+	workQOverflowsLogged += nLost;
+
+	(* _func_logMsg) ("workQDoWork: work queue overflow, %d jobs lost\n",
+			  (int) nLost, 0, 0, 0, 0, 0);
+	}
+
     errno = oldErrno;				/* restore _errno */
     }
 
-#endif	/* workLib_PORTABLE */
-
 /*******************************************************************************
 *
 * workQPanic - work queue has overflowed so reboot system
 *
 * The application has really botched things up if we get here, so we reboot
-* the system.  An overflow can be detected if the read index is one greater than
-* the write index.
+* the system.  It is called on overflow unless <workQOverflowPanic> is FALSE.
 *
 * NOMANUAL
 */
@@ -6,6 +6,9 @@
 /*
 modification history
 --------------------
+02e,17oct26,agt  log alloc and free events for blocks served by the cache
+02d,17oct26,agt  added size-class cache hooks; split out memPartBlockAlloc()
+		 and memPartBlockFree() for batched use under one semTake
 02c,22may02,zl   use the ALIGNED() macro for alignment test (SPR#74247).
 02b,23apr02,gls  added check for overflow in memPartAlignedAlloc (SPR #27741)
 02a,04oct01,tam  fixed doc. of arch alignment
@@ -99,9 +102,13 @@ on the PPC604 CPU type (including ALTIVEC). For all other PowerPC CPU types
 (PPC403, PPC405, PPC440, PPC860, PPC603, etc...), the boundary and overhead 
 are 8 bytes.
 
+A partition may optionally be fronted by a cache of free blocks sorted
+into power-of-two size classes, which serves small allocations in
+constant time without taking the partition semaphore; see memCacheLib.
+
 INCLUDE FILES: memLib.h, stdlib.h
 
-SEE ALSO: memLib, smMemLib
+SEE ALSO: memLib, memCacheLib, smMemLib
 
 INTERNAL
 This package is initialized by kernelInit() which calls memInit() with a
@@ -150,6 +157,7 @@ semCreate().
 #include "string.h"
 #include "errnoLib.h"
 #include "smObjLib.h"
+#include "memCacheLib.h"
 #include "private/memPartLibP.h"
 #include "private/eventP.h"
 
@@ -161,6 +169,13 @@ LOCAL STATUS	 memPartDestroy (PART_ID partId);
 LOCAL BLOCK_HDR *memAlignedBlockSplit (PART_ID partId, BLOCK_HDR *pHdr, 
 				       unsigned nWords, unsigned minWords,
 				       unsigned alignment);
+
+/* used by memCacheLib */
+
+BLOCK_HDR	*memPartBlockAlloc (PART_ID partId, unsigned nWords,
+				    unsigned alignment);
+void		 memPartBlockFree (PART_ID partId, BLOCK_HDR *pHdr);
+
 /* local variables */
 
 LOCAL PARTITION memSysPartition;	/* system partition used by malloc */
@@ -187,6 +202,9 @@ UINT	 memDefaultAlignment	= _ALLOC_ALIGN_SIZE;	/* default alignment */
 FUNCPTR  memPartBlockErrorRtn	= NULL;			/* block error method */
 FUNCPTR  memPartAllocErrorRtn	= NULL;			/* alloc error method */
 FUNCPTR  memPartSemInitRtn	= (FUNCPTR) memPartSemInit;
+FUNCPTR  memPartCacheAllocRtn	= NULL;			/* size-class alloc */
+FUNCPTR  memPartCacheFreeRtn	= NULL;			/* size-class free */
+FUNCPTR  memPartCacheShowRtn	= NULL;			/* size-class show */
 unsigned memPartOptionsDefault	= MEM_BLOCK_ERROR_SUSPEND_FLAG |
 				  MEM_BLOCK_CHECK;
 
@@ -458,11 +476,7 @@ void *memPartAlignedAlloc
     )
     {
     FAST unsigned	nWords;
-    FAST unsigned	nWordsExtra;
-    FAST DL_NODE *	pNode;
     FAST BLOCK_HDR *	pHdr;
-    BLOCK_HDR *		pNewHdr;
-    BLOCK_HDR 		origpHdr;
 
     if (OBJ_VERIFY (partId, memPartClassId) != OK)
 	return (NULL);
@@ -496,6 +510,62 @@ void *memPartAlignedAlloc
 
     semTake (&partId->sem, WAIT_FOREVER);
 
+    pHdr = memPartBlockAlloc (partId, nWords, alignment);
+
+    if (pHdr == NULL)
+	{
+	semGive (&partId->sem);
+
+	if (memPartAllocErrorRtn != NULL)
+	    (* memPartAllocErrorRtn) (partId, nBytes);
+
+	errnoSet (S_memLib_NOT_ENOUGH_MEMORY);
+
+	if (partId->options & MEM_ALLOC_ERROR_SUSPEND_FLAG)
+	    {
+	    if ((taskIdCurrent->options & VX_UNBREAKABLE) == 0)
+		taskSuspend (0);			/* suspend ourselves */
+	    }
+
+	return (NULL);
+	}
+
+#ifdef WV_INSTRUMENTATION
+    EVT_OBJ_4 (OBJ, partId, memPartClassId, EVENT_MEMALLOC, partId, HDR_TO_BLOCK (pHdr), 2 * (pHdr->nWords), nBytes);
+#endif
+
+    semGive (&partId->sem);
+
+    return ((void *) HDR_TO_BLOCK (pHdr));
+    }
+
+/*******************************************************************************
+*
+* memPartBlockAlloc - take a block from the partition free list
+*
+* This routine does the first-fit search for memPartAlignedAlloc(), and
+* updates the allocation statistics.  <nWords> is the full size of the
+* block, including its header, and has already been checked against the
+* partition minimum.  The caller must hold the partition semaphore; this
+* lets memCacheLib take several blocks under a single semTake().
+*
+* RETURNS: The header of the allocated block, or NULL if none fits.
+*
+* NOMANUAL
+*/
+
+BLOCK_HDR *memPartBlockAlloc
+    (
+    FAST PART_ID	partId,		/* memory partition to allocate from */
+    FAST unsigned	nWords,		/* block size in words, with header */
+    unsigned		alignment	/* boundary to align to */
+    )
+    {
+    FAST unsigned	nWordsExtra;
+    FAST DL_NODE *	pNode;
+    FAST BLOCK_HDR *	pHdr;
+    BLOCK_HDR *		pNewHdr;
+
     /* first fit */
 
     pNode = DLL_FIRST (&partId->freeList);
@@ -522,26 +592,9 @@ void *memPartAlignedAlloc
 	    }
 	
 	if (pNode == NULL)
-	    {
-	    semGive (&partId->sem);
-
-	    if (memPartAllocErrorRtn != NULL)
-		(* memPartAllocErrorRtn) (partId, nBytes);
-
-	    errnoSet (S_memLib_NOT_ENOUGH_MEMORY);
-
-	    if (partId->options & MEM_ALLOC_ERROR_SUSPEND_FLAG)
-		{
-		if ((taskIdCurrent->options & VX_UNBREAKABLE) == 0)
-		    taskSuspend (0);			/* suspend ourselves */
-		}
-
 	    return (NULL);
-	    }
 
 	pHdr = NODE_TO_HDR (pNode);
-	origpHdr = *pHdr;
-
 
 	/* now we split off from this block, the amount required by the user;
 	 * note that the piece we are giving the user is at the end of the
@@ -569,10 +622,6 @@ void *memPartAlignedAlloc
 
     pHdr->free = FALSE;
 
-#ifdef WV_INSTRUMENTATION
-    EVT_OBJ_4 (OBJ, partId, memPartClassId, EVENT_MEMALLOC, partId, HDR_TO_BLOCK (pHdr), 2 * (pHdr->nWords), nBytes);
-#endif
-
     /* update allocation statistics */
 
     partId->curBlocksAllocated++;
@@ -580,9 +629,7 @@ void *memPartAlignedAlloc
     partId->curWordsAllocated += pHdr->nWords;
     partId->cumWordsAllocated += pHdr->nWords;
 
-    semGive (&partId->sem);
-
-    return ((void *) HDR_TO_BLOCK (pHdr));
+    return (pHdr);
     }
 
 /*******************************************************************************
@@ -621,6 +668,21 @@ void *memPartAlloc
 
     /* partition is local */
 
+    if ((memPartCacheAllocRtn != NULL) &&
+	(OBJ_VERIFY (partId, memPartClassId) == OK) &&
+	(partId->options & MEM_PART_SIZE_CLASS))
+	{
+	void *pBlock = (void *) (* memPartCacheAllocRtn) (partId, nBytes);
+
+	if (pBlock != NULL)
+	    {
+#ifdef WV_INSTRUMENTATION
+	    EVT_OBJ_4 (OBJ, partId, memPartClassId, EVENT_MEMALLOC, partId, pBlock, 2 * (BLOCK_TO_HDR (pBlock)->nWords), nBytes);
+#endif
+	    return (pBlock);
+	    }
+	}
+
     return (memPartAlignedAlloc (partId, nBytes, memDefaultAlignment));
     }
 
@@ -645,8 +707,6 @@ STATUS memPartFree
     )
     {
     FAST BLOCK_HDR *pHdr;
-    FAST unsigned   nWords;
-    FAST BLOCK_HDR *pNextHdr;
 
 
     if (ID_IS_SHARED (partId))  /* partition is shared? */
@@ -668,6 +728,28 @@ STATUS memPartFree
     if (pBlock == NULL)
 	return (OK);				/* ANSI C compatibility */
 
+    /* small blocks may be kept by the size-class cache, which does its
+     * own block check; anything it refuses is freed (or rejected) here
+     */
+
+    if ((partId->options & MEM_PART_SIZE_CLASS) &&
+	(memPartCacheFreeRtn != NULL))
+	{
+#ifdef WV_INSTRUMENTATION
+	/* the size is read first, as the cache may merge the block back */
+
+	unsigned nWords = BLOCK_TO_HDR (pBlock)->nWords;
+#endif
+
+	if ((* memPartCacheFreeRtn) (partId, pBlock))
+	    {
+#ifdef WV_INSTRUMENTATION
+	    EVT_OBJ_3 (OBJ, partId, memPartClassId, EVENT_MEMFREE, partId, pBlock, 2 * nWords);
+#endif
+	    return (OK);
+	    }
+	}
+
     pHdr   = BLOCK_TO_HDR (pBlock);
 
     /* get exclusive access to the partition */
@@ -697,6 +779,37 @@ STATUS memPartFree
     EVT_OBJ_3 (OBJ, partId, memPartClassId, EVENT_MEMFREE, partId, pBlock, 2 * (pHdr->nWords));
 #endif
 
+    memPartBlockFree (partId, pHdr);
+
+    semGive (&partId->sem);
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* memPartBlockFree - return a block to the partition free list
+*
+* This routine coalesces an allocated block with its free neighbours and
+* puts the result on the free list, adjusting the allocation statistics.
+* The block is assumed valid.  The caller must hold the partition
+* semaphore; this lets memCacheLib give back several blocks under a
+* single semTake().
+*
+* RETURNS: N/A
+*
+* NOMANUAL
+*/
+
+void memPartBlockFree
+    (
+    PART_ID partId,     /* memory partition to add block to */
+    FAST BLOCK_HDR *pHdr	/* header of block to free */
+    )
+    {
+    FAST unsigned   nWords;
+    FAST BLOCK_HDR *pNextHdr;
+
     nWords = pHdr->nWords; 
 
     /* check if we can coalesce with previous block;
@@ -733,10 +846,6 @@ STATUS memPartFree
 
     partId->curBlocksAllocated--;
     partId->curWordsAllocated -= nWords;
-
-    semGive (&partId->sem);
-
-    return (OK);
     }
 
 /*******************************************************************************
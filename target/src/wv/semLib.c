@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+02k,17oct26,agt  semFlushDefer() merges repeated flushes of one semaphore.
 02j,09nov01,dee  add CPU_FAMILY != COLDFIRE in portable test
 02i,26oct01,bwa  Added semEvLib and eventLib to the list of 'SEE ALSO'
                  modules.
@@ -187,6 +188,10 @@ SEE ALSO: taskLib, semBLib, semCLib, semMLib, semSmLib, semEvLib, eventLib,
 #define semLib_PORTABLE
 #endif
 
+/* externs */
+
+extern void	workQMerge1 (FUNCPTR func, int arg1);
+
 /* locals */
 
 LOCAL BOOL	semLibInstalled;		/* protect from muliple inits */
@@ -630,7 +635,9 @@ STATUS semFlushDefer
 	return (ERROR);
 	}
 
-    workQAdd1 (semFlushDeferTbl [semId->semType], (int) semId);
+    /* a second flush in a row finds no task to unblock, so merge them */
+
+    workQMerge1 (semFlushDeferTbl [semId->semType], (int) semId);
 
     return (OK);
     }
@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+02l,17oct26,agt  semMGiveForce() frees the lock of a fast mutex (semFmLib).
 02k,03may02,pcm  removed possible NULL dereference in semMCreate () (SPR 76721)
 02j,19nov01,bwa  Corrected doc for semMCreate return value (SPR #71921).
 02i,09nov01,dee  add CPU_FAMILY != COLDFIRE in portable test
@@ -235,6 +236,7 @@ SEE ALSO: semLib, semBLib, semCLib,
 #include "errnoLib.h"
 #include "taskLib.h"
 #include "intLib.h"
+#include "semFmLib.h"
 #include "eventLib.h"
 #include "private/eventLibP.h"
 #include "private/sigLibP.h"
@@ -716,6 +718,9 @@ STATUS semMGiveForce
 	}
     else
 	{
+	if (semId->semType == SEM_TYPE_FMUTEX)	/* fast mutex lock is free */
+	    *SEM_FM_LOCK (semId) = 0;
+
 	if (semId->events.taskId != (int)NULL)	/* sem is free, send events */
 	    {
 	    if (eventRsrcSend (semId->events.taskId,
@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+01r,17oct26,agt  added fast mutex (semFmLib) semaphore type.
 01q,31oct01,aeg  added display of VxWorks events information.
 01p,26sep01,jws  move vxMP show & info rtn ptrs to funcBind.c (SPR36055)
 01o,18dec00,pes  Correct compiler warnings
@@ -59,6 +60,7 @@ SEE ALSO: semLib,
 #include "string.h"
 #include "stdio.h"
 #include "smObjLib.h"
+#include "semFmLib.h"
 #include "private/eventLibP.h"
 #include "private/semLibP.h"
 #include "private/kernelLibP.h"
@@ -71,7 +73,7 @@ SEE ALSO: semLib,
 
 LOCAL char * 	semTypeMsg [MAX_SEM_TYPE] = 
     {
-    "BINARY", "MUTEX", "COUNTING", "OLD", "\0", "\0", "\0", "\0"
+    "BINARY", "MUTEX", "COUNTING", "OLD", "FMUTEX", "\0", "\0", "\0"
     };
 
 /******************************************************************************
@@ -287,6 +289,7 @@ STATUS semShow
 	    break;
 
 	case SEM_TYPE_MUTEX:
+	case SEM_TYPE_FMUTEX:
 	    if (pTcb != NULL)
 		{
 		printf ("%-20s: 0x%-10x", "Owner", (int)pTcb);
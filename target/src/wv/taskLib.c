@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+05p,17oct26,agt  deferred taskSuspend() and taskResume() merge repeated jobs.
 05o,15may02,pcm  added check for valid priority level in taskInit() (SPR 77368)
 05n,04jan02,hbh  Increased default extra stack size for simulators.
 05m,09nov01,jhw  Revert WDB_INFO to be inside WIND_TCB.
@@ -269,6 +270,10 @@ kernelLib,
 #include "private/eventP.h"
 
 
+/* externs */
+
+extern void	workQMerge1 (FUNCPTR func, int arg1);
+
 /* locals */
 
 LOCAL OBJ_CLASS	taskClass;			/* task object class */
@@ -1465,7 +1470,7 @@ STATUS taskSuspend
 	if ((tid == 0) || (TASK_ID_VERIFY ((void *)tid) != OK))
 	    return (ERROR);
 
-	workQAdd1 ((FUNCPTR)windSuspend, tid);	/* add work to kernel work q */
+	workQMerge1 ((FUNCPTR)windSuspend, tid); /* add work to kernel work q */
 	return (OK);
 	}
 
@@ -1521,7 +1526,7 @@ STATUS taskResume
 	bzero ((char *) &((WIND_TCB *) tid)->excInfo, sizeof (EXC_INFO));
 #endif	/* CPU==SIMSPARCSUNOS || CPU==SIMSPARCSOLARIS */
 
-	workQAdd1 ((FUNCPTR)windResume, tid);	/* add work to kernel work q */
+	workQMerge1 ((FUNCPTR)windResume, tid); /* add work to kernel work q */
 	return (OK);
 	}
 
@@ -6,6 +6,7 @@
 /*
 modification history
 --------------------
+01u,17oct26,agt  deferred wdCancel() merges repeated cancels.
 01t,24jun96,sbs  made windview instrumentation conditionally compiled
 02s,13oct95,jdi  doc: removed SEE ALSO to .pG Cross-Dev.
 02r,18jan95,rhp  doc: say explicitly no need to cancel expired timers,
@@ -118,6 +119,10 @@ SEE ALSO: logLib,
 #include "private/eventP.h"
 
 
+/* externs */
+
+extern void	workQMerge1 (FUNCPTR func, int arg1);
+
 /* locals */
 
 LOCAL BOOL wdLibInstalled;
@@ -457,7 +462,7 @@ STATUS wdCancel
     if (kernelState)
 	{
 	intUnlock (level);			/* UNLOCK INTERRUPTS */
-	workQAdd1 ((FUNCPTR)windWdCancel, (int)wdId);
+	workQMerge1 ((FUNCPTR)windWdCancel, (int)wdId);
 	}
     else
 	{